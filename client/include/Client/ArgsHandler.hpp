@@ -6,9 +6,12 @@
 
 #pragma once
 
+#include <optional>
+
 #include <nlohmann/json.hpp>
 
 #include "Client/Common.hpp"
+#include "Interfaces/Protocol/LinkConditioner.hpp"
 
 namespace cli
 {
@@ -27,6 +30,7 @@ namespace cli
             std::string audio_lib_path = Path::Plugin::PLUGIN_AUDIO_SFML.string();
             std::string network_lib_path = Path::Plugin::PLUGIN_NETWORK_ASIO_CLIENT.string();
             std::string renderer_lib_path = Path::Plugin::PLUGIN_RENDERER_SFML.string();
+            std::optional<rnp::LinkConditions> link; // Simulated degraded link, for testing
 
             static ArgsConfig fromFile(const std::string &path);
     }; // struct Config
@@ -0,0 +1,78 @@
+///
+/// @file GameMulti.hpp
+/// @brief This file contains the multiplayer Game scene
+/// @namespace cli
+///
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "Engine/Interfaces/IScene.hpp"
+#include "Engine/Interpolation.hpp"
+#include "Engine/Prediction.hpp"
+#include "Interfaces/IAudio.hpp"
+#include "Interfaces/INetworkClient.hpp"
+
+namespace cli
+{
+    ///
+    /// @class GameMulti
+    /// @brief GameMulti scene, showing the entities of the server as interpolated from its snapshots
+    /// The entity the server gave the player is shown ahead of them, as predicted from the inputs sent.
+    /// @namespace cli
+    ///
+    class GameMulti final : public eng::AScene
+    {
+        public:
+            GameMulti(const std::shared_ptr<eng::IRenderer> &renderer, const std::shared_ptr<eng::IAudio> &audio,
+                      const std::shared_ptr<eng::INetworkClient> &network);
+            ~GameMulti() override = default;
+
+            GameMulti(const GameMulti &other) = delete;
+            GameMulti &operator=(const GameMulti &other) = delete;
+            GameMulti(GameMulti &&other) = delete;
+            GameMulti &operator=(GameMulti &&other) = delete;
+
+            void update(float dt, const eng::WindowSize &size) override;
+            void event(const eng::Event &event) override;
+            ///
+            /// @brief Apply an event of the server, handed by the engine at the start of the frame
+            ///
+            void onNetworkEvent(const eng::NetworkEvent &event);
+
+        private:
+            ///
+            /// @brief Give each server entity a scene entity at its position, and remove those it no longer has
+            ///
+            void show(const std::vector<rnp::EntityState> &entities);
+            void hide(ecs::Entity entity);
+            ///
+            /// @brief Send the keys held as an input of the controlled entity, and predict it
+            ///
+            void sendInput(std::chrono::steady_clock::time_point now);
+            ///
+            /// @brief Move an entity by an input, as the server does
+            ///
+            static void predict(rnp::EntityState &entity, const eng::PredictedInput &input);
+
+            std::unordered_map<eng::Key, bool> m_keysPressed;
+            ecs::Entity m_fpsEntity;
+            ecs::Entity m_networkEntity; // Round trip and age of the newest snapshot
+            const std::shared_ptr<eng::INetworkClient> &m_network;
+
+            rnp::PacketWorldState m_worldState{}; // Last polled, its buffers are recycled by the interpolator
+            std::uint32_t m_newestTick = 0;
+            eng::SnapshotInterpolator m_interpolator;
+            std::vector<rnp::EntityState> m_entities;            // Interpolated to the render time of the frame
+            std::unordered_map<std::uint32_t, ecs::Entity> m_shown; // Scene entity of each server entity
+            std::unordered_set<std::uint32_t> m_despawned; // Despawned, until the render time is past their removal
+            eng::InputPredictor m_predictor{&GameMulti::predict};
+            std::chrono::steady_clock::time_point m_start = std::chrono::steady_clock::now();
+            std::uint32_t m_lastInputMs = 0; // Client time of the last input sent, 0 before the first
+    }; // class GameMulti
+} // namespace cli
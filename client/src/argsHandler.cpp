@@ -77,6 +77,10 @@ cli::ArgsConfig cli::ArgsConfig::fromFile(const std::string &path)
             cfg.port = c["port"];
         }
     }
+    if (j.contains("link"))
+    {
+        cfg.link = rnp::linkConditionsFromJson(j["link"]);
+    }
     return cfg;
 }
 
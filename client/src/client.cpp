@@ -3,6 +3,7 @@
 #include "Client/Scenes/Menu.hpp"
 #include "Client/Scenes/Settings.hpp"
 #include "Client/Scenes/game/multi/ConfigMulti.hpp"
+#include "Client/Scenes/game/multi/GameMulti.hpp"
 #include "Client/Scenes/game/solo/ConfigSolo.hpp"
 #include "Client/Scenes/game/solo/GameSolo.hpp"
 #include "Client/Systems/Systems.hpp"
@@ -57,6 +58,10 @@ cli::Client::Client(const ArgsConfig &cfg)
         });
     // m_game = std::make_unique<gme::RTypeClient>();
     m_engine->getRenderer()->createWindow("R-Type Client", m_config.height, m_config.width, m_config.frameLimit, m_config.fullscreen);
+    if (cfg.link)
+    {
+        m_engine->getNetwork()->setLinkConditions(*cfg.link);
+    }
     m_engine->getNetwork()->connect(m_config.host, m_config.port);
     m_engine->getNetwork()->sendConnect("Bobi");
     setupScenes();
@@ -113,6 +118,12 @@ void cli::Client::setupScenes() const
     gameSolo->addSystem(std::make_unique<LoadingAnimationSystem>(m_engine->getRenderer()));
     gameSolo->addSystem(std::make_unique<PlayerDirectionSystem>());
     gameSolo->addSystem(std::make_unique<ProjectileSystem>(m_engine->getRenderer()));
+    auto gameMulti = std::make_unique<GameMulti>(m_engine->getRenderer(), m_engine->getAudio(), m_engine->getNetwork());
+    gameMulti->addSystem(std::make_unique<AudioSystem>(m_engine->getAudio()));
+    gameMulti->addSystem(std::make_unique<PixelSystem>(m_engine->getRenderer()));
+    gameMulti->addSystem(std::make_unique<SpriteSystem>(m_engine->getRenderer()));
+    gameMulti->addSystem(std::make_unique<TextSystem>(m_engine->getRenderer()));
+    gameMulti->addSystem(std::make_unique<PlayerDirectionSystem>());
     auto settings = std::make_unique<Settings>(m_engine->getRenderer(), m_engine->getAudio());
     settings->addSystem(std::make_unique<AudioSystem>(m_engine->getAudio()));
     settings->addSystem(std::make_unique<PixelSystem>(m_engine->getRenderer()));
@@ -123,6 +134,10 @@ void cli::Client::setupScenes() const
     const auto configMultiId = configMulti->getId();
     const auto configSoloId = configSolo->getId();
     const auto gameSoloId = gameSolo->getId();
+    const auto gameMultiId = gameMulti->getId();
+    // Owned by the scene manager, the scene lives as long as the engine
+    m_engine->setNetworkEventHandler([scene = gameMulti.get()](const eng::NetworkEvent &event)
+                                     { scene->onNetworkEvent(event); });
     const auto settingsId = settings->getId();
     menu->onOptionSelected = [this, configSoloId, configMultiId, settingsId](const std::string &option)
     {
@@ -139,7 +154,7 @@ void cli::Client::setupScenes() const
             m_engine->getSceneManager()->switchToScene(settingsId);
         }
     };
-    configMulti->onOptionSelected = [this, menuId](const std::string &option)
+    configMulti->onOptionSelected = [this, gameMultiId, menuId](const std::string &option)
     {
         if (option == "Create room")
         {
@@ -147,7 +162,7 @@ void cli::Client::setupScenes() const
         }
         else if (option == "Join room")
         {
-            // m_engine->getSceneManager()->switchToScene(joinRoomId);
+            m_engine->getSceneManager()->switchToScene(gameMultiId);
         }
         else if (option == "Go back to menu")
         {
@@ -175,6 +190,7 @@ void cli::Client::setupScenes() const
     m_engine->getSceneManager()->addScene(std::move(configMulti));
     m_engine->getSceneManager()->addScene(std::move(configSolo));
     m_engine->getSceneManager()->addScene(std::move(gameSolo));
+    m_engine->getSceneManager()->addScene(std::move(gameMulti));
     m_engine->getSceneManager()->addScene(std::move(settings));
     m_engine->getSceneManager()->switchToScene(menuId);
 }
@@ -0,0 +1,308 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <optional>
+#include <utility>
+
+#include "Client/Scenes/game/multi/GameMulti.hpp"
+#include "Client/Common.hpp"
+#include "Client/GameConfig.hpp"
+#include "ECS/Component.hpp"
+#include "Interfaces/IAudio.hpp"
+#include "Interfaces/Protocol/Movement.hpp"
+
+static constexpr eng::Color WHITE = {.r = 255U, .g = 255U, .b = 255U, .a = 255U};
+
+namespace
+{
+    ///
+    /// @brief How a server entity of a type is drawn
+    ///
+    struct Look
+    {
+            const char *texture;
+            float width;
+            float height;
+            float scale;
+    };
+
+    Look lookOf(const std::uint16_t type)
+    {
+        using namespace cli::GameConfig;
+        switch (static_cast<rnp::EntityType>(type))
+        {
+            case rnp::EntityType::PLAYER:
+                return {cli::Path::Texture::TEXTURE_PLAYER, Player::SPRITE_WIDTH, Player::SPRITE_HEIGHT, Player::SCALE};
+            case rnp::EntityType::PROJECTILE:
+                return {cli::Path::Texture::TEXTURE_SHOOT, Projectile::Basic::SPRITE_WIDTH,
+                        Projectile::Basic::SPRITE_HEIGHT, Projectile::Basic::SCALE};
+            case rnp::EntityType::OBSTACLE:
+                return {cli::Path::Texture::TEXTURE_ASTEROID, Asteroid::Small::SPRITE_WIDTH,
+                        Asteroid::Small::SPRITE_HEIGHT, Asteroid::Small::SCALE};
+            default:
+                return {cli::Path::Texture::TEXTURE_ENEMY_EASY, Enemy::Easy::SPRITE_WIDTH, Enemy::Easy::SPRITE_HEIGHT,
+                        Enemy::Easy::SCALE};
+        }
+    }
+} // namespace
+
+cli::GameMulti::GameMulti(const std::shared_ptr<eng::IRenderer> &renderer, const std::shared_ptr<eng::IAudio> &audio,
+                          const std::shared_ptr<eng::INetworkClient> &network)
+    : m_network(network)
+{
+    auto &registry = AScene::getRegistry();
+
+    registry.onComponentAdded(
+        [&renderer, &audio, &registry](const ecs::Entity e, const std::type_info &type)
+        {
+            const auto *audioComp = registry.getComponent<ecs::Audio>(e);
+            const auto *colorComp = registry.getComponent<ecs::Color>(e);
+            const auto *fontComp = registry.getComponent<ecs::Font>(e);
+            const auto *rectComp = registry.getComponent<ecs::Rect>(e);
+            const auto *scaleComp = registry.getComponent<ecs::Scale>(e);
+            const auto *textComp = registry.getComponent<ecs::Text>(e);
+            const auto *textureComp = registry.getComponent<ecs::Texture>(e);
+            const auto *transform = registry.getComponent<ecs::Transform>(e);
+
+            if (type == typeid(ecs::Text))
+            {
+                if (textComp && transform && fontComp)
+                {
+                    renderer->createFont(fontComp->id, fontComp->path);
+                    renderer->createText(
+                        {.font_name = fontComp->id,
+                         .color = {.r = colorComp->r, .g = colorComp->g, .b = colorComp->b, .a = colorComp->a},
+                         .content = textComp->content,
+                         .size = textComp->font_size,
+                         .x = transform->x,
+                         .y = transform->y,
+                         .name = textComp->id});
+                }
+            }
+            else if (type == typeid(ecs::Texture))
+            {
+                const float scale_x = scaleComp ? scaleComp->x : 1.F;
+                const float scale_y = scaleComp ? scaleComp->y : 1.F;
+
+                renderer->createTexture(textureComp->id, textureComp->path);
+
+                if (transform && rectComp)
+                {
+                    renderer->createSprite(textureComp->id + std::to_string(e), textureComp->id, transform->x,
+                                           transform->y, scale_x, scale_y, static_cast<int>(rectComp->pos_x),
+                                           static_cast<int>(rectComp->pos_y), rectComp->size_x, rectComp->size_y);
+                }
+            }
+            else if (type == typeid(ecs::Audio))
+            {
+                if (audioComp)
+                {
+                    audio->createAudio(audioComp->path, audioComp->volume, audioComp->loop,
+                                       audioComp->id + std::to_string(e));
+                }
+            }
+        });
+
+    registry.createEntity().with<ecs::Audio>("id_audio", Path::Audio::AUDIO_TITLE, 5.F, true, true).build();
+    m_fpsEntity = registry.createEntity()
+                      .with<ecs::Font>("main_font", Path::Font::FONTS_RTYPE)
+                      .with<ecs::Transform>("transform_fps", 10.F, 10.F, 0.F)
+                      .with<ecs::Color>("color_fps", WHITE.r, WHITE.g, WHITE.b, WHITE.a)
+                      .with<ecs::Text>("id_text", std::string("FPS: 0"), 20U)
+                      .build();
+    m_networkEntity = registry.createEntity()
+                          .with<ecs::Font>("main_font", Path::Font::FONTS_RTYPE)
+                          .with<ecs::Transform>("transform_network", 10.F, 40.F, 0.F)
+                          .with<ecs::Color>("color_network", WHITE.r, WHITE.g, WHITE.b, WHITE.a)
+                          .with<ecs::Text>("id_text_network", std::string("Ping: -"), 20U)
+                          .build();
+}
+
+void cli::GameMulti::update(const float dt, const eng::WindowSize & /* size */)
+{
+    const auto now = std::chrono::steady_clock::now();
+    sendInput(now);
+    if (m_network->pollWorldState(m_worldState))
+    {
+        // Before push(), which takes the entities
+        m_predictor.reconcile(m_worldState.entities, m_worldState.inputAck);
+        m_newestTick = std::max(m_newestTick, m_worldState.serverTick);
+        m_interpolator.setTickRate(m_network->getServerTickRate());
+        m_interpolator.push(m_worldState, now);
+    }
+    if (m_interpolator.sample(m_entities, now))
+    {
+        // The controlled entity is shown where its inputs took it, not where the render time has it
+        if (const std::optional<rnp::EntityState> predicted = m_predictor.state())
+        {
+            const auto local = std::ranges::lower_bound(m_entities, predicted->id, {}, &rnp::EntityState::id);
+            if (local != m_entities.end() && local->id == predicted->id)
+            {
+                *local = *predicted;
+            }
+            else
+            {
+                m_entities.insert(local, *predicted);
+            }
+        }
+        show(m_entities);
+    }
+
+    if (auto *fpsText = getRegistry().getComponent<ecs::Text>(m_fpsEntity))
+    {
+        fpsText->content = "FPS: " + std::to_string(static_cast<int>(1 / dt));
+    }
+    if (auto *networkText = getRegistry().getComponent<ecs::Text>(m_networkEntity))
+    {
+        const auto roundTrip = std::chrono::duration_cast<std::chrono::milliseconds>(
+            m_network->getClockStats().roundTrip);
+        networkText->content = "Ping: " + std::to_string(roundTrip.count()) + " ms";
+        // How long ago the server was where its newest snapshot shows it
+        const std::optional<double> serverTick = m_network->getServerTickEstimate();
+        const std::uint16_t tickRate = m_network->getServerTickRate();
+        if (serverTick && m_newestTick != 0 && tickRate != 0)
+        {
+            const double age = (*serverTick - m_newestTick) * 1000.0 / tickRate;
+            networkText->content += " - Snapshot: " + std::to_string(std::lround(age)) + " ms";
+        }
+    }
+}
+
+void cli::GameMulti::sendInput(const std::chrono::steady_clock::time_point now)
+{
+    const std::optional<std::uint32_t> entityId = m_predictor.entity();
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - m_start);
+    const auto clientTimeMs = static_cast<std::uint32_t>(elapsed.count()) + 1; // Never 0, which acknowledges none
+    if (!entityId || clientTimeMs == m_lastInputMs)
+    {
+        return;
+    }
+
+    std::uint8_t direction = 0;
+    const std::pair<eng::Key, rnp::InputDirection> bindings[] = {{eng::Key::Up, rnp::InputDirection::UP},
+                                                                 {eng::Key::Down, rnp::InputDirection::DOWN},
+                                                                 {eng::Key::Left, rnp::InputDirection::LEFT},
+                                                                 {eng::Key::Right, rnp::InputDirection::RIGHT}};
+    for (const auto &[key, bit] : bindings)
+    {
+        if (m_keysPressed[key])
+        {
+            direction |= static_cast<std::uint8_t>(bit);
+        }
+    }
+    const eng::PredictedInput input{.clientTimeMs = clientTimeMs,
+                                    .direction = direction,
+                                    .shooting = static_cast<std::uint8_t>(m_keysPressed[eng::Key::Space] ? 1 : 0),
+                                    .dt = rnp::inputStep(m_lastInputMs, clientTimeMs)};
+    m_lastInputMs = clientTimeMs;
+    m_network->sendPlayerInputAsEvent(static_cast<std::uint16_t>(*entityId), input.direction, input.shooting,
+                                      input.clientTimeMs);
+    m_predictor.apply(input);
+}
+
+void cli::GameMulti::predict(rnp::EntityState &entity, const eng::PredictedInput &input)
+{
+    const rnp::PlayerVelocity velocity = rnp::playerVelocity(input.direction);
+    entity.vx = velocity.x;
+    entity.vy = velocity.y;
+    rnp::movePlayer(entity.x, entity.y, velocity, input.dt);
+}
+
+void cli::GameMulti::show(const std::vector<rnp::EntityState> &entities)
+{
+    auto &registry = getRegistry();
+    const auto sampled = [&entities](const std::uint32_t id)
+    { return std::ranges::binary_search(entities, id, {}, &rnp::EntityState::id); };
+    std::erase_if(m_despawned, [&sampled](const std::uint32_t id) { return !sampled(id); });
+    for (auto shown = m_shown.begin(); shown != m_shown.end();)
+    {
+        if (sampled(shown->first))
+        {
+            ++shown;
+            continue;
+        }
+        hide(shown->second);
+        shown = m_shown.erase(shown);
+    }
+
+    for (const rnp::EntityState &entity : entities)
+    {
+        if (m_despawned.contains(entity.id))
+        {
+            continue;
+        }
+        if (const auto shown = m_shown.find(entity.id); shown != m_shown.end())
+        {
+            auto *transform = registry.getComponent<ecs::Transform>(shown->second);
+            auto *velocity = registry.getComponent<ecs::Velocity>(shown->second);
+            transform->x = entity.x;
+            transform->y = entity.y;
+            velocity->x = entity.vx;
+            velocity->y = entity.vy;
+            continue;
+        }
+        // The texture last, its sprite is created from the other components
+        const Look look = lookOf(entity.type);
+        auto builder = registry.createEntity();
+        builder.with<ecs::Transform>("server_transform", entity.x, entity.y, 0.F)
+            .with<ecs::Velocity>("server_velocity", entity.vx, entity.vy)
+            .with<ecs::Rect>("server_rect", 0.F, 0.F, static_cast<int>(look.width), static_cast<int>(look.height))
+            .with<ecs::Scale>("server_scale", look.scale, look.scale);
+        if (entity.type == static_cast<std::uint16_t>(rnp::EntityType::PLAYER))
+        {
+            builder.with<ecs::Player>("player", false);
+        }
+        m_shown.emplace(entity.id, builder.with<ecs::Texture>("server_texture", look.texture).build());
+    }
+}
+
+void cli::GameMulti::hide(const ecs::Entity entity)
+{
+    auto &registry = getRegistry();
+    registry.removeComponent<ecs::Texture>(entity);
+    registry.removeComponent<ecs::Transform>(entity);
+    registry.removeComponent<ecs::Velocity>(entity);
+    registry.removeComponent<ecs::Rect>(entity);
+    registry.removeComponent<ecs::Scale>(entity);
+    registry.removeComponent<ecs::Player>(entity);
+}
+
+void cli::GameMulti::onNetworkEvent(const eng::NetworkEvent &event)
+{
+    switch (event.type)
+    {
+        case rnp::EventType::CONTROL:
+            m_predictor.setEntity(event.entityId);
+            break;
+        case rnp::EventType::DESPAWN:
+            // Gone now, rather than once the render time catches up with the snapshot without it
+            if (const auto shown = m_shown.find(event.entityId); shown != m_shown.end())
+            {
+                hide(shown->second);
+                m_shown.erase(shown);
+            }
+            m_despawned.insert(event.entityId);
+            if (m_predictor.entity() == event.entityId)
+            {
+                m_predictor.clear();
+            }
+            break;
+        default:
+            break; // The other events are seen in the next snapshots
+    }
+}
+
+void cli::GameMulti::event(const eng::Event &event)
+{
+    switch (event.type)
+    {
+        case eng::EventType::KeyPressed:
+            m_keysPressed[event.key] = true;
+            break;
+        case eng::EventType::KeyReleased:
+            m_keysPressed[event.key] = false;
+            break;
+        default:
+            break;
+    }
+}
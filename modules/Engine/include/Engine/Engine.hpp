@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include <chrono>
+#include <cstddef>
 #include <functional>
 #include <memory>
 
@@ -25,6 +27,16 @@ namespace eng
         DEFAULT = 2,
     };
 
+    ///
+    /// @brief Most network events handled per frame, the others wait for the next frames
+    /// At least one event is handled each frame, whatever the time it takes.
+    ///
+    struct NetworkEventBudget
+    {
+            std::size_t maxEvents = 64;
+            std::chrono::microseconds maxTime{1000};
+    };
+
     ///
     /// @class Engine
     /// @brief Class for the game engine
@@ -34,6 +46,8 @@ namespace eng
     {
 
         public:
+            using NetworkEventHandler = std::function<void(const NetworkEvent &)>;
+
             Engine(const std::function<std::shared_ptr<IAudio>()> &audioFactory,
                    const std::function<std::shared_ptr<INetworkClient>()> &networkFactory,
                    const std::function<std::shared_ptr<IRenderer>()> &rendererFactory);
@@ -52,8 +66,15 @@ namespace eng
             State getState() const { return m_state; }
 
             void setState(const State newState) { m_state = newState; }
+            ///
+            /// @brief Handle the events received from the server on the main thread, at the start of each frame
+            /// Until it is set, events stay queued in the network plugin, which drops the newest once it is full.
+            ///
+            void setNetworkEventHandler(NetworkEventHandler handler) { m_networkEventHandler = std::move(handler); }
+            void setNetworkEventBudget(const NetworkEventBudget &budget) { m_networkEventBudget = budget; }
 
             void render(const WindowSize &windowSize, Color clearColor) const;
+            void dispatchNetworkEvents() const;
             void stop() const { m_renderer->closeWindow(); }
 
         private:
@@ -63,5 +84,7 @@ namespace eng
             std::shared_ptr<IAudio> m_audio;
             std::shared_ptr<INetworkClient> m_network;
             std::shared_ptr<IRenderer> m_renderer;
+            NetworkEventHandler m_networkEventHandler;
+            NetworkEventBudget m_networkEventBudget;
     }; // class Engine
 } // namespace eng
\ No newline at end of file
@@ -0,0 +1,239 @@
+///
+/// @file Interpolation.hpp
+/// @brief This file contains the buffer of received snapshots the client renders in between
+/// @namespace eng
+///
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "Interfaces/Protocol/Protocol.hpp"
+
+namespace eng
+{
+
+    ///
+    /// @brief Longest an entity keeps moving along its velocity past the newest snapshot, when the next is late
+    ///
+    inline constexpr std::chrono::milliseconds MAX_EXTRAPOLATION{100};
+
+    ///
+    /// @brief Longest interpolation delay, whatever the snapshot rate and jitter
+    ///
+    inline constexpr std::chrono::milliseconds MAX_INTERPOLATION_DELAY{500};
+
+    ///
+    /// @class SnapshotInterpolator
+    /// @brief Received snapshots indexed by server tick, rendered interpDelay behind their arrival
+    /// The delay covers the spacing between snapshots plus twice their arrival jitter, so the render time almost
+    /// always falls between two received snapshots and entities are lerped between them. When the next one is
+    /// late, entities move on along their velocity for at most MAX_EXTRAPOLATION, then stop. The render clock
+    /// follows changes of the delay by running at most 10% faster or slower, so motion never jumps. Buffers are
+    /// reused, neither pushing nor sampling allocates once they have grown.
+    /// @namespace eng
+    ///
+    class SnapshotInterpolator
+    {
+        public:
+            using Clock = std::chrono::steady_clock;
+
+            static constexpr std::size_t HISTORY = 32;
+
+            void setTickRate(const std::uint16_t tickRate) { m_tickRate = tickRate != 0 ? tickRate : 60; }
+
+            ///
+            /// @brief Store a snapshot received at arrival, its entities sorted by id
+            /// The snapshot is swapped with the one it replaces, whose buffers the caller recycles for the next poll.
+            ///
+            void push(rnp::PacketWorldState &snapshot, const Clock::time_point arrival = Clock::now())
+            {
+                if (m_newestTick && static_cast<std::int32_t>(snapshot.serverTick - *m_newestTick) <= 0)
+                {
+                    // Overtaken by a newer one, it still fills its gap but tells nothing of the arrival timing
+                    Slot &slot = m_slots[snapshot.serverTick % HISTORY];
+                    if (*m_newestTick - snapshot.serverTick < HISTORY &&
+                        (!slot.filled || static_cast<std::int32_t>(snapshot.serverTick - slot.serverTick) > 0))
+                    {
+                        store(slot, snapshot);
+                    }
+                    return;
+                }
+                if (!m_epoch)
+                {
+                    m_epoch = arrival;
+                }
+
+                // Arrival time minus server time: the one way delay plus the clock offset, and its jitter
+                const double offset = seconds(arrival) - serverTime(snapshot.serverTick);
+                if (!m_offset)
+                {
+                    m_offset = offset;
+                }
+                else
+                {
+                    m_jitter += (std::abs(offset - *m_offset) - m_jitter) / 16;
+                    *m_offset += (offset - *m_offset) / 16;
+                }
+                if (m_newestTick)
+                {
+                    const double spacing = static_cast<double>(snapshot.serverTick - *m_newestTick) / m_tickRate;
+                    m_spacing = m_spacing ? *m_spacing + (spacing - *m_spacing) / 8 : spacing;
+                }
+                m_newestTick = snapshot.serverTick;
+
+                store(m_slots[snapshot.serverTick % HISTORY], snapshot);
+            }
+
+            ///
+            /// @brief Delay between the arrival of a snapshot and the time it is rendered at
+            ///
+            [[nodiscard]] std::chrono::duration<double> delay() const
+            {
+                const double target = m_spacing.value_or(1.0 / m_tickRate) + 2 * m_jitter;
+                return std::chrono::duration<double>(
+                    std::min(target, std::chrono::duration<double>(MAX_INTERPOLATION_DELAY).count()));
+            }
+
+            ///
+            /// @brief Entities as they are to be rendered at now, sorted by id
+            /// @return false, leaving entities untouched, until a snapshot was pushed
+            ///
+            bool sample(std::vector<rnp::EntityState> &entities, const Clock::time_point now = Clock::now())
+            {
+                if (!m_offset)
+                {
+                    return false;
+                }
+                advance(now);
+
+                const Slot *from = nullptr; // Newest snapshot at or before the render time
+                const Slot *to = nullptr;   // Oldest snapshot after it
+                for (const Slot &slot : m_slots)
+                {
+                    if (!slot.filled)
+                    {
+                        continue;
+                    }
+                    const double time = serverTime(slot.serverTick);
+                    if (time <= m_renderTime && (from == nullptr || slot.serverTick > from->serverTick))
+                    {
+                        from = &slot;
+                    }
+                    else if (time > m_renderTime && (to == nullptr || slot.serverTick < to->serverTick))
+                    {
+                        to = &slot;
+                    }
+                }
+
+                entities.clear();
+                if (from == nullptr)
+                {
+                    entities.assign(to->entities.begin(), to->entities.end());
+                    return true;
+                }
+                const double elapsed = m_renderTime - serverTime(from->serverTick);
+                if (to == nullptr)
+                {
+                    const auto ahead = static_cast<float>(
+                        std::min(elapsed, std::chrono::duration<double>(MAX_EXTRAPOLATION).count()));
+                    for (rnp::EntityState entity : from->entities)
+                    {
+                        entity.x += entity.vx * ahead;
+                        entity.y += entity.vy * ahead;
+                        entities.push_back(entity);
+                    }
+                    return true;
+                }
+
+                // Entities only in the older snapshot stay until the newer one, those only in the newer wait for it
+                const auto alpha =
+                    static_cast<float>(elapsed / (serverTime(to->serverTick) - serverTime(from->serverTick)));
+                auto next = to->entities.begin();
+                for (rnp::EntityState entity : from->entities)
+                {
+                    while (next != to->entities.end() && next->id < entity.id)
+                    {
+                        ++next;
+                    }
+                    if (next != to->entities.end() && next->id == entity.id)
+                    {
+                        entity.x = std::lerp(entity.x, next->x, alpha);
+                        entity.y = std::lerp(entity.y, next->y, alpha);
+                        entity.vx = std::lerp(entity.vx, next->vx, alpha);
+                        entity.vy = std::lerp(entity.vy, next->vy, alpha);
+                    }
+                    entities.push_back(entity);
+                }
+                return true;
+            }
+
+            void clear()
+            {
+                const std::uint16_t tickRate = m_tickRate;
+                *this = SnapshotInterpolator{};
+                m_tickRate = tickRate;
+            }
+
+        private:
+            struct Slot
+            {
+                    std::uint32_t serverTick = 0;
+                    std::vector<rnp::EntityState> entities;
+                    bool filled = false;
+            };
+
+            static void store(Slot &slot, rnp::PacketWorldState &snapshot)
+            {
+                slot.serverTick = snapshot.serverTick;
+                slot.entities.swap(snapshot.entities);
+                slot.filled = true;
+            }
+
+            [[nodiscard]] double seconds(const Clock::time_point time) const
+            {
+                return std::chrono::duration<double>(time - *m_epoch).count();
+            }
+
+            [[nodiscard]] double serverTime(const std::uint32_t serverTick) const
+            {
+                return static_cast<double>(serverTick) / m_tickRate;
+            }
+
+            ///
+            /// @brief Move the render time, in server seconds, towards now minus the offset and the delay
+            ///
+            void advance(const Clock::time_point now)
+            {
+                const double target = seconds(now) - *m_offset - delay().count();
+                const double frame = m_lastSample ? std::chrono::duration<double>(now - *m_lastSample).count() : 0.0;
+                const double predicted = m_renderTime + frame;
+                if (!m_lastSample || std::abs(target - predicted) > 0.25)
+                {
+                    m_renderTime = target;
+                }
+                else
+                {
+                    m_renderTime = predicted + std::clamp(target - predicted, -frame / 10, frame / 10);
+                }
+                m_lastSample = now;
+            }
+
+            std::array<Slot, HISTORY> m_slots{};
+            std::uint16_t m_tickRate = 60;
+            std::optional<Clock::time_point> m_epoch;
+            std::optional<std::uint32_t> m_newestTick;
+            std::optional<double> m_offset;  // Seconds
+            double m_jitter = 0.0;           // Seconds
+            std::optional<double> m_spacing; // Seconds between snapshots
+            std::optional<Clock::time_point> m_lastSample;
+            double m_renderTime = 0.0; // Server seconds
+    }; // class SnapshotInterpolator
+
+} // namespace eng
@@ -0,0 +1,174 @@
+///
+/// @file Prediction.hpp
+/// @brief This file contains the prediction of the local player from the inputs not acknowledged yet
+/// @namespace eng
+///
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+#include <utility>
+
+#include "Interfaces/Protocol/Delta.hpp"
+#include "Interfaces/Protocol/Protocol.hpp"
+
+namespace eng
+{
+
+    ///
+    /// @brief Prediction error beyond which the predicted entity jumps to the corrected position at once
+    ///
+    inline constexpr float MAX_SMOOTHED_CORRECTION = 64.F;
+
+    ///
+    /// @brief Time constant of the decay of a smoothed correction
+    ///
+    inline constexpr std::chrono::milliseconds CORRECTION_TIME{100};
+
+    ///
+    /// @brief One input of the local player, as sent in an INPUT event, and the frame time it covers
+    ///
+    struct PredictedInput
+    {
+            std::uint32_t clientTimeMs;
+            std::uint8_t direction; // rnp::InputDirection bits
+            std::uint8_t shooting;
+            float dt; // Seconds
+    };
+
+    ///
+    /// @class InputPredictor
+    /// @brief Local player moved by its inputs as soon as they are sent, reconciled with every snapshot
+    /// Inputs are kept until a snapshot acknowledges them. On each snapshot the entity restarts from its
+    /// authoritative state and the pending inputs are replayed on it. The difference with what was displayed is
+    /// kept as a correction decaying over CORRECTION_TIME, so a misprediction is smoothed out rather than
+    /// snapped, unless it is beyond MAX_SMOOTHED_CORRECTION.
+    /// @namespace eng
+    ///
+    class InputPredictor
+    {
+        public:
+            using Simulate = std::function<void(rnp::EntityState &, const PredictedInput &)>;
+
+            static constexpr std::size_t HISTORY = 128;
+
+            explicit InputPredictor(Simulate simulate) : m_simulate(std::move(simulate)) {}
+
+            ///
+            /// @brief Predict the entity id from now on, forgetting the previous one
+            ///
+            void setEntity(const std::uint32_t entityId)
+            {
+                clear();
+                m_entityId = entityId;
+            }
+
+            [[nodiscard]] std::optional<std::uint32_t> entity() const { return m_entityId; }
+
+            ///
+            /// @brief Apply an input just sent to the predicted entity and keep it until acknowledged
+            /// The oldest pending input is dropped once HISTORY are pending.
+            ///
+            void apply(const PredictedInput &input)
+            {
+                if (!m_entityId)
+                {
+                    return;
+                }
+                if (m_count == HISTORY)
+                {
+                    m_first = (m_first + 1) % HISTORY;
+                    --m_count;
+                }
+                m_inputs[(m_first + m_count++) % HISTORY] = input;
+                if (m_predicted)
+                {
+                    m_simulate(*m_predicted, input);
+                }
+                const float decay = std::exp(-input.dt / std::chrono::duration<float>(CORRECTION_TIME).count());
+                m_correctionX *= decay;
+                m_correctionY *= decay;
+            }
+
+            ///
+            /// @brief Restart from the entity in a snapshot, sorted by id, and replay the inputs after inputAck
+            /// @param inputAck client time of the last input the snapshot reflects, 0 if none
+            ///
+            void reconcile(const std::span<const rnp::EntityState> entities, const std::uint32_t inputAck)
+            {
+                const rnp::EntityState *authoritative = m_entityId ? rnp::findEntity(entities, *m_entityId) : nullptr;
+                if (authoritative == nullptr)
+                {
+                    return;
+                }
+                while (inputAck != 0 && m_count != 0 &&
+                       static_cast<std::int32_t>(m_inputs[m_first].clientTimeMs - inputAck) <= 0)
+                {
+                    m_first = (m_first + 1) % HISTORY;
+                    --m_count;
+                }
+
+                const std::optional<rnp::EntityState> displayed = state();
+                m_predicted = *authoritative;
+                for (std::size_t i = 0; i < m_count; ++i)
+                {
+                    m_simulate(*m_predicted, m_inputs[(m_first + i) % HISTORY]);
+                }
+                if (!displayed)
+                {
+                    return;
+                }
+                m_correctionX = displayed->x - m_predicted->x;
+                m_correctionY = displayed->y - m_predicted->y;
+                if (std::hypot(m_correctionX, m_correctionY) > MAX_SMOOTHED_CORRECTION)
+                {
+                    m_correctionX = 0.F;
+                    m_correctionY = 0.F;
+                }
+            }
+
+            ///
+            /// @brief Entity to display, or std::nullopt until a snapshot contained it
+            ///
+            [[nodiscard]] std::optional<rnp::EntityState> state() const
+            {
+                if (!m_predicted)
+                {
+                    return std::nullopt;
+                }
+                rnp::EntityState entity = *m_predicted;
+                entity.x += m_correctionX;
+                entity.y += m_correctionY;
+                return entity;
+            }
+
+            [[nodiscard]] std::size_t pending() const { return m_count; }
+
+            void clear()
+            {
+                m_entityId.reset();
+                m_predicted.reset();
+                m_first = 0;
+                m_count = 0;
+                m_correctionX = 0.F;
+                m_correctionY = 0.F;
+            }
+
+        private:
+            Simulate m_simulate;
+            std::optional<std::uint32_t> m_entityId;
+            std::optional<rnp::EntityState> m_predicted; // Authoritative state with the pending inputs replayed
+            std::array<PredictedInput, HISTORY> m_inputs{}; // Ring of the pending inputs, oldest at m_first
+            std::size_t m_first = 0;
+            std::size_t m_count = 0;
+            float m_correctionX = 0.F; // Displayed minus predicted, decaying
+            float m_correctionY = 0.F;
+    }; // class InputPredictor
+
+} // namespace eng
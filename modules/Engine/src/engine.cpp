@@ -10,8 +10,28 @@ void eng::Engine::render(const WindowSize &windowSize, const Color clearColor) c
 {
     const float dt = m_clock->getDeltaSeconds();
     m_clock->restart();
+    dispatchNetworkEvents();
     m_renderer->clearWindow(clearColor);
     m_sceneManager->getCurrentScene()->updateSystems(dt);
     m_sceneManager->getCurrentScene()->update(dt, windowSize);
     m_renderer->displayWindow();
-}
\ No newline at end of file
+}
+void eng::Engine::dispatchNetworkEvents() const
+{
+    // Left in the ring until someone handles them, where the newest are dropped once it is full
+    if (!m_networkEventHandler)
+    {
+        return;
+    }
+    // A burst, a spawn wave for instance, is spread over the next frames instead of stalling this one
+    const auto deadline = std::chrono::steady_clock::now() + m_networkEventBudget.maxTime;
+    NetworkEvent event;
+    for (std::size_t handled = 0; handled < m_networkEventBudget.maxEvents && m_network->pollEvent(event); ++handled)
+    {
+        m_networkEventHandler(event);
+        if (std::chrono::steady_clock::now() >= deadline)
+        {
+            break;
+        }
+    }
+}
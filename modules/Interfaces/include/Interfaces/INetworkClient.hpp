@@ -6,17 +6,47 @@
 
 #pragma once
 
+#include <array>
+#include <chrono>
 #include <cstdint>
 #include <functional>
+#include <optional>
+#include <span>
 #include <string>
-#include <vector>
 
+#include "Interfaces/Protocol/LinkConditioner.hpp"
+#include "Interfaces/Protocol/PacketView.hpp"
 #include "Interfaces/Protocol/Protocol.hpp"
 #include "Utils/Interfaces/IPlugin.hpp"
 
 namespace eng
 {
 
+    ///
+    /// @brief Round trip statistics of the PING/PONG exchanges with the server
+    ///
+    struct ClockStats
+    {
+            std::chrono::microseconds roundTrip;    // Smoothed
+            std::chrono::microseconds minRoundTrip; // Of the recent samples
+            std::chrono::microseconds jitter;       // Smoothed deviation of the round trip
+            std::size_t samples;                    // PONGs received
+    };
+
+    ///
+    /// @brief Event of an ENTITY_EVENT, decoded on the IO thread and handed to the main thread by pollEvent()
+    ///
+    struct NetworkEvent
+    {
+            std::uint32_t serverTick = 0; // 0 in the legacy format without one
+            rnp::EventType type = rnp::EventType::CUSTOM;
+            std::uint32_t entityId = 0;
+            std::uint8_t size = 0;
+            std::array<std::uint8_t, 255> data{}; // The most an event carries
+
+            [[nodiscard]] std::span<const std::uint8_t> bytes() const { return std::span(data).first(size); }
+    };
+
     ///
     /// @class INetworkClient
     /// @brief Interface for the client network
@@ -25,13 +55,18 @@ namespace eng
     class INetworkClient : public utl::IPlugin
     {
         public:
-            using PacketHandler = std::function<void(const rnp::PacketHeader &, const std::vector<uint8_t> &)>;
+            using PacketHandler = std::function<void(const rnp::PacketHeader &, std::span<const uint8_t>)>;
+            using EventsHandler = std::function<void(const rnp::EventRange &)>;
 
             virtual ~INetworkClient() = default;
 
             // Connection management
             virtual void connect(const std::string &host, uint16_t port) = 0;
             virtual void disconnect() = 0;
+            ///
+            /// @brief Send every datagram through a simulated degraded link, to test on loopback
+            ///
+            virtual void setLinkConditions(const rnp::LinkConditions &conditions) = 0;
 
             // Protocol messages
             virtual void sendConnect(const std::string &playerName) = 0;
@@ -47,12 +82,31 @@ namespace eng
 
             // Handler management
             virtual void setPacketHandler(rnp::PacketType type, PacketHandler handler) = 0;
-            virtual void setEventsHandler(std::function<void(const std::vector<rnp::EventRecord> &)> handler) = 0;
+            virtual void setEventsHandler(EventsHandler handler) = 0;
+            ///
+            /// @brief Take the oldest event received, from the main thread
+            /// Events wait in a bounded lock-free ring filled by the IO thread, the newest are dropped when it is full.
+            ///
+            virtual bool pollEvent(NetworkEvent &event) = 0;
+
+            // Replication
+            ///
+            /// @brief Take the latest complete WORLD_STATE snapshot, if a new one arrived since the last call
+            /// The snapshot is swapped with the caller's, whose buffers are recycled for the next decode.
+            ///
+            virtual bool pollWorldState(rnp::PacketWorldState &snapshot) = 0;
 
             // Getters
             virtual std::uint32_t getSessionId() const = 0;
             virtual std::uint16_t getServerTickRate() const = 0;
 
+            // Clock
+            ///
+            /// @brief Tick, fractional, the server is at right now, or std::nullopt until clocks are synchronized
+            ///
+            virtual std::optional<double> getServerTickEstimate() const = 0;
+            virtual ClockStats getClockStats() const = 0;
+
         private:
     }; // class INetworkClient
 
@@ -6,12 +6,15 @@
 
 #pragma once
 
+#include <chrono>
 #include <cstdint>
-#include <functional>
+#include <span>
 #include <string>
 #include <vector>
 
+#include "Interfaces/Protocol/LinkConditioner.hpp"
 #include "Interfaces/Protocol/Protocol.hpp"
+#include "Utils/BufferPool.hpp"
 #include "Utils/Interfaces/IPlugin.hpp"
 
 namespace srv
@@ -21,6 +24,49 @@ namespace srv
     constexpr size_t MAX_IP_LENGTH = 8;
     constexpr size_t MAX_LEN_RECV_BUFFER = 1024;
 
+    ///
+    /// @brief Player id addressing an event to every player, no player has it
+    ///
+    constexpr std::uint16_t EVERY_PLAYER = 0;
+
+    ///
+    /// @brief Axis-aligned area of the world, in world units
+    ///
+    struct Viewport
+    {
+            float x;
+            float y;
+            float width;
+            float height;
+    };
+
+    ///
+    /// @brief Buffers holding the data of received messages, an event's data or a player name fits in one
+    ///
+    using MessagePool = utl::BufferPool<256, 1024>;
+
+    ///
+    /// @brief What a client did, decoded on the IO thread and handed to the simulation by pollMessage()
+    ///
+    struct NetworkMessage
+    {
+            enum class Kind : std::uint8_t
+            {
+                CONNECT,    // data: player name
+                DISCONNECT, // Left, timed out or replaced by a new session
+                INPUT,      // Each input once, in the order it was sent
+                EVENT,      // Other client event, data: its TLV data
+            };
+
+            Kind kind = Kind::CONNECT;
+            std::uint16_t playerId = 0;
+            std::uint32_t entityId = 0;
+            rnp::EventType eventType = rnp::EventType::INPUT;
+            rnp::InputEventData input{};
+            std::chrono::microseconds viewDelay{0}; // INPUT: how long before its arrival its sender saw the world
+            MessagePool::Lease data{};
+    };
+
     ///
     /// @class INetworkServer
     /// @brief Interface for the server network
@@ -38,6 +84,38 @@ namespace srv
             // Configuration
             virtual void setTickRate(std::uint16_t tickRate) = 0;
             virtual void setServerCapabilities(std::uint32_t caps) = 0;
+            ///
+            /// @brief Send every datagram through a simulated degraded link, to test on loopback
+            ///
+            virtual void setLinkConditions(const rnp::LinkConditions &conditions) = 0;
+
+            // Replication
+            virtual void broadcastWorldState(std::uint32_t serverTick, std::span<const rnp::EntityState> entities) = 0;
+            ///
+            /// @brief Area of the world shown to players, only entities around it are sent to them
+            /// Players and ALWAYS_RELEVANT entities are always sent. Until it is set, every entity is.
+            ///
+            virtual void setViewport(const Viewport &viewport) = 0;
+            ///
+            /// @brief Bytes of entity data each client may receive per snapshot, 0 for no limit but the datagrams
+            /// When changes do not fit, the most important entities are sent first and the others accumulate
+            /// priority until they are.
+            ///
+            virtual void setSnapshotBudget(std::size_t bytes) = 0;
+            ///
+            /// @brief Send an event of the simulation to a player, or to every one, with the next world state
+            /// Reliable events (rnp::reliableEventFlags) are sent reliable and in order, as relayed client events.
+            ///
+            virtual void sendEvent(std::uint16_t playerId, rnp::EventType type, std::uint32_t entityId,
+                                   std::span<const std::uint8_t> data) = 0;
+
+            // Inputs
+            ///
+            /// @brief Take the oldest message received, from the simulation thread, usually until false each tick
+            /// Inputs come each once and in the order they were sent. Messages wait in a bounded lock-free ring, the
+            /// newest are dropped when it is full.
+            ///
+            [[nodiscard]] virtual bool pollMessage(NetworkMessage &message) = 0;
 
         private:
     }; // class INetworkServer
@@ -0,0 +1,140 @@
+///
+/// @file Batch.hpp
+/// @brief This file contains the BATCH packet framing, which coalesces small messages into one datagram
+/// @namespace rnp
+///
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+#include "Interfaces/Protocol/Protocol.hpp"
+
+namespace rnp
+{
+
+    ///
+    /// @brief Whether an unreliable message may wait in a MessageBatch for the network tick
+    /// A PONG leaves at once, the peer times the round trip with it. So do the packets that open or close a session:
+    /// the batch of a session ended by a DISCONNECT goes with it.
+    ///
+    [[nodiscard]] constexpr bool batchable(const PacketType type)
+    {
+        switch (type)
+        {
+            case PacketType::CONNECT_ACCEPT:
+            case PacketType::DISCONNECT:
+            case PacketType::PONG:
+            case PacketType::BATCH:
+                return false;
+            default:
+                return true;
+        }
+    }
+
+    ///
+    /// @brief Call visit(PacketType, std::span<const uint8_t>) for every message of a BATCH payload, in order
+    /// @return false, without visiting anything, if an entry is truncated or is itself a BATCH
+    ///
+    template <typename Visit> bool forEachBatched(const std::span<const std::uint8_t> payload, Visit &&visit)
+    {
+        const auto walk = [payload](const auto &onEntry)
+        {
+            BufferReader reader(payload);
+            BatchEntryHeader entry{};
+            while (reader.remaining() != 0)
+            {
+                if (!read(reader, entry) || entry.type == static_cast<std::uint8_t>(PacketType::BATCH))
+                {
+                    return false;
+                }
+                const std::span<const std::uint8_t> bytes = reader.readBytes(entry.length);
+                if (!reader.ok())
+                {
+                    return false;
+                }
+                onEntry(static_cast<PacketType>(entry.type), bytes);
+            }
+            return true;
+        };
+        if (!walk([](PacketType, std::span<const std::uint8_t>) {}))
+        {
+            return false;
+        }
+        return walk(visit);
+    }
+
+    ///
+    /// @class MessageBatch
+    /// @brief Unreliable messages queued for one peer until the next network tick, never allocates
+    /// Messages are encoded in place after their BatchEntryHeader. A batch holding a single message is sent as that
+    /// plain message, saving the entry header.
+    /// @namespace rnp
+    ///
+    class MessageBatch
+    {
+        public:
+            ///
+            /// @brief Room for the payload of one more message, in a batch of at most capacity payload bytes
+            /// Encode the message there, then commit() it.
+            /// @return std::nullopt if not even the entry header fits
+            ///
+            [[nodiscard]] std::optional<std::span<std::uint8_t>> reserve(const std::size_t capacity)
+            {
+                const std::size_t used = m_size + WIRE_SIZE<BatchEntryHeader>;
+                const std::size_t limit = std::min(capacity, m_bytes.size());
+                if (used > limit)
+                {
+                    return std::nullopt;
+                }
+                return std::span<std::uint8_t>(m_bytes).subspan(used, limit - used);
+            }
+
+            void commit(const PacketType type, const std::size_t length)
+            {
+                BufferWriter writer(std::span<std::uint8_t>(m_bytes).subspan(m_size, WIRE_SIZE<BatchEntryHeader>));
+                write(writer, BatchEntryHeader{.type = static_cast<std::uint8_t>(type),
+                                               .length = static_cast<std::uint16_t>(length)});
+                if (m_count == 0)
+                {
+                    m_firstType = type;
+                }
+                m_size += WIRE_SIZE<BatchEntryHeader> + length;
+                ++m_count;
+            }
+
+            [[nodiscard]] bool empty() const { return m_count == 0; }
+            [[nodiscard]] std::size_t count() const { return m_count; }
+
+            ///
+            /// @brief Packet type to send: the lone message's own type, BATCH otherwise
+            ///
+            [[nodiscard]] PacketType type() const { return m_count == 1 ? m_firstType : PacketType::BATCH; }
+
+            ///
+            /// @brief Payload to send, matching type()
+            ///
+            [[nodiscard]] std::span<const std::uint8_t> payload() const
+            {
+                const auto bytes = std::span<const std::uint8_t>(m_bytes).first(m_size);
+                return m_count == 1 ? bytes.subspan(WIRE_SIZE<BatchEntryHeader>) : bytes;
+            }
+
+            void clear()
+            {
+                m_size = 0;
+                m_count = 0;
+            }
+
+        private:
+            std::array<std::uint8_t, MAX_PAYLOAD> m_bytes; // Only m_size bytes are read
+            std::size_t m_size = 0;
+            std::size_t m_count = 0;
+            PacketType m_firstType = PacketType::BATCH;
+    }; // class MessageBatch
+
+} // namespace rnp
@@ -0,0 +1,162 @@
+///
+/// @file BitStream.hpp
+/// @brief This file contains bit-level writers and readers over preallocated byte spans
+/// @namespace rnp
+///
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+
+namespace rnp
+{
+
+    ///
+    /// @brief Map signed values to unsigned ones so that small magnitudes stay small (0, -1, 1, -2 -> 0, 1, 2, 3)
+    ///
+    [[nodiscard]] constexpr std::uint32_t zigzagEncode(const std::int32_t value) noexcept
+    {
+        return (static_cast<std::uint32_t>(value) << 1U) ^ static_cast<std::uint32_t>(value >> 31);
+    }
+
+    [[nodiscard]] constexpr std::int32_t zigzagDecode(const std::uint32_t value) noexcept
+    {
+        return static_cast<std::int32_t>((value >> 1U) ^ (~(value & 1U) + 1U));
+    }
+
+    ///
+    /// @brief Encoded size of a varint: 7 bits of payload per byte
+    ///
+    [[nodiscard]] constexpr std::size_t varintBits(std::uint32_t value) noexcept
+    {
+        std::size_t bits = 8;
+        while (value >= 0x80)
+        {
+            value >>= 7U;
+            bits += 8;
+        }
+        return bits;
+    }
+
+    ///
+    /// @class BitWriter
+    /// @brief Appends bit fields most significant bit first to a caller-owned span, never allocates
+    /// Whole bytes written on a byte boundary are laid out exactly like BufferWriter's big endian scalars.
+    /// A write that does not fit is dropped and leaves the writer in a failed state.
+    /// @namespace rnp
+    ///
+    class BitWriter
+    {
+        public:
+            explicit BitWriter(const std::span<std::uint8_t> buffer) : m_buffer(buffer) {}
+
+            void writeBits(const std::uint32_t value, unsigned count) noexcept
+            {
+                if (!m_ok || count > 32 || count > remainingBits())
+                {
+                    m_ok = false;
+                    return;
+                }
+                while (count > 0)
+                {
+                    const unsigned used = static_cast<unsigned>(m_bitPos % 8);
+                    const unsigned take = std::min(8U - used, count);
+                    const std::uint32_t bits = (value >> (count - take)) & ((1U << take) - 1U);
+                    std::uint8_t &byte = m_buffer[m_bitPos / 8];
+
+                    if (used == 0)
+                    {
+                        byte = 0;
+                    }
+                    byte = static_cast<std::uint8_t>(byte | (bits << (8U - used - take)));
+                    m_bitPos += take;
+                    count -= take;
+                }
+            }
+
+            void writeBool(const bool value) noexcept { writeBits(value ? 1U : 0U, 1); }
+
+            void writeVarint(std::uint32_t value) noexcept
+            {
+                while (value >= 0x80)
+                {
+                    writeBits((value & 0x7FU) | 0x80U, 8);
+                    value >>= 7U;
+                }
+                writeBits(value, 8);
+            }
+
+            [[nodiscard]] bool ok() const { return m_ok; }
+            [[nodiscard]] std::size_t bitSize() const { return m_bitPos; }
+            /// Bytes touched so far, the last one zero padded
+            [[nodiscard]] std::size_t size() const { return (m_bitPos + 7) / 8; }
+            [[nodiscard]] std::size_t remainingBits() const { return m_buffer.size() * 8 - m_bitPos; }
+
+        private:
+            std::span<std::uint8_t> m_buffer;
+            std::size_t m_bitPos = 0;
+            bool m_ok = true;
+    }; // class BitWriter
+
+    ///
+    /// @class BitReader
+    /// @brief Consumes bit fields most significant bit first from a span, never allocates
+    /// Reading past the end yields zero values and leaves the reader in a failed state.
+    /// @namespace rnp
+    ///
+    class BitReader
+    {
+        public:
+            explicit BitReader(const std::span<const std::uint8_t> buffer) : m_buffer(buffer) {}
+
+            [[nodiscard]] std::uint32_t readBits(unsigned count) noexcept
+            {
+                if (!m_ok || count > 32 || count > remainingBits())
+                {
+                    m_ok = false;
+                    return 0;
+                }
+                std::uint32_t value = 0;
+                while (count > 0)
+                {
+                    const unsigned used = static_cast<unsigned>(m_bitPos % 8);
+                    const unsigned take = std::min(8U - used, count);
+                    const std::uint32_t bits = (m_buffer[m_bitPos / 8] >> (8U - used - take)) & ((1U << take) - 1U);
+
+                    value = (value << take) | bits;
+                    m_bitPos += take;
+                    count -= take;
+                }
+                return value;
+            }
+
+            [[nodiscard]] bool readBool() noexcept { return readBits(1) != 0; }
+
+            [[nodiscard]] std::uint32_t readVarint() noexcept
+            {
+                std::uint32_t value = 0;
+                for (unsigned shift = 0; shift < 35; shift += 7)
+                {
+                    const std::uint32_t byte = readBits(8);
+                    value |= (byte & 0x7FU) << shift;
+                    if ((byte & 0x80U) == 0)
+                    {
+                        return value;
+                    }
+                }
+                m_ok = false;
+                return 0;
+            }
+
+            [[nodiscard]] bool ok() const { return m_ok; }
+            [[nodiscard]] std::size_t remainingBits() const { return m_buffer.size() * 8 - m_bitPos; }
+
+        private:
+            std::span<const std::uint8_t> m_buffer;
+            std::size_t m_bitPos = 0;
+            bool m_ok = true;
+    }; // class BitReader
+
+} // namespace rnp
@@ -0,0 +1,205 @@
+///
+/// @file Buffer.hpp
+/// @brief This file contains big endian writers and readers over preallocated byte spans
+/// @namespace rnp
+///
+
+#pragma once
+
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
+
+namespace rnp
+{
+
+    ///
+    /// @brief Types that can be stored as a single big endian scalar on the wire
+    ///
+    template <typename T>
+    concept WireScalar = (std::is_arithmetic_v<T> || std::is_enum_v<T>) &&
+                         (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+
+    namespace detail
+    {
+        template <std::size_t Size> struct UnsignedOfSize;
+        template <> struct UnsignedOfSize<1>
+        {
+                using type = std::uint8_t;
+        };
+        template <> struct UnsignedOfSize<2>
+        {
+                using type = std::uint16_t;
+        };
+        template <> struct UnsignedOfSize<4>
+        {
+                using type = std::uint32_t;
+        };
+        template <> struct UnsignedOfSize<8>
+        {
+                using type = std::uint64_t;
+        };
+
+        template <WireScalar T> using Bits = typename UnsignedOfSize<sizeof(T)>::type;
+
+        template <std::unsigned_integral U> [[nodiscard]] constexpr U swapToNetwork(const U bits) noexcept
+        {
+            if constexpr (sizeof(U) > 1 && std::endian::native == std::endian::little)
+            {
+                return std::byteswap(bits);
+            }
+            else
+            {
+                return bits;
+            }
+        }
+    } // namespace detail
+
+    ///
+    /// @brief Store a scalar in network byte order, caller guarantees sizeof(T) bytes at dst
+    ///
+    template <WireScalar T> void storeBE(std::uint8_t *dst, const T value) noexcept
+    {
+        const auto bits = detail::swapToNetwork(std::bit_cast<detail::Bits<T>>(value));
+        std::memcpy(dst, &bits, sizeof(bits));
+    }
+
+    ///
+    /// @brief Load a scalar stored in network byte order, caller guarantees sizeof(T) bytes at src
+    ///
+    template <WireScalar T> [[nodiscard]] T loadBE(const std::uint8_t *src) noexcept
+    {
+        detail::Bits<T> bits;
+        std::memcpy(&bits, src, sizeof(bits));
+        return std::bit_cast<T>(detail::swapToNetwork(bits));
+    }
+
+    ///
+    /// @class BufferWriter
+    /// @brief Appends big endian fields to a caller-owned span, never allocates
+    /// A write that does not fit is dropped and leaves the writer in a failed state.
+    /// @namespace rnp
+    ///
+    class BufferWriter
+    {
+        public:
+            explicit BufferWriter(const std::span<std::uint8_t> buffer) : m_buffer(buffer) {}
+
+            template <WireScalar T> void write(const T value) noexcept
+            {
+                if (reserve(sizeof(T)))
+                {
+                    storeBE(m_buffer.data() + m_size - sizeof(T), value);
+                }
+            }
+
+            void writeBytes(const std::span<const std::uint8_t> bytes) noexcept
+            {
+                if (!bytes.empty() && reserve(bytes.size()))
+                {
+                    std::memcpy(m_buffer.data() + m_size - bytes.size(), bytes.data(), bytes.size());
+                }
+            }
+
+            void writeZeros(const std::size_t count) noexcept
+            {
+                if (count > 0 && reserve(count))
+                {
+                    std::memset(m_buffer.data() + m_size - count, 0, count);
+                }
+            }
+
+            ///
+            /// @brief Overwrite an already written scalar, used to patch counts and lengths
+            ///
+            template <WireScalar T> void writeAt(const std::size_t offset, const T value) noexcept
+            {
+                if (offset + sizeof(T) <= m_size)
+                {
+                    storeBE(m_buffer.data() + offset, value);
+                }
+                else
+                {
+                    m_ok = false;
+                }
+            }
+
+            [[nodiscard]] bool ok() const { return m_ok; }
+            [[nodiscard]] std::size_t size() const { return m_size; }
+            [[nodiscard]] std::size_t remaining() const { return m_buffer.size() - m_size; }
+            [[nodiscard]] std::span<std::uint8_t> written() const { return m_buffer.first(m_size); }
+
+        private:
+            bool reserve(const std::size_t count) noexcept
+            {
+                if (!m_ok || count > m_buffer.size() - m_size)
+                {
+                    m_ok = false;
+                    return false;
+                }
+                m_size += count;
+                return true;
+            }
+
+            std::span<std::uint8_t> m_buffer;
+            std::size_t m_size = 0;
+            bool m_ok = true;
+    }; // class BufferWriter
+
+    ///
+    /// @class BufferReader
+    /// @brief Consumes big endian fields from a span, never allocates
+    /// Reading past the end yields zero values and leaves the reader in a failed state.
+    /// @namespace rnp
+    ///
+    class BufferReader
+    {
+        public:
+            explicit BufferReader(const std::span<const std::uint8_t> buffer) : m_buffer(buffer) {}
+
+            template <WireScalar T> [[nodiscard]] T read() noexcept
+            {
+                if (!consume(sizeof(T)))
+                {
+                    return T{};
+                }
+                return loadBE<T>(m_buffer.data() + m_offset - sizeof(T));
+            }
+
+            [[nodiscard]] std::span<const std::uint8_t> readBytes(const std::size_t count) noexcept
+            {
+                if (!consume(count))
+                {
+                    return {};
+                }
+                return m_buffer.subspan(m_offset - count, count);
+            }
+
+            void skip(const std::size_t count) noexcept { (void)consume(count); }
+
+            [[nodiscard]] bool ok() const { return m_ok; }
+            [[nodiscard]] std::size_t offset() const { return m_offset; }
+            [[nodiscard]] std::size_t remaining() const { return m_buffer.size() - m_offset; }
+            [[nodiscard]] std::span<const std::uint8_t> rest() const { return m_buffer.subspan(m_offset); }
+
+        private:
+            bool consume(const std::size_t count) noexcept
+            {
+                if (!m_ok || count > m_buffer.size() - m_offset)
+                {
+                    m_ok = false;
+                    return false;
+                }
+                m_offset += count;
+                return true;
+            }
+
+            std::span<const std::uint8_t> m_buffer;
+            std::size_t m_offset = 0;
+            bool m_ok = true;
+    }; // class BufferReader
+
+} // namespace rnp
@@ -0,0 +1,205 @@
+///
+/// @file Channel.hpp
+/// @brief This file contains the message channels multiplexed over the packet layer and their delivery rules
+/// @namespace rnp
+///
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "Interfaces/Protocol/Protocol.hpp"
+
+namespace rnp
+{
+
+    ///
+    /// @brief Delivery guarantees, carried in the high 4 bits of PacketHeader::channel
+    ///
+    enum class Channel : std::uint8_t
+    {
+        UNRELIABLE = 0,           // Handled on arrival, may be lost (input, ping, acks)
+        UNRELIABLE_SEQUENCED = 1, // Anything older than the newest message received is dropped (snapshots)
+        RELIABLE_UNORDERED = 2,   // Retransmitted until acknowledged, handled on arrival (connection control)
+        RELIABLE_ORDERED = 3      // Retransmitted and handled in send order (SPAWN, DESPAWN, SCORE events)
+    };
+
+    inline constexpr std::size_t CHANNEL_COUNT = 4;
+
+    ///
+    /// @brief Per-channel message sequence, in the low 12 bits of PacketHeader::channel
+    ///
+    inline constexpr std::uint16_t CHANNEL_SEQUENCE_MASK = 0x0FFF;
+
+    ///
+    /// @brief Reliable ordered messages ahead of the next expected one that a receiver holds
+    ///
+    inline constexpr std::uint16_t ORDERED_WINDOW = 32;
+    static_assert((CHANNEL_SEQUENCE_MASK + 1) % ORDERED_WINDOW == 0, "Held slots are indexed by sequence");
+
+    [[nodiscard]] constexpr Channel channelOf(const PacketHeader &header)
+    {
+        return static_cast<Channel>(header.channel >> 12U);
+    }
+
+    [[nodiscard]] constexpr std::uint16_t channelSequenceOf(const PacketHeader &header)
+    {
+        return header.channel & CHANNEL_SEQUENCE_MASK;
+    }
+
+    ///
+    /// @brief Signed distance from b to a in the 12-bit channel sequence space
+    ///
+    [[nodiscard]] constexpr int channelDistance(const std::uint16_t a, const std::uint16_t b)
+    {
+        const int distance = (a - b) & CHANNEL_SEQUENCE_MASK;
+        return distance > CHANNEL_SEQUENCE_MASK / 2 ? distance - CHANNEL_SEQUENCE_MASK - 1 : distance;
+    }
+
+    ///
+    /// @brief Channel a packet travels on: snapshots are sequenced, reliable entity events ordered and other
+    /// reliable packets unordered
+    ///
+    [[nodiscard]] constexpr Channel channelFor(const PacketType type, const std::uint16_t flags)
+    {
+        if (type == PacketType::WORLD_STATE)
+        {
+            return Channel::UNRELIABLE_SEQUENCED;
+        }
+        if ((flags & static_cast<std::uint16_t>(PacketFlags::RELIABLE)) == 0)
+        {
+            return Channel::UNRELIABLE;
+        }
+        return type == PacketType::ENTITY_EVENT ? Channel::RELIABLE_ORDERED : Channel::RELIABLE_UNORDERED;
+    }
+
+    ///
+    /// @class ChannelSender
+    /// @brief Numbers the messages of the sequenced and ordered channels of one session
+    /// Every fragment, chunk or retransmission of one message carries the same stamp.
+    /// @namespace rnp
+    ///
+    class ChannelSender
+    {
+        public:
+            ///
+            /// @brief PacketHeader::channel value of the next message on channel
+            ///
+            [[nodiscard]] std::uint16_t stamp(const Channel channel)
+            {
+                const auto index = static_cast<std::size_t>(channel);
+                std::uint16_t sequence = 0;
+                if (channel == Channel::UNRELIABLE_SEQUENCED || channel == Channel::RELIABLE_ORDERED)
+                {
+                    sequence = m_next[index];
+                    m_next[index] = (m_next[index] + 1U) & CHANNEL_SEQUENCE_MASK;
+                }
+                return static_cast<std::uint16_t>(index << 12U | sequence);
+            }
+
+        private:
+            std::array<std::uint16_t, CHANNEL_COUNT> m_next{};
+    }; // class ChannelSender
+
+    ///
+    /// @class ChannelReceiver
+    /// @brief Applies the delivery rule of each channel to the messages of one session
+    /// Reliable ordered messages received ahead of a missing one are held until it arrives, head-of-line blocking
+    /// only that channel. Held payloads are kept in reused buffers, which stop allocating once warm.
+    /// @namespace rnp
+    ///
+    class ChannelReceiver
+    {
+        public:
+            enum class Delivery : std::uint8_t
+            {
+                DELIVER, // Handle it now, then drain popReady()
+                HOLD,    // Copied, popReady() returns it once the messages before it were delivered
+                DROP     // Stale or duplicate
+            };
+
+            ///
+            /// @brief Whether a packet may be acknowledged: an ordered message beyond the window is left
+            /// unacknowledged, the sender retransmits it once the gap is filled
+            ///
+            [[nodiscard]] bool admits(const PacketHeader &header) const
+            {
+                return channelOf(header) != Channel::RELIABLE_ORDERED ||
+                       channelDistance(channelSequenceOf(header), m_expected) < ORDERED_WINDOW;
+            }
+
+            [[nodiscard]] Delivery receive(const PacketHeader &header, const std::span<const std::uint8_t> payload)
+            {
+                const std::uint16_t sequence = channelSequenceOf(header);
+                switch (channelOf(header))
+                {
+                    case Channel::UNRELIABLE_SEQUENCED:
+                    {
+                        if (m_sequenced && channelDistance(sequence, m_newest) < 0)
+                        {
+                            return Delivery::DROP;
+                        }
+                        m_sequenced = true;
+                        m_newest = sequence;
+                        return Delivery::DELIVER;
+                    }
+                    case Channel::RELIABLE_ORDERED:
+                    {
+                        const int distance = channelDistance(sequence, m_expected);
+                        if (distance == 0)
+                        {
+                            m_expected = (m_expected + 1U) & CHANNEL_SEQUENCE_MASK;
+                            return Delivery::DELIVER;
+                        }
+                        Held &held = m_held[sequence % ORDERED_WINDOW];
+                        if (distance < 0 || distance >= ORDERED_WINDOW || held.waiting)
+                        {
+                            return Delivery::DROP;
+                        }
+                        held.waiting = true;
+                        held.header = header;
+                        held.payload.assign(payload.begin(), payload.end());
+                        return Delivery::HOLD;
+                    }
+                    default:
+                        return Delivery::DELIVER;
+                }
+            }
+
+            ///
+            /// @brief Take the next held ordered message if it is now in order
+            /// The payload is swapped into the caller's buffer, whose capacity is recycled.
+            ///
+            [[nodiscard]] bool popReady(PacketHeader &header, std::vector<std::uint8_t> &payload)
+            {
+                Held &held = m_held[m_expected % ORDERED_WINDOW];
+                if (!held.waiting || channelSequenceOf(held.header) != m_expected)
+                {
+                    return false;
+                }
+                held.waiting = false;
+                header = held.header;
+                std::swap(payload, held.payload);
+                m_expected = (m_expected + 1U) & CHANNEL_SEQUENCE_MASK;
+                return true;
+            }
+
+        private:
+            struct Held
+            {
+                    bool waiting = false;
+                    PacketHeader header{};
+                    std::vector<std::uint8_t> payload;
+            };
+
+            bool m_sequenced = false;
+            std::uint16_t m_newest = 0;
+            std::uint16_t m_expected = 0;
+            std::array<Held, ORDERED_WINDOW> m_held;
+    }; // class ChannelReceiver
+
+} // namespace rnp
@@ -0,0 +1,311 @@
+///
+/// @file Compression.hpp
+/// @brief This file contains the LZ payload codec behind the COMPRESSED flag and its dictionary trainer
+/// @namespace rnp
+///
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "Interfaces/Protocol/Buffer.hpp"
+
+namespace rnp
+{
+
+    ///
+    /// @brief Largest static dictionary, match offsets reach back into it from any point of a payload
+    ///
+    inline constexpr std::size_t MAX_DICTIONARY_SIZE = 4096;
+
+    ///
+    /// @brief Payloads shorter than this are sent as is, a sequence header would eat most of the gain
+    ///
+    inline constexpr std::size_t MIN_COMPRESSED_PAYLOAD = 32;
+
+    ///
+    /// @class LzCodec
+    /// @brief Byte oriented LZ77 codec in the LZ4 block style, with an optional static prefix dictionary
+    /// A payload is a series of sequences: token (literal count << 4 | match length - 4), extra literal count bytes,
+    /// literals, then unless the payload ends there a big endian 16-bit match offset and extra match length bytes.
+    /// A nibble of 15 is continued by bytes added to it until one is below 255.
+    /// The match finder is a single-probe hash table kept on the stack: compress() and decompress() are const,
+    /// allocation free and safe to call from several threads once the dictionary is set.
+    /// @namespace rnp
+    ///
+    class LzCodec
+    {
+        public:
+            LzCodec() = default;
+            explicit LzCodec(const std::span<const std::uint8_t> dictionary) { setDictionary(dictionary); }
+
+            ///
+            /// @brief Install the dictionary, only its last MAX_DICTIONARY_SIZE bytes are kept
+            ///
+            void setDictionary(std::span<const std::uint8_t> dictionary)
+            {
+                if (dictionary.size() > MAX_DICTIONARY_SIZE)
+                {
+                    dictionary = dictionary.last(MAX_DICTIONARY_SIZE);
+                }
+                std::ranges::copy(dictionary, m_dictionary.begin());
+                m_dictionarySize = dictionary.size();
+                m_dictionaryTable.fill(0);
+                for (std::size_t i = 0; i + MIN_MATCH <= m_dictionarySize; ++i)
+                {
+                    m_dictionaryTable[hash(loadBE<std::uint32_t>(m_dictionary.data() + i))] =
+                        static_cast<std::uint16_t>(i + 1);
+                }
+            }
+
+            [[nodiscard]] std::span<const std::uint8_t> dictionary() const
+            {
+                return std::span(m_dictionary).first(m_dictionarySize);
+            }
+
+            ///
+            /// @brief Compress input into output
+            /// @return the compressed size, or std::nullopt when it does not fit output (size output smaller than
+            /// input to only keep payloads that shrink)
+            ///
+            [[nodiscard]] std::optional<std::size_t> compress(const std::span<const std::uint8_t> input,
+                                                              const std::span<std::uint8_t> output,
+                                                              const bool useDictionary) const
+            {
+                if (input.size() > MAX_INPUT_SIZE)
+                {
+                    return std::nullopt;
+                }
+                // Positions are counted from the start of the dictionary, which virtually precedes the input
+                const std::size_t dictSize = useDictionary ? m_dictionarySize : 0;
+                std::array<std::uint16_t, HASH_SIZE> table{};
+                if (useDictionary)
+                {
+                    table = m_dictionaryTable;
+                }
+                const auto byteAt = [&](const std::size_t pos) -> std::uint32_t
+                { return pos < dictSize ? m_dictionary[pos] : input[pos - dictSize]; };
+
+                BufferWriter writer(output);
+                std::size_t anchor = 0;
+                std::size_t pos = 0;
+                while (pos + MIN_MATCH <= input.size())
+                {
+                    const auto value = loadBE<std::uint32_t>(input.data() + pos);
+                    std::uint16_t &slot = table[hash(value)];
+                    const std::size_t candidate = slot;
+                    slot = static_cast<std::uint16_t>(dictSize + pos + 1);
+                    if (candidate == 0 || (byteAt(candidate - 1) << 24U | byteAt(candidate) << 16U |
+                                           byteAt(candidate + 1) << 8U | byteAt(candidate + 2)) != value)
+                    {
+                        ++pos;
+                        continue;
+                    }
+
+                    const std::size_t match = candidate - 1;
+                    std::size_t length = MIN_MATCH;
+                    while (pos + length < input.size() && byteAt(match + length) == input[pos + length])
+                    {
+                        ++length;
+                    }
+                    writeSequence(writer, input.subspan(anchor, pos - anchor), dictSize + pos - match, length);
+                    pos += length;
+                    anchor = pos;
+                }
+                writeSequence(writer, input.subspan(anchor), 0, 0);
+                return writer.ok() ? std::optional(writer.size()) : std::nullopt;
+            }
+
+            ///
+            /// @brief Decompress input into output, every length and offset is bounds checked
+            /// @return the decompressed size, or std::nullopt if input is malformed or does not fit output
+            ///
+            [[nodiscard]] std::optional<std::size_t> decompress(const std::span<const std::uint8_t> input,
+                                                                const std::span<std::uint8_t> output,
+                                                                const bool useDictionary) const
+            {
+                const std::size_t dictSize = useDictionary ? m_dictionarySize : 0;
+                BufferReader reader(input);
+                std::size_t size = 0;
+
+                while (reader.remaining() > 0)
+                {
+                    const auto token = reader.read<std::uint8_t>();
+                    const std::size_t literalCount = readLength(reader, token >> 4U);
+                    const std::span<const std::uint8_t> literals = reader.readBytes(literalCount);
+                    if (!reader.ok() || literals.size() > output.size() - size)
+                    {
+                        return std::nullopt;
+                    }
+                    std::ranges::copy(literals, output.begin() + static_cast<std::ptrdiff_t>(size));
+                    size += literals.size();
+                    if (reader.remaining() == 0)
+                    {
+                        break;
+                    }
+
+                    const auto offset = reader.read<std::uint16_t>();
+                    const std::size_t length = readLength(reader, token & 0x0FU) + MIN_MATCH;
+                    if (!reader.ok() || offset == 0 || offset > size + dictSize || length > output.size() - size)
+                    {
+                        return std::nullopt;
+                    }
+                    // Byte by byte: a match may overlap the bytes it produces, or start in the dictionary
+                    for (std::size_t i = 0; i < length; ++i, ++size)
+                    {
+                        output[size] = offset > size ? m_dictionary[dictSize + size - offset] : output[size - offset];
+                    }
+                }
+                return size;
+            }
+
+        private:
+            static constexpr std::size_t MIN_MATCH = 4;
+            static constexpr unsigned HASH_BITS = 11;
+            static constexpr std::size_t HASH_SIZE = std::size_t{1} << HASH_BITS;
+            // Table entries hold dictionary + input positions plus one in 16 bits
+            static constexpr std::size_t MAX_INPUT_SIZE = 0xFFFF - MAX_DICTIONARY_SIZE - 1;
+
+            [[nodiscard]] static std::size_t hash(const std::uint32_t value)
+            {
+                return (value * 2654435761U) >> (32U - HASH_BITS);
+            }
+
+            static void writeLength(BufferWriter &writer, std::size_t length)
+            {
+                for (; length >= 0xFF; length -= 0xFF)
+                {
+                    writer.write(std::uint8_t{0xFF});
+                }
+                writer.write(static_cast<std::uint8_t>(length));
+            }
+
+            [[nodiscard]] static std::size_t readLength(BufferReader &reader, const std::size_t nibble)
+            {
+                std::size_t length = nibble;
+                if (nibble == 0x0F)
+                {
+                    std::uint8_t extra = 0xFF;
+                    while (extra == 0xFF && reader.ok())
+                    {
+                        extra = reader.read<std::uint8_t>();
+                        length += extra;
+                    }
+                }
+                return length;
+            }
+
+            ///
+            /// @brief Append literals and, when length is not zero, a back reference of length bytes at offset
+            ///
+            static void writeSequence(BufferWriter &writer, const std::span<const std::uint8_t> literals,
+                                      const std::size_t offset, const std::size_t length)
+            {
+                const std::size_t matchNibble = length == 0 ? 0 : std::min<std::size_t>(length - MIN_MATCH, 0x0F);
+                const std::size_t literalNibble = std::min<std::size_t>(literals.size(), 0x0F);
+
+                writer.write(static_cast<std::uint8_t>(literalNibble << 4U | matchNibble));
+                if (literalNibble == 0x0F)
+                {
+                    writeLength(writer, literals.size() - 0x0F);
+                }
+                writer.writeBytes(literals);
+                if (length != 0)
+                {
+                    writer.write(static_cast<std::uint16_t>(offset));
+                    if (matchNibble == 0x0F)
+                    {
+                        writeLength(writer, length - MIN_MATCH - 0x0F);
+                    }
+                }
+            }
+
+            std::array<std::uint8_t, MAX_DICTIONARY_SIZE> m_dictionary{};
+            std::size_t m_dictionarySize = 0;
+            std::array<std::uint16_t, HASH_SIZE> m_dictionaryTable{}; // Match finder state after the dictionary
+    }; // class LzCodec
+
+    ///
+    /// @brief Build a static dictionary from recorded payloads
+    /// Greedily keeps the segmentSize byte windows whose 8-byte substrings are the most frequent across samples,
+    /// each pick discounting the substrings it covers, until no window repeats. The best segments end up last,
+    /// closest to the payload. Meant to run offline, it allocates freely.
+    ///
+    [[nodiscard]] inline std::vector<std::uint8_t>
+        trainDictionary(const std::span<const std::vector<std::uint8_t>> samples,
+                        const std::size_t capacity = MAX_DICTIONARY_SIZE, const std::size_t segmentSize = 32)
+    {
+        constexpr std::size_t GRAM = 8;
+        if (segmentSize < GRAM)
+        {
+            return {};
+        }
+
+        // Give every distinct 8-byte substring an index, then count its occurrences
+        std::unordered_map<std::uint64_t, std::uint32_t> gramIndex;
+        std::vector<std::vector<std::uint32_t>> grams(samples.size());
+        std::vector<std::uint64_t> frequency;
+        for (std::size_t s = 0; s < samples.size(); ++s)
+        {
+            for (std::size_t pos = 0; pos + GRAM <= samples[s].size(); ++pos)
+            {
+                std::uint64_t gram = 0;
+                std::memcpy(&gram, samples[s].data() + pos, GRAM);
+                const auto [it, inserted] = gramIndex.try_emplace(gram, static_cast<std::uint32_t>(frequency.size()));
+                if (inserted)
+                {
+                    frequency.push_back(0);
+                }
+                ++frequency[it->second];
+                grams[s].push_back(it->second);
+            }
+        }
+
+        const std::size_t gramsPerSegment = segmentSize - GRAM + 1;
+        std::vector<std::uint8_t> dictionary;
+        while (dictionary.size() + segmentSize <= std::min(capacity, MAX_DICTIONARY_SIZE))
+        {
+            std::size_t bestSample = 0;
+            std::size_t bestPos = 0;
+            std::uint64_t bestScore = 0;
+            for (std::size_t s = 0; s < samples.size(); ++s)
+            {
+                // Sliding sum of the frequencies of the substrings inside the window
+                std::uint64_t score = 0;
+                for (std::size_t pos = 0; pos < grams[s].size(); ++pos)
+                {
+                    score += frequency[grams[s][pos]];
+                    if (pos >= gramsPerSegment)
+                    {
+                        score -= frequency[grams[s][pos - gramsPerSegment]];
+                    }
+                    if (pos + 1 >= gramsPerSegment && score > bestScore)
+                    {
+                        bestScore = score;
+                        bestSample = s;
+                        bestPos = pos + 1 - gramsPerSegment;
+                    }
+                }
+            }
+            if (bestScore < 2 * gramsPerSegment)
+            {
+                break;
+            }
+            for (std::size_t i = 0; i < gramsPerSegment; ++i)
+            {
+                frequency[grams[bestSample][bestPos + i]] = 0;
+            }
+            const auto segment = samples[bestSample].begin() + static_cast<std::ptrdiff_t>(bestPos);
+            dictionary.insert(dictionary.begin(), segment, segment + static_cast<std::ptrdiff_t>(segmentSize));
+        }
+        return dictionary;
+    }
+
+} // namespace rnp
@@ -0,0 +1,134 @@
+///
+/// @file Delta.hpp
+/// @brief This file contains the field-mask delta codec used by WORLD_STATE snapshots
+/// @namespace rnp
+///
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Interfaces/Protocol/Protocol.hpp"
+
+namespace rnp
+{
+
+    ///
+    /// @brief Members that can be sent individually, the Nth member is gated by bit N of a field mask
+    ///
+    template <auto... FieldList> struct MaskedFields
+    {
+            static_assert(sizeof...(FieldList) <= 8, "A field mask is a single byte");
+
+            static constexpr std::uint8_t ALL = static_cast<std::uint8_t>((1U << sizeof...(FieldList)) - 1U);
+
+            ///
+            /// @brief Mask of the members that differ between baseline and current
+            ///
+            template <typename T> [[nodiscard]] static std::uint8_t diff(const T &baseline, const T &current) noexcept
+            {
+                unsigned mask = 0;
+                unsigned bit = 1;
+                ((mask |= baseline.*FieldList != current.*FieldList ? bit : 0U, bit <<= 1U), ...);
+                return static_cast<std::uint8_t>(mask);
+            }
+    };
+
+    ///
+    /// @brief Delta-encodable members of EntityState, in field mask bit order
+    ///
+    using EntityStateFields = MaskedFields<&EntityState::type, &EntityState::x, &EntityState::y, &EntityState::vx,
+                                           &EntityState::vy, &EntityState::stateFlags>;
+
+    ///
+    /// @brief Find an entity in a snapshot sorted by id
+    ///
+    [[nodiscard]] inline const EntityState *findEntity(const std::span<const EntityState> snapshot,
+                                                       const std::uint32_t id)
+    {
+        const auto it = std::ranges::lower_bound(snapshot, id, {}, &EntityState::id);
+        return it != snapshot.end() && it->id == id ? &*it : nullptr;
+    }
+
+    ///
+    /// @brief Walk two snapshots sorted by id, reporting entities gone from current
+    ///
+    template <typename OnRemoved>
+    void forEachRemoved(const std::span<const EntityState> baseline, const std::span<const EntityState> current,
+                        OnRemoved &&onRemoved)
+    {
+        auto it = current.begin();
+        for (const EntityState &entity : baseline)
+        {
+            while (it != current.end() && it->id < entity.id)
+            {
+                ++it;
+            }
+            if (it == current.end() || it->id != entity.id)
+            {
+                onRemoved(entity.id);
+            }
+        }
+    }
+
+    ///
+    /// @brief Walk two snapshots sorted by id, reporting new and modified entities with the mask of fields to send
+    /// diff(baseline, current) returns the mask of an entity present in both, new entities get every field.
+    ///
+    template <typename Diff, typename OnChanged>
+    void forEachChanged(const std::span<const EntityState> baseline, const std::span<const EntityState> current,
+                        Diff &&diff, OnChanged &&onChanged)
+    {
+        auto it = baseline.begin();
+        for (const EntityState &entity : current)
+        {
+            while (it != baseline.end() && it->id < entity.id)
+            {
+                ++it;
+            }
+            const std::uint8_t mask =
+                it != baseline.end() && it->id == entity.id ? diff(*it, entity) : EntityStateFields::ALL;
+            if (mask != 0)
+            {
+                onChanged(entity, mask);
+            }
+        }
+    }
+
+    ///
+    /// @brief Rebuild a snapshot from its baseline, the changed entities and the removed ids
+    /// updates and removed are sorted in place, out is overwritten and stays sorted by id.
+    ///
+    inline void applyDelta(const std::span<const EntityState> baseline, const std::span<EntityState> updates,
+                           const std::span<std::uint32_t> removed, std::vector<EntityState> &out)
+    {
+        std::ranges::sort(updates, {}, &EntityState::id);
+        std::ranges::sort(removed);
+
+        out.clear();
+        auto base = baseline.begin();
+        auto update = updates.begin();
+        while (base != baseline.end() || update != updates.end())
+        {
+            if (update == updates.end() || (base != baseline.end() && base->id < update->id))
+            {
+                if (!std::ranges::binary_search(removed, base->id))
+                {
+                    out.push_back(*base);
+                }
+                ++base;
+                continue;
+            }
+            if (base != baseline.end() && base->id == update->id)
+            {
+                ++base;
+            }
+            out.push_back(*update);
+            ++update;
+        }
+    }
+
+} // namespace rnp
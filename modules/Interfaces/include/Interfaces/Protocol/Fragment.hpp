@@ -0,0 +1,205 @@
+///
+/// @file Fragment.hpp
+/// @brief This file contains the FRAG flag splitting and reassembly of payloads larger than one datagram
+/// @namespace rnp
+///
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+
+#include "Interfaces/Protocol/Protocol.hpp"
+
+namespace rnp
+{
+
+    ///
+    /// @brief Upper bound of fragments per message, lets receivers track them in a 64-bit mask
+    ///
+    inline constexpr std::size_t MAX_FRAGMENTS = 64;
+
+    ///
+    /// @brief Largest message bytes carried by one fragment, after its FragmentHeader
+    ///
+    inline constexpr std::size_t MAX_FRAGMENT_PAYLOAD = MAX_PAYLOAD - WIRE_SIZE<FragmentHeader>;
+
+    ///
+    /// @brief Largest payload a FRAG message can carry
+    ///
+    inline constexpr std::size_t MAX_MESSAGE_SIZE = MAX_FRAGMENTS * MAX_FRAGMENT_PAYLOAD;
+    static_assert(MAX_MESSAGE_SIZE <= 0xFFFF, "A reassembled payload length must fit PacketHeader::length");
+
+    ///
+    /// @brief Split message in fragmentSize pieces, calling emit(header, bytes) for each one in order
+    /// @return false, without emitting anything, if the message needs more than MAX_FRAGMENTS fragments
+    ///
+    template <typename Emit>
+    bool forEachFragment(const std::span<const std::uint8_t> message, const std::size_t fragmentSize,
+                         const std::uint16_t fragId, Emit &&emit)
+    {
+        if (fragmentSize == 0 || message.empty() || message.size() > fragmentSize * MAX_FRAGMENTS)
+        {
+            return false;
+        }
+        const std::size_t count = (message.size() + fragmentSize - 1) / fragmentSize;
+        for (std::size_t index = 0; index < count; ++index)
+        {
+            const std::size_t offset = index * fragmentSize;
+            const FragmentHeader header{.fragId = fragId,
+                                        .fragIndex = static_cast<std::uint16_t>(index),
+                                        .fragCount = static_cast<std::uint16_t>(count)};
+            emit(header, message.subspan(offset, std::min(fragmentSize, message.size() - offset)));
+        }
+        return true;
+    }
+
+    ///
+    /// @class FragmentReassembler
+    /// @brief Rebuilds FRAG messages of one peer in preallocated slots, never allocates
+    /// Up to SlotCount messages of at most MaxFragments fragments are assembled at once. A slot is recycled when its
+    /// message completes, when it stays incomplete longer than the timeout, or when a newer message needs room and
+    /// it is the oldest. Duplicate fragments, and late copies of recently completed messages, are ignored.
+    /// @namespace rnp
+    ///
+    template <std::size_t MaxFragments, std::size_t SlotCount> class FragmentReassembler
+    {
+            static_assert(MaxFragments > 0 && MaxFragments <= MAX_FRAGMENTS, "Fragments are tracked in a 64-bit mask");
+            static_assert(SlotCount > 0);
+
+        public:
+            using Clock = std::chrono::steady_clock;
+
+            static constexpr std::chrono::milliseconds DEFAULT_TIMEOUT{1000};
+
+            explicit FragmentReassembler(const std::chrono::milliseconds timeout = DEFAULT_TIMEOUT) : m_timeout(timeout)
+            {
+            }
+
+            ///
+            /// @brief Store one fragment
+            /// @return the whole message once its last missing fragment arrived, std::nullopt otherwise
+            /// The returned bytes live in the reassembler and stay valid until the next call to push().
+            ///
+            [[nodiscard]] std::optional<std::span<const std::uint8_t>>
+                push(const FragmentHeader &header, const std::span<const std::uint8_t> fragment,
+                     const Clock::time_point now = Clock::now())
+            {
+                if (header.fragCount == 0 || header.fragCount > MaxFragments || header.fragIndex >= header.fragCount ||
+                    fragment.size() > MAX_FRAGMENT_PAYLOAD)
+                {
+                    return std::nullopt;
+                }
+                expire(now);
+                if (wasCompleted(header.fragId))
+                {
+                    return std::nullopt;
+                }
+
+                Slot &slot = slotFor(header, now);
+                if (slot.fragCount != header.fragCount)
+                {
+                    // Same id, different layout: never mix two messages, drop both
+                    slot.active = false;
+                    return std::nullopt;
+                }
+                const std::uint64_t bit = std::uint64_t{1} << header.fragIndex;
+                if ((slot.received & bit) != 0)
+                {
+                    return std::nullopt;
+                }
+                std::memcpy(slot.bytes.data() + header.fragIndex * MAX_FRAGMENT_PAYLOAD, fragment.data(),
+                            fragment.size());
+                slot.lengths[header.fragIndex] = static_cast<std::uint16_t>(fragment.size());
+                slot.received |= bit;
+
+                const std::uint64_t all =
+                    header.fragCount == MAX_FRAGMENTS ? ~std::uint64_t{0} : (std::uint64_t{1} << header.fragCount) - 1U;
+                if (slot.received != all)
+                {
+                    return std::nullopt;
+                }
+
+                // Fragments sit at a fixed stride, pack them so the message is contiguous
+                std::size_t size = slot.lengths[0];
+                for (std::size_t i = 1; i < slot.fragCount; ++i)
+                {
+                    std::memmove(slot.bytes.data() + size, slot.bytes.data() + i * MAX_FRAGMENT_PAYLOAD,
+                                 slot.lengths[i]);
+                    size += slot.lengths[i];
+                }
+                slot.active = false;
+                m_completed[m_completedCount++ % m_completed.size()] = header.fragId;
+                return std::span<const std::uint8_t>(slot.bytes.data(), size);
+            }
+
+            ///
+            /// @brief Drop messages left incomplete for longer than the timeout
+            ///
+            void expire(const Clock::time_point now)
+            {
+                for (Slot &slot : m_slots)
+                {
+                    if (slot.active && now - slot.firstSeen > m_timeout)
+                    {
+                        slot.active = false;
+                    }
+                }
+            }
+
+        private:
+            struct Slot
+            {
+                    bool active = false;
+                    std::uint16_t fragId = 0;
+                    std::uint16_t fragCount = 0;
+                    std::uint64_t received = 0;
+                    Clock::time_point firstSeen{};
+                    std::array<std::uint16_t, MaxFragments> lengths{};
+                    std::array<std::uint8_t, MaxFragments * MAX_FRAGMENT_PAYLOAD> bytes; // Only lengths bytes are read
+            };
+
+            [[nodiscard]] bool wasCompleted(const std::uint16_t fragId) const
+            {
+                const auto completed =
+                    std::span(m_completed).first(std::min(m_completedCount, m_completed.size()));
+                return std::ranges::find(completed, fragId) != completed.end();
+            }
+
+            ///
+            /// @brief Slot assembling header.fragId, or a fresh one taken from the free or oldest slot
+            ///
+            Slot &slotFor(const FragmentHeader &header, const Clock::time_point now)
+            {
+                Slot *target = &m_slots.front();
+                for (Slot &slot : m_slots)
+                {
+                    if (slot.active && slot.fragId == header.fragId)
+                    {
+                        return slot;
+                    }
+                    if (target->active && (!slot.active || slot.firstSeen < target->firstSeen))
+                    {
+                        target = &slot;
+                    }
+                }
+                target->active = true;
+                target->fragId = header.fragId;
+                target->fragCount = header.fragCount;
+                target->received = 0;
+                target->firstSeen = now;
+                return *target;
+            }
+
+            std::array<Slot, SlotCount> m_slots;
+            std::array<std::uint16_t, 2 * SlotCount> m_completed{}; // Ids of the last completed messages
+            std::size_t m_completedCount = 0;
+            std::chrono::milliseconds m_timeout;
+    }; // class FragmentReassembler
+
+} // namespace rnp
@@ -0,0 +1,150 @@
+///
+/// @file Input.hpp
+/// @brief This file contains the redundant encoding of the last input frames of a client in INPUT_FRAMES events
+/// @namespace rnp
+///
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <span>
+
+#include "Interfaces/Protocol/Buffer.hpp"
+#include "Interfaces/Protocol/Protocol.hpp"
+
+namespace rnp
+{
+
+    ///
+    /// @brief Input frames carried by one INPUT_FRAMES event: a packet may be lost MAX_INPUT_FRAMES - 1 times in a
+    /// row without losing an input
+    ///
+    inline constexpr std::size_t MAX_INPUT_FRAMES = 8;
+
+    ///
+    /// @brief Largest INPUT_FRAMES data: the newest frame in full, each older one with all its fields changed
+    ///
+    inline constexpr std::size_t MAX_INPUT_FRAMES_SIZE = 3 + WIRE_SIZE<InputEventData> + (MAX_INPUT_FRAMES - 1) * 7;
+
+    struct InputFrame
+    {
+            std::uint16_t sequence;
+            InputEventData input;
+    };
+
+    ///
+    /// @brief Whether input sequence a comes after b, across wrap-around
+    ///
+    [[nodiscard]] constexpr bool isNewerInput(const std::uint16_t a, const std::uint16_t b)
+    {
+        return static_cast<std::int16_t>(a - b) > 0;
+    }
+
+    ///
+    /// @class InputHistory
+    /// @brief Last MAX_INPUT_FRAMES inputs of a client, numbered, written together in every INPUT_FRAMES event
+    /// Data: sequence(2) of the newest frame | frame_count(1) | newest InputEventData | then each older frame,
+    /// newest first: changes(1) | time_delta_ms(2) | the fields of changes, in order. Bit 0 of changes is
+    /// buttons, bit 1 direction, bit 2 shooting, and time_delta_ms the client time before the next newer frame.
+    /// A held input costs 3 bytes per redundant frame.
+    /// @namespace rnp
+    ///
+    class InputHistory
+    {
+        public:
+            ///
+            /// @brief Append an input, numbered after the previous one
+            ///
+            std::uint16_t push(const InputEventData &input)
+            {
+                ++m_sequence;
+                m_frames[m_sequence % MAX_INPUT_FRAMES] = input;
+                m_count = std::min(m_count + 1, MAX_INPUT_FRAMES);
+                return m_sequence;
+            }
+
+            [[nodiscard]] bool empty() const { return m_count == 0; }
+
+            void write(BufferWriter &writer) const
+            {
+                writer.write(m_sequence);
+                writer.write(static_cast<std::uint8_t>(m_count));
+                const InputEventData *newer = &frame(0);
+                rnp::write(writer, *newer);
+                for (std::size_t age = 1; age < m_count; ++age)
+                {
+                    const InputEventData &older = frame(age);
+                    const std::uint8_t changes = (older.buttons != newer->buttons ? BUTTONS : 0) |
+                                                 (older.direction != newer->direction ? DIRECTION : 0) |
+                                                 (older.shooting != newer->shooting ? SHOOTING : 0);
+                    writer.write(changes);
+                    writer.write(static_cast<std::uint16_t>(newer->clientTimeMs - older.clientTimeMs));
+                    if ((changes & BUTTONS) != 0)
+                    {
+                        writer.write(older.buttons);
+                    }
+                    if ((changes & DIRECTION) != 0)
+                    {
+                        writer.write(older.direction);
+                    }
+                    if ((changes & SHOOTING) != 0)
+                    {
+                        writer.write(older.shooting);
+                    }
+                    newer = &older;
+                }
+            }
+
+            ///
+            /// @brief Call visit(const InputFrame &) for every frame of INPUT_FRAMES data, oldest first
+            /// @return false, without visiting anything, if the data is truncated or holds no frame
+            ///
+            template <typename Visit> static bool forEachFrame(const std::span<const std::uint8_t> data, Visit &&visit)
+            {
+                BufferReader reader(data);
+                const auto sequence = reader.read<std::uint16_t>();
+                const auto count = reader.read<std::uint8_t>();
+                std::array<InputEventData, MAX_INPUT_FRAMES> frames{};
+                if (!reader.ok() || count == 0 || count > MAX_INPUT_FRAMES || !read(reader, frames[0]))
+                {
+                    return false;
+                }
+                for (std::size_t age = 1; age < count; ++age)
+                {
+                    const InputEventData &newer = frames[age - 1];
+                    InputEventData &older = frames[age];
+                    const auto changes = reader.read<std::uint8_t>();
+                    older.clientTimeMs = newer.clientTimeMs - reader.read<std::uint16_t>();
+                    older.buttons = (changes & BUTTONS) != 0 ? reader.read<std::uint16_t>() : newer.buttons;
+                    older.direction = (changes & DIRECTION) != 0 ? reader.read<std::uint8_t>() : newer.direction;
+                    older.shooting = (changes & SHOOTING) != 0 ? reader.read<std::uint8_t>() : newer.shooting;
+                }
+                if (!reader.ok())
+                {
+                    return false;
+                }
+                for (std::size_t age = count; age-- > 0;)
+                {
+                    visit(InputFrame{.sequence = static_cast<std::uint16_t>(sequence - age), .input = frames[age]});
+                }
+                return true;
+            }
+
+        private:
+            static constexpr std::uint8_t BUTTONS = 0x01;
+            static constexpr std::uint8_t DIRECTION = 0x02;
+            static constexpr std::uint8_t SHOOTING = 0x04;
+
+            [[nodiscard]] const InputEventData &frame(const std::size_t age) const
+            {
+                return m_frames[static_cast<std::uint16_t>(m_sequence - age) % MAX_INPUT_FRAMES];
+            }
+
+            std::array<InputEventData, MAX_INPUT_FRAMES> m_frames{}; // By sequence
+            std::uint16_t m_sequence = 0;
+            std::size_t m_count = 0;
+    }; // class InputHistory
+
+} // namespace rnp
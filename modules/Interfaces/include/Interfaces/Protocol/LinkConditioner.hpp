@@ -0,0 +1,236 @@
+///
+/// @file LinkConditioner.hpp
+/// @brief This file contains the simulation of a degraded link datagrams can be sent through, for local testing
+/// @namespace rnp
+///
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace rnp
+{
+
+    ///
+    /// @brief What the simulated link does to each datagram sent through it
+    /// Probabilities are in [0, 1]. Loss is uniform in the good state of a Gilbert-Elliott chain and burstLoss in its
+    /// bad state, entered with probability burstEnter and left with burstExit at each datagram: leave burstEnter at
+    /// 0 for uniform loss only.
+    ///
+    struct LinkConditions
+    {
+            std::chrono::microseconds latency{0}; // One way
+            std::chrono::microseconds jitter{0};  // Uniform extra delay, up to this
+            double loss = 0.0;
+            double burstEnter = 0.0;
+            double burstExit = 1.0;
+            double burstLoss = 1.0;
+            double duplicate = 0.0;
+            double reorder = 0.0; // Held back by reorderDelay, later datagrams overtake it
+            std::chrono::microseconds reorderDelay{20000};
+            std::size_t bandwidthBytesPerSecond = 0; // 0 for no cap
+            std::size_t queueBytes = 64 * 1024;      // Bottleneck queue, the tail is dropped beyond it
+            std::uint64_t seed = 1;                  // Same seed and traffic, same decisions
+    };
+
+    ///
+    /// @brief Read LinkConditions from a JSON object of the config files, any key may be missing
+    /// Keys: latency_ms, jitter_ms, loss, burst_enter, burst_exit, burst_loss, duplicate, reorder, reorder_ms,
+    /// bandwidth_kbps, queue_bytes, seed.
+    ///
+    template <typename Json> [[nodiscard]] LinkConditions linkConditionsFromJson(const Json &json)
+    {
+        LinkConditions conditions;
+        const auto millis = [&json](const char *key, std::chrono::microseconds &field)
+        {
+            if (json.contains(key))
+            {
+                field = std::chrono::microseconds(static_cast<std::int64_t>(json[key].template get<double>() * 1000));
+            }
+        };
+        const auto value = [&json](const char *key, auto &field)
+        {
+            if (json.contains(key))
+            {
+                field = json[key].template get<std::remove_reference_t<decltype(field)>>();
+            }
+        };
+        millis("latency_ms", conditions.latency);
+        millis("jitter_ms", conditions.jitter);
+        value("loss", conditions.loss);
+        value("burst_enter", conditions.burstEnter);
+        value("burst_exit", conditions.burstExit);
+        value("burst_loss", conditions.burstLoss);
+        value("duplicate", conditions.duplicate);
+        value("reorder", conditions.reorder);
+        millis("reorder_ms", conditions.reorderDelay);
+        if (json.contains("bandwidth_kbps"))
+        {
+            conditions.bandwidthBytesPerSecond = json["bandwidth_kbps"].template get<std::size_t>() * 1000 / 8;
+        }
+        value("queue_bytes", conditions.queueBytes);
+        value("seed", conditions.seed);
+        return conditions;
+    }
+
+    ///
+    /// @class LinkConditioner
+    /// @brief Decides, for each datagram, whether the simulated link loses, duplicates or delays it, and until when
+    /// A capped link sends one datagram at a time: each waits for the previous ones to be serialized, and one that
+    /// would wait longer than the queue holds is dropped, as a router does. The random draws come from a
+    /// splitmix64 generator, so a run repeats exactly on any platform given the same seed and traffic.
+    /// @namespace rnp
+    ///
+    class LinkConditioner
+    {
+        public:
+            using Clock = std::chrono::steady_clock;
+
+            ///
+            /// @brief Arrival times of the copies of a datagram that make it through, none if it is lost
+            ///
+            struct Delivery
+            {
+                    std::uint8_t copies = 0;
+                    std::array<Clock::time_point, 2> at{};
+            };
+
+            explicit LinkConditioner(const LinkConditions &conditions)
+                : m_conditions(conditions), m_state(conditions.seed)
+            {
+            }
+
+            [[nodiscard]] const LinkConditions &conditions() const { return m_conditions; }
+
+            [[nodiscard]] Delivery send(const Clock::time_point now, const std::size_t bytes)
+            {
+                Delivery delivery;
+                if (lost())
+                {
+                    return delivery;
+                }
+                Clock::time_point departure = now;
+                if (m_conditions.bandwidthBytesPerSecond != 0)
+                {
+                    const auto serialization = std::chrono::duration_cast<Clock::duration>(
+                        std::chrono::duration<double>(static_cast<double>(bytes) /
+                                                      static_cast<double>(m_conditions.bandwidthBytesPerSecond)));
+                    const auto queueDelay = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(
+                        static_cast<double>(m_conditions.queueBytes) /
+                        static_cast<double>(m_conditions.bandwidthBytesPerSecond)));
+                    const Clock::time_point start = std::max(now, m_linkFree);
+                    if (start - now > queueDelay)
+                    {
+                        return delivery;
+                    }
+                    m_linkFree = start + serialization;
+                    departure = m_linkFree;
+                }
+                delivery.copies = chance(m_conditions.duplicate) ? 2 : 1;
+                for (std::uint8_t copy = 0; copy < delivery.copies; ++copy)
+                {
+                    Clock::time_point arrival = departure + m_conditions.latency + uniform(m_conditions.jitter);
+                    if (chance(m_conditions.reorder))
+                    {
+                        arrival += m_conditions.reorderDelay;
+                    }
+                    delivery.at[copy] = arrival;
+                }
+                return delivery;
+            }
+
+        private:
+            [[nodiscard]] bool lost()
+            {
+                m_burst = m_burst ? !chance(m_conditions.burstExit) : chance(m_conditions.burstEnter);
+                return chance(m_burst ? m_conditions.burstLoss : m_conditions.loss);
+            }
+
+            [[nodiscard]] bool chance(const double probability)
+            {
+                return probability > 0.0 && (probability >= 1.0 || next() < probability);
+            }
+
+            [[nodiscard]] Clock::duration uniform(const std::chrono::microseconds range)
+            {
+                return std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double, std::micro>(next() * static_cast<double>(range.count())));
+            }
+
+            // splitmix64, in [0, 1)
+            [[nodiscard]] double next()
+            {
+                std::uint64_t z = (m_state += 0x9E3779B97F4A7C15ULL);
+                z = (z ^ (z >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+                z = (z ^ (z >> 27U)) * 0x94D049BB133111EBULL;
+                return static_cast<double>((z ^ (z >> 31U)) >> 11U) * 0x1.0p-53;
+            }
+
+            LinkConditions m_conditions;
+            std::uint64_t m_state;
+            bool m_burst = false;           // Gilbert-Elliott bad state
+            Clock::time_point m_linkFree{}; // When the capped link is done with the datagrams already sent
+    }; // class LinkConditioner
+
+    ///
+    /// @class DelayLine
+    /// @brief Datagrams held until their arrival time, handed out in arrival order, ties in sending order
+    /// @namespace rnp
+    ///
+    template <typename Packet> class DelayLine
+    {
+        public:
+            using Clock = std::chrono::steady_clock;
+
+            void push(const Clock::time_point at, Packet &&packet)
+            {
+                m_heap.push_back({at, m_order++, std::move(packet)});
+                std::ranges::push_heap(m_heap, later);
+            }
+
+            [[nodiscard]] std::optional<Clock::time_point> nextDue() const
+            {
+                return m_heap.empty() ? std::nullopt : std::optional(m_heap.front().at);
+            }
+
+            ///
+            /// @brief Call deliver(packet) for every packet due at now
+            ///
+            template <typename Deliver> void popDue(const Clock::time_point now, Deliver &&deliver)
+            {
+                while (!m_heap.empty() && m_heap.front().at <= now)
+                {
+                    std::ranges::pop_heap(m_heap, later);
+                    Packet packet = std::move(m_heap.back().packet);
+                    m_heap.pop_back();
+                    deliver(std::move(packet));
+                }
+            }
+
+            [[nodiscard]] std::size_t size() const { return m_heap.size(); }
+
+        private:
+            struct Entry
+            {
+                    Clock::time_point at;
+                    std::uint64_t order;
+                    Packet packet;
+            };
+
+            static bool later(const Entry &lhs, const Entry &rhs)
+            {
+                return lhs.at != rhs.at ? lhs.at > rhs.at : lhs.order > rhs.order;
+            }
+
+            std::vector<Entry> m_heap;
+            std::uint64_t m_order = 0;
+    }; // class DelayLine
+
+} // namespace rnp
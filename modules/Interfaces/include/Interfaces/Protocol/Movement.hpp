@@ -0,0 +1,79 @@
+///
+/// @file Movement.hpp
+/// @brief This file contains how an INPUT moves the entity of its player, shared by the server and the client
+/// @namespace rnp
+///
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include "Interfaces/Protocol/Protocol.hpp"
+
+namespace rnp
+{
+
+    ///
+    /// @brief Playing field, in world units: a player stays within it
+    ///
+    inline constexpr float FIELD_WIDTH = 1920.F;
+    inline constexpr float FIELD_HEIGHT = 1080.F;
+
+    ///
+    /// @brief Size of a player, its position being its top left corner
+    ///
+    inline constexpr float PLAYER_WIDTH = 66.F;
+    inline constexpr float PLAYER_HEIGHT = 34.F;
+
+    inline constexpr float PLAYER_SPEED = 500.F; // World units per second
+    inline constexpr float DIAGONAL_SPEED_MULTIPLIER = 0.707F;
+
+    ///
+    /// @brief Longest an input is held, in seconds, whatever the client time it claims
+    ///
+    inline constexpr float MAX_INPUT_STEP = 0.1F;
+
+    struct PlayerVelocity
+    {
+            float x;
+            float y;
+    };
+
+    ///
+    /// @brief Velocity of a player holding an INPUT direction, opposite directions cancel out
+    ///
+    [[nodiscard]] constexpr PlayerVelocity playerVelocity(const std::uint8_t direction)
+    {
+        const auto held = [direction](const InputDirection bit)
+        { return (direction & static_cast<std::uint8_t>(bit)) != 0 ? 1.F : 0.F; };
+        const float x = held(InputDirection::RIGHT) - held(InputDirection::LEFT);
+        const float y = held(InputDirection::DOWN) - held(InputDirection::UP);
+        const float speed = x != 0.F && y != 0.F ? PLAYER_SPEED * DIAGONAL_SPEED_MULTIPLIER : PLAYER_SPEED;
+        return {.x = x * speed, .y = y * speed};
+    }
+
+    ///
+    /// @brief Seconds an input is held: the client time since the previous input of the player, 0 for its first
+    ///
+    [[nodiscard]] constexpr float inputStep(const std::uint32_t previousTimeMs, const std::uint32_t timeMs)
+    {
+        if (previousTimeMs == 0 || static_cast<std::int32_t>(timeMs - previousTimeMs) <= 0)
+        {
+            return 0.F;
+        }
+        return std::min(static_cast<float>(timeMs - previousTimeMs) / 1000.F, MAX_INPUT_STEP);
+    }
+
+    ///
+    /// @brief Move a player at a velocity for dt seconds, within the field
+    /// The server applies every input this way and the client predicts its own player with the same function, so
+    /// both agree but for the inputs lost or not acknowledged yet.
+    ///
+    constexpr void movePlayer(float &x, float &y, const PlayerVelocity velocity, const float dt)
+    {
+        x = std::clamp(x + velocity.x * dt, 0.F, FIELD_WIDTH - PLAYER_WIDTH);
+        y = std::clamp(y + velocity.y * dt, 0.F, FIELD_HEIGHT - PLAYER_HEIGHT);
+    }
+
+} // namespace rnp
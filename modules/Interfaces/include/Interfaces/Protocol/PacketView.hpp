@@ -0,0 +1,169 @@
+///
+/// @file PacketView.hpp
+/// @brief This file contains non-owning views over received RNP datagrams
+/// @namespace rnp
+///
+
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <span>
+
+#include "Interfaces/Protocol/Buffer.hpp"
+#include "Interfaces/Protocol/Protocol.hpp"
+
+namespace rnp
+{
+
+    ///
+    /// @brief One TLV event, pointing into the received datagram
+    ///
+    struct EventView
+    {
+            EventType type;
+            std::uint32_t entityId;
+            std::span<const std::uint8_t> data;
+    };
+
+    ///
+    /// @class EventRange
+    /// @brief Iterable, bounds-checked view over an ENTITY_EVENT TLV payload
+    /// Format per event: type(1) | entity_id(4, BE) | data_len(1) | data(data_len)
+    /// The payload is validated once on construction, a truncated tail is never iterated.
+    /// @namespace rnp
+    ///
+    class EventRange
+    {
+        public:
+            static constexpr std::size_t EVENT_HEADER_SIZE = 6;
+
+            class Iterator
+            {
+                public:
+                    using value_type = EventView;
+                    using difference_type = std::ptrdiff_t;
+
+                    Iterator() = default;
+                    explicit Iterator(const std::span<const std::uint8_t> bytes) : m_bytes(bytes) {}
+
+                    [[nodiscard]] EventView operator*() const
+                    {
+                        return {.type = static_cast<EventType>(m_bytes[0]),
+                                .entityId = loadBE<std::uint32_t>(m_bytes.data() + 1),
+                                .data = m_bytes.subspan(EVENT_HEADER_SIZE, m_bytes[5])};
+                    }
+
+                    Iterator &operator++()
+                    {
+                        m_bytes = m_bytes.subspan(EVENT_HEADER_SIZE + m_bytes[5]);
+                        return *this;
+                    }
+
+                    Iterator operator++(int)
+                    {
+                        Iterator tmp = *this;
+                        ++*this;
+                        return tmp;
+                    }
+
+                    bool operator==(std::default_sentinel_t) const { return m_bytes.empty(); }
+
+                private:
+                    std::span<const std::uint8_t> m_bytes;
+            }; // class Iterator
+
+            EventRange() = default;
+            explicit EventRange(const std::span<const std::uint8_t> payload)
+            {
+                std::size_t offset = 0;
+
+                while (payload.size() - offset >= EVENT_HEADER_SIZE)
+                {
+                    const std::size_t next = offset + EVENT_HEADER_SIZE + payload[offset + 5];
+                    if (next > payload.size())
+                    {
+                        break;
+                    }
+                    offset = next;
+                    ++m_count;
+                }
+                m_valid = offset == payload.size();
+                m_bytes = payload.first(offset);
+            }
+
+            [[nodiscard]] Iterator begin() const { return Iterator(m_bytes); }
+            [[nodiscard]] std::default_sentinel_t end() const { return {}; }
+
+            [[nodiscard]] std::size_t size() const { return m_count; }
+            [[nodiscard]] bool empty() const { return m_count == 0; }
+            [[nodiscard]] bool isValid() const { return m_valid; }
+            [[nodiscard]] std::span<const std::uint8_t> bytes() const { return m_bytes; }
+
+        private:
+            std::span<const std::uint8_t> m_bytes;
+            std::size_t m_count = 0;
+            bool m_valid = true;
+    }; // class EventRange
+
+    ///
+    /// @class PacketView
+    /// @brief Non-owning view over one datagram: parsed header and payload span
+    /// The view borrows the receive buffer, it must not outlive it.
+    /// @namespace rnp
+    ///
+    class PacketView
+    {
+        public:
+            ///
+            /// @brief Parse a datagram in place
+            /// @return std::nullopt if the header is truncated, the advertised length overruns the datagram or a
+            /// PIGGYBACK_ACK trailer is missing
+            ///
+            [[nodiscard]] static std::optional<PacketView> parse(const std::span<const std::uint8_t> datagram) noexcept
+            {
+                PacketView view;
+                BufferReader reader(datagram);
+
+                if (!read(reader, view.m_header))
+                {
+                    return std::nullopt;
+                }
+                view.m_payload = reader.readBytes(view.m_header.length);
+                if (view.hasFlag(PacketFlags::PIGGYBACK_ACK))
+                {
+                    PacketAck ack{};
+                    if (read(reader, ack))
+                    {
+                        view.m_ack = ack;
+                    }
+                }
+                if (!reader.ok())
+                {
+                    return std::nullopt;
+                }
+                return view;
+            }
+
+            [[nodiscard]] const PacketHeader &header() const { return m_header; }
+            [[nodiscard]] PacketType type() const { return static_cast<PacketType>(m_header.type); }
+            [[nodiscard]] std::span<const std::uint8_t> payload() const { return m_payload; }
+            ///
+            /// @brief ACK the sender piggybacked on the packet, if any
+            ///
+            [[nodiscard]] const std::optional<PacketAck> &ack() const { return m_ack; }
+            [[nodiscard]] bool hasFlag(PacketFlags flag) const
+            {
+                return (m_header.flags & static_cast<std::uint16_t>(flag)) != 0;
+            }
+
+        private:
+            PacketView() = default;
+
+            PacketHeader m_header{};
+            std::span<const std::uint8_t> m_payload;
+            std::optional<PacketAck> m_ack;
+    }; // class PacketView
+
+} // namespace rnp
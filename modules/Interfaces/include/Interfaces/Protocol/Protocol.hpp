@@ -6,16 +6,23 @@
 
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <cstring>
+#include <span>
 #include <stdexcept>
+#include <string>
 #include <vector>
 
+#include "Interfaces/Protocol/Buffer.hpp"
+#include "Interfaces/Protocol/Schema.hpp"
+
 namespace rnp
 {
 
     inline constexpr std::uint8_t PROTOCOL_VERSION = 1;
     inline constexpr std::size_t MAX_PAYLOAD = 512;
+    inline constexpr std::size_t HEADER_SIZE = 16;
 
     ///
     /// @brief Packet types according to RNP specification
@@ -31,9 +38,16 @@ namespace rnp
         ACK = 0x07,
         ENTITY_EVENT = 0x08,
         CONNECT_ACCEPT = 0x09,
+        WORLD_STATE_ACK = 0x0A,
+        BATCH = 0x0B,
         PLAYER_INPUT = 0x03 // Deprecated: use ENTITY_EVENT with INPUT type
     };
 
+    ///
+    /// @brief Size of a table indexed by PacketType (highest type + 1)
+    ///
+    inline constexpr std::size_t PACKET_TYPE_COUNT = static_cast<std::size_t>(PacketType::BATCH) + 1;
+
     ///
     /// @brief Packet flags for reliability and fragmentation
     ///
@@ -43,9 +57,29 @@ namespace rnp
         ACK_REQ = 0x0001,
         RELIABLE = 0x0002,
         FRAG = 0x0004,
-        COMPRESSED = 0x0008
+        COMPRESSED = 0x0008,
+        PIGGYBACK_ACK = 0x0010 // A PacketAck follows the payload, outside length
     };
 
+    ///
+    /// @brief Capability bits exchanged in CONNECT client_caps / CONNECT_ACCEPT server_caps
+    /// A capability is used by a session only when both ends advertise it.
+    ///
+    enum class Capability : std::uint32_t
+    {
+        NONE = 0x00000000,
+        QUANTIZED_STATE = 0x00000001,        // Bit-packed, quantized WORLD_STATE entity records
+        LZ_COMPRESSION = 0x00000002,         // COMPRESSED payloads, LzCodec
+        COMPRESSION_DICTIONARY = 0x00000004, // COMPRESSED payloads reference the shared static dictionary
+        MESSAGE_BATCHING = 0x00000008,       // Small unreliable messages coalesced into BATCH packets
+        REDUNDANT_INPUT = 0x00000010         // Inputs sent as INPUT_FRAMES events, the last frames repeated
+    };
+
+    [[nodiscard]] constexpr bool hasCapability(const std::uint32_t caps, const Capability capability)
+    {
+        return (caps & static_cast<std::uint32_t>(capability)) != 0;
+    }
+
     ///
     /// @brief Disconnect reason codes
     ///
@@ -82,6 +116,8 @@ namespace rnp
         SCORE = 0x04,
         POWERUP = 0x05,
         INPUT = 0x06,
+        INPUT_FRAMES = 0x07, // Client to server only, the server relays each new frame as an INPUT
+        CONTROL = 0x08,      // Server to client only: the entity the inputs of the receiving client drive
         CUSTOM = 0xFF
     };
 
@@ -97,6 +133,15 @@ namespace rnp
         OBSTACLE = 0x05
     };
 
+    ///
+    /// @brief Bits of EntityState::stateFlags
+    ///
+    enum class EntityStateFlags : std::uint8_t
+    {
+        NONE = 0x00,
+        ALWAYS_RELEVANT = 0x01 // Sent to every client whatever its viewport (bosses)
+    };
+
     ///
     /// @brief Event record for ENTITY_EVENT packets (TLV format)
     ///
@@ -116,10 +161,16 @@ namespace rnp
             std::uint8_t type;       // PacketType
             std::uint16_t length;    // Payload length in bytes
             std::uint16_t flags;     // PacketFlags bitfield
-            std::uint16_t reserved;  // Must be 0
+            std::uint16_t channel;   // Channel (4 bits) | channel sequence (12 bits), see Channel.hpp
             std::uint32_t sequence;  // Per-session, monotonic sequence number
             std::uint32_t sessionId; // Server-assigned session ID
     };
+    template <> struct Schema<PacketHeader>
+        : Fields<&PacketHeader::type, &PacketHeader::length, &PacketHeader::flags, &PacketHeader::channel,
+                 &PacketHeader::sequence, &PacketHeader::sessionId, Padding{1}>
+    {
+    };
+    static_assert(WIRE_SIZE<PacketHeader> == HEADER_SIZE);
 
     ///
     /// @brief CONNECT packet payload
@@ -141,6 +192,11 @@ namespace rnp
             std::uint16_t mtuPayloadBytes;
             std::uint32_t serverCaps;
     };
+    template <> struct Schema<PacketConnectAccept>
+        : Fields<&PacketConnectAccept::sessionId, &PacketConnectAccept::tickRateHz,
+                 &PacketConnectAccept::mtuPayloadBytes, &PacketConnectAccept::serverCaps>
+    {
+    };
 
     ///
     /// @brief DISCONNECT packet payload
@@ -149,6 +205,9 @@ namespace rnp
     {
             std::uint16_t reasonCode; // DisconnectReason
     };
+    template <> struct Schema<PacketDisconnect> : Fields<&PacketDisconnect::reasonCode>
+    {
+    };
 
     ///
     /// @brief Entity state for WORLD_STATE packet
@@ -159,17 +218,65 @@ namespace rnp
             std::uint16_t type; // EntityType
             float x, y;
             float vx, vy;
-            std::uint8_t stateFlags;
+            std::uint8_t stateFlags; // EntityStateFlags bitfield
+    };
+    template <> struct Schema<EntityState>
+        : Fields<&EntityState::id, &EntityState::type, &EntityState::x, &EntityState::y, &EntityState::vx,
+                 &EntityState::vy, &EntityState::stateFlags>
+    {
+    };
+    static_assert(WIRE_SIZE<EntityState> == 23);
+
+    ///
+    /// @brief Fixed prefix of a WORLD_STATE payload
+    /// Followed by removed_count entity ids, then entity_count delta records against baseline_tick (0: full state).
+    /// A tick that does not fit one datagram is split in chunk_count chunks sharing the same server_tick.
+    ///
+    struct WorldStateHeader
+    {
+            std::uint32_t serverTick;
+            std::uint32_t baselineTick;
+            std::uint16_t entityCount;  // Entity records in this chunk
+            std::uint16_t removedCount; // Removed entity ids in this chunk
+            std::uint8_t chunkIndex;
+            std::uint8_t chunkCount;
+    };
+    template <> struct Schema<WorldStateHeader>
+        : Fields<&WorldStateHeader::serverTick, &WorldStateHeader::baselineTick, &WorldStateHeader::entityCount,
+                 &WorldStateHeader::removedCount, &WorldStateHeader::chunkIndex, &WorldStateHeader::chunkCount>
+    {
+    };
+
+    ///
+    /// @brief Upper bound of chunks per tick, lets receivers track them in a 32-bit mask
+    ///
+    inline constexpr std::size_t MAX_WORLD_STATE_CHUNKS = 32;
+
+    ///
+    /// @brief Snapshots kept on both ends to serve as delta baselines, older acks trigger a full state
+    ///
+    inline constexpr std::size_t WORLD_STATE_HISTORY = 32;
+
+    ///
+    /// @brief WORLD_STATE_ACK packet payload, last snapshot the client rebuilt
+    ///
+    struct PacketWorldStateAck
+    {
+            std::uint32_t serverTick;
+    };
+    template <> struct Schema<PacketWorldStateAck> : Fields<&PacketWorldStateAck::serverTick>
+    {
     };
 
     ///
-    /// @brief WORLD_STATE packet payload
+    /// @brief Decoded WORLD_STATE snapshot, every chunk of one server tick merged together, entities sorted by id
     ///
     struct PacketWorldState
     {
             std::uint32_t serverTick;
             std::uint16_t entityCount;
             std::vector<EntityState> entities;
+            std::uint32_t inputAck; // client_time_ms of the last own INPUT reflected, 0 if none
     };
 
     ///
@@ -180,6 +287,21 @@ namespace rnp
             std::uint32_t nonce;
             std::uint32_t sendTimeMs;
     };
+    template <> struct Schema<PacketPingPong> : Fields<&PacketPingPong::nonce, &PacketPingPong::sendTimeMs>
+    {
+    };
+
+    ///
+    /// @brief Server clock appended to PONG: the last tick sent and how long ago it was, for clock synchronization
+    ///
+    struct PacketPongClock
+    {
+            std::uint32_t serverTick;
+            std::uint32_t tickPhaseUs;
+    };
+    template <> struct Schema<PacketPongClock> : Fields<&PacketPongClock::serverTick, &PacketPongClock::tickPhaseUs>
+    {
+    };
 
     ///
     /// @brief ACK packet payload
@@ -189,6 +311,9 @@ namespace rnp
             std::uint32_t cumulativeAck;
             std::uint32_t ackBits; // 32-bit SACK window
     };
+    template <> struct Schema<PacketAck> : Fields<&PacketAck::cumulativeAck, &PacketAck::ackBits>
+    {
+    };
 
     ///
     /// @brief ERROR packet payload
@@ -209,41 +334,172 @@ namespace rnp
             std::uint16_t fragIndex;
             std::uint16_t fragCount;
     };
+    template <> struct Schema<FragmentHeader>
+        : Fields<&FragmentHeader::fragId, &FragmentHeader::fragIndex, &FragmentHeader::fragCount>
+    {
+    };
 
     ///
-    /// @brief Serialize events in ENTITY_EVENT format (TLV with entity_id)
-    /// Format per event: type(1) | entity_id(4, BE) | data_len(1) | data(data_len)
+    /// @brief Header of each message coalesced in a BATCH payload, followed by its length payload bytes
     ///
-    inline std::vector<std::uint8_t> serializeEvents(const std::vector<EventRecord> &events)
+    struct BatchEntryHeader
+    {
+            std::uint8_t type;    // PacketType
+            std::uint16_t length; // Message payload length in bytes
+    };
+    template <> struct Schema<BatchEntryHeader> : Fields<&BatchEntryHeader::type, &BatchEntryHeader::length>
     {
-        std::vector<std::uint8_t> payload;
-        payload.reserve(64);
+    };
 
-        for (const auto &ev : events)
-        {
-            const std::uint8_t dataLen = static_cast<std::uint8_t>(ev.data.size());
+    ///
+    /// @brief Fixed prefix of a server ENTITY_EVENT payload, followed by event_count TLV events
+    ///
+    struct EntityEventHeader
+    {
+            std::uint32_t serverTick;
+            std::uint16_t eventCount;
+    };
+    template <> struct Schema<EntityEventHeader>
+        : Fields<&EntityEventHeader::serverTick, &EntityEventHeader::eventCount>
+    {
+    };
 
-            // Event type (1 byte)
-            payload.push_back(static_cast<std::uint8_t>(ev.type));
+    ///
+    /// @brief SPAWN event data
+    ///
+    struct SpawnEventData
+    {
+            std::uint16_t entityType; // EntityType
+            float x, y;
+    };
+    template <> struct Schema<SpawnEventData>
+        : Fields<&SpawnEventData::entityType, &SpawnEventData::x, &SpawnEventData::y>
+    {
+    };
 
-            // Entity ID (4 bytes, big endian)
-            payload.push_back(static_cast<std::uint8_t>((ev.entityId >> 24) & 0xFF));
-            payload.push_back(static_cast<std::uint8_t>((ev.entityId >> 16) & 0xFF));
-            payload.push_back(static_cast<std::uint8_t>((ev.entityId >> 8) & 0xFF));
-            payload.push_back(static_cast<std::uint8_t>(ev.entityId & 0xFF));
+    ///
+    /// @brief DESPAWN event data
+    ///
+    struct DespawnEventData
+    {
+            std::uint8_t reason;
+    };
+    template <> struct Schema<DespawnEventData> : Fields<&DespawnEventData::reason>
+    {
+    };
+
+    ///
+    /// @brief DAMAGE event data
+    ///
+    struct DamageEventData
+    {
+            std::uint16_t amount;
+            std::uint32_t sourceId;
+    };
+    template <> struct Schema<DamageEventData> : Fields<&DamageEventData::amount, &DamageEventData::sourceId>
+    {
+    };
+
+    ///
+    /// @brief SCORE event data
+    ///
+    struct ScoreEventData
+    {
+            std::uint16_t points;
+    };
+    template <> struct Schema<ScoreEventData> : Fields<&ScoreEventData::points>
+    {
+    };
+
+    ///
+    /// @brief POWERUP event data
+    ///
+    struct PowerupEventData
+    {
+            std::uint16_t powerupType;
+    };
+    template <> struct Schema<PowerupEventData> : Fields<&PowerupEventData::powerupType>
+    {
+    };
 
-            // Data length (1 byte)
-            payload.push_back(dataLen);
+    ///
+    /// @brief INPUT event direction bits
+    ///
+    enum class InputDirection : std::uint8_t
+    {
+        NONE = 0x00,
+        UP = 0x01,
+        DOWN = 0x02,
+        LEFT = 0x04,
+        RIGHT = 0x08
+    };
 
-            // Data (dataLen bytes)
-            payload.insert(payload.end(), ev.data.begin(), ev.data.end());
+    ///
+    /// @brief INPUT event data
+    ///
+    struct InputEventData
+    {
+            std::uint16_t buttons;
+            std::uint8_t direction;
+            std::uint8_t shooting;
+            std::uint32_t clientTimeMs;
+    };
+    template <> struct Schema<InputEventData>
+        : Fields<&InputEventData::buttons, &InputEventData::direction, &InputEventData::shooting,
+                 &InputEventData::clientTimeMs>
+    {
+    };
+
+    ///
+    /// @brief Append one TLV event with raw data
+    /// Format per event: type(1) | entity_id(4, BE) | data_len(1) | data(data_len)
+    ///
+    inline void writeEvent(BufferWriter &writer, const EventType type, const std::uint32_t entityId,
+                           const std::span<const std::uint8_t> data) noexcept
+    {
+        writer.write(type);
+        writer.write(entityId);
+        writer.write(static_cast<std::uint8_t>(data.size()));
+        writer.writeBytes(data);
+    }
 
-            if (payload.size() > MAX_PAYLOAD)
+    ///
+    /// @brief Append one TLV event whose data is a described struct
+    ///
+    template <Described T>
+    void writeEvent(BufferWriter &writer, const EventType type, const std::uint32_t entityId, const T &data) noexcept
+    {
+        static_assert(WIRE_SIZE<T> <= 0xFF, "Event data must fit data_len");
+        writer.write(type);
+        writer.write(entityId);
+        writer.write(static_cast<std::uint8_t>(WIRE_SIZE<T>));
+        write(writer, data);
+    }
+
+    ///
+    /// @brief Serialize events in ENTITY_EVENT format (TLV with entity_id)
+    /// Format per event: type(1) | entity_id(4, BE) | data_len(1) | data(data_len)
+    /// The result may exceed MAX_PAYLOAD, the transport then sends it as FRAG fragments.
+    ///
+    inline std::vector<std::uint8_t> serializeEvents(const std::vector<EventRecord> &events)
+    {
+        std::size_t size = 0;
+        for (const auto &ev : events)
+        {
+            if (ev.data.size() > 0xFF)
             {
-                throw std::runtime_error("Events payload exceeds MAX_PAYLOAD");
+                throw std::runtime_error("Event data exceeds 255 bytes");
             }
+            size += 6 + ev.data.size();
+        }
+
+        std::vector<std::uint8_t> buffer(size);
+        BufferWriter writer(buffer);
+        for (const auto &ev : events)
+        {
+            writeEvent(writer, ev.type, ev.entityId, ev.data);
         }
-        return payload;
+        return buffer;
     }
 
     ///
@@ -253,35 +509,20 @@ namespace rnp
     inline std::vector<EventRecord> deserializeEvents(const std::uint8_t *payload, const std::size_t length)
     {
         std::vector<EventRecord> events;
-        std::size_t offset = 0;
+        BufferReader reader({payload, length});
 
-        while (offset < length)
+        while (reader.remaining() > 0)
         {
-            if (length - offset < 6) // type(1) + entity_id(4) + data_len(1)
+            EventRecord rec{};
+            rec.type = reader.read<EventType>();
+            rec.entityId = reader.read<std::uint32_t>();
+            const std::span<const std::uint8_t> data = reader.readBytes(reader.read<std::uint8_t>());
+            if (!reader.ok())
             {
-                throw std::runtime_error("Truncated event header in payload");
-            }
-
-            const EventType type = static_cast<EventType>(payload[offset]);
-            const std::uint32_t entityId = (static_cast<std::uint32_t>(payload[offset + 1]) << 24) |
-                                           (static_cast<std::uint32_t>(payload[offset + 2]) << 16) |
-                                           (static_cast<std::uint32_t>(payload[offset + 3]) << 8) |
-                                           static_cast<std::uint32_t>(payload[offset + 4]);
-            const std::uint8_t dataLen = payload[offset + 5];
-            offset += 6;
-
-            if (length - offset < dataLen)
-            {
-                throw std::runtime_error("Truncated event data in payload");
-            }
-
-            EventRecord rec{type, entityId, {}};
-            if (dataLen > 0)
-            {
-                rec.data.insert(rec.data.end(), payload + offset, payload + offset + dataLen);
+                throw std::runtime_error("Truncated event in payload");
             }
+            rec.data.assign(data.begin(), data.end());
             events.emplace_back(std::move(rec));
-            offset += dataLen;
         }
         return events;
     }
@@ -291,36 +532,10 @@ namespace rnp
     ///
     inline std::vector<uint8_t> serializeHeader(const PacketHeader &header)
     {
-        std::vector<uint8_t> buffer(16); // Fixed header size
-
-        buffer[0] = header.type;
-
-        // length (2 bytes, big endian)
-        buffer[1] = static_cast<uint8_t>((header.length >> 8) & 0xFF);
-        buffer[2] = static_cast<uint8_t>(header.length & 0xFF);
-
-        // flags (2 bytes, big endian)
-        buffer[3] = static_cast<uint8_t>((header.flags >> 8) & 0xFF);
-        buffer[4] = static_cast<uint8_t>(header.flags & 0xFF);
-
-        // reserved (2 bytes)
-        buffer[5] = static_cast<uint8_t>((header.reserved >> 8) & 0xFF);
-        buffer[6] = static_cast<uint8_t>(header.reserved & 0xFF);
-
-        // sequence (4 bytes, big endian)
-        buffer[7] = static_cast<uint8_t>((header.sequence >> 24) & 0xFF);
-        buffer[8] = static_cast<uint8_t>((header.sequence >> 16) & 0xFF);
-        buffer[9] = static_cast<uint8_t>((header.sequence >> 8) & 0xFF);
-        buffer[10] = static_cast<uint8_t>(header.sequence & 0xFF);
-
-        // sessionId (4 bytes, big endian)
-        buffer[11] = static_cast<uint8_t>((header.sessionId >> 24) & 0xFF);
-        buffer[12] = static_cast<uint8_t>((header.sessionId >> 16) & 0xFF);
-        buffer[13] = static_cast<uint8_t>((header.sessionId >> 8) & 0xFF);
-        buffer[14] = static_cast<uint8_t>(header.sessionId & 0xFF);
-
-        buffer[15] = 0; // Padding to 16 bytes
+        std::vector<uint8_t> buffer(HEADER_SIZE);
+        BufferWriter writer(buffer);
 
+        write(writer, header);
         return buffer;
     }
 
@@ -344,31 +559,13 @@ namespace rnp
     ///
     inline PacketHeader deserializeHeader(const uint8_t *data, const std::size_t size)
     {
-        if (size < 16)
+        PacketHeader header{};
+        BufferReader reader({data, size});
+
+        if (!read(reader, header))
         {
             throw std::runtime_error("Buffer too small for header");
         }
-
-        PacketHeader header;
-
-        header.type = data[0];
-
-        // length (2 bytes, big endian)
-        header.length = (static_cast<std::uint16_t>(data[1]) << 8) | static_cast<std::uint16_t>(data[2]);
-
-        // flags (2 bytes, big endian)
-        header.flags = (static_cast<std::uint16_t>(data[3]) << 8) | static_cast<std::uint16_t>(data[4]);
-
-        // reserved (2 bytes)
-        header.reserved = (static_cast<std::uint16_t>(data[5]) << 8) | static_cast<std::uint16_t>(data[6]);
-
-        // sequence (4 bytes, big endian)
-        header.sequence = (static_cast<std::uint32_t>(data[7]) << 24) | (static_cast<std::uint32_t>(data[8]) << 16) |
-                          (static_cast<std::uint32_t>(data[9]) << 8) | static_cast<std::uint32_t>(data[10]);
-
-        header.sessionId = (static_cast<std::uint32_t>(data[11]) << 24) | (static_cast<std::uint32_t>(data[12]) << 16) |
-                           (static_cast<std::uint32_t>(data[13]) << 8) | static_cast<std::uint32_t>(data[14]);
-
         return header;
     }
 
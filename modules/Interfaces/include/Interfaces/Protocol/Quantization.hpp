@@ -0,0 +1,222 @@
+///
+/// @file Quantization.hpp
+/// @brief This file contains the quantized, bit-packed encoding of WORLD_STATE entity records
+/// @namespace rnp
+///
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+#include "Interfaces/Protocol/BitStream.hpp"
+#include "Interfaces/Protocol/Delta.hpp"
+#include "Interfaces/Protocol/Protocol.hpp"
+
+namespace rnp
+{
+
+    ///
+    /// @brief Fixed-point mapping of [min, max] onto an unsigned integer of bits bits, out of range values are clamped
+    ///
+    struct Quantizer
+    {
+            float min;
+            float max;
+            unsigned bits;
+
+            [[nodiscard]] std::uint32_t quantize(const float value) const
+            {
+                const float steps = static_cast<float>((1U << bits) - 1U);
+                const float normalized = (std::clamp(value, min, max) - min) / (max - min);
+                return static_cast<std::uint32_t>(std::lround(normalized * steps));
+            }
+
+            [[nodiscard]] float dequantize(const std::uint32_t value) const
+            {
+                const float steps = static_cast<float>((1U << bits) - 1U);
+                return min + (static_cast<float>(value) / steps) * (max - min);
+            }
+    };
+
+    ///
+    /// @brief Precision of each quantized EntityState field
+    /// Positions cover the 1920x1080 playfield plus a spawn margin, at about 1/25th of a pixel.
+    ///
+    struct EntityQuantization
+    {
+            Quantizer x{.min = -256.F, .max = 2176.F, .bits = 16};
+            Quantizer y{.min = -256.F, .max = 1336.F, .bits = 16};
+            Quantizer vx{.min = -1024.F, .max = 1024.F, .bits = 12};
+            Quantizer vy{.min = -1024.F, .max = 1024.F, .bits = 12};
+            unsigned typeBits = 3; // EntityType values fit in 3 bits
+    };
+
+    inline constexpr EntityQuantization DEFAULT_ENTITY_QUANTIZATION{};
+
+    ///
+    /// @class EntityStateCodec
+    /// @brief Writes and reads WORLD_STATE entity ids and fields, either plain or quantized
+    /// Plain records are byte aligned big endian (id 32 bits, field mask 8 bits, raw fields).
+    /// Quantized records use a zig-zag varint id delta, a 6 bit field mask and fixed-point fields.
+    /// @namespace rnp
+    ///
+    class EntityStateCodec
+    {
+        public:
+            explicit EntityStateCodec(const bool quantized,
+                                      const EntityQuantization &quantization = DEFAULT_ENTITY_QUANTIZATION)
+                : m_quantized(quantized), m_quantization(quantization)
+            {
+            }
+
+            [[nodiscard]] bool quantized() const { return m_quantized; }
+
+            ///
+            /// @brief Fields to send, quantized fields only count as changed when their encoded value differs
+            ///
+            [[nodiscard]] std::uint8_t diff(const EntityState &baseline, const EntityState &current) const
+            {
+                std::uint8_t mask = EntityStateFields::diff(baseline, current);
+                if (m_quantized)
+                {
+                    mask = static_cast<std::uint8_t>(mask & ~quantizedEqualMask(baseline, current));
+                }
+                return mask;
+            }
+
+            [[nodiscard]] std::size_t idBits(const std::uint32_t id, const std::uint32_t previousId) const
+            {
+                return m_quantized ? varintBits(zigzagEncode(static_cast<std::int32_t>(id - previousId))) : 32;
+            }
+
+            [[nodiscard]] std::size_t recordBits(const std::uint8_t fieldMask) const
+            {
+                std::size_t bits = maskBits();
+                bits += (fieldMask & TYPE) != 0 ? (m_quantized ? m_quantization.typeBits : 16) : 0;
+                bits += (fieldMask & X) != 0 ? (m_quantized ? m_quantization.x.bits : 32) : 0;
+                bits += (fieldMask & Y) != 0 ? (m_quantized ? m_quantization.y.bits : 32) : 0;
+                bits += (fieldMask & VX) != 0 ? (m_quantized ? m_quantization.vx.bits : 32) : 0;
+                bits += (fieldMask & VY) != 0 ? (m_quantized ? m_quantization.vy.bits : 32) : 0;
+                bits += (fieldMask & FLAGS) != 0 ? 8 : 0;
+                return bits;
+            }
+
+            ///
+            /// @brief Ids are delta coded against the previous id of the same list when quantized
+            ///
+            void writeId(BitWriter &writer, const std::uint32_t id, const std::uint32_t previousId) const
+            {
+                if (m_quantized)
+                {
+                    writer.writeVarint(zigzagEncode(static_cast<std::int32_t>(id - previousId)));
+                }
+                else
+                {
+                    writer.writeBits(id, 32);
+                }
+            }
+
+            [[nodiscard]] std::uint32_t readId(BitReader &reader, const std::uint32_t previousId) const
+            {
+                if (m_quantized)
+                {
+                    return previousId + static_cast<std::uint32_t>(zigzagDecode(reader.readVarint()));
+                }
+                return reader.readBits(32);
+            }
+
+            void writeRecord(BitWriter &writer, const EntityState &entity, const std::uint8_t fieldMask) const
+            {
+                writer.writeBits(fieldMask, maskBits());
+                if ((fieldMask & TYPE) != 0)
+                {
+                    writer.writeBits(entity.type, m_quantized ? m_quantization.typeBits : 16);
+                }
+                writeFloat(writer, fieldMask & X, entity.x, m_quantization.x);
+                writeFloat(writer, fieldMask & Y, entity.y, m_quantization.y);
+                writeFloat(writer, fieldMask & VX, entity.vx, m_quantization.vx);
+                writeFloat(writer, fieldMask & VY, entity.vy, m_quantization.vy);
+                if ((fieldMask & FLAGS) != 0)
+                {
+                    writer.writeBits(entity.stateFlags, 8);
+                }
+            }
+
+            ///
+            /// @brief Read a record over entity, which holds the baseline value of the fields left out
+            ///
+            void readRecord(BitReader &reader, EntityState &entity) const
+            {
+                const auto fieldMask = static_cast<std::uint8_t>(reader.readBits(maskBits()));
+                if ((fieldMask & TYPE) != 0)
+                {
+                    entity.type =
+                        static_cast<std::uint16_t>(reader.readBits(m_quantized ? m_quantization.typeBits : 16));
+                }
+                readFloat(reader, fieldMask & X, entity.x, m_quantization.x);
+                readFloat(reader, fieldMask & Y, entity.y, m_quantization.y);
+                readFloat(reader, fieldMask & VX, entity.vx, m_quantization.vx);
+                readFloat(reader, fieldMask & VY, entity.vy, m_quantization.vy);
+                if ((fieldMask & FLAGS) != 0)
+                {
+                    entity.stateFlags = static_cast<std::uint8_t>(reader.readBits(8));
+                }
+            }
+
+        private:
+            // Field mask bits, in EntityStateFields order
+            static constexpr std::uint8_t TYPE = 0x01;
+            static constexpr std::uint8_t X = 0x02;
+            static constexpr std::uint8_t Y = 0x04;
+            static constexpr std::uint8_t VX = 0x08;
+            static constexpr std::uint8_t VY = 0x10;
+            static constexpr std::uint8_t FLAGS = 0x20;
+
+            [[nodiscard]] unsigned maskBits() const { return m_quantized ? 6 : 8; }
+
+            [[nodiscard]] std::uint8_t quantizedEqualMask(const EntityState &a, const EntityState &b) const
+            {
+                const EntityQuantization &q = m_quantization;
+                unsigned mask = 0;
+                mask |= q.x.quantize(a.x) == q.x.quantize(b.x) ? X : 0U;
+                mask |= q.y.quantize(a.y) == q.y.quantize(b.y) ? Y : 0U;
+                mask |= q.vx.quantize(a.vx) == q.vx.quantize(b.vx) ? VX : 0U;
+                mask |= q.vy.quantize(a.vy) == q.vy.quantize(b.vy) ? VY : 0U;
+                return static_cast<std::uint8_t>(mask);
+            }
+
+            void writeFloat(BitWriter &writer, const unsigned present, const float value,
+                            const Quantizer &quantizer) const
+            {
+                if (present == 0)
+                {
+                    return;
+                }
+                if (m_quantized)
+                {
+                    writer.writeBits(quantizer.quantize(value), quantizer.bits);
+                }
+                else
+                {
+                    writer.writeBits(std::bit_cast<std::uint32_t>(value), 32);
+                }
+            }
+
+            void readFloat(BitReader &reader, const unsigned present, float &value, const Quantizer &quantizer) const
+            {
+                if (present == 0)
+                {
+                    return;
+                }
+                value = m_quantized ? quantizer.dequantize(reader.readBits(quantizer.bits))
+                                    : std::bit_cast<float>(reader.readBits(32));
+            }
+
+            bool m_quantized;
+            EntityQuantization m_quantization;
+    }; // class EntityStateCodec
+
+} // namespace rnp
@@ -0,0 +1,421 @@
+///
+/// @file Reliability.hpp
+/// @brief This file contains the per-session sequence tracking, SACK aggregation and retransmission of RELIABLE packets
+/// @namespace rnp
+///
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+
+#include "Interfaces/Protocol/Buffer.hpp"
+#include "Interfaces/Protocol/Channel.hpp"
+#include "Interfaces/Protocol/Protocol.hpp"
+
+namespace rnp
+{
+
+    ///
+    /// @brief Sequence numbers acknowledged by the ackBits of an ACK, below its cumulativeAck
+    ///
+    inline constexpr std::uint32_t ACK_WINDOW = 32;
+
+    ///
+    /// @brief Bounds of the retransmission timeout, whatever the RTT estimate and the backoff
+    ///
+    inline constexpr std::chrono::milliseconds MIN_RETRANSMIT_TIMEOUT{200};
+    inline constexpr std::chrono::milliseconds MAX_RETRANSMIT_TIMEOUT{1600};
+
+    ///
+    /// @brief Retransmissions of a RELIABLE packet before the sender gives up on it, or on the session when the packet
+    /// is on the reliable ordered channel
+    ///
+    inline constexpr std::uint8_t MAX_RETRANSMITS = 6;
+
+    ///
+    /// @brief Longest an owed ACK waits to be aggregated with the next ones or piggybacked on a packet, also the
+    /// retransmission timer period
+    ///
+    inline constexpr std::chrono::milliseconds ACK_DELAY{10};
+
+    ///
+    /// @brief Whether an ACK covers sequence, either as its cumulativeAck or through one of its ackBits
+    ///
+    [[nodiscard]] inline bool isAcknowledged(const PacketAck &ack, const std::uint32_t sequence)
+    {
+        const std::uint32_t distance = ack.cumulativeAck - sequence;
+        return distance == 0 || (distance <= ACK_WINDOW && ((ack.ackBits >> (distance - 1)) & 1U) != 0);
+    }
+
+    ///
+    /// @brief Flags of an ENTITY_EVENT batch: SPAWN, DESPAWN, SCORE and CONTROL must survive loss (and travel on
+    /// the reliable ordered channel), the other events are superseded
+    ///
+    template <typename Events> [[nodiscard]] std::uint16_t reliableEventFlags(const Events &events)
+    {
+        const auto mustArrive = [](const auto &event)
+        {
+            return event.type == EventType::SPAWN || event.type == EventType::DESPAWN ||
+                   event.type == EventType::SCORE || event.type == EventType::CONTROL;
+        };
+        const bool reliable = std::ranges::any_of(events, mustArrive);
+        return reliable ? static_cast<std::uint16_t>(static_cast<std::uint16_t>(PacketFlags::RELIABLE) |
+                                                     static_cast<std::uint16_t>(PacketFlags::ACK_REQ))
+                        : std::uint16_t{0};
+    }
+
+    ///
+    /// @class RttEstimator
+    /// @brief Smoothed round trip time and retransmission timeout of a session, as in RFC 6298
+    /// Only packets acknowledged without being retransmitted are sampled (Karn's algorithm).
+    /// @namespace rnp
+    ///
+    class RttEstimator
+    {
+        public:
+            void sample(const std::chrono::steady_clock::duration rtt)
+            {
+                const auto measured = std::chrono::duration_cast<std::chrono::microseconds>(rtt);
+                if (!m_smoothed)
+                {
+                    m_smoothed = measured;
+                    m_variation = measured / 2;
+                    return;
+                }
+                const std::chrono::microseconds error =
+                    measured > *m_smoothed ? measured - *m_smoothed : *m_smoothed - measured;
+                m_variation = (3 * m_variation + error) / 4;
+                m_smoothed = (7 * *m_smoothed + measured) / 8;
+            }
+
+            [[nodiscard]] std::optional<std::chrono::microseconds> smoothed() const { return m_smoothed; }
+
+            ///
+            /// @brief Timeout of a packet sent retransmits times: the estimate doubled on every retransmission
+            ///
+            [[nodiscard]] std::chrono::microseconds timeout(const std::uint8_t retransmits = 0) const
+            {
+                std::chrono::microseconds base = MIN_RETRANSMIT_TIMEOUT;
+                if (m_smoothed)
+                {
+                    base = std::clamp<std::chrono::microseconds>(*m_smoothed + 4 * m_variation,
+                                                                 MIN_RETRANSMIT_TIMEOUT, MAX_RETRANSMIT_TIMEOUT);
+                }
+                for (std::uint8_t i = 0; i < retransmits && base < MAX_RETRANSMIT_TIMEOUT; ++i)
+                {
+                    base *= 2;
+                }
+                return std::min<std::chrono::microseconds>(base, MAX_RETRANSMIT_TIMEOUT);
+            }
+
+        private:
+            std::optional<std::chrono::microseconds> m_smoothed;
+            std::chrono::microseconds m_variation{0};
+    }; // class RttEstimator
+
+    ///
+    /// @class ReceiveWindow
+    /// @brief Sequence numbers received from one peer and the ACKs owed to it
+    /// The latest sequence and a 32-bit bitmap of the ones before it form the SACK sent back. ACK_REQ packets are
+    /// not acknowledged one by one: the SACK rides on the next packet sent to the peer (piggyback()), and
+    /// flushAcks() sends a single ACK covering those still owed once no packet took it, plus a standalone ACK for
+    /// each that fell behind the window. Reliable sequences are remembered past the window so a late retransmission
+    /// is never delivered twice.
+    /// @namespace rnp
+    ///
+    class ReceiveWindow
+    {
+        public:
+            ///
+            /// @brief Record a received packet
+            /// @return false if it is a duplicate that must not be handled again (it is still acknowledged)
+            ///
+            [[nodiscard]] bool receive(const PacketHeader &header)
+            {
+                const std::uint32_t sequence = header.sequence;
+                bool duplicate = false;
+                if (!m_started)
+                {
+                    m_started = true;
+                    m_latest = sequence;
+                }
+                else if (const auto ahead = static_cast<std::int32_t>(sequence - m_latest); ahead > 0)
+                {
+                    // The previous latest becomes bit ahead - 1
+                    const auto shift = static_cast<std::uint32_t>(ahead);
+                    m_bits = shift < ACK_WINDOW   ? (m_bits << shift) | (1U << (shift - 1))
+                             : shift == ACK_WINDOW ? 1U << (ACK_WINDOW - 1)
+                                                   : 0U;
+                    m_latest = sequence;
+                }
+                else if (ahead == 0)
+                {
+                    duplicate = true;
+                }
+                else if (static_cast<std::uint32_t>(-ahead) <= ACK_WINDOW)
+                {
+                    const std::uint32_t bit = 1U << (static_cast<std::uint32_t>(-ahead) - 1);
+                    duplicate = (m_bits & bit) != 0;
+                    m_bits |= bit;
+                }
+
+                if ((header.flags & static_cast<std::uint16_t>(PacketFlags::RELIABLE)) != 0)
+                {
+                    const std::span<const std::uint32_t> delivered = deliveredSequences();
+                    duplicate = duplicate || std::ranges::find(delivered, sequence) != delivered.end();
+                    if (!duplicate)
+                    {
+                        m_delivered[m_deliveredCount++ % m_delivered.size()] = sequence;
+                    }
+                }
+                const std::span<const std::uint32_t> owed = std::span(m_owed).first(m_owedCount);
+                if ((header.flags & static_cast<std::uint16_t>(PacketFlags::ACK_REQ)) != 0 &&
+                    m_owedCount < m_owed.size() && std::ranges::find(owed, sequence) == owed.end())
+                {
+                    // When full the ACK is skipped, the sender retransmits and gets it then
+                    m_owed[m_owedCount++] = sequence;
+                }
+                return !duplicate;
+            }
+
+            [[nodiscard]] bool ackOwed() const { return m_owedCount != 0; }
+
+            ///
+            /// @brief SACK to append to a packet about to be sent, if ACKs are owed
+            /// The owed ACKs it covers are settled, flushAcks() only sends the others.
+            ///
+            [[nodiscard]] std::optional<PacketAck> piggyback()
+            {
+                if (m_owedCount == 0)
+                {
+                    return std::nullopt;
+                }
+                const PacketAck window{.cumulativeAck = m_latest, .ackBits = m_bits};
+                const auto owed = std::span(m_owed).first(m_owedCount);
+                m_owedCount = static_cast<std::size_t>(
+                    std::ranges::remove_if(owed, [&window](const std::uint32_t sequence)
+                                           { return isAcknowledged(window, sequence); })
+                        .begin() -
+                    owed.begin());
+                return window;
+            }
+
+            ///
+            /// @brief Call send(const PacketAck &) with the ACKs owed since the last flush that no packet carried
+            ///
+            template <typename Send> void flushAcks(Send &&send)
+            {
+                if (m_owedCount == 0)
+                {
+                    return;
+                }
+                const PacketAck window{.cumulativeAck = m_latest, .ackBits = m_bits};
+                send(window);
+                for (const std::uint32_t sequence : std::span(m_owed).first(m_owedCount))
+                {
+                    if (!isAcknowledged(window, sequence))
+                    {
+                        send(PacketAck{.cumulativeAck = sequence, .ackBits = 0});
+                    }
+                }
+                m_owedCount = 0;
+            }
+
+        private:
+            [[nodiscard]] std::span<const std::uint32_t> deliveredSequences() const
+            {
+                return std::span(m_delivered).first(std::min(m_deliveredCount, m_delivered.size()));
+            }
+
+            bool m_started = false;
+            std::uint32_t m_latest = 0;
+            std::uint32_t m_bits = 0; // Bit i set when m_latest - 1 - i was received
+            std::array<std::uint32_t, 128> m_delivered{}; // Last reliable sequences handled
+            std::size_t m_deliveredCount = 0;
+            std::array<std::uint32_t, 16> m_owed{}; // ACK_REQ sequences received since the last flush
+            std::size_t m_owedCount = 0;
+    }; // class ReceiveWindow
+
+    ///
+    /// @class ReliableSender
+    /// @brief Copies of the RELIABLE datagrams sent to one peer until they are acknowledged, never allocates
+    /// A datagram is resent, unchanged and with its original sequence number, when its timeout expires. The timeout
+    /// follows the session RTT estimate and doubles on every retransmission. An unordered datagram is given up after
+    /// MAX_RETRANSMITS of them, an ordered one never is: the peer could not deliver anything after it, so the sender
+    /// reports itself stalled() and the session is to be closed. At most Capacity datagrams are in flight, up to
+    /// Capacity more wait in a backlog for one of them to be acknowledged.
+    /// @namespace rnp
+    ///
+    template <std::size_t Capacity> class ReliableSender
+    {
+        public:
+            using Clock = std::chrono::steady_clock;
+
+            enum class Track : std::uint8_t
+            {
+                SEND,   // In flight, to be sent now
+                QUEUED, // Backlogged, retransmit() sends it once a datagram in flight is acknowledged
+                FULL    // Not kept, the backlog is full: the sender is now stalled()
+            };
+
+            ///
+            /// @brief Keep a copy of a datagram about to be sent
+            ///
+            [[nodiscard]] Track track(const std::uint32_t sequence, const std::span<const std::uint8_t> datagram,
+                                      const Clock::time_point now = Clock::now())
+            {
+                if (datagram.size() < HEADER_SIZE || datagram.size() > HEADER_SIZE + MAX_PAYLOAD)
+                {
+                    return Track::FULL;
+                }
+                auto entry = std::ranges::find_if(m_entries, [](const Entry &candidate) { return !candidate.active; });
+                if (m_backlogCount == 0 && entry != m_entries.end())
+                {
+                    store(*entry, sequence, datagram, now);
+                    return Track::SEND;
+                }
+                // Behind the backlog, so datagrams leave in the order they were sent
+                if (m_backlogCount == m_backlog.size())
+                {
+                    m_stalled = true;
+                    return Track::FULL;
+                }
+                store(m_backlog[(m_backlogHead + m_backlogCount++) % m_backlog.size()], sequence, datagram, now);
+                return Track::QUEUED;
+            }
+
+            ///
+            /// @brief Release the datagrams an ACK covers and feed the RTT estimate
+            ///
+            void acknowledge(const PacketAck &ack, const Clock::time_point now = Clock::now())
+            {
+                for (Entry &entry : m_entries)
+                {
+                    if (entry.active && isAcknowledged(ack, entry.sequence))
+                    {
+                        if (entry.retransmits == 0)
+                        {
+                            m_rtt.sample(now - entry.sentAt);
+                        }
+                        entry.active = false;
+                    }
+                }
+            }
+
+            ///
+            /// @brief Call resend(std::span<const uint8_t>) for every datagram whose timeout expired, then send the
+            /// backlogged ones that fit in flight
+            /// @return the number of unordered datagrams given up
+            ///
+            template <typename Resend> std::size_t retransmit(const Clock::time_point now, Resend &&resend)
+            {
+                std::size_t lost = 0;
+                for (Entry &entry : m_entries)
+                {
+                    if (!entry.active || now < entry.deadline)
+                    {
+                        continue;
+                    }
+                    if (entry.retransmits >= MAX_RETRANSMITS)
+                    {
+                        if (!entry.ordered)
+                        {
+                            entry.active = false;
+                            ++lost;
+                            continue;
+                        }
+                        m_stalled = true;
+                    }
+                    else
+                    {
+                        ++entry.retransmits;
+                    }
+                    entry.deadline = now + m_rtt.timeout(entry.retransmits);
+                    resend(std::span<const std::uint8_t>(entry.bytes).first(entry.size));
+                }
+
+                for (Entry &entry : m_entries)
+                {
+                    if (entry.active || m_backlogCount == 0)
+                    {
+                        continue;
+                    }
+                    entry = m_backlog[m_backlogHead];
+                    m_backlogHead = (m_backlogHead + 1) % m_backlog.size();
+                    --m_backlogCount;
+                    entry.sentAt = now;
+                    entry.deadline = now + m_rtt.timeout();
+                    resend(std::span<const std::uint8_t>(entry.bytes).first(entry.size));
+                }
+                return lost;
+            }
+
+            ///
+            /// @brief Whether the peer stopped acknowledging: an ordered datagram went unacknowledged after
+            /// MAX_RETRANSMITS retransmissions, or the backlog overflowed
+            ///
+            [[nodiscard]] bool stalled() const { return m_stalled; }
+            [[nodiscard]] std::size_t backlog() const { return m_backlogCount; }
+
+            ///
+            /// @brief Forget every datagram, once the session they were sent on is closed
+            ///
+            void clear()
+            {
+                for (Entry &entry : m_entries)
+                {
+                    entry.active = false;
+                }
+                m_backlogHead = 0;
+                m_backlogCount = 0;
+                m_stalled = false;
+            }
+
+            [[nodiscard]] const RttEstimator &rtt() const { return m_rtt; }
+
+        private:
+            struct Entry
+            {
+                    bool active = false;
+                    bool ordered = false; // On Channel::RELIABLE_ORDERED, never given up
+                    std::uint8_t retransmits = 0;
+                    std::uint16_t size = 0;
+                    std::uint32_t sequence = 0;
+                    Clock::time_point sentAt{};
+                    Clock::time_point deadline{};
+                    std::array<std::uint8_t, HEADER_SIZE + MAX_PAYLOAD> bytes; // Only size bytes are read
+            };
+
+            // PacketHeader::channel, after type(1) | length(2) | flags(2)
+            static constexpr std::size_t CHANNEL_OFFSET = 5;
+
+            void store(Entry &entry, const std::uint32_t sequence, const std::span<const std::uint8_t> datagram,
+                       const Clock::time_point now) const
+            {
+                PacketHeader header{};
+                header.channel = loadBE<std::uint16_t>(datagram.data() + CHANNEL_OFFSET);
+                entry.active = true;
+                entry.ordered = channelOf(header) == Channel::RELIABLE_ORDERED;
+                entry.sequence = sequence;
+                entry.retransmits = 0;
+                entry.sentAt = now;
+                entry.deadline = now + m_rtt.timeout();
+                entry.size = static_cast<std::uint16_t>(datagram.size());
+                std::memcpy(entry.bytes.data(), datagram.data(), datagram.size());
+            }
+
+            std::array<Entry, Capacity> m_entries;
+            std::array<Entry, Capacity> m_backlog; // FIFO of m_backlogCount entries from m_backlogHead
+            std::size_t m_backlogHead = 0;
+            std::size_t m_backlogCount = 0;
+            bool m_stalled = false;
+            RttEstimator m_rtt;
+    }; // class ReliableSender
+
+} // namespace rnp
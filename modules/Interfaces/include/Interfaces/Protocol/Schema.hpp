@@ -0,0 +1,107 @@
+///
+/// @file Schema.hpp
+/// @brief This file contains the declarative field schema used to generate RNP codecs
+/// @namespace rnp
+///
+
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+
+#include "Interfaces/Protocol/Buffer.hpp"
+
+namespace rnp
+{
+
+    ///
+    /// @brief Zero-filled bytes inside a layout (written as 0, skipped on read)
+    ///
+    struct Padding
+    {
+            std::size_t bytes;
+    };
+
+    ///
+    /// @brief Wire layout of a packet struct, specialize as `template <> struct Schema<T> : Fields<&T::a, ...> {};`
+    ///
+    template <typename T> struct Schema;
+
+    namespace detail
+    {
+        template <typename C, typename M> M memberTypeOf(M C::*);
+
+        template <auto Field> [[nodiscard]] consteval std::size_t fieldWireSize()
+        {
+            if constexpr (std::is_member_object_pointer_v<decltype(Field)>)
+            {
+                using Member = decltype(memberTypeOf(Field));
+                static_assert(WireScalar<Member>, "Schema fields must be big endian scalars");
+                return sizeof(Member);
+            }
+            else
+            {
+                return Field.bytes;
+            }
+        }
+
+        template <auto Field, typename T> void writeField(BufferWriter &writer, const T &value) noexcept
+        {
+            if constexpr (std::is_member_object_pointer_v<decltype(Field)>)
+            {
+                writer.write(value.*Field);
+            }
+            else
+            {
+                writer.writeZeros(Field.bytes);
+            }
+        }
+
+        template <auto Field, typename T> void readField(BufferReader &reader, T &value) noexcept
+        {
+            if constexpr (std::is_member_object_pointer_v<decltype(Field)>)
+            {
+                value.*Field = reader.read<decltype(memberTypeOf(Field))>();
+            }
+            else
+            {
+                reader.skip(Field.bytes);
+            }
+        }
+    } // namespace detail
+
+    ///
+    /// @brief Ordered list of the members (or Padding) making up a wire layout
+    ///
+    template <auto... FieldList> struct Fields
+    {
+            static constexpr std::size_t WIRE_SIZE = (detail::fieldWireSize<FieldList>() + ... + 0);
+
+            template <typename T> static void write(BufferWriter &writer, const T &value) noexcept
+            {
+                (detail::writeField<FieldList>(writer, value), ...);
+            }
+
+            template <typename T> static bool read(BufferReader &reader, T &value) noexcept
+            {
+                (detail::readField<FieldList>(reader, value), ...);
+                return reader.ok();
+            }
+    };
+
+    template <typename T>
+    concept Described = requires { Schema<T>::WIRE_SIZE; };
+
+    ///
+    /// @brief Encoded size of a described struct, known at compile time
+    ///
+    template <Described T> inline constexpr std::size_t WIRE_SIZE = Schema<T>::WIRE_SIZE;
+
+    template <Described T> void write(BufferWriter &writer, const T &value) noexcept
+    {
+        Schema<T>::write(writer, value);
+    }
+
+    template <Described T> bool read(BufferReader &reader, T &value) noexcept { return Schema<T>::read(reader, value); }
+
+} // namespace rnp
@@ -0,0 +1,149 @@
+///
+/// @file BufferPool.hpp
+/// @brief This file contains a fixed-capacity pool of preallocated byte buffers
+/// @namespace utl
+///
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <span>
+
+namespace utl
+{
+
+    ///
+    /// @class BufferPool
+    /// @brief Hands out preallocated buffers as move-only leases, returned to the pool on destruction
+    /// Acquire and release are thread-safe and lock-free, the free buffers form a stack whose head carries a
+    /// counter against ABA; no allocation happens after construction.
+    /// @namespace utl
+    ///
+    template <std::size_t BufferSize, std::size_t BufferCount> class BufferPool
+    {
+        public:
+            static constexpr std::size_t BUFFER_SIZE = BufferSize;
+
+            class Lease
+            {
+                public:
+                    Lease() = default;
+                    ~Lease() { release(); }
+
+                    Lease(const Lease &) = delete;
+                    Lease &operator=(const Lease &) = delete;
+                    Lease(Lease &&other) noexcept
+                        : m_pool(other.m_pool), m_index(other.m_index), m_size(other.m_size)
+                    {
+                        other.m_pool = nullptr;
+                    }
+                    Lease &operator=(Lease &&other) noexcept
+                    {
+                        if (this != &other)
+                        {
+                            release();
+                            m_pool = other.m_pool;
+                            m_index = other.m_index;
+                            m_size = other.m_size;
+                            other.m_pool = nullptr;
+                        }
+                        return *this;
+                    }
+
+                    explicit operator bool() const { return m_pool != nullptr; }
+
+                    /// Whole buffer capacity
+                    [[nodiscard]] std::span<std::uint8_t> buffer() const { return m_pool->m_buffers[m_index]; }
+                    /// Bytes in use, as set by resize()
+                    [[nodiscard]] std::span<std::uint8_t> data() const { return buffer().first(m_size); }
+                    [[nodiscard]] std::size_t size() const { return m_size; }
+                    void resize(const std::size_t size) { m_size = size < BufferSize ? size : BufferSize; }
+
+                private:
+                    friend class BufferPool;
+
+                    Lease(BufferPool *pool, const std::uint32_t index) : m_pool(pool), m_index(index) {}
+
+                    void release()
+                    {
+                        if (m_pool)
+                        {
+                            m_pool->release(m_index);
+                            m_pool = nullptr;
+                        }
+                    }
+
+                    BufferPool *m_pool = nullptr;
+                    std::uint32_t m_index = 0;
+                    std::size_t m_size = 0;
+            }; // class Lease
+
+            BufferPool()
+            {
+                for (std::uint32_t i = 0; i < BufferCount; ++i)
+                {
+                    m_next[i].store(i + 1 < BufferCount ? i + 1 : NONE, std::memory_order_relaxed);
+                }
+            }
+            ~BufferPool() = default;
+
+            BufferPool(const BufferPool &) = delete;
+            BufferPool &operator=(const BufferPool &) = delete;
+            BufferPool(BufferPool &&) = delete;
+            BufferPool &operator=(BufferPool &&) = delete;
+
+            ///
+            /// @brief Take a free buffer
+            /// @return an empty lease when every buffer is in flight
+            ///
+            [[nodiscard]] Lease acquire()
+            {
+                std::uint64_t head = m_head.load(std::memory_order_acquire);
+                for (;;)
+                {
+                    const auto index = static_cast<std::uint32_t>(head);
+                    if (index == NONE)
+                    {
+                        return {};
+                    }
+                    const std::uint64_t next = tagged(head, m_next[index].load(std::memory_order_relaxed));
+                    if (m_head.compare_exchange_weak(head, next, std::memory_order_acquire,
+                                                     std::memory_order_acquire))
+                    {
+                        m_freeCount.fetch_sub(1, std::memory_order_relaxed);
+                        return {this, index};
+                    }
+                }
+            }
+
+            [[nodiscard]] std::size_t available() const { return m_freeCount.load(std::memory_order_relaxed); }
+
+        private:
+            static constexpr std::uint32_t NONE = UINT32_MAX;
+
+            // Head of the free stack: the counter in the high half changes on every update
+            [[nodiscard]] static std::uint64_t tagged(const std::uint64_t head, const std::uint32_t index)
+            {
+                return ((head >> 32U) + 1U) << 32U | index;
+            }
+
+            void release(const std::uint32_t index)
+            {
+                m_freeCount.fetch_add(1, std::memory_order_relaxed);
+                std::uint64_t head = m_head.load(std::memory_order_relaxed);
+                do
+                {
+                    m_next[index].store(static_cast<std::uint32_t>(head), std::memory_order_relaxed);
+                } while (!m_head.compare_exchange_weak(head, tagged(head, index), std::memory_order_release,
+                                                       std::memory_order_relaxed));
+            }
+
+            std::array<std::array<std::uint8_t, BufferSize>, BufferCount> m_buffers{};
+            std::array<std::atomic<std::uint32_t>, BufferCount> m_next{}; // Next free buffer, NONE for the last
+            std::atomic<std::uint64_t> m_head{0};                          // Free buffer on top of the stack
+            std::atomic<std::size_t> m_freeCount{BufferCount};
+    }; // class BufferPool
+
+} // namespace utl
@@ -0,0 +1,106 @@
+///
+/// @file MpscRing.hpp
+/// @brief This file contains a bounded lock-free queue with several producers and one consumer
+/// @namespace utl
+///
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace utl
+{
+
+    ///
+    /// @class MpscRing
+    /// @brief Fixed ring of Capacity values, pushed from any thread and popped from a single one
+    /// Every cell carries a sequence number telling whose turn it is: a producer claims the next cell with a
+    /// compare-and-swap on the tail, fills it and publishes it by bumping its sequence, the consumer takes cells in
+    /// order once published. Neither side blocks or allocates, a push into a full ring fails.
+    /// @namespace utl
+    ///
+    template <typename T, std::size_t Capacity> class MpscRing
+    {
+            static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+        public:
+            MpscRing()
+            {
+                for (std::size_t i = 0; i < Capacity; ++i)
+                {
+                    m_cells[i].sequence.store(i, std::memory_order_relaxed);
+                }
+            }
+
+            MpscRing(const MpscRing &) = delete;
+            MpscRing &operator=(const MpscRing &) = delete;
+            MpscRing(MpscRing &&) = delete;
+            MpscRing &operator=(MpscRing &&) = delete;
+
+            ///
+            /// @brief Move value in, from any thread
+            /// @return false if the ring is full, value is left untouched
+            ///
+            [[nodiscard]] bool tryPush(T &&value)
+            {
+                std::size_t tail = m_tail.load(std::memory_order_relaxed);
+                for (;;)
+                {
+                    Cell &cell = m_cells[tail & (Capacity - 1)];
+                    const std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                    const auto lag = static_cast<std::ptrdiff_t>(sequence - tail);
+                    if (lag == 0)
+                    {
+                        if (m_tail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed))
+                        {
+                            cell.value = std::move(value);
+                            cell.sequence.store(tail + 1, std::memory_order_release);
+                            return true;
+                        }
+                    }
+                    else if (lag < 0)
+                    {
+                        return false; // The consumer has not taken the value of the previous lap yet
+                    }
+                    else
+                    {
+                        tail = m_tail.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            ///
+            /// @brief Move the oldest value out, from the consumer thread only
+            /// @return false if the ring is empty, or its oldest value is still being written
+            ///
+            [[nodiscard]] bool tryPop(T &value)
+            {
+                Cell &cell = m_cells[m_head & (Capacity - 1)];
+                if (cell.sequence.load(std::memory_order_acquire) != m_head + 1)
+                {
+                    return false;
+                }
+                value = std::move(cell.value);
+                cell.sequence.store(m_head + Capacity, std::memory_order_release);
+                ++m_head;
+                return true;
+            }
+
+        private:
+            static constexpr std::size_t CACHE_LINE = 64;
+
+            struct Cell
+            {
+                    std::atomic<std::size_t> sequence;
+                    T value{};
+            };
+
+            std::array<Cell, Capacity> m_cells;
+            alignas(CACHE_LINE) std::atomic<std::size_t> m_tail{0}; // Next cell to claim, producers
+            alignas(CACHE_LINE) std::size_t m_head = 0;             // Next cell to take, consumer only
+    }; // class MpscRing
+
+} // namespace utl
@@ -0,0 +1,93 @@
+///
+/// @file SpscRing.hpp
+/// @brief This file contains a bounded lock-free queue between one producer and one consumer
+/// @namespace utl
+///
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace utl
+{
+
+    ///
+    /// @class SpscRing
+    /// @brief Fixed ring of Capacity values, written in place by one thread and read in place by another
+    /// Values are never moved: the producer fills the cell claim() hands out and publishes it with commit(), the
+    /// consumer reads front() and gives the cell back with pop(). Cells keep whatever they own between laps, so
+    /// values holding buffers stop allocating once these have grown. Each side caches the index of the other and
+    /// only reloads it when the ring looks full or empty.
+    /// @namespace utl
+    ///
+    template <typename T, std::size_t Capacity> class SpscRing
+    {
+            static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+        public:
+            SpscRing() = default;
+
+            SpscRing(const SpscRing &) = delete;
+            SpscRing &operator=(const SpscRing &) = delete;
+            SpscRing(SpscRing &&) = delete;
+            SpscRing &operator=(SpscRing &&) = delete;
+
+            ///
+            /// @brief Cell to fill, from the producer thread only
+            /// @return nullptr if the ring is full
+            ///
+            [[nodiscard]] T *claim()
+            {
+                const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+                if (tail - m_headCache == Capacity)
+                {
+                    m_headCache = m_head.load(std::memory_order_acquire);
+                    if (tail - m_headCache == Capacity)
+                    {
+                        return nullptr;
+                    }
+                }
+                return &m_cells[tail & (Capacity - 1)];
+            }
+
+            ///
+            /// @brief Publish the cell claim() returned
+            ///
+            void commit() { m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+            ///
+            /// @brief Oldest published cell, from the consumer thread only
+            /// @return nullptr if the ring is empty
+            ///
+            [[nodiscard]] T *front()
+            {
+                const std::size_t head = m_head.load(std::memory_order_relaxed);
+                if (head == m_tailCache)
+                {
+                    m_tailCache = m_tail.load(std::memory_order_acquire);
+                    if (head == m_tailCache)
+                    {
+                        return nullptr;
+                    }
+                }
+                return &m_cells[head & (Capacity - 1)];
+            }
+
+            ///
+            /// @brief Give the cell front() returned back to the producer
+            ///
+            void pop() { m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+        private:
+            static constexpr std::size_t CACHE_LINE = 64;
+
+            std::array<T, Capacity> m_cells{};
+            alignas(CACHE_LINE) std::atomic<std::size_t> m_tail{0}; // Written by the producer
+            std::size_t m_headCache = 0;                            // Producer copy of m_head
+            alignas(CACHE_LINE) std::atomic<std::size_t> m_head{0}; // Written by the consumer
+            std::size_t m_tailCache = 0;                            // Consumer copy of m_tail
+    }; // class SpscRing
+
+} // namespace utl
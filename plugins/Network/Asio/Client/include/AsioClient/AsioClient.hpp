@@ -6,18 +6,36 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <span>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 #define ASIO_STANDALONE
 #include "asio.hpp"
 
+#include "AsioClient/ClockSync.hpp"
 #include "Interfaces/INetworkClient.hpp"
+#include "Interfaces/Protocol/Batch.hpp"
+#include "Interfaces/Protocol/Channel.hpp"
+#include "Interfaces/Protocol/Compression.hpp"
+#include "Interfaces/Protocol/Delta.hpp"
+#include "Interfaces/Protocol/Fragment.hpp"
+#include "Interfaces/Protocol/Input.hpp"
+#include "Interfaces/Protocol/LinkConditioner.hpp"
+#include "Interfaces/Protocol/PacketView.hpp"
 #include "Interfaces/Protocol/Protocol.hpp"
+#include "Interfaces/Protocol/Quantization.hpp"
+#include "Interfaces/Protocol/Reliability.hpp"
+#include "Utils/BufferPool.hpp"
+#include "Utils/SpscRing.hpp"
 
 namespace eng
 {
@@ -30,8 +48,6 @@ namespace eng
     class AsioClient final : public INetworkClient
     {
         public:
-            using PacketHandler = std::function<void(const rnp::PacketHeader &, const std::vector<uint8_t> &)>;
-
             AsioClient();
             ~AsioClient() override = default;
 
@@ -45,6 +61,7 @@ namespace eng
 
             void connect(const std::string &host, uint16_t port) override;
             void disconnect() override;
+            void setLinkConditions(const rnp::LinkConditions &conditions) override;
 
             void sendConnect(const std::string &playerName);
             void sendConnectWithCaps(const std::string &playerName, std::uint32_t clientCaps);
@@ -56,44 +73,125 @@ namespace eng
             void sendPing();
             void sendPing(std::uint32_t nonce, std::uint32_t sendTimeMs);
             void sendAck(std::uint32_t cumulative, std::uint32_t ackBits);
+            void sendWorldStateAck(std::uint32_t serverTick);
 
             void setPacketHandler(rnp::PacketType type, PacketHandler handler);
 
-            void setEventsHandler(std::function<void(const std::vector<rnp::EventRecord> &)> handler);
+            ///
+            /// @brief Receive every ENTITY_EVENT on the IO thread, before its events are queued for pollEvent()
+            ///
+            void setEventsHandler(EventsHandler handler);
+            bool pollEvent(NetworkEvent &event) override;
+
+            ///
+            /// @brief Load the static dictionary shared with the server and advertise COMPRESSION_DICTIONARY
+            /// Call before sendConnect(), the server must load the same dictionary.
+            ///
+            void setCompressionDictionary(std::span<const uint8_t> dictionary);
+
+            bool pollWorldState(rnp::PacketWorldState &snapshot) override;
 
             std::uint32_t getSessionId() const { return m_sessionId; }
             std::uint16_t getServerTickRate() const { return m_serverTickRate; }
+            std::optional<double> getServerTickEstimate() const override;
+            ClockStats getClockStats() const override;
 
         private:
+            using SendPool = utl::BufferPool<rnp::HEADER_SIZE + rnp::MAX_PAYLOAD, 64>;
+
+            template <typename Encoder>
+            void sendPacket(rnp::PacketType type, std::uint16_t flags, Encoder &&encodePayload);
+            template <typename Encoder>
+            void sendOnChannel(rnp::PacketType type, std::uint16_t flags, std::uint16_t channel,
+                               Encoder &&encodePayload);
+            [[nodiscard]] std::size_t maxDatagramPayload() const;
+            [[nodiscard]] std::uint32_t sessionCaps() const { return m_clientCaps & m_serverCaps; }
+            bool compressPayload(SendPool::Lease &packet);
+            void sendMessage(rnp::PacketType type, std::uint16_t flags, std::uint16_t channel,
+                             std::span<const uint8_t> message);
+            void transmit(SendPool::Lease packet);
+            void conditionDatagram(SendPool::Lease packet);
+            void sendDatagram(SendPool::Lease packet);
+            void scheduleLink();
             void startReceive();
             void handleReceive(const asio::error_code &error, std::size_t bytesTransferred);
             void handleSend(const asio::error_code &error, std::size_t bytesTransferred);
-            void processPacket(const std::vector<uint8_t> &data);
-            void processEvents(const std::vector<uint8_t> &payload);
-            void handleConnectAccept(const std::vector<uint8_t> &payload);
-            void handleReliablePacket(const rnp::PacketHeader &header);
-            void processAck(const std::vector<uint8_t> &payload);
-            void processWorldState(const std::vector<uint8_t> &payload);
-            void processEntityEvent(const std::vector<uint8_t> &payload);
+            void processPacket(std::span<const uint8_t> datagram);
+            void handleMessage(const rnp::PacketHeader &header, std::span<const uint8_t> payload);
+            void handleConnectAccept(std::span<const uint8_t> payload);
+            void processAck(std::span<const uint8_t> payload);
+            void processWorldState(std::span<const uint8_t> payload);
+            void processEntityEvent(std::span<const uint8_t> payload);
+            void queueEvents(std::uint32_t serverTick, const rnp::EventRange &events);
+            void recordInputEchoes(std::uint32_t serverTick, const rnp::EventRange &events);
+            [[nodiscard]] std::uint32_t inputAck(std::uint32_t serverTick) const;
+            void scheduleReliability();
+            void sendClockPing();
             void retransmitReliable();
+            void closeSession(); // IO thread only
 
             asio::io_context m_ioContext;
             asio::ip::udp::socket m_socket;
+            asio::steady_timer m_reliabilityTimer; // ACK aggregation and retransmission, every rnp::ACK_DELAY
             asio::ip::udp::endpoint m_serverEndpoint;
-            std::array<uint8_t, rnp::MAX_PAYLOAD + 16> m_recvBuffer;
+            std::array<uint8_t, rnp::MAX_PAYLOAD + rnp::HEADER_SIZE> m_recvBuffer;
+            SendPool m_sendPool;
+            std::atomic<bool> m_linkConditioned{false}; // Datagrams go through m_link, from any thread
+            std::optional<rnp::LinkConditioner> m_link; // IO thread only
+            rnp::DelayLine<SendPool::Lease> m_linkQueue;
+            asio::steady_timer m_linkTimer;
+            std::optional<std::chrono::steady_clock::time_point> m_linkTimerDue;
 
             std::unique_ptr<asio::executor_work_guard<asio::io_context::executor_type>> m_workGuard;
             std::thread m_ioThread;
-            std::unordered_map<rnp::PacketType, PacketHandler> m_packetHandlers;
-            std::function<void(const std::vector<rnp::EventRecord> &)> m_eventsHandler;
-            uint32_t m_sequenceNumber = 0;
-            bool m_connected = false;
-            std::uint32_t m_sessionId = 0;
-            std::uint16_t m_serverTickRate = 0;
-            std::uint16_t m_serverMtu = 0;
-            std::uint32_t m_serverCaps = 0;
-            std::uint32_t m_clientCaps = 0;
-            std::unordered_map<std::uint32_t, std::vector<uint8_t>> m_pendingReliable;
-            std::uint32_t m_lastAckSent = 0;
+            std::array<PacketHandler, rnp::PACKET_TYPE_COUNT> m_packetHandlers;
+            EventsHandler m_eventsHandler;
+            std::atomic<std::uint32_t> m_sequenceNumber{0}; // Sent from the caller's and the IO thread
+            std::uint16_t m_nextFragId = 0;
+            std::mutex m_messageMutex;
+            std::array<uint8_t, rnp::MAX_MESSAGE_SIZE> m_messageBuffer; // Oversized payloads, under m_messageMutex
+            std::array<uint8_t, rnp::MAX_MESSAGE_SIZE> m_compressBuffer; // Oversized payloads, under m_messageMutex
+            std::array<uint8_t, rnp::MAX_MESSAGE_SIZE> m_decompressBuffer; // Received payloads, IO thread only
+            rnp::LzCodec m_codec;
+            rnp::FragmentReassembler<rnp::MAX_FRAGMENTS, 4> m_reassembler; // IO thread only
+            // Set by CONNECT_ACCEPT and closeSession() on the IO thread, read from the caller's thread too
+            std::atomic<bool> m_connected{false};
+            std::atomic<std::uint32_t> m_sessionId{0};
+            std::atomic<std::uint16_t> m_serverTickRate{0};
+            std::atomic<std::uint16_t> m_serverMtu{0};
+            std::atomic<std::uint32_t> m_serverCaps{0};
+            std::atomic<std::uint32_t> m_clientCaps{0}; // Set by sendConnectWithCaps(), read on the IO thread
+            std::mutex m_ackMutex;
+            rnp::ReceiveWindow m_receiveWindow; // Under m_ackMutex, taken before m_reliableMutex
+            std::mutex m_reliableMutex;
+            rnp::ReliableSender<64> m_reliableSender; // Under m_reliableMutex
+            rnp::ChannelSender m_channelSender;       // Under m_reliableMutex
+            rnp::ChannelReceiver m_channelReceiver;   // IO thread only
+            std::vector<uint8_t> m_orderedBuffer;     // Held ordered message being handled, IO thread only
+
+            rnp::PacketWorldState m_pendingWorldState{}; // Records of the tick being assembled, IO thread only
+            std::vector<std::uint32_t> m_pendingRemoved;
+            std::uint32_t m_pendingBaselineTick = 0;
+            std::uint32_t m_pendingChunks = 0; // Bitmask of chunks received for m_pendingWorldState
+            std::uint32_t m_lastWorldStateTick = 0;
+            std::array<rnp::PacketWorldState, rnp::WORLD_STATE_HISTORY> m_worldStateHistory{}; // Delta baselines
+            std::mutex m_worldStateMutex;
+            rnp::PacketWorldState m_readyWorldState{};
+            bool m_worldStateReady = false;
+            utl::SpscRing<NetworkEvent, 1024> m_events; // IO thread to main thread, a few spawn waves
+            bool m_eventsOverflow = false;              // Events dropped since the ring last had room, IO thread only
+
+            struct InputEcho
+            {
+                    std::uint32_t serverTick = 0;
+                    std::uint32_t clientTimeMs = 0;
+            };
+            static constexpr std::uint32_t NO_INPUT_ENTITY = ~std::uint32_t{0};
+            std::atomic<std::uint32_t> m_inputEntityId{NO_INPUT_ENTITY}; // Entity of the last sent INPUT
+            std::array<InputEcho, 16> m_inputEchoes{};                   // Ring of received echoes, IO thread only
+            std::size_t m_nextInputEcho = 0;
+            rnp::InputHistory m_inputHistory; // Caller's thread only
+            mutable std::mutex m_clockMutex;
+            ClockSync m_clockSync; // Under m_clockMutex
     }; // class AsioClient
 } // namespace eng
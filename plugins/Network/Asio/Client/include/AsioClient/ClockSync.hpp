@@ -0,0 +1,161 @@
+///
+/// @file ClockSync.hpp
+/// @brief This file contains the estimation of the server clock from PING/PONG round trips
+/// @namespace eng
+///
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+#include "Interfaces/INetworkClient.hpp"
+#include "Interfaces/Protocol/Protocol.hpp"
+
+namespace eng
+{
+
+    ///
+    /// @brief Time between two PINGs once synchronized, and during the burst sent right after connecting
+    ///
+    inline constexpr std::chrono::milliseconds CLOCK_SYNC_INTERVAL{1000};
+    inline constexpr std::chrono::milliseconds CLOCK_SYNC_BURST_INTERVAL{50};
+    inline constexpr std::size_t CLOCK_SYNC_BURST = 8;
+
+    ///
+    /// @class ClockSync
+    /// @brief Round trip statistics and server tick estimate, from the PONGs answering its PINGs
+    /// Each PONG gives an offset sample between the local clock and the server tick timeline, taken as sent
+    /// halfway through the round trip. Queueing delays only lengthen round trips and skew their samples, so the
+    /// sample with the smallest round trip of the last WINDOW is trusted, and the offset moves an eighth of the way
+    /// towards it on every PONG.
+    /// @namespace eng
+    ///
+    class ClockSync
+    {
+        public:
+            using Clock = std::chrono::steady_clock;
+
+            static constexpr std::size_t WINDOW = 16;
+
+            explicit ClockSync(const Clock::time_point epoch = Clock::now()) : m_epoch(epoch) {}
+
+            ///
+            /// @brief The PING to send at now, or std::nullopt if the next one is not due yet
+            ///
+            [[nodiscard]] std::optional<rnp::PacketPingPong> ping(const Clock::time_point now)
+            {
+                const std::chrono::milliseconds interval =
+                    m_sent < CLOCK_SYNC_BURST ? CLOCK_SYNC_BURST_INTERVAL : CLOCK_SYNC_INTERVAL;
+                if (m_lastPing && now - *m_lastPing < interval)
+                {
+                    return std::nullopt;
+                }
+                m_lastPing = now;
+                const std::uint32_t nonce = ++m_sent;
+                m_pending[nonce % m_pending.size()] = {.nonce = nonce, .sentAt = now};
+                return rnp::PacketPingPong{
+                    .nonce = nonce,
+                    .sendTimeMs = static_cast<std::uint32_t>(
+                        std::chrono::duration_cast<std::chrono::milliseconds>(now - m_epoch).count())};
+            }
+
+            ///
+            /// @brief Take a PONG received at now into account, ignored unless it answers a recent PING
+            ///
+            void onPong(const rnp::PacketPingPong &pong, const rnp::PacketPongClock &clock,
+                        const std::uint16_t tickRate, const Clock::time_point now)
+            {
+                Pending &pending = m_pending[pong.nonce % m_pending.size()];
+                if (tickRate == 0 || pending.nonce != pong.nonce || pending.nonce == 0)
+                {
+                    return;
+                }
+                pending.nonce = 0; // A duplicated PONG is not a second sample
+                const auto roundTrip = std::chrono::duration_cast<std::chrono::microseconds>(now - pending.sentAt);
+
+                // RFC 6298 smoothing of the round trip and its variation
+                if (!m_smoothedRtt)
+                {
+                    m_smoothedRtt = roundTrip;
+                    m_rttVariation = roundTrip / 2;
+                }
+                else
+                {
+                    const std::chrono::microseconds deviation =
+                        roundTrip > *m_smoothedRtt ? roundTrip - *m_smoothedRtt : *m_smoothedRtt - roundTrip;
+                    m_rttVariation = (3 * m_rttVariation + deviation) / 4;
+                    m_smoothedRtt = (7 * *m_smoothedRtt + roundTrip) / 8;
+                }
+
+                // Server timeline, in seconds, minus the local clock when the PONG left the server
+                const double serverTime = static_cast<double>(clock.serverTick) / tickRate + clock.tickPhaseUs / 1e6;
+                const double sample = serverTime - seconds(pending.sentAt + (now - pending.sentAt) / 2);
+                m_samples[m_sampleCount++ % WINDOW] = {.roundTrip = roundTrip, .offset = sample};
+                const std::size_t count = std::min(m_sampleCount, WINDOW);
+                const Sample *best = &m_samples[0];
+                for (std::size_t i = 1; i < count; ++i)
+                {
+                    if (m_samples[i].roundTrip < best->roundTrip)
+                    {
+                        best = &m_samples[i];
+                    }
+                }
+                m_minRtt = best->roundTrip;
+                m_offset = m_offset ? *m_offset + (best->offset - *m_offset) / 8 : best->offset;
+            }
+
+            ///
+            /// @brief Tick, fractional, the server is at now, or std::nullopt before the first PONG
+            ///
+            [[nodiscard]] std::optional<double> serverTick(const Clock::time_point now,
+                                                           const std::uint16_t tickRate) const
+            {
+                if (!m_offset)
+                {
+                    return std::nullopt;
+                }
+                return (seconds(now) + *m_offset) * tickRate;
+            }
+
+            [[nodiscard]] ClockStats stats() const
+            {
+                return {.roundTrip = m_smoothedRtt.value_or(std::chrono::microseconds{0}),
+                        .minRoundTrip = m_minRtt,
+                        .jitter = m_rttVariation,
+                        .samples = m_sampleCount};
+            }
+
+        private:
+            struct Pending
+            {
+                    std::uint32_t nonce = 0; // 0 once answered
+                    Clock::time_point sentAt;
+            };
+            struct Sample
+            {
+                    std::chrono::microseconds roundTrip;
+                    double offset; // Seconds
+            };
+
+            [[nodiscard]] double seconds(const Clock::time_point time) const
+            {
+                return std::chrono::duration<double>(time - m_epoch).count();
+            }
+
+            Clock::time_point m_epoch;
+            std::optional<Clock::time_point> m_lastPing;
+            std::uint32_t m_sent = 0;
+            std::array<Pending, 8> m_pending{}; // By nonce
+            std::array<Sample, WINDOW> m_samples{};
+            std::size_t m_sampleCount = 0;
+            std::optional<std::chrono::microseconds> m_smoothedRtt;
+            std::chrono::microseconds m_rttVariation{0};
+            std::chrono::microseconds m_minRtt{0}; // Of the window
+            std::optional<double> m_offset;        // Server seconds minus local seconds
+    }; // class ClockSync
+
+} // namespace eng
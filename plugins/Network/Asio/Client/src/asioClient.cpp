@@ -1,5 +1,7 @@
+#include <algorithm>
 #include <cstring>
 #include <iostream>
+#include <string_view>
 
 #include <asio.hpp>
 
@@ -7,7 +9,18 @@
 
 using asio::ip::udp;
 
-eng::AsioClient::AsioClient() : m_socket(m_ioContext) {}
+eng::AsioClient::AsioClient() : m_socket(m_ioContext), m_reliabilityTimer(m_ioContext), m_linkTimer(m_ioContext)
+{
+    static constexpr std::size_t INITIAL_SNAPSHOT_CAPACITY = 256;
+
+    m_pendingWorldState.entities.reserve(INITIAL_SNAPSHOT_CAPACITY);
+    m_pendingRemoved.reserve(INITIAL_SNAPSHOT_CAPACITY);
+    m_readyWorldState.entities.reserve(INITIAL_SNAPSHOT_CAPACITY);
+    for (rnp::PacketWorldState &snapshot : m_worldStateHistory)
+    {
+        snapshot.entities.reserve(INITIAL_SNAPSHOT_CAPACITY);
+    }
+}
 
 void eng::AsioClient::connect(const std::string &host, uint16_t port)
 {
@@ -34,6 +47,7 @@ void eng::AsioClient::connect(const std::string &host, uint16_t port)
             });
 
         startReceive();
+        asio::post(m_ioContext, [this]() { scheduleReliability(); });
     }
     catch (const std::exception &e)
     {
@@ -53,6 +67,8 @@ void eng::AsioClient::disconnect()
                        [this]()
                        {
                            asio::error_code ec;
+                           m_reliabilityTimer.cancel();
+                           m_linkTimer.cancel();
                            m_socket.close(ec);
                        });
             m_workGuard.reset();
@@ -70,352 +86,740 @@ void eng::AsioClient::disconnect()
     }
 }
 
-void eng::AsioClient::sendConnect(const std::string &playerName) { sendConnectWithCaps(playerName, 0); }
+template <typename Encoder>
+void eng::AsioClient::sendPacket(const rnp::PacketType type, const std::uint16_t flags, Encoder &&encodePayload)
+{
+    std::uint16_t channel = 0;
+    {
+        std::scoped_lock lock(m_reliableMutex);
+        channel = m_channelSender.stamp(rnp::channelFor(type, flags));
+    }
+    sendOnChannel(type, flags, channel, std::forward<Encoder>(encodePayload));
+}
 
-void eng::AsioClient::sendConnectWithCaps(const std::string &playerName, std::uint32_t clientCaps)
+template <typename Encoder>
+void eng::AsioClient::sendOnChannel(const rnp::PacketType type, const std::uint16_t flags,
+                                    const std::uint16_t channel, Encoder &&encodePayload)
 {
-    rnp::PacketHeader header;
-    header.type = static_cast<std::uint8_t>(rnp::PacketType::CONNECT);
+    SendPool::Lease packet = m_sendPool.acquire();
+    if (!packet)
+    {
+        std::cerr << "[AsioClient] Send pool exhausted, packet dropped\n";
+        return;
+    }
 
-    // Payload: name_len(1) | player_name[name_len] | client_caps(4, BE)
-    std::vector<uint8_t> payload;
-    std::uint8_t nameLen = std::min(static_cast<std::uint8_t>(playerName.size()), static_cast<std::uint8_t>(31));
-    payload.push_back(nameLen);
-    payload.insert(payload.end(), playerName.begin(), playerName.begin() + nameLen);
-
-    // client_caps (4 bytes, big endian)
-    payload.push_back(static_cast<uint8_t>((clientCaps >> 24) & 0xFF));
-    payload.push_back(static_cast<uint8_t>((clientCaps >> 16) & 0xFF));
-    payload.push_back(static_cast<uint8_t>((clientCaps >> 8) & 0xFF));
-    payload.push_back(static_cast<uint8_t>(clientCaps & 0xFF));
-
-    header.length = payload.size();
-    header.flags =
-        static_cast<std::uint16_t>(rnp::PacketFlags::RELIABLE) | static_cast<std::uint16_t>(rnp::PacketFlags::ACK_REQ);
-    header.reserved = 0;
-    header.sequence = ++m_sequenceNumber;
-    header.sessionId = 0; // Pas encore de session
+    rnp::BufferWriter payload(packet.buffer().subspan(rnp::HEADER_SIZE, maxDatagramPayload()));
+    encodePayload(payload);
+    if (!payload.ok())
+    {
+        // Too large for one datagram: encode again into the message buffer
+        packet = {};
+        std::scoped_lock lock(m_messageMutex);
+        rnp::BufferWriter message(m_messageBuffer);
+        encodePayload(message);
+        if (!message.ok())
+        {
+            std::cerr << "[AsioClient] Payload exceeds MAX_MESSAGE_SIZE, packet dropped\n";
+            return;
+        }
+        sendMessage(type, flags, channel, message.written());
+        return;
+    }
+    packet.resize(rnp::HEADER_SIZE + payload.size());
 
-    m_clientCaps = clientCaps;
-    std::vector<uint8_t> buffer = rnp::serialize(header, payload.data());
+    // Fragments were compressed as a whole message before being split
+    constexpr auto PACKED = static_cast<std::uint16_t>(static_cast<std::uint16_t>(rnp::PacketFlags::FRAG) |
+                                                       static_cast<std::uint16_t>(rnp::PacketFlags::COMPRESSED));
+    std::uint16_t packetFlags = flags;
+    if ((flags & PACKED) == 0 && compressPayload(packet))
+    {
+        packetFlags |= static_cast<std::uint16_t>(rnp::PacketFlags::COMPRESSED);
+    }
 
-    m_socket.async_send_to(asio::buffer(buffer), m_serverEndpoint,
-                           [this](const asio::error_code &error, std::size_t bytesTransferred)
-                           { handleSend(error, bytesTransferred); });
+    const std::size_t payloadSize = packet.size() - rnp::HEADER_SIZE;
+    const std::uint32_t sessionId = m_sessionId;
+    // Owed ACKs ride along when there is room, flushAcks() then has nothing left to send for them
+    if (type != rnp::PacketType::ACK && sessionId != 0 &&
+        payloadSize + rnp::WIRE_SIZE<rnp::PacketAck> <= maxDatagramPayload())
+    {
+        std::optional<rnp::PacketAck> ack;
+        {
+            std::scoped_lock lock(m_ackMutex);
+            ack = m_receiveWindow.piggyback();
+        }
+        if (ack)
+        {
+            rnp::BufferWriter ackWriter(packet.buffer().subspan(packet.size(), rnp::WIRE_SIZE<rnp::PacketAck>));
+            rnp::write(ackWriter, *ack);
+            packet.resize(packet.size() + rnp::WIRE_SIZE<rnp::PacketAck>);
+            packetFlags |= static_cast<std::uint16_t>(rnp::PacketFlags::PIGGYBACK_ACK);
+        }
+    }
+
+    const rnp::PacketHeader header{.type = static_cast<std::uint8_t>(type),
+                                   .length = static_cast<std::uint16_t>(payloadSize),
+                                   .flags = packetFlags,
+                                   .channel = channel,
+                                   .sequence = ++m_sequenceNumber,
+                                   .sessionId = sessionId};
+    rnp::BufferWriter headerWriter(packet.buffer().first(rnp::HEADER_SIZE));
+    rnp::write(headerWriter, header);
+    if ((flags & static_cast<std::uint16_t>(rnp::PacketFlags::RELIABLE)) != 0)
+    {
+        std::scoped_lock lock(m_reliableMutex);
+        switch (m_reliableSender.track(header.sequence, packet.data()))
+        {
+            case decltype(m_reliableSender)::Track::SEND:
+                break;
+            case decltype(m_reliableSender)::Track::QUEUED:
+                return; // Sent by retransmitReliable() once the server acknowledges what is in flight
+            default:
+                return; // The sender stalled, retransmitReliable() closes the session
+        }
+    }
+
+    transmit(std::move(packet));
 }
 
-void eng::AsioClient::sendDisconnect() { sendDisconnect(rnp::DisconnectReason::CLIENT_REQUEST); }
+bool eng::AsioClient::compressPayload(SendPool::Lease &packet)
+{
+    const std::uint32_t caps = sessionCaps();
+    const std::size_t size = packet.size() - rnp::HEADER_SIZE;
+    if (!rnp::hasCapability(caps, rnp::Capability::LZ_COMPRESSION) || size < rnp::MIN_COMPRESSED_PAYLOAD)
+    {
+        return false;
+    }
+    SendPool::Lease compressed = m_sendPool.acquire();
+    if (!compressed)
+    {
+        return false;
+    }
+    // Capped one byte below the input: a payload that does not shrink fails to fit and is sent as is
+    const std::optional<std::size_t> compressedSize =
+        m_codec.compress(packet.data().subspan(rnp::HEADER_SIZE),
+                         compressed.buffer().subspan(rnp::HEADER_SIZE, size - 1),
+                         rnp::hasCapability(caps, rnp::Capability::COMPRESSION_DICTIONARY));
+    if (!compressedSize)
+    {
+        return false;
+    }
+    compressed.resize(rnp::HEADER_SIZE + *compressedSize);
+    packet = std::move(compressed);
+    return true;
+}
 
-void eng::AsioClient::sendDisconnect(rnp::DisconnectReason reason)
+void eng::AsioClient::setCompressionDictionary(const std::span<const uint8_t> dictionary)
 {
-    rnp::PacketHeader header;
-    header.type = static_cast<std::uint8_t>(rnp::PacketType::DISCONNECT);
+    m_codec.setDictionary(dictionary);
+}
 
-    // Payload: reason_code(2, BE)
-    std::vector<uint8_t> payload;
-    std::uint16_t reasonCode = static_cast<std::uint16_t>(reason);
-    payload.push_back(static_cast<uint8_t>((reasonCode >> 8) & 0xFF));
-    payload.push_back(static_cast<uint8_t>(reasonCode & 0xFF));
+std::size_t eng::AsioClient::maxDatagramPayload() const
+{
+    // Until CONNECT_ACCEPT advertises the server MTU, only MAX_PAYLOAD bounds a datagram
+    const std::uint16_t serverMtu = m_serverMtu;
+    return serverMtu > rnp::HEADER_SIZE ? std::min<std::size_t>(serverMtu - rnp::HEADER_SIZE, rnp::MAX_PAYLOAD)
+                                        : rnp::MAX_PAYLOAD;
+}
 
-    header.length = payload.size();
-    header.flags = 0;
-    header.reserved = 0;
-    header.sequence = ++m_sequenceNumber;
-    header.sessionId = m_sessionId;
+void eng::AsioClient::sendMessage(const rnp::PacketType type, const std::uint16_t flags, const std::uint16_t channel,
+                                  std::span<const uint8_t> message)
+{
+    // Compress the whole message, it may then fit a single datagram, otherwise fragment what is left
+    std::uint16_t messageFlags = flags;
+    const std::uint32_t caps = sessionCaps();
+    if (rnp::hasCapability(caps, rnp::Capability::LZ_COMPRESSION))
+    {
+        const std::optional<std::size_t> size =
+            m_codec.compress(message, std::span(m_compressBuffer).first(message.size() - 1),
+                             rnp::hasCapability(caps, rnp::Capability::COMPRESSION_DICTIONARY));
+        if (size)
+        {
+            message = std::span<const uint8_t>(m_compressBuffer).first(*size);
+            messageFlags |= static_cast<std::uint16_t>(rnp::PacketFlags::COMPRESSED);
+        }
+    }
+    if (message.size() <= maxDatagramPayload())
+    {
+        sendOnChannel(type, messageFlags, channel,
+                      [message](rnp::BufferWriter &writer) { writer.writeBytes(message); });
+        return;
+    }
 
-    std::vector<uint8_t> buffer = rnp::serialize(header, payload.data());
+    const std::size_t fragmentSize = maxDatagramPayload() - rnp::WIRE_SIZE<rnp::FragmentHeader>;
+    const auto fragFlags =
+        static_cast<std::uint16_t>(messageFlags | static_cast<std::uint16_t>(rnp::PacketFlags::FRAG));
 
-    m_socket.async_send_to(asio::buffer(buffer), m_serverEndpoint,
-                           [this](const asio::error_code &error, std::size_t bytesTransferred)
-                           { handleSend(error, bytesTransferred); });
+    const bool sent = rnp::forEachFragment(
+        message, fragmentSize, ++m_nextFragId,
+        [&](const rnp::FragmentHeader &fragment, const std::span<const uint8_t> bytes)
+        {
+            sendOnChannel(type, fragFlags, channel,
+                          [&fragment, bytes](rnp::BufferWriter &writer)
+                          {
+                              rnp::write(writer, fragment);
+                              writer.writeBytes(bytes);
+                          });
+        });
+    if (!sent)
+    {
+        std::cerr << "[AsioClient] Message of " << message.size() << " bytes needs too many fragments, dropped\n";
+    }
 }
 
-void eng::AsioClient::sendPlayerInput(uint8_t direction, uint8_t shooting)
+void eng::AsioClient::transmit(SendPool::Lease packet)
 {
-    rnp::PacketHeader header;
-    header.type = static_cast<std::uint8_t>(rnp::PacketType::PLAYER_INPUT);
-    header.length = 2;
-    header.flags = 0;
-    header.reserved = 0;
-    header.sequence = ++m_sequenceNumber;
-    header.sessionId = m_sessionId;
-
-    uint8_t payload[2] = {direction, shooting};
-    std::vector<uint8_t> buffer = rnp::serialize(header, payload);
-
-    m_socket.async_send_to(asio::buffer(buffer), m_serverEndpoint,
-                           [this](const asio::error_code &error, std::size_t bytesTransferred)
-                           { handleSend(error, bytesTransferred); });
+    if (!m_linkConditioned.load(std::memory_order_acquire))
+    {
+        sendDatagram(std::move(packet));
+        return;
+    }
+    // Senders run on the caller's thread too, the simulated link belongs to the IO thread
+    asio::post(m_ioContext,
+               [this, packet = std::move(packet)]() mutable { conditionDatagram(std::move(packet)); });
 }
 
-void eng::AsioClient::sendPlayerInputAsEvent(std::uint16_t playerId, uint8_t direction, uint8_t shooting,
-                                             uint32_t clientTimeMs)
+void eng::AsioClient::setLinkConditions(const rnp::LinkConditions &conditions)
 {
-    rnp::EventRecord ev;
-    ev.type = rnp::EventType::INPUT;
-    ev.entityId = playerId;
-
-    // Data: buttons(2, BE) | direction(1) | shooting(1) | client_time_ms(4, BE)
-    std::uint16_t buttons = 0; // TODO: map from direction/shooting to buttons
-    ev.data.push_back(static_cast<uint8_t>((buttons >> 8) & 0xFF));
-    ev.data.push_back(static_cast<uint8_t>(buttons & 0xFF));
-    ev.data.push_back(direction);
-    ev.data.push_back(shooting);
-    ev.data.push_back(static_cast<uint8_t>((clientTimeMs >> 24) & 0xFF));
-    ev.data.push_back(static_cast<uint8_t>((clientTimeMs >> 16) & 0xFF));
-    ev.data.push_back(static_cast<uint8_t>((clientTimeMs >> 8) & 0xFF));
-    ev.data.push_back(static_cast<uint8_t>(clientTimeMs & 0xFF));
-
-    std::vector<rnp::EventRecord> events;
-    events.push_back(ev);
-
-    const std::vector<uint8_t> eventsPayload = rnp::serializeEvents(events);
-
-    rnp::PacketHeader header;
-    header.type = static_cast<std::uint8_t>(rnp::PacketType::ENTITY_EVENT);
-    header.length = static_cast<std::uint16_t>(eventsPayload.size());
-    header.flags = 0;
-    header.reserved = 0;
-    header.sequence = ++m_sequenceNumber;
-    header.sessionId = m_sessionId;
-
-    std::vector<uint8_t> buffer = rnp::serialize(header, eventsPayload.data());
-
-    m_socket.async_send_to(asio::buffer(buffer), m_serverEndpoint,
-                           [this](const asio::error_code &error, std::size_t bytesTransferred)
-                           { handleSend(error, bytesTransferred); });
+    asio::post(m_ioContext, [this, conditions]() { m_link.emplace(conditions); });
+    m_linkConditioned.store(true, std::memory_order_release);
 }
 
-void eng::AsioClient::sendPing()
+void eng::AsioClient::conditionDatagram(SendPool::Lease packet)
 {
-    rnp::PacketHeader header;
-    header.type = static_cast<std::uint8_t>(rnp::PacketType::PING);
-    header.length = 0;
-    header.flags = 0;
-    header.reserved = 0;
-    header.sequence = ++m_sequenceNumber;
-    header.sessionId = m_sessionId;
+    const rnp::LinkConditioner::Delivery delivery = m_link->send(std::chrono::steady_clock::now(), packet.size());
+    for (std::uint8_t copy = 0; copy < delivery.copies; ++copy)
+    {
+        SendPool::Lease sent = copy + 1 < delivery.copies ? m_sendPool.acquire() : std::move(packet);
+        if (!sent)
+        {
+            continue;
+        }
+        if (copy + 1 < delivery.copies)
+        {
+            std::ranges::copy(packet.data(), sent.buffer().begin());
+            sent.resize(packet.size());
+        }
+        m_linkQueue.push(delivery.at[copy], std::move(sent));
+    }
+    scheduleLink();
+}
 
-    std::vector<uint8_t> buffer = rnp::serialize(header);
+void eng::AsioClient::scheduleLink()
+{
+    // The timer is only moved when a datagram is due before the one it waits for
+    const std::optional<std::chrono::steady_clock::time_point> due = m_linkQueue.nextDue();
+    if (!due || (m_linkTimerDue && *m_linkTimerDue <= *due))
+    {
+        return;
+    }
+    m_linkTimerDue = due;
+    m_linkTimer.expires_at(*due);
+    m_linkTimer.async_wait(
+        [this](const asio::error_code &error)
+        {
+            if (error)
+            {
+                return;
+            }
+            m_linkTimerDue.reset();
+            m_linkQueue.popDue(std::chrono::steady_clock::now(),
+                               [this](SendPool::Lease &&packet) { sendDatagram(std::move(packet)); });
+            scheduleLink();
+        });
+}
 
-    m_socket.async_send_to(asio::buffer(buffer), m_serverEndpoint,
-                           [this](const asio::error_code &error, std::size_t bytesTransferred)
+void eng::AsioClient::sendDatagram(SendPool::Lease packet)
+{
+    // The lease rides along with the completion handler so the buffer outlives the asynchronous send
+    const asio::const_buffer buffer = asio::buffer(packet.data().data(), packet.size());
+    m_socket.async_send_to(buffer, m_serverEndpoint,
+                           [this, packet = std::move(packet)](const asio::error_code &error,
+                                                              std::size_t bytesTransferred)
                            { handleSend(error, bytesTransferred); });
 }
 
-void eng::AsioClient::sendPing(std::uint32_t nonce, std::uint32_t sendTimeMs)
+void eng::AsioClient::sendConnect(const std::string &playerName)
 {
-    rnp::PacketHeader header;
-    header.type = static_cast<std::uint8_t>(rnp::PacketType::PING);
+    std::uint32_t caps = static_cast<std::uint32_t>(rnp::Capability::QUANTIZED_STATE) |
+                         static_cast<std::uint32_t>(rnp::Capability::LZ_COMPRESSION) |
+                         static_cast<std::uint32_t>(rnp::Capability::MESSAGE_BATCHING) |
+                         static_cast<std::uint32_t>(rnp::Capability::REDUNDANT_INPUT);
+    if (!m_codec.dictionary().empty())
+    {
+        caps |= static_cast<std::uint32_t>(rnp::Capability::COMPRESSION_DICTIONARY);
+    }
+    sendConnectWithCaps(playerName, caps);
+}
 
-    // Payload: nonce(4, BE) | send_time_ms(4, BE)
-    std::vector<uint8_t> payload;
+void eng::AsioClient::sendConnectWithCaps(const std::string &playerName, std::uint32_t clientCaps)
+{
+    // Payload: name_len(1) | player_name[name_len] | client_caps(4, BE)
+    const std::size_t nameLen = std::min<std::size_t>(playerName.size(), 31);
 
-    // nonce (4 bytes, big endian)
-    payload.push_back(static_cast<uint8_t>((nonce >> 24) & 0xFF));
-    payload.push_back(static_cast<uint8_t>((nonce >> 16) & 0xFF));
-    payload.push_back(static_cast<uint8_t>((nonce >> 8) & 0xFF));
-    payload.push_back(static_cast<uint8_t>(nonce & 0xFF));
+    m_clientCaps = clientCaps;
+    sendPacket(rnp::PacketType::CONNECT,
+               static_cast<std::uint16_t>(rnp::PacketFlags::RELIABLE) |
+                   static_cast<std::uint16_t>(rnp::PacketFlags::ACK_REQ),
+               [&playerName, nameLen, clientCaps](rnp::BufferWriter &writer)
+               {
+                   writer.write(static_cast<std::uint8_t>(nameLen));
+                   writer.writeBytes({reinterpret_cast<const std::uint8_t *>(playerName.data()), nameLen});
+                   writer.write(clientCaps);
+               });
+}
 
-    // send_time_ms (4 bytes, big endian)
-    payload.push_back(static_cast<uint8_t>((sendTimeMs >> 24) & 0xFF));
-    payload.push_back(static_cast<uint8_t>((sendTimeMs >> 16) & 0xFF));
-    payload.push_back(static_cast<uint8_t>((sendTimeMs >> 8) & 0xFF));
-    payload.push_back(static_cast<uint8_t>(sendTimeMs & 0xFF));
+void eng::AsioClient::sendDisconnect() { sendDisconnect(rnp::DisconnectReason::CLIENT_REQUEST); }
 
-    header.length = payload.size();
-    header.flags = 0;
-    header.reserved = 0;
-    header.sequence = ++m_sequenceNumber;
-    header.sessionId = m_sessionId;
+void eng::AsioClient::sendDisconnect(rnp::DisconnectReason reason)
+{
+    const rnp::PacketDisconnect disconnect{.reasonCode = static_cast<std::uint16_t>(reason)};
 
-    std::vector<uint8_t> buffer = rnp::serialize(header, payload.data());
+    sendPacket(rnp::PacketType::DISCONNECT, 0,
+               [&disconnect](rnp::BufferWriter &writer) { rnp::write(writer, disconnect); });
+}
 
-    m_socket.async_send_to(asio::buffer(buffer), m_serverEndpoint,
-                           [this](const asio::error_code &error, std::size_t bytesTransferred)
-                           { handleSend(error, bytesTransferred); });
+void eng::AsioClient::sendPlayerInput(uint8_t direction, uint8_t shooting)
+{
+    sendPacket(rnp::PacketType::PLAYER_INPUT, 0,
+               [direction, shooting](rnp::BufferWriter &writer)
+               {
+                   writer.write(direction);
+                   writer.write(shooting);
+               });
 }
 
-void eng::AsioClient::sendAck(std::uint32_t cumulative, std::uint32_t ackBits)
+void eng::AsioClient::sendPlayerInputAsEvent(std::uint16_t playerId, uint8_t direction, uint8_t shooting,
+                                             uint32_t clientTimeMs)
 {
-    rnp::PacketHeader header;
-    header.type = static_cast<std::uint8_t>(rnp::PacketType::ACK);
+    const rnp::InputEventData input{.buttons = 0, // TODO: map from direction/shooting to buttons
+                                    .direction = direction,
+                                    .shooting = shooting,
+                                    .clientTimeMs = clientTimeMs};
 
-    // Payload: cumulative_ack(4, BE) | ack_bits(4, BE)
-    std::vector<uint8_t> payload;
+    m_inputEntityId.store(playerId, std::memory_order_relaxed);
+    if (!rnp::hasCapability(sessionCaps(), rnp::Capability::REDUNDANT_INPUT))
+    {
+        sendPacket(rnp::PacketType::ENTITY_EVENT, 0, [playerId, &input](rnp::BufferWriter &writer)
+                   { rnp::writeEvent(writer, rnp::EventType::INPUT, playerId, input); });
+        return;
+    }
 
-    // cumulative_ack (4 bytes, big endian)
-    payload.push_back(static_cast<uint8_t>((cumulative >> 24) & 0xFF));
-    payload.push_back(static_cast<uint8_t>((cumulative >> 16) & 0xFF));
-    payload.push_back(static_cast<uint8_t>((cumulative >> 8) & 0xFF));
-    payload.push_back(static_cast<uint8_t>(cumulative & 0xFF));
+    // Every event repeats the last frames, a lost one is covered by the next instead of a retransmission
+    m_inputHistory.push(input);
+    std::array<std::uint8_t, rnp::MAX_INPUT_FRAMES_SIZE> frames{};
+    rnp::BufferWriter framesWriter(frames);
+    m_inputHistory.write(framesWriter);
+    sendPacket(rnp::PacketType::ENTITY_EVENT, 0, [playerId, &framesWriter](rnp::BufferWriter &writer)
+               { rnp::writeEvent(writer, rnp::EventType::INPUT_FRAMES, playerId, framesWriter.written()); });
+}
 
-    // ack_bits (4 bytes, big endian)
-    payload.push_back(static_cast<uint8_t>((ackBits >> 24) & 0xFF));
-    payload.push_back(static_cast<uint8_t>((ackBits >> 16) & 0xFF));
-    payload.push_back(static_cast<uint8_t>((ackBits >> 8) & 0xFF));
-    payload.push_back(static_cast<uint8_t>(ackBits & 0xFF));
+void eng::AsioClient::sendPing()
+{
+    sendPacket(rnp::PacketType::PING, 0, [](rnp::BufferWriter &) {});
+}
+
+void eng::AsioClient::sendPing(std::uint32_t nonce, std::uint32_t sendTimeMs)
+{
+    const rnp::PacketPingPong ping{.nonce = nonce, .sendTimeMs = sendTimeMs};
 
-    header.length = payload.size();
-    header.flags = 0;
-    header.reserved = 0;
-    header.sequence = ++m_sequenceNumber;
-    header.sessionId = m_sessionId;
+    sendPacket(rnp::PacketType::PING, 0, [&ping](rnp::BufferWriter &writer) { rnp::write(writer, ping); });
+}
 
-    m_lastAckSent = cumulative;
-    std::vector<uint8_t> buffer = rnp::serialize(header, payload.data());
+void eng::AsioClient::sendAck(std::uint32_t cumulative, std::uint32_t ackBits)
+{
+    const rnp::PacketAck ack{.cumulativeAck = cumulative, .ackBits = ackBits};
 
-    m_socket.async_send_to(asio::buffer(buffer), m_serverEndpoint,
-                           [this](const asio::error_code &error, std::size_t bytesTransferred)
-                           { handleSend(error, bytesTransferred); });
+    sendPacket(rnp::PacketType::ACK, 0, [&ack](rnp::BufferWriter &writer) { rnp::write(writer, ack); });
 }
 
-void eng::AsioClient::setPacketHandler(rnp::PacketType type, PacketHandler handler)
+void eng::AsioClient::sendWorldStateAck(std::uint32_t serverTick)
 {
-    m_packetHandlers[type] = handler;
+    const rnp::PacketWorldStateAck ack{.serverTick = serverTick};
+
+    sendPacket(rnp::PacketType::WORLD_STATE_ACK, 0, [&ack](rnp::BufferWriter &writer) { rnp::write(writer, ack); });
 }
 
-void eng::AsioClient::setEventsHandler(std::function<void(const std::vector<rnp::EventRecord> &)> handler)
+void eng::AsioClient::setPacketHandler(rnp::PacketType type, PacketHandler handler)
 {
-    m_eventsHandler = std::move(handler);
+    const auto index = static_cast<std::size_t>(type);
+    if (index < m_packetHandlers.size())
+    {
+        m_packetHandlers[index] = std::move(handler);
+    }
 }
 
-void eng::AsioClient::handleConnectAccept(const std::vector<uint8_t> &payload)
+void eng::AsioClient::setEventsHandler(EventsHandler handler) { m_eventsHandler = std::move(handler); }
+
+void eng::AsioClient::handleConnectAccept(std::span<const uint8_t> payload)
 {
-    if (payload.size() < 12)
+    rnp::BufferReader reader(payload);
+    rnp::PacketConnectAccept accept{};
+    if (!rnp::read(reader, accept))
     {
         std::cerr << "[AsioClient] Invalid CONNECT_ACCEPT payload\n";
         return;
     }
 
-    // session_id(4, BE)
-    m_sessionId = (static_cast<std::uint32_t>(payload[0]) << 24) | (static_cast<std::uint32_t>(payload[1]) << 16) |
-                  (static_cast<std::uint32_t>(payload[2]) << 8) | static_cast<std::uint32_t>(payload[3]);
-
-    // tick_rate_hz(2, BE)
-    m_serverTickRate = (static_cast<std::uint16_t>(payload[4]) << 8) | static_cast<std::uint16_t>(payload[5]);
-
-    // mtu_payload_bytes(2, BE)
-    m_serverMtu = (static_cast<std::uint16_t>(payload[6]) << 8) | static_cast<std::uint16_t>(payload[7]);
-
-    // server_caps(4, BE)
-    m_serverCaps = (static_cast<std::uint32_t>(payload[8]) << 24) | (static_cast<std::uint32_t>(payload[9]) << 16) |
-                   (static_cast<std::uint32_t>(payload[10]) << 8) | static_cast<std::uint32_t>(payload[11]);
+    m_sessionId = accept.sessionId;
+    m_serverTickRate = accept.tickRateHz;
+    m_serverMtu = accept.mtuPayloadBytes;
+    m_serverCaps = accept.serverCaps;
 
     m_connected = true;
-    std::cout << "[AsioClient] Connection accepted - Session ID: " << m_sessionId << ", Tick Rate: " << m_serverTickRate
-              << " Hz" << ", MTU: " << m_serverMtu << " bytes\n";
+    std::cout << "[AsioClient] Connection accepted - Session ID: " << accept.sessionId
+              << ", Tick Rate: " << accept.tickRateHz << " Hz" << ", MTU: " << accept.mtuPayloadBytes << " bytes\n";
 }
 
-void eng::AsioClient::handleReliablePacket(const rnp::PacketHeader &header)
+void eng::AsioClient::processAck(std::span<const uint8_t> payload)
 {
-    // Track reliable packets (simplified implementation)
-    // In production, implement proper acknowledgment tracking
+    rnp::BufferReader reader(payload);
+    rnp::PacketAck ack{};
+    if (!rnp::read(reader, ack))
+    {
+        return;
+    }
+    std::scoped_lock lock(m_reliableMutex);
+    m_reliableSender.acknowledge(ack);
 }
 
-void eng::AsioClient::processAck(const std::vector<uint8_t> &payload)
+void eng::AsioClient::processWorldState(std::span<const uint8_t> payload)
 {
-    if (payload.size() < 8)
+    rnp::BufferReader reader(payload);
+    rnp::WorldStateHeader worldState{};
+    if (!rnp::read(reader, worldState) || worldState.chunkCount == 0 ||
+        worldState.chunkCount > rnp::MAX_WORLD_STATE_CHUNKS || worldState.chunkIndex >= worldState.chunkCount ||
+        (worldState.baselineTick != 0 && worldState.serverTick - worldState.baselineTick >= rnp::WORLD_STATE_HISTORY))
     {
+        std::cerr << "[AsioClient] Erreur de parsing WORLD_STATE: invalid chunk\n";
         return;
     }
 
-    // cumulative_ack (4 bytes, big endian)
-    std::uint32_t cumulative = (static_cast<std::uint32_t>(payload[0]) << 24) |
-                               (static_cast<std::uint32_t>(payload[1]) << 16) |
-                               (static_cast<std::uint32_t>(payload[2]) << 8) | static_cast<std::uint32_t>(payload[3]);
+    // Drop chunks of a tick that is not newer than the last applied one (serial number arithmetic)
+    if (static_cast<std::int32_t>(worldState.serverTick - m_lastWorldStateTick) <= 0)
+    {
+        return;
+    }
+    // A delta is only usable if its baseline is still in the history
+    std::span<const rnp::EntityState> baseline;
+    if (worldState.baselineTick != 0)
+    {
+        const rnp::PacketWorldState &slot = m_worldStateHistory[worldState.baselineTick % rnp::WORLD_STATE_HISTORY];
+        if (slot.serverTick != worldState.baselineTick)
+        {
+            return;
+        }
+        baseline = slot.entities;
+    }
+    if (worldState.serverTick != m_pendingWorldState.serverTick)
+    {
+        if (m_pendingChunks != 0 &&
+            static_cast<std::int32_t>(worldState.serverTick - m_pendingWorldState.serverTick) < 0)
+        {
+            return;
+        }
+        // A newer tick started, whatever was left of the previous one is incomplete
+        m_pendingWorldState.serverTick = worldState.serverTick;
+        m_pendingWorldState.entities.clear();
+        m_pendingRemoved.clear();
+        m_pendingBaselineTick = worldState.baselineTick;
+        m_pendingChunks = 0;
+    }
 
-    // ack_bits (4 bytes, big endian)
-    std::uint32_t ackBits = (static_cast<std::uint32_t>(payload[4]) << 24) |
-                            (static_cast<std::uint32_t>(payload[5]) << 16) |
-                            (static_cast<std::uint32_t>(payload[6]) << 8) | static_cast<std::uint32_t>(payload[7]);
+    const std::uint32_t chunkBit = 1U << worldState.chunkIndex;
+    if ((m_pendingChunks & chunkBit) != 0 || worldState.baselineTick != m_pendingBaselineTick)
+    {
+        return;
+    }
 
-    // Remove acknowledged packets from pending reliable
-    m_pendingReliable.erase(cumulative);
+    // Decode in place at the end of the reusable buffers, records start from their baseline value
+    const rnp::EntityStateCodec codec(
+        rnp::hasCapability(sessionCaps(), rnp::Capability::QUANTIZED_STATE));
+    const std::size_t removedOffset = m_pendingRemoved.size();
+    const std::size_t entitiesOffset = m_pendingWorldState.entities.size();
+    rnp::BitReader bits(reader.rest());
+    std::uint32_t previousId = 0;
+    for (std::uint16_t i = 0; i < worldState.removedCount && bits.ok(); ++i)
+    {
+        previousId = m_pendingRemoved.emplace_back(codec.readId(bits, previousId));
+    }
+    previousId = 0;
+    for (std::uint16_t i = 0; i < worldState.entityCount && bits.ok(); ++i)
+    {
+        const std::uint32_t id = codec.readId(bits, previousId);
+        const rnp::EntityState *previous = rnp::findEntity(baseline, id);
+        rnp::EntityState &entity =
+            m_pendingWorldState.entities.emplace_back(previous != nullptr ? *previous : rnp::EntityState{});
+        entity.id = id;
+        codec.readRecord(bits, entity);
+        previousId = id;
+    }
+    if (!bits.ok())
+    {
+        std::cerr << "[AsioClient] Erreur de parsing WORLD_STATE: truncated chunk\n";
+        m_pendingRemoved.resize(removedOffset);
+        m_pendingWorldState.entities.resize(entitiesOffset);
+        return;
+    }
+    m_pendingChunks |= chunkBit;
 
-    // Process ack bits for selective acknowledgment
-    for (int i = 0; i < 32; ++i)
+    const std::uint32_t allChunks =
+        worldState.chunkCount == rnp::MAX_WORLD_STATE_CHUNKS ? ~0U : (1U << worldState.chunkCount) - 1U;
+    if (m_pendingChunks != allChunks)
     {
-        if (ackBits & (1 << i))
-        {
-            m_pendingReliable.erase(cumulative - i - 1);
-        }
+        return;
+    }
+
+    // Every chunk arrived: rebuild the snapshot into the history, then publish a copy and ack it
+    rnp::PacketWorldState &snapshot = m_worldStateHistory[worldState.serverTick % rnp::WORLD_STATE_HISTORY];
+    rnp::applyDelta(baseline, m_pendingWorldState.entities, m_pendingRemoved, snapshot.entities);
+    snapshot.serverTick = worldState.serverTick;
+    snapshot.entityCount = static_cast<std::uint16_t>(snapshot.entities.size());
+    m_lastWorldStateTick = worldState.serverTick;
+    {
+        std::scoped_lock lock(m_worldStateMutex);
+        m_readyWorldState.serverTick = snapshot.serverTick;
+        m_readyWorldState.entityCount = snapshot.entityCount;
+        m_readyWorldState.entities.assign(snapshot.entities.begin(), snapshot.entities.end());
+        m_readyWorldState.inputAck = inputAck(snapshot.serverTick);
+        m_worldStateReady = true;
+    }
+    m_pendingWorldState.entities.clear();
+    m_pendingRemoved.clear();
+    m_pendingChunks = 0;
+
+    sendWorldStateAck(worldState.serverTick);
+}
+
+bool eng::AsioClient::pollWorldState(rnp::PacketWorldState &snapshot)
+{
+    std::scoped_lock lock(m_worldStateMutex);
+    if (!m_worldStateReady)
+    {
+        return false;
     }
+    std::swap(snapshot, m_readyWorldState);
+    m_worldStateReady = false;
+    return true;
 }
 
-void eng::AsioClient::processWorldState(const std::vector<uint8_t> &payload)
+void eng::AsioClient::processEntityEvent(std::span<const uint8_t> payload)
 {
     if (payload.size() < 6)
     {
+        // Legacy format without server_tick
+        const rnp::EventRange events(payload);
+        if (!events.isValid())
+        {
+            std::cerr << "[AsioClient] Erreur de parsing ENTITY_EVENT: truncated event\n";
+            return;
+        }
+        if (m_eventsHandler)
+        {
+            m_eventsHandler(events);
+        }
+        queueEvents(0, events);
         return;
     }
 
-    // server_tick (4 bytes, big endian)
-    std::uint32_t serverTick = (static_cast<std::uint32_t>(payload[0]) << 24) |
-                               (static_cast<std::uint32_t>(payload[1]) << 16) |
-                               (static_cast<std::uint32_t>(payload[2]) << 8) | static_cast<std::uint32_t>(payload[3]);
+    // New format with server_tick
+    // server_tick (4 bytes, big endian) | event_count (2 bytes, big endian)
+    rnp::BufferReader reader(payload);
+    rnp::EntityEventHeader eventHeader{};
+    (void)rnp::read(reader, eventHeader);
 
-    // entity_count (2 bytes, big endian)
-    std::uint16_t entityCount = (static_cast<std::uint16_t>(payload[4]) << 8) | static_cast<std::uint16_t>(payload[5]);
+    // Events serialized
+    const rnp::EventRange events(reader.rest());
+    if (!events.isValid() || events.size() != eventHeader.eventCount)
+    {
+        std::cerr << "[AsioClient] Erreur de parsing ENTITY_EVENT: truncated event\n";
+        return;
+    }
 
-    std::cout << "[AsioClient] World state received - Tick: " << serverTick << ", Entities: " << entityCount << "\n";
+    std::cout << "[AsioClient] Entity events received - Tick: " << eventHeader.serverTick
+              << ", Events: " << eventHeader.eventCount << "\n";
 
-    // TODO: Parse entities and call appropriate handler
+    recordInputEchoes(eventHeader.serverTick, events);
+    if (m_eventsHandler)
+    {
+        m_eventsHandler(events);
+    }
+    queueEvents(eventHeader.serverTick, events);
 }
 
-void eng::AsioClient::processEntityEvent(const std::vector<uint8_t> &payload)
+void eng::AsioClient::queueEvents(const std::uint32_t serverTick, const rnp::EventRange &events)
 {
-    try
+    for (const rnp::EventView event : events)
     {
-        if (payload.size() < 6)
+        NetworkEvent *queued = m_events.claim();
+        if (queued == nullptr)
         {
-            // Legacy format without server_tick
-            const std::vector<rnp::EventRecord> events = rnp::deserializeEvents(payload.data(), payload.size());
-            if (m_eventsHandler)
+            if (!m_eventsOverflow)
             {
-                m_eventsHandler(events);
+                std::cerr << "[AsioClient] Event queue full, events dropped until it is polled\n";
+                m_eventsOverflow = true;
             }
             return;
         }
+        m_eventsOverflow = false;
+        queued->serverTick = serverTick;
+        queued->type = event.type;
+        queued->entityId = event.entityId;
+        queued->size = static_cast<std::uint8_t>(std::min(event.data.size(), queued->data.size()));
+        std::copy_n(event.data.begin(), queued->size, queued->data.begin());
+        m_events.commit();
+    }
+}
 
-        // New format with server_tick
-        // server_tick (4 bytes, big endian)
-        std::uint32_t serverTick =
-            (static_cast<std::uint32_t>(payload[0]) << 24) | (static_cast<std::uint32_t>(payload[1]) << 16) |
-            (static_cast<std::uint32_t>(payload[2]) << 8) | static_cast<std::uint32_t>(payload[3]);
-
-        // event_count (2 bytes, big endian)
-        std::uint16_t eventCount =
-            (static_cast<std::uint16_t>(payload[4]) << 8) | static_cast<std::uint16_t>(payload[5]);
-
-        // Events serialized
-        const std::vector<rnp::EventRecord> events = rnp::deserializeEvents(payload.data() + 6, payload.size() - 6);
+bool eng::AsioClient::pollEvent(NetworkEvent &event)
+{
+    const NetworkEvent *queued = m_events.front();
+    if (queued == nullptr)
+    {
+        return false;
+    }
+    event.serverTick = queued->serverTick;
+    event.type = queued->type;
+    event.entityId = queued->entityId;
+    event.size = queued->size;
+    std::copy_n(queued->data.begin(), queued->size, event.data.begin());
+    m_events.pop();
+    return true;
+}
 
-        std::cout << "[AsioClient] Entity events received - Tick: " << serverTick << ", Events: " << eventCount << "\n";
+void eng::AsioClient::recordInputEchoes(const std::uint32_t serverTick, const rnp::EventRange &events)
+{
+    const std::uint32_t entityId = m_inputEntityId.load(std::memory_order_relaxed);
+    if (entityId == NO_INPUT_ENTITY)
+    {
+        return;
+    }
+    for (const rnp::EventView &event : events)
+    {
+        if (event.type != rnp::EventType::INPUT || event.entityId != entityId)
+        {
+            continue;
+        }
+        rnp::BufferReader reader(event.data);
+        rnp::InputEventData input{};
+        if (rnp::read(reader, input))
+        {
+            m_inputEchoes[m_nextInputEcho++ % m_inputEchoes.size()] = {.serverTick = serverTick,
+                                                                       .clientTimeMs = input.clientTimeMs};
+        }
+    }
+}
 
-        if (m_eventsHandler)
+std::uint32_t eng::AsioClient::inputAck(const std::uint32_t serverTick) const
+{
+    // The snapshot of a tick reflects the inputs echoed at earlier ticks, the latest of them acknowledges the others
+    std::uint32_t ack = 0;
+    std::optional<std::uint32_t> ackTick;
+    for (const InputEcho &echo : m_inputEchoes)
+    {
+        if (echo.serverTick != 0 && static_cast<std::int32_t>(echo.serverTick - serverTick) < 0 &&
+            (!ackTick || static_cast<std::int32_t>(echo.serverTick - *ackTick) > 0))
         {
-            m_eventsHandler(events);
+            ackTick = echo.serverTick;
+            ack = echo.clientTimeMs;
         }
     }
-    catch (const std::exception &e)
+    return ack;
+}
+
+void eng::AsioClient::scheduleReliability()
+{
+    m_reliabilityTimer.expires_after(rnp::ACK_DELAY);
+    m_reliabilityTimer.async_wait(
+        [this](const asio::error_code &error)
+        {
+            if (error)
+            {
+                return;
+            }
+            // Owed ACKs wait for the session id, CONNECT_ACCEPT is acknowledged once it is known. Those no packet
+            // carried within ACK_DELAY go out on their own
+            if (m_sessionId != 0)
+            {
+                sendClockPing();
+                std::scoped_lock lock(m_ackMutex);
+                m_receiveWindow.flushAcks([this](const rnp::PacketAck &ack)
+                                          { sendAck(ack.cumulativeAck, ack.ackBits); });
+            }
+            retransmitReliable();
+            scheduleReliability();
+        });
+}
+
+void eng::AsioClient::sendClockPing()
+{
+    std::optional<rnp::PacketPingPong> ping;
     {
-        std::cerr << "[AsioClient] Erreur de parsing ENTITY_EVENT: " << e.what() << "\n";
+        std::scoped_lock lock(m_clockMutex);
+        ping = m_clockSync.ping(std::chrono::steady_clock::now());
+    }
+    if (ping)
+    {
+        sendPing(ping->nonce, ping->sendTimeMs);
     }
 }
 
+std::optional<double> eng::AsioClient::getServerTickEstimate() const
+{
+    std::scoped_lock lock(m_clockMutex);
+    return m_clockSync.serverTick(std::chrono::steady_clock::now(), m_serverTickRate);
+}
+
+eng::ClockStats eng::AsioClient::getClockStats() const
+{
+    std::scoped_lock lock(m_clockMutex);
+    return m_clockSync.stats();
+}
+
 void eng::AsioClient::retransmitReliable()
 {
-    // Simplified retransmission logic
-    // In production, track timestamps and implement exponential backoff
-    for (const auto &[seq, data] : m_pendingReliable)
+    std::unique_lock lock(m_reliableMutex);
+    const std::size_t lost = m_reliableSender.retransmit(
+        std::chrono::steady_clock::now(),
+        [this](const std::span<const uint8_t> datagram)
+        {
+            SendPool::Lease packet = m_sendPool.acquire();
+            if (!packet)
+            {
+                return;
+            }
+            std::memcpy(packet.buffer().data(), datagram.data(), datagram.size());
+            packet.resize(datagram.size());
+            transmit(std::move(packet));
+        });
+    if (lost != 0)
+    {
+        std::cerr << "[AsioClient] " << lost << " reliable packet(s) lost after "
+                  << static_cast<int>(rnp::MAX_RETRANSMITS) << " retransmissions\n";
+    }
+    // Nothing ordered can be delivered past an unacknowledged message: the session is over
+    if (m_reliableSender.stalled())
     {
-        m_socket.async_send_to(asio::buffer(data), m_serverEndpoint,
-                               [this](const asio::error_code &error, std::size_t bytesTransferred)
-                               { handleSend(error, bytesTransferred); });
+        lock.unlock();
+        closeSession();
     }
 }
 
+void eng::AsioClient::closeSession()
+{
+    const std::uint32_t sessionId = m_sessionId;
+    if (sessionId == 0)
+    {
+        return;
+    }
+    std::cerr << "[AsioClient] Server stopped acknowledging reliable packets, session " << sessionId << " closed\n";
+    sendDisconnect(rnp::DisconnectReason::TIMEOUT);
+    {
+        std::scoped_lock lock(m_reliableMutex);
+        m_reliableSender.clear();
+    }
+    m_sessionId = 0;
+}
+
 void eng::AsioClient::startReceive()
 {
     m_socket.async_receive_from(asio::buffer(m_recvBuffer), m_serverEndpoint,
@@ -427,8 +831,7 @@ void eng::AsioClient::handleReceive(const asio::error_code &error, std::size_t b
 {
     if (!error)
     {
-        std::vector<uint8_t> data(m_recvBuffer.begin(), m_recvBuffer.begin() + bytesTransferred);
-        processPacket(data);
+        processPacket(std::span<const uint8_t>(m_recvBuffer.data(), bytesTransferred));
         startReceive();
     }
     else if (error != asio::error::operation_aborted)
@@ -446,103 +849,196 @@ void eng::AsioClient::handleSend(const asio::error_code &error, std::size_t byte
     }
 }
 
-void eng::AsioClient::processPacket(const std::vector<uint8_t> &data)
+void eng::AsioClient::processPacket(std::span<const uint8_t> datagram)
 {
     try
     {
-        rnp::PacketHeader header = rnp::deserializeHeader(data.data(), data.size());
-
-        std::vector<uint8_t> payload;
-        if (header.length > 0 && data.size() >= 16 + header.length)
+        const std::optional<rnp::PacketView> packet = rnp::PacketView::parse(datagram);
+        if (!packet)
         {
-            payload.assign(data.begin() + 16, data.begin() + 16 + header.length);
+            std::cerr << "[AsioClient] Malformed packet dropped\n";
+            return;
         }
+        rnp::PacketHeader header = packet->header();
+        std::span<const uint8_t> payload = packet->payload();
 
         // Vérifier la session ID (sauf pour CONNECT_ACCEPT)
-        if (static_cast<rnp::PacketType>(header.type) != rnp::PacketType::CONNECT_ACCEPT && m_sessionId != 0 &&
-            header.sessionId != m_sessionId)
+        const std::uint32_t sessionId = m_sessionId;
+        if (static_cast<rnp::PacketType>(header.type) != rnp::PacketType::CONNECT_ACCEPT && sessionId != 0 &&
+            header.sessionId != sessionId)
         {
             std::cerr << "[AsioClient] Invalid session ID in packet\n";
             return;
         }
 
-        // Gérer les flags de fiabilité
-        if (header.flags & static_cast<std::uint16_t>(rnp::PacketFlags::RELIABLE))
+        if (packet->ack())
         {
-            handleReliablePacket(header);
+            std::scoped_lock lock(m_reliableMutex);
+            m_reliableSender.acknowledge(*packet->ack());
         }
-        if (header.flags & static_cast<std::uint16_t>(rnp::PacketFlags::ACK_REQ))
+
+        // Gérer les flags de fiabilité: duplicates are acknowledged again but not handled twice, ordered messages
+        // beyond the channel window are not acknowledged at all
+        if (!m_channelReceiver.admits(header))
         {
-            sendAck(header.sequence, 0);
+            return;
         }
-
-        switch (static_cast<rnp::PacketType>(header.type))
         {
-            case rnp::PacketType::CONNECT_ACCEPT:
+            std::scoped_lock lock(m_ackMutex);
+            if (!m_receiveWindow.receive(header))
             {
-                handleConnectAccept(payload);
-                break;
+                return;
             }
-            case rnp::PacketType::WORLD_STATE:
+        }
+
+        // Fragments are buffered until the last one arrives, the message is then handled like a single packet
+        if (packet->hasFlag(rnp::PacketFlags::FRAG))
+        {
+            rnp::BufferReader reader(payload);
+            rnp::FragmentHeader fragment{};
+            if (!rnp::read(reader, fragment))
             {
-                processWorldState(payload);
-                break;
+                std::cerr << "[AsioClient] Malformed fragment dropped\n";
+                return;
             }
-            case rnp::PacketType::ENTITY_EVENT:
+            const std::optional<std::span<const uint8_t>> message = m_reassembler.push(fragment, reader.rest());
+            if (!message)
             {
-                processEntityEvent(payload);
-                break;
+                return;
             }
-            case rnp::PacketType::ACK:
+            payload = *message;
+            header.length = static_cast<std::uint16_t>(payload.size());
+            header.flags &= static_cast<std::uint16_t>(~static_cast<std::uint16_t>(rnp::PacketFlags::FRAG));
+        }
+        if (packet->hasFlag(rnp::PacketFlags::COMPRESSED))
+        {
+            const std::uint32_t caps = sessionCaps();
+            const std::optional<std::size_t> size =
+                rnp::hasCapability(caps, rnp::Capability::LZ_COMPRESSION)
+                    ? m_codec.decompress(payload, m_decompressBuffer,
+                                         rnp::hasCapability(caps, rnp::Capability::COMPRESSION_DICTIONARY))
+                    : std::nullopt;
+            if (!size)
             {
-                processAck(payload);
-                break;
+                std::cerr << "[AsioClient] Invalid compressed payload dropped\n";
+                return;
             }
-            case rnp::PacketType::PACKET_ERROR:
+            payload = std::span<const uint8_t>(m_decompressBuffer).first(*size);
+            header.length = static_cast<std::uint16_t>(payload.size());
+            header.flags &= static_cast<std::uint16_t>(~static_cast<std::uint16_t>(rnp::PacketFlags::COMPRESSED));
+        }
+
+        // Channel delivery rules: stale sequenced messages are dropped, early ordered ones wait for the gap
+        if (m_channelReceiver.receive(header, payload) != rnp::ChannelReceiver::Delivery::DELIVER)
+        {
+            return;
+        }
+        handleMessage(header, payload);
+        while (m_channelReceiver.popReady(header, m_orderedBuffer))
+        {
+            handleMessage(header, m_orderedBuffer);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "[AsioClient] Erreur de traitement du paquet: " << e.what() << "\n";
+    }
+}
+
+void eng::AsioClient::handleMessage(const rnp::PacketHeader &header, std::span<const uint8_t> payload)
+{
+    switch (static_cast<rnp::PacketType>(header.type))
+    {
+        case rnp::PacketType::CONNECT_ACCEPT:
+        {
+            handleConnectAccept(payload);
+            break;
+        }
+        case rnp::PacketType::WORLD_STATE:
+        {
+            processWorldState(payload);
+            break;
+        }
+        case rnp::PacketType::ENTITY_EVENT:
+        {
+            processEntityEvent(payload);
+            break;
+        }
+        case rnp::PacketType::ACK:
+        {
+            processAck(payload);
+            break;
+        }
+        case rnp::PacketType::PACKET_ERROR:
+        {
+            // Payload: error_code(2, BE) | msg_len(2, BE) | message
+            rnp::BufferReader reader(payload);
+            const auto errorCode = reader.read<std::uint16_t>();
+            const std::span<const uint8_t> message = reader.readBytes(reader.read<std::uint16_t>());
+            if (reader.ok())
             {
-                if (payload.size() >= 4)
-                {
-                    std::uint16_t errorCode =
-                        (static_cast<std::uint16_t>(payload[0]) << 8) | static_cast<std::uint16_t>(payload[1]);
-                    std::uint16_t msgLen =
-                        (static_cast<std::uint16_t>(payload[2]) << 8) | static_cast<std::uint16_t>(payload[3]);
-                    if (payload.size() >= 4 + msgLen)
-                    {
-                        std::string errorMsg(payload.begin() + 4, payload.begin() + 4 + msgLen);
-                        std::cerr << "[AsioClient] Error " << errorCode << ": " << errorMsg << "\n";
-                    }
-                }
-                break;
+                const std::string_view errorMsg(reinterpret_cast<const char *>(message.data()), message.size());
+                std::cerr << "[AsioClient] Error " << errorCode << ": " << errorMsg << "\n";
             }
-            case rnp::PacketType::PONG:
+            break;
+        }
+        case rnp::PacketType::DISCONNECT:
+        {
+            rnp::BufferReader reader(payload);
+            rnp::PacketDisconnect disconnect{};
+            if (rnp::read(reader, disconnect))
             {
-                if (payload.size() >= 8)
+                std::cerr << "[AsioClient] Disconnected by the server - Reason: " << disconnect.reasonCode << "\n";
+            }
+            break;
+        }
+        case rnp::PacketType::BATCH:
+        {
+            // Every coalesced message is handled as if it had its own datagram
+            rnp::PacketHeader entryHeader = header;
+            const bool valid = rnp::forEachBatched(
+                payload,
+                [&](const rnp::PacketType type, const std::span<const uint8_t> bytes)
                 {
-                    std::uint32_t nonce = (static_cast<std::uint32_t>(payload[0]) << 24) |
-                                          (static_cast<std::uint32_t>(payload[1]) << 16) |
-                                          (static_cast<std::uint32_t>(payload[2]) << 8) |
-                                          static_cast<std::uint32_t>(payload[3]);
-                    std::uint32_t sendTime = (static_cast<std::uint32_t>(payload[4]) << 24) |
-                                             (static_cast<std::uint32_t>(payload[5]) << 16) |
-                                             (static_cast<std::uint32_t>(payload[6]) << 8) |
-                                             static_cast<std::uint32_t>(payload[7]);
-                    std::cout << "[AsioClient] PONG received - nonce: " << nonce << ", time: " << sendTime << "\n";
-                }
-                break;
+                    entryHeader.type = static_cast<std::uint8_t>(type);
+                    entryHeader.length = static_cast<std::uint16_t>(bytes.size());
+                    handleMessage(entryHeader, bytes);
+                });
+            if (!valid)
+            {
+                std::cerr << "[AsioClient] Malformed batch dropped\n";
             }
-            default:
-                break;
+            break;
         }
-
-        // Appeler les handlers personnalisés
-        auto it = m_packetHandlers.find(static_cast<rnp::PacketType>(header.type));
-        if (it != m_packetHandlers.end())
+        case rnp::PacketType::PING:
         {
-            it->second(header, payload);
+            // Keepalive of the server, answered with the same nonce
+            rnp::BufferReader reader(payload);
+            rnp::PacketPingPong ping{};
+            (void)rnp::read(reader, ping);
+            sendPacket(rnp::PacketType::PONG, 0, [&ping](rnp::BufferWriter &writer) { rnp::write(writer, ping); });
+            break;
         }
+        case rnp::PacketType::PONG:
+        {
+            const auto now = std::chrono::steady_clock::now();
+            rnp::BufferReader reader(payload);
+            rnp::PacketPingPong pong{};
+            rnp::PacketPongClock clock{};
+            if (rnp::read(reader, pong) && rnp::read(reader, clock))
+            {
+                std::scoped_lock lock(m_clockMutex);
+                m_clockSync.onPong(pong, clock, m_serverTickRate, now);
+            }
+            break;
+        }
+        default:
+            break;
     }
-    catch (const std::exception &e)
+
+    // Appeler les handlers personnalisés
+    if (header.type < m_packetHandlers.size() && m_packetHandlers[header.type])
     {
-        std::cerr << "[AsioClient] Erreur de traitement du paquet: " << e.what() << "\n";
+        m_packetHandlers[header.type](header, payload);
     }
 }
@@ -6,21 +6,58 @@
 
 #pragma once
 
+#include <array>
+#include <chrono>
 #include <functional>
+#include <memory>
+#include <optional>
+#include <span>
 #include <string>
 #include <thread>
-#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #define ASIO_STANDALONE
 #include "asio.hpp"
 
+#include "AsioServer/Congestion.hpp"
+#include "AsioServer/EventRelay.hpp"
+#include "AsioServer/Interest.hpp"
+#include "AsioServer/RateLimit.hpp"
+#include "AsioServer/Replication.hpp"
+#include "AsioServer/SessionTable.hpp"
+#include "AsioServer/SnapshotHistory.hpp"
+#include "AsioServer/TimingWheel.hpp"
 #include "Interfaces/INetworkServer.hpp"
+#include "Interfaces/Protocol/Batch.hpp"
+#include "Interfaces/Protocol/Channel.hpp"
+#include "Interfaces/Protocol/Compression.hpp"
+#include "Interfaces/Protocol/Delta.hpp"
+#include "Interfaces/Protocol/Fragment.hpp"
+#include "Interfaces/Protocol/Input.hpp"
+#include "Interfaces/Protocol/LinkConditioner.hpp"
+#include "Interfaces/Protocol/PacketView.hpp"
 #include "Interfaces/Protocol/Protocol.hpp"
+#include "Interfaces/Protocol/Quantization.hpp"
+#include "Interfaces/Protocol/Reliability.hpp"
+#include "Utils/BufferPool.hpp"
+#include "Utils/MpscRing.hpp"
+#include "Utils/SpscRing.hpp"
 
 namespace srv
 {
 
+    ///
+    /// @brief How long a session may stay silent, in its handshake or after it
+    ///
+    struct SessionTimeouts
+    {
+            std::chrono::milliseconds handshake = HANDSHAKE_TIMEOUT;
+            std::chrono::milliseconds keepaliveAfter = KEEPALIVE_AFTER;
+            std::chrono::milliseconds keepaliveInterval = KEEPALIVE_INTERVAL;
+            std::chrono::milliseconds session = SESSION_TIMEOUT;
+    };
+
     ///
     /// @class AsioServer
     /// @brief Network implementation with asio for server
@@ -30,17 +67,40 @@ namespace srv
     {
         public:
             using PacketHandler = std::function<void(const asio::ip::udp::endpoint &, const rnp::PacketHeader &,
-                                                     const std::vector<uint8_t> &)>;
+                                                     std::span<const uint8_t>)>;
+            using ClientReassembler = rnp::FragmentReassembler<8, 2>; // Clients only send small messages
+            using ReliableSender = rnp::ReliableSender<64>;
+            struct ClientReliability
+            {
+                    rnp::ReceiveWindow received;
+                    ReliableSender sent;
+                    rnp::ChannelSender channels;
+                    rnp::ChannelReceiver delivery;
+            };
             using ClientInfo = struct
             {
                     asio::ip::udp::endpoint endpoint;
                     std::string playerName;
-                    uint32_t lastSequence;
                     bool connected;
                     std::uint16_t playerId;
                     std::uint32_t sessionId;
                     std::uint32_t clientCaps;
+                    std::uint32_t lastSnapshotAck; // Delta baseline, 0 until the first WORLD_STATE_ACK
+                    std::uint32_t sendSequence;    // Last sequence number sent in this session
+                    std::unique_ptr<ClientReassembler> reassembler;
+                    std::unique_ptr<ClientReliability> reliability;
+                    std::unique_ptr<rnp::MessageBatch> batch; // Unreliable messages waiting for the network tick
+                    std::unique_ptr<ClientInterest> interest;
+                    std::unique_ptr<ClientReplication> replication; // Snapshots rebuilt by the client, priorities
+                    std::unique_ptr<CongestionControl> congestion;  // Snapshot rate its link sustains
+                    std::optional<std::uint16_t> lastInputSequence; // Newest INPUT_FRAMES frame relayed
+                    TokenBucket ingress;                            // Packets the client may still send
+                    bool rateLimited;                               // Told so since its last admitted packet
+                    // Until the client sends a packet of its session, proving it received CONNECT_ACCEPT
+                    std::optional<std::chrono::steady_clock::time_point> handshakeSince;
+                    std::chrono::steady_clock::time_point lastHeard; // Last packet admitted
             };
+            using Sessions = SessionTable<asio::ip::udp::endpoint, ClientInfo>;
 
             AsioServer();
             ~AsioServer() override;
@@ -63,53 +123,183 @@ namespace srv
             void sendWorldState(const asio::ip::udp::endpoint &client, const std::vector<uint8_t> &worldData);
             void sendEntityEvent(const asio::ip::udp::endpoint &client, std::uint32_t serverTick,
                                  const std::vector<rnp::EventRecord> &events);
+            void sendEntityEvent(const asio::ip::udp::endpoint &client, std::uint32_t serverTick,
+                                 const rnp::EventRange &events);
             void sendEvents(const asio::ip::udp::endpoint &client, const std::vector<rnp::EventRecord> &events);
             void sendPong(const asio::ip::udp::endpoint &client, std::uint32_t nonce, std::uint32_t sendTimeMs);
             void sendPong(const asio::ip::udp::endpoint &client);
             void sendError(const asio::ip::udp::endpoint &client, rnp::ErrorCode errorCode,
                            const std::string &errorMessage);
             void sendError(const asio::ip::udp::endpoint &client, const std::string &errorMessage);
+            void sendDisconnect(const asio::ip::udp::endpoint &client, rnp::DisconnectReason reason);
             void sendAck(const asio::ip::udp::endpoint &client, std::uint32_t cumulative, std::uint32_t ackBits);
             void broadcastToAll(const std::vector<uint8_t> &data);
             void broadcastEntityEvents(std::uint32_t serverTick, const std::vector<rnp::EventRecord> &events);
             void broadcastEvents(const std::vector<rnp::EventRecord> &events);
+            void broadcastEvents(std::span<const uint8_t> eventsPayload);
+            ///
+            /// @brief Hand the snapshot of a tick to the IO thread, from the simulation thread only
+            /// It is copied into the egress ring, dropped if the IO thread is EGRESS_SNAPSHOTS ticks behind.
+            ///
+            void broadcastWorldState(std::uint32_t serverTick, std::span<const rnp::EntityState> entities) override;
+            void setViewport(const Viewport &viewport) override;
+            void setSnapshotBudget(std::size_t bytes) override;
+            ///
+            /// @brief Queue an event for the next broadcastWorldState(), from the simulation thread only
+            ///
+            void sendEvent(std::uint16_t playerId, rnp::EventType type, std::uint32_t entityId,
+                           std::span<const std::uint8_t> data) override;
+            [[nodiscard]] bool pollMessage(NetworkMessage &message) override { return m_ingress.tryPop(message); }
+            ///
+            /// @brief Give one client its own viewport instead of the server one, for spectators
+            ///
+            void setClientViewport(const asio::ip::udp::endpoint &client, const Viewport &viewport);
 
+            ///
+            /// @brief Observe the packets of a type, for tools and tests: the handler runs on the IO thread, after the
+            /// packet was handled, and must not touch the simulation
+            ///
             void setPacketHandler(rnp::PacketType type, PacketHandler handler);
-            void setTickRate(std::uint16_t tickRate) { m_tickRateHz = tickRate; }
-            void setServerCapabilities(std::uint32_t caps) { m_serverCaps = caps; }
+            void setTickRate(std::uint16_t tickRate) override { m_tickRateHz = tickRate; }
+            void setServerCapabilities(std::uint32_t caps) override { m_serverCaps = caps; }
+            void setLinkConditions(const rnp::LinkConditions &conditions) override;
+            ///
+            /// @brief Load the static dictionary shared with clients and advertise COMPRESSION_DICTIONARY
+            /// Call before start(), clients must load the same dictionary.
+            ///
+            void setCompressionDictionary(std::span<const uint8_t> dictionary);
+            ///
+            /// @brief Replace the default session timeouts, before start()
+            ///
+            void setSessionTimeouts(const SessionTimeouts &timeouts) { m_timeouts = timeouts; }
 
-            const std::unordered_map<asio::ip::udp::endpoint, ClientInfo> &getClients() const { return m_clients; }
+            const Sessions &getClients() const { return m_clients; }
 
         private:
             void startReceive();
             void handleReceive(const asio::error_code &error, std::size_t bytesTransferred);
             void handleSend(const asio::error_code &error, std::size_t bytesTransferred);
-            void processPacket(const asio::ip::udp::endpoint &sender, const std::vector<uint8_t> &data);
-            void addClient(const asio::ip::udp::endpoint &endpoint, const std::string &playerName,
-                           std::uint32_t clientCaps, std::uint32_t sessionId);
+            [[nodiscard]] bool admit(const asio::ip::udp::endpoint &sender, std::span<const uint8_t> datagram);
+            void processPacket(const asio::ip::udp::endpoint &sender, std::span<const uint8_t> datagram);
+            void handleMessage(const asio::ip::udp::endpoint &sender, ClientInfo *client,
+                               const rnp::PacketHeader &header, std::span<const uint8_t> payload);
+            ClientInfo *addClient(const asio::ip::udp::endpoint &endpoint, const std::string &playerName,
+                                  std::uint32_t clientCaps);
             void removeClient(const asio::ip::udp::endpoint &endpoint);
-            std::uint16_t getPlayerId(const asio::ip::udp::endpoint &endpoint) const;
-            std::uint32_t getSessionId(const asio::ip::udp::endpoint &endpoint) const;
-            void handleReliablePacket(const asio::ip::udp::endpoint &sender, const rnp::PacketHeader &header);
-            void processAck(const asio::ip::udp::endpoint &sender, const std::vector<uint8_t> &payload);
+            void queueMessage(NetworkMessage &&message);
+            void queueMessage(NetworkMessage &&message, std::span<const uint8_t> data);
+            void queueInput(const ClientInfo &clientInfo, std::uint32_t entityId, const rnp::InputEventData &input);
+            void drainEgress();
+            [[nodiscard]] bool admitHandshake(const asio::ip::udp::endpoint &sender);
+            void checkSessions();
+            void checkSession(std::uint32_t sessionId, std::chrono::steady_clock::time_point now);
+            void sendPing(const asio::ip::udp::endpoint &client);
+            void relayInputFrames(ClientInfo &clientInfo, const rnp::EventView &event);
+            void processAck(ClientInfo *client, std::span<const uint8_t> payload);
+            void scheduleReliability();
+            void flushAcks();
             void retransmitReliable();
+            void flushBatches();
+            void flushBatch(ClientInfo &clientInfo);
+
+            using SendPool = utl::BufferPool<rnp::HEADER_SIZE + rnp::MAX_PAYLOAD, 1024>;
+            static constexpr std::size_t INGRESS_MESSAGES = 4096; // Over 60 messages per client and tick
+            static constexpr std::size_t EGRESS_SNAPSHOTS = 8;
+            struct OutboundEvent
+            {
+                    std::uint16_t playerId = EVERY_PLAYER;
+                    rnp::EventType type = rnp::EventType::CUSTOM;
+                    std::uint32_t entityId = 0;
+                    std::uint8_t size = 0;
+                    std::array<std::uint8_t, 255> data{}; // The most an event carries
+            };
+            struct OutboundSnapshot
+            {
+                    std::uint32_t serverTick = 0;
+                    std::vector<rnp::EntityState> entities; // Keeps its capacity from one lap to the next
+                    std::vector<OutboundEvent> events;      // Sent by the simulation during the tick
+            };
+            using WorldStateChunks = std::array<SendPool::Lease, rnp::MAX_WORLD_STATE_CHUNKS>;
+
+            // The session of the client, resolved once per message, is nullptr for an endpoint without one
+            template <typename Encoder>
+            void sendPacket(const asio::ip::udp::endpoint &client, rnp::PacketType type, std::uint16_t flags,
+                            Encoder &&encodePayload);
+            template <typename Encoder>
+            void sendPacket(const asio::ip::udp::endpoint &client, ClientInfo *session, rnp::PacketType type,
+                            std::uint16_t flags, Encoder &&encodePayload);
+            template <typename Encoder>
+            bool batchMessage(ClientInfo *session, rnp::PacketType type, Encoder &encodePayload);
+            template <typename Encoder>
+            void sendOnChannel(const asio::ip::udp::endpoint &client, ClientInfo *session, rnp::PacketType type,
+                               std::uint16_t flags, std::uint16_t channel, Encoder &&encodePayload);
+            void sendPayload(const asio::ip::udp::endpoint &client, ClientInfo *session, rnp::PacketType type,
+                             std::uint16_t flags, std::uint16_t channel, SendPool::Lease packet);
+            [[nodiscard]] static std::uint16_t stampChannel(ClientInfo *session, rnp::PacketType type,
+                                                            std::uint16_t flags);
+            [[nodiscard]] std::size_t maxDatagramPayload() const;
+            [[nodiscard]] std::uint32_t sessionCaps(const ClientInfo *session) const;
+            bool compressPayload(std::uint32_t caps, SendPool::Lease &packet);
+            void sendMessage(const asio::ip::udp::endpoint &client, ClientInfo *session, rnp::PacketType type,
+                             std::uint16_t flags, std::uint16_t channel, std::span<const uint8_t> message);
+            void transmit(const asio::ip::udp::endpoint &client, SendPool::Lease packet);
+            void sendDatagram(const asio::ip::udp::endpoint &client, SendPool::Lease packet);
+            void scheduleLink();
+            void sendWorldStates(std::uint32_t serverTick);
+            void relayEvents(std::uint32_t serverTick);
+            void sendWorldDelta(ClientInfo &clientInfo, std::uint32_t serverTick,
+                                std::span<const rnp::EntityState> current, std::uint32_t baselineTick,
+                                std::span<const rnp::EntityState> baseline);
 
             asio::io_context m_ioContext;
             asio::ip::udp::socket m_socket;
+            asio::steady_timer m_reliabilityTimer; // Network tick (rnp::ACK_DELAY): ACKs, retransmissions, batches
             asio::ip::udp::endpoint m_remoteEndpoint;
-            std::array<uint8_t, rnp::MAX_PAYLOAD + 16> m_recvBuffer;
+            std::array<uint8_t, rnp::MAX_PAYLOAD + rnp::HEADER_SIZE> m_recvBuffer;
+            SendPool m_sendPool;
+            std::optional<rnp::LinkConditioner> m_link; // Simulated link datagrams go through, IO thread only
+            rnp::DelayLine<std::pair<asio::ip::udp::endpoint, SendPool::Lease>> m_linkQueue;
+            asio::steady_timer m_linkTimer;
+            std::optional<std::chrono::steady_clock::time_point> m_linkTimerDue;
 
             std::unique_ptr<asio::executor_work_guard<asio::io_context::executor_type>> m_workGuard;
             std::thread m_ioThread;
-            std::unordered_map<asio::ip::udp::endpoint, ClientInfo> m_clients;
-            std::unordered_map<rnp::PacketType, PacketHandler> m_packetHandlers;
-            uint32_t m_sequenceNumber = 0;
+            Sessions m_clients;
+            TimingWheel m_sessionDeadlines; // Handshake, keepalive and timeout checks by session id
+            SessionTimeouts m_timeouts;
+            std::vector<asio::ip::udp::endpoint> m_stalledClients; // Closed after a retransmission pass, reused
+            std::array<PacketHandler, rnp::PACKET_TYPE_COUNT> m_packetHandlers;
+            uint32_t m_sequenceNumber = 0; // Packets to endpoints without a session
+            std::uint16_t m_nextFragId = 0;
+            std::array<uint8_t, rnp::MAX_MESSAGE_SIZE> m_messageBuffer; // Oversized payloads, IO thread only
             std::uint16_t m_nextPlayerId = 1;
-            std::uint32_t m_nextSessionId = 1;
+            AddressBuckets m_unknownBuckets; // Senders without a session, IO thread only
+            TokenBucket m_handshakeBucket{HANDSHAKE_RATE, HANDSHAKE_BURST};
+            std::size_t m_pendingHandshakes = 0;
+            std::size_t m_droppedPackets = 0; // Over budget since the last report, IO thread only
+            std::chrono::steady_clock::time_point m_lastDropReport;
             std::uint16_t m_tickRateHz = 60;
+            std::uint32_t m_lastTick = 0; // Last tick sent and when, IO thread only
+            std::chrono::steady_clock::time_point m_lastTickSentAt = std::chrono::steady_clock::now();
             std::uint16_t m_mtuPayloadBytes = 508;
-            std::uint32_t m_serverCaps = 0;
-            std::unordered_map<std::uint32_t, std::vector<uint8_t>> m_pendingReliable;
-            std::unordered_map<asio::ip::udp::endpoint, std::uint32_t> m_clientLastAck;
+            std::uint32_t m_serverCaps = static_cast<std::uint32_t>(rnp::Capability::QUANTIZED_STATE) |
+                                         static_cast<std::uint32_t>(rnp::Capability::LZ_COMPRESSION) |
+                                         static_cast<std::uint32_t>(rnp::Capability::MESSAGE_BATCHING) |
+                                         static_cast<std::uint32_t>(rnp::Capability::REDUNDANT_INPUT);
+            rnp::LzCodec m_codec;
+            std::array<uint8_t, rnp::MAX_MESSAGE_SIZE> m_compressBuffer;   // Oversized payloads, IO thread only
+            std::array<uint8_t, rnp::MAX_MESSAGE_SIZE> m_decompressBuffer; // Received payloads, IO thread only
+            std::vector<uint8_t> m_orderedBuffer; // Held ordered message being handled, IO thread only
+            EventRelay m_relay;                   // Client events of the current tick, IO thread only
+            SnapshotHistory m_history;                                  // IO thread only
+            MessagePool m_messagePool;                                  // Data of the messages in m_ingress
+            utl::MpscRing<NetworkMessage, INGRESS_MESSAGES> m_ingress;  // IO thread to simulation
+            utl::SpscRing<OutboundSnapshot, EGRESS_SNAPSHOTS> m_egress; // Simulation to IO thread
+            std::vector<OutboundEvent> m_pendingEvents; // Until the next snapshot, simulation thread only
+            std::size_t m_droppedMessages = 0; // Ring or pool full since the last report, IO thread only
+            std::optional<Viewport> m_viewport;              // IO thread only
+            std::size_t m_snapshotBudgetBytes = 0;           // Entity data per snapshot, 0 for no limit, IO thread only
+            InterestGrid m_interestGrid;                     // Entities of the tick being sent, IO thread only
+            std::vector<rnp::EntityState> m_relevantCurrent; // Snapshot of one client, IO thread only
     }; // class AsioServer
 } // namespace srv
@@ -0,0 +1,224 @@
+///
+/// @file Congestion.hpp
+/// @brief This file contains the per-client estimation of the snapshot rate a link sustains
+/// @namespace srv
+///
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+namespace srv
+{
+
+    ///
+    /// @brief Bounds of the snapshot bytes per second allowed to one client
+    ///
+    inline constexpr std::size_t MIN_SEND_RATE = 4 * 1024;
+    inline constexpr std::size_t MAX_SEND_RATE = 1024 * 1024;
+    inline constexpr std::size_t INITIAL_SEND_RATE = 32 * 1024;
+
+    ///
+    /// @brief Smallest snapshot worth sending, below it snapshots are sent less often rather than smaller
+    ///
+    inline constexpr std::size_t MIN_SNAPSHOT_BYTES = 512;
+
+    ///
+    /// @brief Most game ticks between two snapshots of a client, 20 Hz at a 60 Hz tick rate
+    ///
+    inline constexpr std::uint32_t MAX_SNAPSHOT_INTERVAL = 3;
+
+    ///
+    /// @class CongestionControl
+    /// @brief Snapshot rate of one client, adapted from its WORLD_STATE_ACKs (AIMD)
+    /// Every CONGESTION_PERIOD, the period is congested when more than a tenth of the snapshots went unacknowledged
+    /// or when the round trip grew more than QUEUE_DELAY_TARGET over its minimum of the last seconds, a sign that
+    /// queues are building along the link. A congested period cuts the rate to 70% of what was delivered, others
+    /// raise it as long as the client actually uses it: doubling it until the first congestion, by RATE_INCREASE
+    /// after. The rate sets the snapshot budget and, once it falls below MIN_SNAPSHOT_BYTES per tick, how many ticks
+    /// are skipped between snapshots.
+    /// @namespace srv
+    ///
+    class CongestionControl
+    {
+        public:
+            using Clock = std::chrono::steady_clock;
+
+            static constexpr std::chrono::milliseconds CONGESTION_PERIOD{250};
+            static constexpr std::chrono::milliseconds QUEUE_DELAY_TARGET{50};
+            static constexpr std::size_t RATE_INCREASE = 1024; // Per period
+            static constexpr std::size_t LOSS_DIVISOR = 10;     // Congested beyond 1 loss in LOSS_DIVISOR
+
+            ///
+            /// @brief Snapshot bytes per second currently allowed
+            ///
+            [[nodiscard]] std::size_t rate() const { return m_rate; }
+
+            ///
+            /// @brief Smoothed round trip of the snapshots, from sending to their WORLD_STATE_ACK
+            ///
+            [[nodiscard]] std::optional<std::chrono::microseconds> roundTripTime() const { return m_smoothedRtt; }
+
+            ///
+            /// @brief Game ticks between two snapshots: the fewest leaving MIN_SNAPSHOT_BYTES per snapshot
+            ///
+            [[nodiscard]] std::uint32_t interval(const std::uint16_t tickRate) const
+            {
+                for (std::uint32_t ticks = 1; ticks < MAX_SNAPSHOT_INTERVAL; ++ticks)
+                {
+                    if (snapshotBudget(tickRate, ticks) >= MIN_SNAPSHOT_BYTES)
+                    {
+                        return ticks;
+                    }
+                }
+                return MAX_SNAPSHOT_INTERVAL;
+            }
+
+            ///
+            /// @brief Bytes one snapshot may take at the current interval
+            ///
+            [[nodiscard]] std::size_t snapshotBudget(const std::uint16_t tickRate) const
+            {
+                return snapshotBudget(tickRate, interval(tickRate));
+            }
+
+            [[nodiscard]] bool shouldSend(const std::uint32_t serverTick, const std::uint16_t tickRate) const
+            {
+                return !m_lastSentTick || serverTick - *m_lastSentTick >= interval(tickRate);
+            }
+
+            void onSent(const std::uint32_t serverTick, const std::size_t bytes,
+                        const Clock::time_point now = Clock::now())
+            {
+                update(now);
+                Sent &sent = m_sent[serverTick % m_sent.size()];
+                if (sent.state == State::PENDING)
+                {
+                    ++m_lost; // Never acknowledged in the whole ring
+                }
+                sent = {.serverTick = serverTick, .sentAt = now, .bytes = bytes, .state = State::PENDING};
+                m_lastSentTick = serverTick;
+            }
+
+            void onAcked(const std::uint32_t serverTick, const Clock::time_point now = Clock::now())
+            {
+                Sent &sent = m_sent[serverTick % m_sent.size()];
+                if (sent.serverTick != serverTick || (sent.state != State::PENDING && sent.state != State::LOST))
+                {
+                    return;
+                }
+                // A snapshot declared lost that still arrives was stuck in a queue: its round trip tells how long
+                const auto rtt = std::chrono::duration_cast<std::chrono::microseconds>(now - sent.sentAt);
+                m_smoothedRtt = m_smoothedRtt ? (7 * *m_smoothedRtt + rtt) / 8 : rtt;
+                m_periodMinRtt = m_periodMinRtt ? std::min(*m_periodMinRtt, rtt) : rtt;
+                if (sent.state == State::PENDING)
+                {
+                    ++m_acked;
+                    m_ackedBytes += sent.bytes;
+                }
+                sent.state = State::ACKED;
+            }
+
+        private:
+            enum class State : std::uint8_t
+            {
+                NONE,
+                PENDING,
+                ACKED,
+                LOST
+            };
+            struct Sent
+            {
+                    std::uint32_t serverTick = 0;
+                    Clock::time_point sentAt;
+                    std::size_t bytes = 0;
+                    State state = State::NONE;
+            };
+
+            [[nodiscard]] std::size_t snapshotBudget(const std::uint16_t tickRate, const std::uint32_t ticks) const
+            {
+                return tickRate == 0 ? m_rate : m_rate * ticks / tickRate;
+            }
+
+            ///
+            /// @brief Declare late snapshots lost, then adjust the rate once per CONGESTION_PERIOD
+            ///
+            void update(const Clock::time_point now)
+            {
+                if (!m_periodStart)
+                {
+                    m_periodStart = now;
+                    return;
+                }
+                const std::chrono::microseconds lossTimeout =
+                    std::max<std::chrono::microseconds>(m_smoothedRtt.value_or(std::chrono::milliseconds(250)) * 2,
+                                                        std::chrono::milliseconds(100));
+                for (Sent &sent : m_sent)
+                {
+                    if (sent.state == State::PENDING && now - sent.sentAt > lossTimeout)
+                    {
+                        sent.state = State::LOST;
+                        ++m_lost;
+                    }
+                }
+                const Clock::duration elapsed = now - *m_periodStart;
+                if (elapsed < CONGESTION_PERIOD)
+                {
+                    return;
+                }
+
+                // Base round trip: the minimum of the last BASE_RTT_PERIODS periods
+                if (m_periodMinRtt)
+                {
+                    m_minRtts[m_period % m_minRtts.size()] = *m_periodMinRtt;
+                    m_baseRtt = *m_periodMinRtt;
+                    for (std::size_t i = 0; i < std::min(m_period + 1, m_minRtts.size()); ++i)
+                    {
+                        m_baseRtt = std::min(m_baseRtt, m_minRtts[i]);
+                    }
+                    ++m_period;
+                }
+                const bool lossy = m_lost * LOSS_DIVISOR > m_acked + m_lost;
+                const bool queueing = m_periodMinRtt && *m_periodMinRtt - m_baseRtt > QUEUE_DELAY_TARGET;
+                const auto delivered = static_cast<std::size_t>(
+                    static_cast<double>(m_ackedBytes) / std::chrono::duration<double>(elapsed).count());
+                if (lossy || queueing)
+                {
+                    m_rate = std::max(MIN_SEND_RATE, std::min(m_rate, delivered) * 7 / 10);
+                    m_slowStart = false;
+                }
+                else if (m_rate < 2 * delivered)
+                {
+                    m_rate = std::min(MAX_SEND_RATE, m_slowStart ? m_rate * 2 : m_rate + RATE_INCREASE);
+                }
+
+                m_periodStart = now;
+                m_periodMinRtt.reset();
+                m_acked = 0;
+                m_lost = 0;
+                m_ackedBytes = 0;
+            }
+
+            static constexpr std::size_t BASE_RTT_PERIODS = 40;
+
+            std::array<Sent, 64> m_sent{}; // By server tick
+            std::optional<std::uint32_t> m_lastSentTick;
+            std::size_t m_rate = INITIAL_SEND_RATE;
+            bool m_slowStart = true; // Doubling the rate every period until the first congestion
+            std::optional<std::chrono::microseconds> m_smoothedRtt;
+            std::array<std::chrono::microseconds, BASE_RTT_PERIODS> m_minRtts{};
+            std::chrono::microseconds m_baseRtt{0};
+            std::size_t m_period = 0;
+            // Current period
+            std::optional<Clock::time_point> m_periodStart;
+            std::optional<std::chrono::microseconds> m_periodMinRtt;
+            std::size_t m_acked = 0;
+            std::size_t m_lost = 0;
+            std::size_t m_ackedBytes = 0;
+    }; // class CongestionControl
+
+} // namespace srv
@@ -0,0 +1,124 @@
+///
+/// @file EventRelay.hpp
+/// @brief This file contains the per-tick buffer of client events relayed to the other clients
+/// @namespace srv
+///
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Interfaces/Protocol/PacketView.hpp"
+#include "Interfaces/Protocol/Protocol.hpp"
+
+namespace srv
+{
+
+    ///
+    /// @class EventRelay
+    /// @brief Events received from clients during one tick, sent once per tick to every other client
+    /// Only the last INPUT of an entity is kept: an input supersedes the previous one. It is also echoed to its
+    /// sender, acknowledging every input up to its client time. Other events are relayed in the order they were
+    /// received. Events of the simulation go out with them, to one client or to all. Buffers are reused, queuing
+    /// does not allocate once they have grown.
+    /// @namespace srv
+    ///
+    class EventRelay
+    {
+        public:
+            ///
+            /// @brief Source of events relayed to every client, the sender included, and destination of every client
+            ///
+            static constexpr std::uint16_t EVERYONE = 0;
+
+            void push(const std::uint16_t source, const rnp::EventRange &events)
+            {
+                for (const rnp::EventView event : events)
+                {
+                    push(source, event);
+                }
+            }
+
+            void push(const std::uint16_t source, const rnp::EventView &event)
+            {
+                if (event.type == rnp::EventType::INPUT)
+                {
+                    const auto superseded = std::ranges::find_if(
+                        m_events, [source, &event](const Queued &queued)
+                        { return queued.live && queued.source == source && queued.type == rnp::EventType::INPUT &&
+                                 queued.entityId == event.entityId; });
+                    if (superseded != m_events.end())
+                    {
+                        superseded->live = false;
+                    }
+                }
+                queue(source, EVERYONE, event);
+            }
+
+            ///
+            /// @brief Queue an event of the simulation for the client of a player id, or for every client
+            ///
+            void pushTo(const std::uint16_t destination, const rnp::EventView &event)
+            {
+                queue(EVERYONE, destination, event);
+            }
+
+            [[nodiscard]] bool empty() const { return m_events.empty(); }
+
+            ///
+            /// @brief Call visit(const rnp::EventView &) for every queued event to relay to destination, in order
+            /// Its own events are left out, but for its last INPUT of each entity, echoed as an acknowledgement.
+            ///
+            template <typename Visit> void forEachFor(const std::uint16_t destination, Visit &&visit) const
+            {
+                for (const Queued &queued : m_events)
+                {
+                    if (queued.live && (queued.destination == EVERYONE || queued.destination == destination) &&
+                        (queued.source == EVERYONE || queued.source != destination ||
+                         queued.type == rnp::EventType::INPUT))
+                    {
+                        visit(rnp::EventView{.type = queued.type,
+                                             .entityId = queued.entityId,
+                                             .data = std::span(m_data).subspan(queued.offset, queued.length)});
+                    }
+                }
+            }
+
+            void clear()
+            {
+                m_events.clear();
+                m_data.clear();
+            }
+
+        private:
+            struct Queued
+            {
+                    bool live;
+                    rnp::EventType type;
+                    std::uint16_t source;      // Player id of the sender, EVERYONE for legacy inputs and the server
+                    std::uint16_t destination; // Player id it is for, EVERYONE for all
+                    std::uint32_t entityId;
+                    std::uint32_t offset; // Data in m_data
+                    std::uint8_t length;
+            };
+
+            void queue(const std::uint16_t source, const std::uint16_t destination, const rnp::EventView &event)
+            {
+                m_events.push_back({.live = true,
+                                    .type = event.type,
+                                    .source = source,
+                                    .destination = destination,
+                                    .entityId = event.entityId,
+                                    .offset = static_cast<std::uint32_t>(m_data.size()),
+                                    .length = static_cast<std::uint8_t>(event.data.size())});
+                m_data.insert(m_data.end(), event.data.begin(), event.data.end());
+            }
+
+            std::vector<Queued> m_events;
+            std::vector<std::uint8_t> m_data;
+    }; // class EventRelay
+
+} // namespace srv
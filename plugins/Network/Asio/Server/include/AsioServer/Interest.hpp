@@ -0,0 +1,261 @@
+///
+/// @file Interest.hpp
+/// @brief This file contains the area of interest filtering of world snapshots, per client
+/// @namespace srv
+///
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "Interfaces/INetworkServer.hpp"
+#include "Interfaces/Protocol/Protocol.hpp"
+
+namespace srv
+{
+
+    ///
+    /// @brief Distance around a viewport within which entities enter the relevant set
+    ///
+    inline constexpr float INTEREST_MARGIN = 128.F;
+
+    ///
+    /// @brief Extra distance a relevant entity may drift beyond the margin before it leaves the set
+    ///
+    inline constexpr float INTEREST_HYSTERESIS = 64.F;
+
+    ///
+    /// @brief Whether an entity is sent to every client, whatever its viewport: players and ALWAYS_RELEVANT ones
+    ///
+    [[nodiscard]] inline bool isAlwaysRelevant(const rnp::EntityState &entity)
+    {
+        return entity.type == static_cast<std::uint16_t>(rnp::EntityType::PLAYER) ||
+               (entity.stateFlags & static_cast<std::uint8_t>(rnp::EntityStateFlags::ALWAYS_RELEVANT)) != 0;
+    }
+
+    [[nodiscard]] constexpr Viewport expand(const Viewport &viewport, const float distance)
+    {
+        return {.x = viewport.x - distance,
+                .y = viewport.y - distance,
+                .width = viewport.width + 2 * distance,
+                .height = viewport.height + 2 * distance};
+    }
+
+    [[nodiscard]] constexpr bool contains(const Viewport &area, const rnp::EntityState &entity)
+    {
+        return entity.x >= area.x && entity.x <= area.x + area.width && entity.y >= area.y &&
+               entity.y <= area.y + area.height;
+    }
+
+    ///
+    /// @brief Copy the entities of a snapshot sorted by id whose id is in ids (sorted too)
+    ///
+    inline void selectEntities(const std::span<const rnp::EntityState> entities,
+                               const std::span<const std::uint32_t> ids, std::vector<rnp::EntityState> &selected)
+    {
+        selected.clear();
+        auto id = ids.begin();
+        for (const rnp::EntityState &entity : entities)
+        {
+            while (id != ids.end() && *id < entity.id)
+            {
+                ++id;
+            }
+            if (id == ids.end())
+            {
+                break;
+            }
+            if (*id == entity.id)
+            {
+                selected.push_back(entity);
+            }
+        }
+    }
+
+    ///
+    /// @class InterestGrid
+    /// @brief Uniform grid over the entities of one snapshot, built once per tick and queried for every client
+    /// The grid covers the bounding box of the snapshot, its cells grow when the box is too large for
+    /// MAX_CELLS_PER_AXIS of them. Always relevant entities are kept apart and never returned by query().
+    /// Buffers are reused, building does not allocate once they have grown.
+    /// @namespace srv
+    ///
+    class InterestGrid
+    {
+        public:
+            static constexpr float CELL_SIZE = 256.F;
+            static constexpr std::size_t MAX_CELLS_PER_AXIS = 64;
+
+            void build(const std::span<const rnp::EntityState> entities)
+            {
+                m_always.clear();
+                float minX = 0.F;
+                float minY = 0.F;
+                float maxX = 0.F;
+                float maxY = 0.F;
+                bool first = true;
+                for (const rnp::EntityState &entity : entities)
+                {
+                    if (isAlwaysRelevant(entity) || !std::isfinite(entity.x) || !std::isfinite(entity.y))
+                    {
+                        continue;
+                    }
+                    minX = first ? entity.x : std::min(minX, entity.x);
+                    minY = first ? entity.y : std::min(minY, entity.y);
+                    maxX = first ? entity.x : std::max(maxX, entity.x);
+                    maxY = first ? entity.y : std::max(maxY, entity.y);
+                    first = false;
+                }
+                m_originX = minX;
+                m_originY = minY;
+                m_cellSize = std::max({CELL_SIZE, (maxX - minX) / static_cast<float>(MAX_CELLS_PER_AXIS),
+                                       (maxY - minY) / static_cast<float>(MAX_CELLS_PER_AXIS)});
+                m_columns = cellIndex(maxX, m_originX) + 1;
+                m_rows = cellIndex(maxY, m_originY) + 1;
+
+                // Counting sort of the entity indices by cell
+                m_cellStart.assign(m_columns * m_rows + 1, 0);
+                m_cellOf.resize(entities.size());
+                for (std::uint32_t i = 0; i < entities.size(); ++i)
+                {
+                    const rnp::EntityState &entity = entities[i];
+                    if (isAlwaysRelevant(entity))
+                    {
+                        m_always.push_back(i);
+                        m_cellOf[i] = NO_CELL;
+                        continue;
+                    }
+                    if (!std::isfinite(entity.x) || !std::isfinite(entity.y))
+                    {
+                        m_cellOf[i] = NO_CELL;
+                        continue;
+                    }
+                    m_cellOf[i] = static_cast<std::uint32_t>(cellIndex(entity.y, m_originY) * m_columns +
+                                                             cellIndex(entity.x, m_originX));
+                    ++m_cellStart[m_cellOf[i] + 1];
+                }
+                for (std::size_t cell = 1; cell < m_cellStart.size(); ++cell)
+                {
+                    m_cellStart[cell] += m_cellStart[cell - 1];
+                }
+                m_entries.resize(m_cellStart.back());
+                m_cursor.assign(m_cellStart.begin(), m_cellStart.end() - 1);
+                for (std::uint32_t i = 0; i < entities.size(); ++i)
+                {
+                    if (m_cellOf[i] != NO_CELL)
+                    {
+                        m_entries[m_cursor[m_cellOf[i]]++] = i;
+                    }
+                }
+            }
+
+            ///
+            /// @brief Indices of the always relevant entities of the snapshot
+            ///
+            [[nodiscard]] std::span<const std::uint32_t> alwaysRelevant() const { return m_always; }
+
+            ///
+            /// @brief Call visit(std::uint32_t index) for the entities in the cells overlapping area
+            /// Cells are coarse: the caller tests the entity position itself.
+            ///
+            template <typename Visit> void query(const Viewport &area, Visit &&visit) const
+            {
+                if (m_entries.empty() || area.x + area.width < m_originX || area.y + area.height < m_originY)
+                {
+                    return;
+                }
+                const std::size_t firstColumn = cellIndex(area.x, m_originX);
+                const std::size_t lastColumn = std::min(cellIndex(area.x + area.width, m_originX), m_columns - 1);
+                const std::size_t firstRow = cellIndex(area.y, m_originY);
+                const std::size_t lastRow = std::min(cellIndex(area.y + area.height, m_originY), m_rows - 1);
+                for (std::size_t row = firstRow; row <= lastRow; ++row)
+                {
+                    for (std::size_t column = firstColumn; column <= lastColumn; ++column)
+                    {
+                        const std::size_t cell = row * m_columns + column;
+                        for (std::uint32_t entry = m_cellStart[cell]; entry < m_cellStart[cell + 1]; ++entry)
+                        {
+                            visit(m_entries[entry]);
+                        }
+                    }
+                }
+            }
+
+        private:
+            static constexpr std::uint32_t NO_CELL = ~std::uint32_t{0};
+
+            ///
+            /// @brief Cell of a coordinate along one axis, 0 below the origin, bounded far beyond the last cell
+            ///
+            [[nodiscard]] std::size_t cellIndex(const float coordinate, const float origin) const
+            {
+                const float cell = (coordinate - origin) / m_cellSize;
+                return cell > 0.F ? std::min(static_cast<std::size_t>(cell), MAX_CELLS_PER_AXIS * 2) : 0;
+            }
+
+            float m_originX = 0.F;
+            float m_originY = 0.F;
+            float m_cellSize = CELL_SIZE;
+            std::size_t m_columns = 0;
+            std::size_t m_rows = 0;
+            std::vector<std::uint32_t> m_cellStart; // First entry of each cell, plus the end of the last one
+            std::vector<std::uint32_t> m_cursor;
+            std::vector<std::uint32_t> m_entries; // Entity indices, grouped by cell
+            std::vector<std::uint32_t> m_cellOf;
+            std::vector<std::uint32_t> m_always;
+    }; // class InterestGrid
+
+    ///
+    /// @class ClientInterest
+    /// @brief Relevant set of one client
+    /// An entity enters the set within INTEREST_MARGIN of the viewport and leaves it beyond INTEREST_MARGIN +
+    /// INTEREST_HYSTERESIS, so entities moving along the edge do not flicker in and out.
+    /// @namespace srv
+    ///
+    class ClientInterest
+    {
+        public:
+            std::optional<Viewport> viewport; // Overrides the server viewport, for spectators
+
+            ///
+            /// @brief Compute the relevant ids of a new snapshot
+            /// @return the ids, sorted, valid until the next update()
+            ///
+            std::span<const std::uint32_t> update(const InterestGrid &grid,
+                                                  const std::span<const rnp::EntityState> entities,
+                                                  const Viewport &area)
+            {
+                std::swap(m_ids, m_previous);
+                m_ids.clear();
+                for (const std::uint32_t index : grid.alwaysRelevant())
+                {
+                    m_ids.push_back(entities[index].id);
+                }
+                const Viewport inner = expand(area, INTEREST_MARGIN);
+                const Viewport outer = expand(area, INTEREST_MARGIN + INTEREST_HYSTERESIS);
+                grid.query(outer,
+                           [&](const std::uint32_t index)
+                           {
+                               const rnp::EntityState &entity = entities[index];
+                               if (contains(inner, entity) ||
+                                   (contains(outer, entity) && std::ranges::binary_search(m_previous, entity.id)))
+                               {
+                                   m_ids.push_back(entity.id);
+                               }
+                           });
+                std::ranges::sort(m_ids);
+                return m_ids;
+            }
+
+        private:
+            std::vector<std::uint32_t> m_ids;
+            std::vector<std::uint32_t> m_previous;
+    }; // class ClientInterest
+
+} // namespace srv
@@ -0,0 +1,104 @@
+///
+/// @file RateLimit.hpp
+/// @brief This file contains the packet budgets datagrams are checked against before being parsed
+/// @namespace srv
+///
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+namespace srv
+{
+
+    ///
+    /// @brief Packets per second and burst allowed to a session, twice the rate the spec recommends to clients
+    ///
+    inline constexpr double SESSION_PACKET_RATE = 400.0;
+    inline constexpr double SESSION_PACKET_BURST = 100.0;
+
+    ///
+    /// @brief Packets per second and burst allowed to an address without a session, enough to connect
+    ///
+    inline constexpr double UNKNOWN_PACKET_RATE = 10.0;
+    inline constexpr double UNKNOWN_PACKET_BURST = 20.0;
+
+    ///
+    /// @brief CONNECTs per second and burst the whole server handles, whatever their source
+    ///
+    inline constexpr double HANDSHAKE_RATE = 100.0;
+    inline constexpr double HANDSHAKE_BURST = 50.0;
+
+    ///
+    /// @brief Sessions whose CONNECT_ACCEPT the client has not answered yet, and how long they are kept
+    ///
+    inline constexpr std::size_t MAX_PENDING_HANDSHAKES = 64;
+    inline constexpr std::chrono::seconds HANDSHAKE_TIMEOUT{5};
+
+    ///
+    /// @class TokenBucket
+    /// @brief Budget of packets refilled at a steady rate, up to a burst
+    /// @namespace srv
+    ///
+    class TokenBucket
+    {
+        public:
+            using Clock = std::chrono::steady_clock;
+
+            TokenBucket() : TokenBucket(SESSION_PACKET_RATE, SESSION_PACKET_BURST) {}
+            TokenBucket(const double rate, const double burst) : m_rate(rate), m_burst(burst), m_tokens(burst) {}
+
+            ///
+            /// @brief Take a token for a packet received at now
+            /// @return false if the budget is spent, the packet is to be dropped
+            ///
+            [[nodiscard]] bool consume(const Clock::time_point now)
+            {
+                if (m_last != Clock::time_point{})
+                {
+                    const double elapsed = std::chrono::duration<double>(now - m_last).count();
+                    m_tokens = std::min(m_burst, m_tokens + elapsed * m_rate);
+                }
+                m_last = now;
+                if (m_tokens < 1.0)
+                {
+                    return false;
+                }
+                m_tokens -= 1.0;
+                return true;
+            }
+
+        private:
+            double m_rate;   // Tokens per second
+            double m_burst;  // Most tokens held
+            double m_tokens; // Packets allowed right now
+            Clock::time_point m_last{};
+    }; // class TokenBucket
+
+    ///
+    /// @class AddressBuckets
+    /// @brief Token buckets of the senders without a session, indexed by a hash of their address
+    /// The table has a fixed size so a flood from spoofed addresses allocates nothing: addresses sharing a slot share
+    /// its budget, and a single host gains nothing by changing ports.
+    /// @namespace srv
+    ///
+    class AddressBuckets
+    {
+        public:
+            static constexpr std::size_t SLOTS = 1024;
+
+            AddressBuckets() { m_buckets.fill(TokenBucket(UNKNOWN_PACKET_RATE, UNKNOWN_PACKET_BURST)); }
+
+            [[nodiscard]] bool consume(const std::size_t addressHash, const TokenBucket::Clock::time_point now)
+            {
+                return m_buckets[addressHash % SLOTS].consume(now);
+            }
+
+        private:
+            std::array<TokenBucket, SLOTS> m_buckets;
+    }; // class AddressBuckets
+
+} // namespace srv
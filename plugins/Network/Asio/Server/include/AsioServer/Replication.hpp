@@ -0,0 +1,268 @@
+///
+/// @file Replication.hpp
+/// @brief This file contains the per-client priority accumulator choosing the snapshot contents within a budget
+/// @namespace srv
+///
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "Interfaces/Protocol/Delta.hpp"
+#include "Interfaces/Protocol/Protocol.hpp"
+#include "Interfaces/Protocol/Quantization.hpp"
+
+namespace srv
+{
+
+    ///
+    /// @brief Distance from the client's focus at which an entity gains half the priority of one at the focus
+    ///
+    inline constexpr float PRIORITY_DISTANCE_SCALE = 512.F;
+
+    ///
+    /// @brief Priority an entity with changes the client does not have gains every tick
+    /// Players and projectiles weigh most, new entities twice as much, and the gain falls with the distance to
+    /// the focus (the center of the client viewport) when there is one.
+    ///
+    [[nodiscard]] inline float priorityGain(const rnp::EntityState &entity, const bool isNew,
+                                            const std::optional<std::array<float, 2>> &focus)
+    {
+        float gain = 1.F;
+        switch (static_cast<rnp::EntityType>(entity.type))
+        {
+            case rnp::EntityType::PLAYER:
+                gain = 4.F;
+                break;
+            case rnp::EntityType::PROJECTILE:
+                gain = 3.F;
+                break;
+            case rnp::EntityType::ENEMY:
+                gain = 2.F;
+                break;
+            default:
+                break;
+        }
+        if (isNew)
+        {
+            gain *= 2.F;
+        }
+        if (focus && std::isfinite(entity.x) && std::isfinite(entity.y))
+        {
+            gain /= 1.F + std::hypot(entity.x - (*focus)[0], entity.y - (*focus)[1]) / PRIORITY_DISTANCE_SCALE;
+        }
+        return gain;
+    }
+
+    ///
+    /// @class ClientReplication
+    /// @brief What one client was sent: the snapshots it rebuilt and the priority of the changes it is missing
+    /// Deltas are encoded against the snapshot the client rebuilt at its acknowledged tick, so entities left out
+    /// of a tick simply keep their older value on the client. Every entity with changes to send accumulates
+    /// priority each tick it is left out and drops back to zero once sent: under a tight budget the most
+    /// important ones go first, and the others still go eventually. Buffers are reused, planning a tick does not
+    /// allocate once they have grown.
+    /// @namespace srv
+    ///
+    class ClientReplication
+    {
+        public:
+            struct Record
+            {
+                    std::uint32_t index; // In the current snapshot
+                    std::uint8_t fieldMask;
+            };
+
+            ///
+            /// @brief Snapshot the client rebuilt at serverTick, or std::nullopt if unknown or already overwritten
+            ///
+            [[nodiscard]] std::optional<std::span<const rnp::EntityState>> find(const std::uint32_t serverTick) const
+            {
+                const Slot &slot = m_slots[serverTick % m_slots.size()];
+                if (serverTick == 0 || slot.serverTick != serverTick)
+                {
+                    return std::nullopt;
+                }
+                return slot.entities;
+            }
+
+            ///
+            /// @brief Choose the contents of the next snapshot, against baseline and within budgetBits
+            /// Every removal is kept, then changed entities are taken by decreasing priority while they fit.
+            /// removed() and records() are sorted by id, ready to encode.
+            ///
+            void plan(const std::span<const rnp::EntityState> baseline, const std::span<const rnp::EntityState> current,
+                      const rnp::EntityStateCodec &codec, const std::size_t budgetBits,
+                      const std::optional<std::array<float, 2>> &focus)
+            {
+                m_removed.clear();
+                m_candidates.clear();
+                m_records.clear();
+
+                std::size_t usedBits = 0;
+                std::uint32_t previousId = 0;
+                rnp::forEachRemoved(baseline, current,
+                                    [&](const std::uint32_t id)
+                                    {
+                                        usedBits += codec.idBits(id, previousId);
+                                        previousId = id;
+                                        m_removed.push_back(id);
+                                    });
+
+                // Accumulate the priority of every changed entity, entities with nothing to send are forgotten
+                auto accumulated = m_priorities.begin();
+                previousId = 0;
+                rnp::forEachChanged(
+                    baseline, current, [&codec](const rnp::EntityState &from, const rnp::EntityState &to)
+                    { return codec.diff(from, to); },
+                    [&](const rnp::EntityState &entity, const std::uint8_t fieldMask)
+                    {
+                        while (accumulated != m_priorities.end() && accumulated->id < entity.id)
+                        {
+                            ++accumulated;
+                        }
+                        float priority = accumulated != m_priorities.end() && accumulated->id == entity.id
+                                             ? accumulated->priority
+                                             : 0.F;
+                        priority += priorityGain(entity, !rnp::findEntity(baseline, entity.id), focus);
+                        m_candidates.push_back(
+                            {.record = {.index = static_cast<std::uint32_t>(&entity - current.data()),
+                                        .fieldMask = fieldMask},
+                             .id = entity.id,
+                             .priority = priority,
+                             .bits = static_cast<std::uint32_t>(codec.idBits(entity.id, previousId) +
+                                                                codec.recordBits(fieldMask)),
+                             .selected = false});
+                        previousId = entity.id;
+                    });
+
+                m_order.resize(m_candidates.size());
+                for (std::uint32_t i = 0; i < m_order.size(); ++i)
+                {
+                    m_order[i] = i;
+                }
+                std::ranges::sort(m_order, [this](const std::uint32_t a, const std::uint32_t b)
+                                  { return m_candidates[a].priority > m_candidates[b].priority; });
+                const std::size_t removedBits = usedBits;
+                for (const std::uint32_t candidate : m_order)
+                {
+                    if (usedBits + m_candidates[candidate].bits <= budgetBits)
+                    {
+                        usedBits += m_candidates[candidate].bits;
+                        m_candidates[candidate].selected = true;
+                    }
+                }
+                // Skipped candidates lengthen the id deltas of the selected ones: drop the least important until the
+                // exact size fits
+                auto leastImportant = m_order.rbegin();
+                while (removedBits + selectedBits(codec) > budgetBits)
+                {
+                    while (leastImportant != m_order.rend() && !m_candidates[*leastImportant].selected)
+                    {
+                        ++leastImportant;
+                    }
+                    if (leastImportant == m_order.rend())
+                    {
+                        break;
+                    }
+                    m_candidates[*leastImportant++].selected = false;
+                }
+                for (const Candidate &candidate : m_candidates)
+                {
+                    if (candidate.selected)
+                    {
+                        m_records.push_back(candidate.record);
+                    }
+                }
+            }
+
+            [[nodiscard]] std::span<const std::uint32_t> removed() const { return m_removed; }
+            [[nodiscard]] std::span<const Record> records() const { return m_records; }
+
+            ///
+            /// @brief Remember what was actually encoded at serverTick: the first removedCount removals and
+            /// recordCount records of the plan
+            /// Their priority drops to zero, the others keep theirs, and the snapshot the client will rebuild from
+            /// them becomes a baseline.
+            ///
+            void commit(const std::uint32_t serverTick, const std::span<const rnp::EntityState> baseline,
+                        const std::span<const rnp::EntityState> current, const std::size_t removedCount,
+                        const std::size_t recordCount)
+            {
+                const std::span<const Record> sent = std::span(m_records).first(recordCount);
+                m_priorities.clear();
+                auto record = sent.begin();
+                for (const Candidate &candidate : m_candidates)
+                {
+                    const bool wasSent = record != sent.end() && record->index == candidate.record.index;
+                    if (wasSent)
+                    {
+                        ++record;
+                    }
+                    else
+                    {
+                        m_priorities.push_back({.id = candidate.id, .priority = candidate.priority});
+                    }
+                }
+
+                m_updates.clear();
+                for (const Record &update : sent)
+                {
+                    m_updates.push_back(current[update.index]);
+                }
+                Slot &slot = m_slots[serverTick % m_slots.size()];
+                slot.serverTick = serverTick;
+                rnp::applyDelta(baseline, m_updates, std::span(m_removed).first(removedCount), slot.entities);
+            }
+
+        private:
+            [[nodiscard]] std::size_t selectedBits(const rnp::EntityStateCodec &codec) const
+            {
+                std::size_t bits = 0;
+                std::uint32_t previousId = 0;
+                for (const Candidate &candidate : m_candidates)
+                {
+                    if (candidate.selected)
+                    {
+                        bits += codec.idBits(candidate.id, previousId) + codec.recordBits(candidate.record.fieldMask);
+                        previousId = candidate.id;
+                    }
+                }
+                return bits;
+            }
+
+            struct Candidate
+            {
+                    Record record;
+                    std::uint32_t id;
+                    float priority;
+                    std::uint32_t bits; // Estimated, the id delta is against the previous candidate
+                    bool selected;
+            };
+            struct Priority
+            {
+                    std::uint32_t id;
+                    float priority;
+            };
+            struct Slot
+            {
+                    std::uint32_t serverTick = 0;
+                    std::vector<rnp::EntityState> entities;
+            };
+
+            std::array<Slot, rnp::WORLD_STATE_HISTORY> m_slots{};
+            std::vector<Priority> m_priorities; // Sorted by id, entities left out of the last snapshot
+            std::vector<std::uint32_t> m_removed;
+            std::vector<Candidate> m_candidates; // Sorted by id
+            std::vector<std::uint32_t> m_order;
+            std::vector<Record> m_records;
+            std::vector<rnp::EntityState> m_updates;
+    }; // class ClientReplication
+
+} // namespace srv
@@ -0,0 +1,183 @@
+///
+/// @file SessionTable.hpp
+/// @brief This file contains the table of sessions, found by the slot their session id carries
+/// @namespace srv
+///
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace srv
+{
+
+    ///
+    /// @brief Sessions the server holds, pending or not, a power of two
+    ///
+    inline constexpr std::size_t MAX_SESSIONS = 256;
+    static_assert((MAX_SESSIONS & (MAX_SESSIONS - 1)) == 0);
+
+    ///
+    /// @brief Silence after which the server PINGs a session, once per KEEPALIVE_INTERVAL, then drops it
+    ///
+    inline constexpr std::chrono::seconds KEEPALIVE_AFTER{3};
+    inline constexpr std::chrono::seconds KEEPALIVE_INTERVAL{1};
+    inline constexpr std::chrono::seconds SESSION_TIMEOUT{15};
+
+    ///
+    /// @class SessionTable
+    /// @brief Sessions stored in MAX_SESSIONS slots, the low bits of a session id being its slot
+    /// A received packet finds its session from the id in its header without hashing anything, the endpoint index
+    /// is only for packets without a session id and for the endpoint-based API. The other bits of an id are random,
+    /// so a stale or guessed id does not match the session now in its slot. Slots never move, a session stays at
+    /// the same address until erased, and iterating visits the used slots only.
+    /// @namespace srv
+    ///
+    template <typename Endpoint, typename Session> class SessionTable
+    {
+        public:
+            static constexpr std::uint32_t SLOT_MASK = MAX_SESSIONS - 1;
+
+            SessionTable() : m_slots(MAX_SESSIONS)
+            {
+                m_used.reserve(MAX_SESSIONS);
+                m_index.reserve(MAX_SESSIONS);
+            }
+
+            [[nodiscard]] Session *find(const std::uint32_t sessionId)
+            {
+                Slot &slot = m_slots[sessionId & SLOT_MASK];
+                return slot.session && slot.sessionId == sessionId ? &*slot.session : nullptr;
+            }
+
+            [[nodiscard]] const Session *find(const std::uint32_t sessionId) const
+            {
+                return const_cast<SessionTable *>(this)->find(sessionId);
+            }
+
+            [[nodiscard]] Session *find(const Endpoint &endpoint)
+            {
+                const auto it = m_index.find(endpoint);
+                return it != m_index.end() ? &*m_slots[it->second].session : nullptr;
+            }
+
+            [[nodiscard]] const Session *find(const Endpoint &endpoint) const
+            {
+                return const_cast<SessionTable *>(this)->find(endpoint);
+            }
+
+            ///
+            /// @brief Session of the id in a packet header, provided it was sent from the endpoint of the session
+            ///
+            [[nodiscard]] Session *find(const std::uint32_t sessionId, const Endpoint &endpoint)
+            {
+                Slot &slot = m_slots[sessionId & SLOT_MASK];
+                return slot.session && slot.sessionId == sessionId && slot.endpoint == endpoint ? &*slot.session
+                                                                                                : nullptr;
+            }
+
+            ///
+            /// @brief Store the session make(sessionId) returns for endpoint, in place of the one it had
+            /// @return the stored session, nullptr when every slot is used
+            ///
+            template <typename Make> Session *emplace(const Endpoint &endpoint, Make &&make)
+            {
+                erase(endpoint);
+                if (m_used.size() == MAX_SESSIONS)
+                {
+                    return nullptr;
+                }
+                std::uint32_t slotIndex = m_nextSlot;
+                while (m_slots[slotIndex].session)
+                {
+                    slotIndex = (slotIndex + 1) & SLOT_MASK;
+                }
+                m_nextSlot = (slotIndex + 1) & SLOT_MASK;
+
+                // Random high bits, never those of the previous session of the slot, never the id 0
+                Slot &slot = m_slots[slotIndex];
+                std::uint32_t sessionId = slot.sessionId;
+                while (sessionId == slot.sessionId || sessionId == 0)
+                {
+                    sessionId = (m_random() & ~SLOT_MASK) | slotIndex;
+                }
+                slot.sessionId = sessionId;
+                slot.endpoint = endpoint;
+                slot.session.emplace(make(sessionId));
+                m_index.emplace(endpoint, slotIndex);
+                m_used.push_back(slotIndex);
+                return &*slot.session;
+            }
+
+            bool erase(const Endpoint &endpoint)
+            {
+                const auto it = m_index.find(endpoint);
+                if (it == m_index.end())
+                {
+                    return false;
+                }
+                const std::uint32_t slotIndex = it->second;
+                m_index.erase(it);
+                m_slots[slotIndex].session.reset();
+                for (std::uint32_t &used : m_used)
+                {
+                    if (used == slotIndex)
+                    {
+                        used = m_used.back();
+                        m_used.pop_back();
+                        break;
+                    }
+                }
+                return true;
+            }
+
+            [[nodiscard]] bool contains(const Endpoint &endpoint) const { return m_index.contains(endpoint); }
+            [[nodiscard]] std::size_t size() const { return m_used.size(); }
+
+            template <typename Table, typename Value> class Iterator
+            {
+                public:
+                    Iterator(Table *table, const std::size_t index) : m_table(table), m_index(index) {}
+
+                    Value &operator*() const { return *m_table->m_slots[m_table->m_used[m_index]].session; }
+                    Value *operator->() const { return &**this; }
+                    Iterator &operator++()
+                    {
+                        ++m_index;
+                        return *this;
+                    }
+                    bool operator==(const Iterator &other) const { return m_index == other.m_index; }
+
+                private:
+                    Table *m_table;
+                    std::size_t m_index;
+            };
+            using iterator = Iterator<SessionTable, Session>;
+            using const_iterator = Iterator<const SessionTable, const Session>;
+
+            iterator begin() { return {this, 0}; }
+            iterator end() { return {this, m_used.size()}; }
+            const_iterator begin() const { return {this, 0}; }
+            const_iterator end() const { return {this, m_used.size()}; }
+
+        private:
+            struct Slot
+            {
+                    std::uint32_t sessionId = 0; // Of the session in the slot, or of the last one
+                    Endpoint endpoint;
+                    std::optional<Session> session;
+            };
+
+            std::vector<Slot> m_slots;                              // MAX_SESSIONS, never reallocated
+            std::vector<std::uint32_t> m_used;                      // Slots holding a session, unordered
+            std::unordered_map<Endpoint, std::uint32_t> m_index;   // Endpoint to slot
+            std::uint32_t m_nextSlot = 0;                           // Where the search for a free slot starts
+            std::random_device m_random;
+    }; // class SessionTable
+
+} // namespace srv
@@ -0,0 +1,61 @@
+///
+/// @file SnapshotHistory.hpp
+/// @brief This file contains the ring of recent world snapshots used as delta baselines
+/// @namespace srv
+///
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "Interfaces/Protocol/Protocol.hpp"
+
+namespace srv
+{
+
+    ///
+    /// @class SnapshotHistory
+    /// @brief Keeps the last WORLD_STATE_HISTORY snapshots, each sorted by entity id
+    /// Slots are reused in place, storing a snapshot does not allocate once the buffers have grown.
+    /// @namespace srv
+    ///
+    class SnapshotHistory
+    {
+        public:
+            void store(const std::uint32_t serverTick, const std::span<const rnp::EntityState> entities)
+            {
+                Snapshot &slot = m_snapshots[serverTick % m_snapshots.size()];
+                slot.serverTick = serverTick;
+                slot.entities.assign(entities.begin(), entities.end());
+                std::ranges::sort(slot.entities, {}, &rnp::EntityState::id);
+            }
+
+            ///
+            /// @brief Snapshot of a tick, or std::nullopt if it was never stored or already overwritten
+            ///
+            [[nodiscard]] std::optional<std::span<const rnp::EntityState>> find(const std::uint32_t serverTick) const
+            {
+                const Snapshot &slot = m_snapshots[serverTick % m_snapshots.size()];
+                if (serverTick == 0 || slot.serverTick != serverTick)
+                {
+                    return std::nullopt;
+                }
+                return slot.entities;
+            }
+
+        private:
+            struct Snapshot
+            {
+                    std::uint32_t serverTick = 0;
+                    std::vector<rnp::EntityState> entities;
+            };
+
+            std::array<Snapshot, rnp::WORLD_STATE_HISTORY> m_snapshots{};
+    }; // class SnapshotHistory
+
+} // namespace srv
@@ -0,0 +1,74 @@
+///
+/// @file TimingWheel.hpp
+/// @brief This file contains the timing wheel session deadlines are checked on
+/// @namespace srv
+///
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace srv
+{
+
+    ///
+    /// @class TimingWheel
+    /// @brief Ids due at a deadline, in SLOTS buckets of RESOLUTION each around a wheel
+    /// Scheduling and expiring cost O(1) per id whatever the number of ids. A deadline beyond the horizon lands in
+    /// the last bucket, the caller checks the actual deadline of every id it is handed and schedules it again if
+    /// needed, so entries left behind by a change need not be removed either.
+    /// @namespace srv
+    ///
+    class TimingWheel
+    {
+        public:
+            using Clock = std::chrono::steady_clock;
+
+            static constexpr std::size_t SLOTS = 256;
+            static constexpr std::chrono::milliseconds RESOLUTION{100}; // Horizon of about 25 s
+
+            explicit TimingWheel(const Clock::time_point start = Clock::now()) : m_start(start) {}
+
+            void schedule(const std::uint32_t id, const Clock::time_point deadline)
+            {
+                const auto due = static_cast<std::uint64_t>(
+                    std::max<Clock::rep>(0, ((deadline - m_start) + RESOLUTION - Clock::duration{1}) / RESOLUTION));
+                m_slots[std::clamp(due, m_tick + 1, m_tick + SLOTS - 1) % SLOTS].push_back(id);
+            }
+
+            ///
+            /// @brief Call expire(id) for every id whose bucket now has passed
+            /// After a stall longer than the horizon, every id is handed once.
+            ///
+            template <typename Expire> void advance(const Clock::time_point now, Expire &&expire)
+            {
+                const auto target = static_cast<std::uint64_t>(std::max<Clock::rep>(0, (now - m_start) / RESOLUTION));
+                if (target <= m_tick)
+                {
+                    return;
+                }
+                m_tick = std::max(m_tick, target - std::min<std::uint64_t>(target, SLOTS));
+                while (m_tick < target)
+                {
+                    ++m_tick;
+                    m_due.swap(m_slots[m_tick % SLOTS]); // Ids expire() schedules again land in other buckets
+                    for (const std::uint32_t id : m_due)
+                    {
+                        expire(id);
+                    }
+                    m_due.clear();
+                }
+            }
+
+        private:
+            Clock::time_point m_start;
+            std::uint64_t m_tick = 0; // Last bucket handed
+            std::array<std::vector<std::uint32_t>, SLOTS> m_slots{};
+            std::vector<std::uint32_t> m_due; // Bucket being handed, its buffer is swapped back in
+    }; // class TimingWheel
+
+} // namespace srv
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 
@@ -5,7 +6,10 @@
 
 using asio::ip::udp;
 
-srv::AsioServer::AsioServer() : m_socket(m_ioContext), m_recvBuffer() {}
+srv::AsioServer::AsioServer()
+    : m_socket(m_ioContext), m_reliabilityTimer(m_ioContext), m_recvBuffer(), m_linkTimer(m_ioContext)
+{
+}
 
 void srv::AsioServer::init(const std::string &host, const uint16_t port)
 {
@@ -23,6 +27,7 @@ void srv::AsioServer::start()
         asio::make_work_guard(m_ioContext));
 
     startReceive();
+    scheduleReliability();
 
     m_ioThread = std::thread(
         [this]
@@ -46,6 +51,8 @@ void srv::AsioServer::stop()
                    [this]
                    {
                        asio::error_code ec;
+                       m_reliabilityTimer.cancel();
+                       m_linkTimer.cancel();
                        m_socket.close(ec);
                    });
 
@@ -72,8 +79,11 @@ void srv::AsioServer::handleReceive(const asio::error_code &error, const std::si
 {
     if (!error)
     {
-        std::vector<uint8_t> data(m_recvBuffer.begin(), m_recvBuffer.begin() + bytesTransferred);
-        processPacket(m_remoteEndpoint, data);
+        const std::span<const uint8_t> datagram(m_recvBuffer.data(), bytesTransferred);
+        if (admit(m_remoteEndpoint, datagram))
+        {
+            processPacket(m_remoteEndpoint, datagram);
+        }
         startReceive();
     }
     else if (error == asio::error::operation_aborted)
@@ -95,462 +105,916 @@ void srv::AsioServer::handleSend(const asio::error_code &error, std::size_t byte
     }
 }
 
-void srv::AsioServer::processPacket(const asio::ip::udp::endpoint &sender, const std::vector<uint8_t> &data)
+bool srv::AsioServer::admit(const asio::ip::udp::endpoint &sender, const std::span<const uint8_t> datagram)
+{
+    // Checked before anything is parsed or allocated, a datagram over budget costs a lookup and is dropped. The
+    // session comes from the id in the header, bound to the endpoint it was given to; a datagram too short for a
+    // header is charged to its address without looking one up.
+    const auto now = std::chrono::steady_clock::now();
+    rnp::BufferReader reader(datagram);
+    rnp::PacketHeader header{};
+    ClientInfo *client = datagram.size() >= rnp::HEADER_SIZE && rnp::read(reader, header) && header.sessionId != 0
+                             ? m_clients.find(header.sessionId, sender)
+                             : nullptr;
+    if (client == nullptr)
+    {
+        if (m_unknownBuckets.consume(std::hash<asio::ip::address>{}(sender.address()), now))
+        {
+            return true;
+        }
+        ++m_droppedPackets;
+        return false;
+    }
+    if (client->ingress.consume(now))
+    {
+        client->rateLimited = false;
+        client->lastHeard = now;
+        return true;
+    }
+    ++m_droppedPackets;
+    if (!client->rateLimited)
+    {
+        client->rateLimited = true;
+        sendError(sender, rnp::ErrorCode::RATE_LIMITED, "Rate limited");
+    }
+    return false;
+}
+
+void srv::AsioServer::processPacket(const asio::ip::udp::endpoint &sender, std::span<const uint8_t> datagram)
 {
     try
     {
-        rnp::PacketHeader header = rnp::deserializeHeader(data.data(), data.size());
+        const std::optional<rnp::PacketView> packet = rnp::PacketView::parse(datagram);
+        if (!packet)
+        {
+            sendError(sender, rnp::ErrorCode::INVALID_PAYLOAD, "Malformed packet");
+            return;
+        }
+        rnp::PacketHeader header = packet->header();
+        std::span<const uint8_t> payload = packet->payload();
+
+        // Vérifier la session ID (sauf pour CONNECT): found by its id, the endpoint is only looked up when it fails
+        ClientInfo *client = header.sessionId != 0 ? m_clients.find(header.sessionId, sender) : nullptr;
+        if (client == nullptr)
+        {
+            client = m_clients.find(sender);
+        }
+        if (client != nullptr && packet->type() != rnp::PacketType::CONNECT && client->sessionId != header.sessionId)
+        {
+            sendError(sender, rnp::ErrorCode::UNAUTHORIZED_SESSION, "Invalid session ID");
+            return;
+        }
+        // A packet of its session proves the client received CONNECT_ACCEPT at this address
+        if (client != nullptr && client->handshakeSince && packet->type() != rnp::PacketType::CONNECT)
+        {
+            client->handshakeSince.reset();
+            client->connected = true;
+            --m_pendingHandshakes;
+            queueMessage({.kind = NetworkMessage::Kind::CONNECT, .playerId = client->playerId},
+                         std::span(reinterpret_cast<const uint8_t *>(client->playerName.data()),
+                                   client->playerName.size()));
+        }
 
-        std::vector<uint8_t> payload;
-        if (header.length > 0 && data.size() >= 16 + header.length)
+        if (client != nullptr && packet->ack())
         {
-            payload.assign(data.begin() + 16, data.begin() + 16 + header.length);
+            client->reliability->sent.acknowledge(*packet->ack());
         }
 
-        // Vérifier la session ID (sauf pour CONNECT)
-        if (static_cast<rnp::PacketType>(header.type) != rnp::PacketType::CONNECT)
+        // Gérer les flags de fiabilité: duplicates are acknowledged again but not handled twice, ordered messages
+        // beyond the channel window are not acknowledged at all
+        if (client != nullptr &&
+            (!client->reliability->delivery.admits(header) || !client->reliability->received.receive(header)))
         {
-            auto it = m_clients.find(sender);
-            if (it != m_clients.end() && it->second.sessionId != header.sessionId)
+            return;
+        }
+
+        // Fragments are buffered per session, the message is handled once its last fragment arrived
+        if (packet->hasFlag(rnp::PacketFlags::FRAG))
+        {
+            rnp::BufferReader reader(payload);
+            rnp::FragmentHeader fragment{};
+            if (client == nullptr || !rnp::read(reader, fragment))
             {
-                sendError(sender, rnp::ErrorCode::UNAUTHORIZED_SESSION, "Invalid session ID");
                 return;
             }
+            const std::optional<std::span<const uint8_t>> message = client->reassembler->push(fragment, reader.rest());
+            if (!message)
+            {
+                return;
+            }
+            payload = *message;
+            header.length = static_cast<std::uint16_t>(payload.size());
+            header.flags &= static_cast<std::uint16_t>(~static_cast<std::uint16_t>(rnp::PacketFlags::FRAG));
+        }
+        if (packet->hasFlag(rnp::PacketFlags::COMPRESSED))
+        {
+            const std::uint32_t caps = sessionCaps(client);
+            const std::optional<std::size_t> size =
+                rnp::hasCapability(caps, rnp::Capability::LZ_COMPRESSION)
+                    ? m_codec.decompress(payload, m_decompressBuffer,
+                                         rnp::hasCapability(caps, rnp::Capability::COMPRESSION_DICTIONARY))
+                    : std::nullopt;
+            if (!size)
+            {
+                sendError(sender, rnp::ErrorCode::INVALID_PAYLOAD, "Invalid compressed payload");
+                return;
+            }
+            payload = std::span<const uint8_t>(m_decompressBuffer).first(*size);
+            header.length = static_cast<std::uint16_t>(payload.size());
+            header.flags &= static_cast<std::uint16_t>(~static_cast<std::uint16_t>(rnp::PacketFlags::COMPRESSED));
         }
 
-        // Gérer les flags de fiabilité
-        if (header.flags & static_cast<std::uint16_t>(rnp::PacketFlags::RELIABLE))
+        // Channel delivery rules: stale sequenced messages are dropped, early ordered ones wait for the gap
+        if (client != nullptr &&
+            client->reliability->delivery.receive(header, payload) != rnp::ChannelReceiver::Delivery::DELIVER)
         {
-            handleReliablePacket(sender, header);
+            return;
         }
-        if (header.flags & static_cast<std::uint16_t>(rnp::PacketFlags::ACK_REQ))
+        handleMessage(sender, client, header, payload);
+        // The message may have ended the session, or started one
+        for (client = m_clients.find(sender);
+             client != nullptr && client->reliability->delivery.popReady(header, m_orderedBuffer);
+             client = m_clients.find(sender))
         {
-            sendAck(sender, header.sequence, 0);
+            handleMessage(sender, client, header, m_orderedBuffer);
         }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "[AsioServer] Erreur de traitement du paquet: " << e.what() << "\n";
+        sendError(sender, rnp::ErrorCode::INVALID_PAYLOAD, "Erreur de traitement du paquet");
+    }
+}
 
-        switch (static_cast<rnp::PacketType>(header.type))
+void srv::AsioServer::handleMessage(const asio::ip::udp::endpoint &sender, ClientInfo *client,
+                                    const rnp::PacketHeader &header, std::span<const uint8_t> payload)
+{
+    switch (static_cast<rnp::PacketType>(header.type))
+    {
+        case rnp::PacketType::CONNECT:
         {
-            case rnp::PacketType::CONNECT:
+            // Payload: name_len(1) | player_name[name_len] | client_caps(4, BE)
+            rnp::BufferReader reader(payload);
+            const std::span<const uint8_t> name = reader.readBytes(reader.read<std::uint8_t>());
+            const auto clientCaps = reader.read<std::uint32_t>();
+            if (reader.ok() && admitHandshake(sender))
             {
-                if (payload.size() >= 5)
+                const std::string playerName(name.begin(), name.end());
+                client = addClient(sender, playerName, clientCaps);
+                if (client == nullptr)
                 {
-                    std::uint8_t nameLen = payload[0];
-                    if (payload.size() >= 1 + nameLen + 4)
-                    {
-                        std::string playerName(payload.begin() + 1, payload.begin() + 1 + nameLen);
-                        std::uint32_t clientCaps = (static_cast<std::uint32_t>(payload[1 + nameLen]) << 24) |
-                                                   (static_cast<std::uint32_t>(payload[1 + nameLen + 1]) << 16) |
-                                                   (static_cast<std::uint32_t>(payload[1 + nameLen + 2]) << 8) |
-                                                   static_cast<std::uint32_t>(payload[1 + nameLen + 3]);
-
-                        std::uint32_t sessionId = m_nextSessionId++;
-                        addClient(sender, playerName, clientCaps, sessionId);
-                        sendConnectAccept(sender, sessionId);
-                        std::cout << "[AsioServer] Client connecté: " << playerName << " ("
-                                  << sender.address().to_string() << ":" << sender.port()
-                                  << ") - Session: " << sessionId << "\n";
-                    }
+                    break;
                 }
-                break;
+                // The new session acknowledges the CONNECT itself
+                (void)client->reliability->received.receive(header);
+                sendConnectAccept(sender, client->sessionId);
+                std::cout << "[AsioServer] Client connecté: " << playerName << " (" << sender.address().to_string()
+                          << ":" << sender.port() << ") - Session: " << client->sessionId << "\n";
             }
-            case rnp::PacketType::DISCONNECT:
+            break;
+        }
+        case rnp::PacketType::DISCONNECT:
+        {
+            rnp::BufferReader reader(payload);
+            rnp::PacketDisconnect disconnect{};
+            if (rnp::read(reader, disconnect))
+            {
+                std::cout << "[AsioServer] Client déconnecté: " << sender.address().to_string() << ":" << sender.port()
+                          << " - Reason: " << disconnect.reasonCode << "\n";
+            }
+            removeClient(sender);
+            break;
+        }
+        case rnp::PacketType::ACK:
+        {
+            processAck(client, payload);
+            break;
+        }
+        case rnp::PacketType::WORLD_STATE_ACK:
+        {
+            rnp::BufferReader reader(payload);
+            rnp::PacketWorldStateAck ack{};
+            if (!rnp::read(reader, ack) || client == nullptr)
             {
-                if (payload.size() >= 2)
-                {
-                    std::uint16_t reason =
-                        (static_cast<std::uint16_t>(payload[0]) << 8) | static_cast<std::uint16_t>(payload[1]);
-                    std::cout << "[AsioServer] Client déconnecté: " << sender.address().to_string() << ":"
-                              << sender.port() << " - Reason: " << reason << "\n";
-                }
-                removeClient(sender);
                 break;
             }
-            case rnp::PacketType::ACK:
+            client->congestion->onAcked(ack.serverTick);
+            if (static_cast<std::int32_t>(ack.serverTick - client->lastSnapshotAck) > 0)
             {
-                processAck(sender, payload);
+                client->lastSnapshotAck = ack.serverTick;
+            }
+            break;
+        }
+        case rnp::PacketType::ENTITY_EVENT:
+        {
+            const rnp::EventRange events(payload);
+            if (!events.isValid())
+            {
+                std::cerr << "[AsioServer] Erreur parsing ENTITY_EVENT: truncated event\n";
                 break;
             }
-            case rnp::PacketType::ENTITY_EVENT:
+
+            // Relayed to the other clients with the events of the whole tick, input frames as INPUTs in order
+            const std::uint16_t source = client != nullptr ? client->playerId : EventRelay::EVERYONE;
+            for (const rnp::EventView event : events)
             {
-                try
+                if (event.type == rnp::EventType::INPUT)
                 {
-                    const std::vector<rnp::EventRecord> events = rnp::deserializeEvents(payload.data(), payload.size());
-
-                    // Broadcast les events aux autres clients
-                    for (const auto &[endpoint, clientInfo] : m_clients)
+                    rnp::BufferReader reader(event.data);
+                    rnp::InputEventData input{};
+                    if (rnp::read(reader, input) && client != nullptr)
                     {
-                        if (endpoint != sender && clientInfo.connected)
-                        {
-                            sendEntityEvent(endpoint, 0, events);
-                        }
+                        queueInput(*client, event.entityId, input);
                     }
                 }
-                catch (const std::exception &e)
+                else if (event.type != rnp::EventType::INPUT_FRAMES && client != nullptr)
                 {
-                    std::cerr << "[AsioServer] Erreur parsing ENTITY_EVENT: " << e.what() << "\n";
+                    queueMessage({.kind = NetworkMessage::Kind::EVENT,
+                                  .playerId = client->playerId,
+                                  .entityId = event.entityId,
+                                  .eventType = event.type},
+                                 event.data);
                 }
-                break;
-            }
-            case rnp::PacketType::PLAYER_INPUT:
-            {
-                // Support legacy PLAYER_INPUT
-                if (payload.size() >= 2)
+                if (event.type != rnp::EventType::INPUT_FRAMES)
                 {
-                    const std::uint8_t direction = payload[0];
-                    const std::uint8_t shooting = payload[1];
-
-                    rnp::EventRecord ev;
-                    ev.type = rnp::EventType::INPUT;
-                    ev.entityId = getPlayerId(sender);
-                    ev.data.reserve(4);
-
-                    const std::uint16_t playerId = getPlayerId(sender);
-                    ev.data.push_back(static_cast<std::uint8_t>(playerId & 0xFF));
-                    ev.data.push_back(static_cast<std::uint8_t>((playerId >> 8) & 0xFF));
-                    ev.data.push_back(direction);
-                    ev.data.push_back(shooting);
-
-                    std::vector<rnp::EventRecord> batch;
-                    batch.emplace_back(std::move(ev));
-                    broadcastEvents(batch);
+                    m_relay.push(source, event);
                 }
-                break;
-            }
-            case rnp::PacketType::PING:
-            {
-                if (payload.size() >= 8)
+                else if (client != nullptr)
                 {
-                    std::uint32_t nonce = (static_cast<std::uint32_t>(payload[0]) << 24) |
-                                          (static_cast<std::uint32_t>(payload[1]) << 16) |
-                                          (static_cast<std::uint32_t>(payload[2]) << 8) |
-                                          static_cast<std::uint32_t>(payload[3]);
-                    std::uint32_t sendTime = (static_cast<std::uint32_t>(payload[4]) << 24) |
-                                             (static_cast<std::uint32_t>(payload[5]) << 16) |
-                                             (static_cast<std::uint32_t>(payload[6]) << 8) |
-                                             static_cast<std::uint32_t>(payload[7]);
-                    sendPong(sender, nonce, sendTime);
+                    relayInputFrames(*client, event);
                 }
-                else
+            }
+            break;
+        }
+        case rnp::PacketType::PLAYER_INPUT:
+        {
+            // Support legacy PLAYER_INPUT
+            if (payload.size() >= 2)
+            {
+                const std::uint16_t playerId = client != nullptr ? client->playerId : 0;
+
+                // Data: player_id(2, LE) | direction(1) | shooting(1)
+                const std::array<uint8_t, 4> data = {static_cast<std::uint8_t>(playerId & 0xFF),
+                                                     static_cast<std::uint8_t>((playerId >> 8) & 0xFF), payload[0],
+                                                     payload[1]};
+                std::array<uint8_t, rnp::EventRange::EVENT_HEADER_SIZE + data.size()> event{};
+                rnp::BufferWriter writer(event);
+                rnp::writeEvent(writer, rnp::EventType::INPUT, playerId, data);
+                m_relay.push(EventRelay::EVERYONE, rnp::EventRange(writer.written()));
+            }
+            break;
+        }
+        case rnp::PacketType::BATCH:
+        {
+            // Every coalesced message is handled as if it had its own datagram
+            rnp::PacketHeader entryHeader = header;
+            const bool valid = rnp::forEachBatched(
+                payload,
+                [&](const rnp::PacketType type, const std::span<const uint8_t> bytes)
                 {
-                    sendPong(sender);
-                }
-                break;
+                    entryHeader.type = static_cast<std::uint8_t>(type);
+                    entryHeader.length = static_cast<std::uint16_t>(bytes.size());
+                    handleMessage(sender, client, entryHeader, bytes);
+                    if (type == rnp::PacketType::CONNECT || type == rnp::PacketType::DISCONNECT)
+                    {
+                        client = m_clients.find(sender);
+                    }
+                });
+            if (!valid)
+            {
+                sendError(sender, rnp::ErrorCode::INVALID_PAYLOAD, "Malformed batch");
             }
-            default:
-                break;
+            break;
         }
-
-        auto it = m_packetHandlers.find(static_cast<rnp::PacketType>(header.type));
-        if (it != m_packetHandlers.end())
+        case rnp::PacketType::PING:
         {
-            it->second(sender, header, payload);
+            rnp::BufferReader reader(payload);
+            rnp::PacketPingPong ping{};
+            if (rnp::read(reader, ping))
+            {
+                sendPong(sender, ping.nonce, ping.sendTimeMs);
+            }
+            else
+            {
+                sendPong(sender);
+            }
+            break;
         }
+        default:
+            break;
     }
-    catch (const std::exception &e)
+
+    if (header.type < m_packetHandlers.size() && m_packetHandlers[header.type])
     {
-        std::cerr << "[AsioServer] Erreur de traitement du paquet: " << e.what() << "\n";
-        sendError(sender, rnp::ErrorCode::INVALID_PAYLOAD, "Erreur de traitement du paquet");
+        m_packetHandlers[header.type](sender, header, payload);
     }
 }
 
-void srv::AsioServer::addClient(const asio::ip::udp::endpoint &endpoint, const std::string &playerName,
-                                std::uint32_t clientCaps, std::uint32_t sessionId)
+void srv::AsioServer::relayInputFrames(ClientInfo &clientInfo, const rnp::EventView &event)
 {
-    ClientInfo info;
-    info.endpoint = endpoint;
-    info.playerName = playerName;
-    info.lastSequence = 0;
-    info.connected = true;
-    info.playerId = m_nextPlayerId++;
-    info.sessionId = sessionId;
-    info.clientCaps = clientCaps;
-    m_clients[endpoint] = info;
+    // Each frame is repeated in the next events, only the ones newer than the last relayed are relayed
+    std::optional<std::uint16_t> &lastSequence = clientInfo.lastInputSequence;
+    const bool valid = rnp::InputHistory::forEachFrame(
+        event.data,
+        [&](const rnp::InputFrame &frame)
+        {
+            if (lastSequence && !rnp::isNewerInput(frame.sequence, *lastSequence))
+            {
+                return;
+            }
+            lastSequence = frame.sequence;
+            queueInput(clientInfo, event.entityId, frame.input);
+            std::array<std::uint8_t, rnp::WIRE_SIZE<rnp::InputEventData>> data{};
+            rnp::BufferWriter writer(data);
+            rnp::write(writer, frame.input);
+            m_relay.push(clientInfo.playerId,
+                         rnp::EventView{.type = rnp::EventType::INPUT, .entityId = event.entityId, .data = data});
+        });
+    if (!valid)
+    {
+        std::cerr << "[AsioServer] Erreur parsing INPUT_FRAMES: truncated frames\n";
+    }
 }
 
-void srv::AsioServer::removeClient(const asio::ip::udp::endpoint &endpoint) { m_clients.erase(endpoint); }
+srv::AsioServer::ClientInfo *srv::AsioServer::addClient(const asio::ip::udp::endpoint &endpoint,
+                                                        const std::string &playerName, std::uint32_t clientCaps)
+{
+    removeClient(endpoint);
+    ClientInfo *client = m_clients.emplace(endpoint,
+                                           [&](const std::uint32_t sessionId)
+                                           {
+                                               ClientInfo info;
+                                               info.endpoint = endpoint;
+                                               info.playerName = playerName;
+                                               info.connected = false; // Until the handshake completes
+                                               info.playerId = m_nextPlayerId++;
+                                               info.sessionId = sessionId;
+                                               info.clientCaps = clientCaps;
+                                               info.lastSnapshotAck = 0;
+                                               info.sendSequence = 0;
+                                               info.reassembler = std::make_unique<ClientReassembler>();
+                                               info.reliability = std::make_unique<ClientReliability>();
+                                               info.batch = std::make_unique<rnp::MessageBatch>();
+                                               info.interest = std::make_unique<ClientInterest>();
+                                               info.replication = std::make_unique<ClientReplication>();
+                                               info.congestion = std::make_unique<CongestionControl>();
+                                               info.rateLimited = false;
+                                               info.handshakeSince = std::chrono::steady_clock::now();
+                                               info.lastHeard = *info.handshakeSince;
+                                               return info;
+                                           });
+    if (client != nullptr)
+    {
+        ++m_pendingHandshakes;
+        m_sessionDeadlines.schedule(client->sessionId, *client->handshakeSince + m_timeouts.handshake);
+    }
+    return client;
+}
 
-std::uint16_t srv::AsioServer::getPlayerId(const asio::ip::udp::endpoint &endpoint) const
+void srv::AsioServer::removeClient(const asio::ip::udp::endpoint &endpoint)
 {
-    auto it = m_clients.find(endpoint);
-    if (it != m_clients.end())
+    const ClientInfo *client = m_clients.find(endpoint);
+    if (client == nullptr)
     {
-        return it->second.playerId;
+        return;
     }
-    return 0;
+    if (client->handshakeSince)
+    {
+        --m_pendingHandshakes;
+    }
+    else
+    {
+        queueMessage({.kind = NetworkMessage::Kind::DISCONNECT, .playerId = client->playerId});
+    }
+    m_clients.erase(endpoint);
 }
 
-std::uint32_t srv::AsioServer::getSessionId(const asio::ip::udp::endpoint &endpoint) const
+void srv::AsioServer::queueMessage(NetworkMessage &&message)
 {
-    auto it = m_clients.find(endpoint);
-    if (it != m_clients.end())
+    if (!m_ingress.tryPush(std::move(message)))
     {
-        return it->second.sessionId;
+        ++m_droppedMessages;
     }
-    return 0;
 }
 
-void srv::AsioServer::sendConnectAccept(const asio::ip::udp::endpoint &client, std::uint32_t sessionId)
+void srv::AsioServer::queueMessage(NetworkMessage &&message, const std::span<const uint8_t> data)
 {
-    rnp::PacketHeader header;
-    header.type = static_cast<std::uint8_t>(rnp::PacketType::CONNECT_ACCEPT);
+    message.data = m_messagePool.acquire();
+    if (!message.data)
+    {
+        ++m_droppedMessages;
+        return;
+    }
+    const std::size_t size = std::min(data.size(), MessagePool::BUFFER_SIZE);
+    std::copy_n(data.begin(), size, message.data.buffer().begin());
+    message.data.resize(size);
+    queueMessage(std::move(message));
+}
 
-    // Payload: session_id(4, BE) | tick_rate_hz(2, BE) | mtu_payload_bytes(2, BE) | server_caps(4, BE)
-    std::vector<uint8_t> payload;
+void srv::AsioServer::queueInput(const ClientInfo &clientInfo, const std::uint32_t entityId,
+                                 const rnp::InputEventData &input)
+{
+    // Half a round trip on its way here, behind a client rendering about a snapshot interval late
+    const std::chrono::microseconds halfRoundTrip =
+        clientInfo.congestion->roundTripTime().value_or(std::chrono::microseconds{0}) / 2;
+    const std::chrono::microseconds rendering =
+        m_tickRateHz == 0
+            ? std::chrono::microseconds{0}
+            : std::chrono::microseconds{1'000'000} * clientInfo.congestion->interval(m_tickRateHz) / m_tickRateHz;
+    queueMessage({.kind = NetworkMessage::Kind::INPUT,
+                  .playerId = clientInfo.playerId,
+                  .entityId = entityId,
+                  .input = input,
+                  .viewDelay = halfRoundTrip + rendering});
+}
 
-    // session_id (4 bytes, big endian)
-    payload.push_back(static_cast<uint8_t>((sessionId >> 24) & 0xFF));
-    payload.push_back(static_cast<uint8_t>((sessionId >> 16) & 0xFF));
-    payload.push_back(static_cast<uint8_t>((sessionId >> 8) & 0xFF));
-    payload.push_back(static_cast<uint8_t>(sessionId & 0xFF));
+bool srv::AsioServer::admitHandshake(const asio::ip::udp::endpoint &sender)
+{
+    if (!m_handshakeBucket.consume(std::chrono::steady_clock::now()))
+    {
+        ++m_droppedPackets;
+        return false;
+    }
+    // A CONNECT from a session's own address replaces that session, others need room for a new one
+    if (m_clients.contains(sender))
+    {
+        return true;
+    }
 
-    // tick_rate_hz (2 bytes, big endian)
-    payload.push_back(static_cast<uint8_t>((m_tickRateHz >> 8) & 0xFF));
-    payload.push_back(static_cast<uint8_t>(m_tickRateHz & 0xFF));
+    // The oldest pending handshake makes room, so a flood of spoofed CONNECTs cannot lock clients out for long
+    if (m_pendingHandshakes >= MAX_PENDING_HANDSHAKES || m_clients.size() >= MAX_SESSIONS)
+    {
+        const ClientInfo *oldest = nullptr;
+        for (const ClientInfo &client : m_clients)
+        {
+            if (client.handshakeSince && (oldest == nullptr || *client.handshakeSince < *oldest->handshakeSince))
+            {
+                oldest = &client;
+            }
+        }
+        if (oldest == nullptr)
+        {
+            sendDisconnect(sender, rnp::DisconnectReason::SERVER_FULL);
+            return false;
+        }
+        removeClient(oldest->endpoint);
+    }
+    return true;
+}
 
-    // mtu_payload_bytes (2 bytes, big endian)
-    payload.push_back(static_cast<uint8_t>((m_mtuPayloadBytes >> 8) & 0xFF));
-    payload.push_back(static_cast<uint8_t>(m_mtuPayloadBytes & 0xFF));
+void srv::AsioServer::checkSessions()
+{
+    const auto now = std::chrono::steady_clock::now();
+    m_sessionDeadlines.advance(now, [this, now](const std::uint32_t sessionId) { checkSession(sessionId, now); });
+}
 
-    // server_caps (4 bytes, big endian)
-    payload.push_back(static_cast<uint8_t>((m_serverCaps >> 24) & 0xFF));
-    payload.push_back(static_cast<uint8_t>((m_serverCaps >> 16) & 0xFF));
-    payload.push_back(static_cast<uint8_t>((m_serverCaps >> 8) & 0xFF));
-    payload.push_back(static_cast<uint8_t>(m_serverCaps & 0xFF));
+void srv::AsioServer::checkSession(const std::uint32_t sessionId, const std::chrono::steady_clock::time_point now)
+{
+    ClientInfo *client = m_clients.find(sessionId);
+    if (client == nullptr)
+    {
+        return; // Ended since it was scheduled
+    }
+    if (client->handshakeSince)
+    {
+        if (now - *client->handshakeSince < m_timeouts.handshake)
+        {
+            m_sessionDeadlines.schedule(sessionId, *client->handshakeSince + m_timeouts.handshake);
+            return;
+        }
+        removeClient(client->endpoint);
+        return;
+    }
 
-    header.length = payload.size();
-    header.flags =
-        static_cast<std::uint16_t>(rnp::PacketFlags::RELIABLE) | static_cast<std::uint16_t>(rnp::PacketFlags::ACK_REQ);
-    header.reserved = 0;
-    header.sequence = ++m_sequenceNumber;
-    header.sessionId = sessionId;
+    // Packets push lastHeard forward without touching the wheel, the session is checked again from it
+    const auto silence = now - client->lastHeard;
+    if (silence >= m_timeouts.session)
+    {
+        std::cout << "[AsioServer] Client expiré: " << client->playerName << " - Session: " << sessionId << "\n";
+        const asio::ip::udp::endpoint endpoint = client->endpoint;
+        sendDisconnect(endpoint, rnp::DisconnectReason::TIMEOUT);
+        removeClient(endpoint);
+        return;
+    }
+    if (silence >= m_timeouts.keepaliveAfter)
+    {
+        sendPing(client->endpoint);
+        m_sessionDeadlines.schedule(
+            sessionId, std::min(now + m_timeouts.keepaliveInterval, client->lastHeard + m_timeouts.session));
+        return;
+    }
+    m_sessionDeadlines.schedule(sessionId, client->lastHeard + m_timeouts.keepaliveAfter);
+}
 
-    std::vector<uint8_t> buffer = rnp::serialize(header, payload.data());
+template <typename Encoder>
+void srv::AsioServer::sendPacket(const asio::ip::udp::endpoint &client, const rnp::PacketType type,
+                                 const std::uint16_t flags, Encoder &&encodePayload)
+{
+    sendPacket(client, m_clients.find(client), type, flags, std::forward<Encoder>(encodePayload));
+}
 
-    m_socket.async_send_to(asio::buffer(buffer), client,
-                           [this](const asio::error_code &error, std::size_t bytesTransferred)
-                           { handleSend(error, bytesTransferred); });
+template <typename Encoder>
+void srv::AsioServer::sendPacket(const asio::ip::udp::endpoint &client, ClientInfo *session,
+                                 const rnp::PacketType type, const std::uint16_t flags, Encoder &&encodePayload)
+{
+    sendOnChannel(client, session, type, flags, stampChannel(session, type, flags),
+                  std::forward<Encoder>(encodePayload));
 }
 
-void srv::AsioServer::sendAck(const asio::ip::udp::endpoint &client, std::uint32_t cumulative, std::uint32_t ackBits)
+template <typename Encoder>
+void srv::AsioServer::sendOnChannel(const asio::ip::udp::endpoint &client, ClientInfo *session,
+                                    const rnp::PacketType type, const std::uint16_t flags, const std::uint16_t channel,
+                                    Encoder &&encodePayload)
 {
-    rnp::PacketHeader header;
-    header.type = static_cast<std::uint8_t>(rnp::PacketType::ACK);
+    // Small unreliable messages wait for the network tick, coalesced with the others of the session
+    if (flags == 0 && channel == 0 && rnp::batchable(type) && batchMessage(session, type, encodePayload))
+    {
+        return;
+    }
 
-    // Payload: cumulative_ack(4, BE) | ack_bits(4, BE)
-    std::vector<uint8_t> payload;
+    SendPool::Lease packet = m_sendPool.acquire();
+    if (!packet)
+    {
+        std::cerr << "[AsioServer] Send pool exhausted, packet dropped\n";
+        return;
+    }
 
-    // cumulative_ack (4 bytes, big endian)
-    payload.push_back(static_cast<uint8_t>((cumulative >> 24) & 0xFF));
-    payload.push_back(static_cast<uint8_t>((cumulative >> 16) & 0xFF));
-    payload.push_back(static_cast<uint8_t>((cumulative >> 8) & 0xFF));
-    payload.push_back(static_cast<uint8_t>(cumulative & 0xFF));
+    rnp::BufferWriter payload(packet.buffer().subspan(rnp::HEADER_SIZE, maxDatagramPayload()));
+    encodePayload(payload);
+    if (payload.ok())
+    {
+        packet.resize(rnp::HEADER_SIZE + payload.size());
+        sendPayload(client, session, type, flags, channel, std::move(packet));
+        return;
+    }
 
-    // ack_bits (4 bytes, big endian)
-    payload.push_back(static_cast<uint8_t>((ackBits >> 24) & 0xFF));
-    payload.push_back(static_cast<uint8_t>((ackBits >> 16) & 0xFF));
-    payload.push_back(static_cast<uint8_t>((ackBits >> 8) & 0xFF));
-    payload.push_back(static_cast<uint8_t>(ackBits & 0xFF));
+    // Too large for one datagram: encode again into the message buffer
+    packet = {};
+    rnp::BufferWriter message(m_messageBuffer);
+    encodePayload(message);
+    if (!message.ok())
+    {
+        std::cerr << "[AsioServer] Payload exceeds MAX_MESSAGE_SIZE, packet dropped\n";
+        return;
+    }
+    sendMessage(client, session, type, flags, channel, message.written());
+}
 
-    header.length = payload.size();
-    header.flags = 0;
-    header.reserved = 0;
-    header.sequence = ++m_sequenceNumber;
-    header.sessionId = getSessionId(client);
+template <typename Encoder>
+bool srv::AsioServer::batchMessage(ClientInfo *session, const rnp::PacketType type, Encoder &encodePayload)
+{
+    if (!rnp::hasCapability(sessionCaps(session), rnp::Capability::MESSAGE_BATCHING))
+    {
+        return false;
+    }
+    rnp::MessageBatch &batch = *session->batch;
+    const auto encode = [&]() -> std::optional<std::size_t>
+    {
+        const std::optional<std::span<uint8_t>> room = batch.reserve(maxDatagramPayload());
+        if (!room)
+        {
+            return std::nullopt;
+        }
+        rnp::BufferWriter writer(*room);
+        encodePayload(writer);
+        return writer.ok() ? std::optional<std::size_t>(writer.size()) : std::nullopt;
+    };
+
+    // A message that does not fit behind the queued ones sends them first, one too large on its own is not batched
+    std::optional<std::size_t> size = encode();
+    if (!size && !batch.empty())
+    {
+        flushBatch(*session);
+        size = encode();
+    }
+    if (!size)
+    {
+        return false;
+    }
+    batch.commit(type, *size);
+    return true;
+}
 
-    std::vector<uint8_t> buffer = rnp::serialize(header, payload.data());
+std::uint16_t srv::AsioServer::stampChannel(ClientInfo *session, const rnp::PacketType type, const std::uint16_t flags)
+{
+    return session != nullptr ? session->reliability->channels.stamp(rnp::channelFor(type, flags)) : 0;
+}
 
-    m_socket.async_send_to(asio::buffer(buffer), client,
-                           [this](const asio::error_code &error, std::size_t bytesTransferred)
-                           { handleSend(error, bytesTransferred); });
+std::uint32_t srv::AsioServer::sessionCaps(const ClientInfo *session) const
+{
+    return session != nullptr ? session->clientCaps & m_serverCaps : 0;
 }
 
-void srv::AsioServer::sendWorldState(const asio::ip::udp::endpoint &client, const std::vector<uint8_t> &worldData)
+bool srv::AsioServer::compressPayload(const std::uint32_t caps, SendPool::Lease &packet)
 {
-    rnp::PacketHeader header;
-    header.type = static_cast<std::uint8_t>(rnp::PacketType::WORLD_STATE);
-    header.length = worldData.size();
-    header.flags = 0;
-    header.reserved = 0;
-    header.sequence = ++m_sequenceNumber;
-    header.sessionId = getSessionId(client);
+    const std::size_t size = packet.size() - rnp::HEADER_SIZE;
+    if (!rnp::hasCapability(caps, rnp::Capability::LZ_COMPRESSION) || size < rnp::MIN_COMPRESSED_PAYLOAD)
+    {
+        return false;
+    }
+    SendPool::Lease compressed = m_sendPool.acquire();
+    if (!compressed)
+    {
+        return false;
+    }
+    // Capped one byte below the input: a payload that does not shrink fails to fit and is sent as is
+    const std::optional<std::size_t> compressedSize =
+        m_codec.compress(packet.data().subspan(rnp::HEADER_SIZE),
+                         compressed.buffer().subspan(rnp::HEADER_SIZE, size - 1),
+                         rnp::hasCapability(caps, rnp::Capability::COMPRESSION_DICTIONARY));
+    if (!compressedSize)
+    {
+        return false;
+    }
+    compressed.resize(rnp::HEADER_SIZE + *compressedSize);
+    packet = std::move(compressed);
+    return true;
+}
 
-    std::vector<uint8_t> buffer = rnp::serialize(header, worldData.data());
+void srv::AsioServer::setCompressionDictionary(const std::span<const uint8_t> dictionary)
+{
+    m_codec.setDictionary(dictionary);
+    if (dictionary.empty())
+    {
+        m_serverCaps &= ~static_cast<std::uint32_t>(rnp::Capability::COMPRESSION_DICTIONARY);
+    }
+    else
+    {
+        m_serverCaps |= static_cast<std::uint32_t>(rnp::Capability::COMPRESSION_DICTIONARY);
+    }
+}
 
-    m_socket.async_send_to(asio::buffer(buffer), client,
-                           [this](const asio::error_code &error, std::size_t bytesTransferred)
-                           { handleSend(error, bytesTransferred); });
+std::size_t srv::AsioServer::maxDatagramPayload() const
+{
+    return std::min<std::size_t>(m_mtuPayloadBytes - rnp::HEADER_SIZE, rnp::MAX_PAYLOAD);
 }
 
-void srv::AsioServer::sendWorldState(const asio::ip::udp::endpoint &client, std::uint32_t serverTick,
-                                     const std::vector<rnp::EntityState> &entities)
+void srv::AsioServer::sendMessage(const asio::ip::udp::endpoint &client, ClientInfo *session,
+                                  const rnp::PacketType type, const std::uint16_t flags, const std::uint16_t channel,
+                                  std::span<const uint8_t> message)
 {
-    rnp::PacketHeader header;
-    header.type = static_cast<std::uint8_t>(rnp::PacketType::WORLD_STATE);
-
-    // Payload: server_tick(4, BE) | entity_count(2, BE) | entities...
-    std::vector<uint8_t> payload;
-
-    // server_tick (4 bytes, big endian)
-    payload.push_back(static_cast<uint8_t>((serverTick >> 24) & 0xFF));
-    payload.push_back(static_cast<uint8_t>((serverTick >> 16) & 0xFF));
-    payload.push_back(static_cast<uint8_t>((serverTick >> 8) & 0xFF));
-    payload.push_back(static_cast<uint8_t>(serverTick & 0xFF));
-
-    // entity_count (2 bytes, big endian)
-    std::uint16_t entityCount = static_cast<std::uint16_t>(entities.size());
-    payload.push_back(static_cast<uint8_t>((entityCount >> 8) & 0xFF));
-    payload.push_back(static_cast<uint8_t>(entityCount & 0xFF));
-
-    // Pour chaque entité: id(4) | type(2) | x(4) | y(4) | vx(4) | vy(4) | state_flags(1)
-    for (const auto &entity : entities)
-    {
-        // id (4 bytes, big endian)
-        payload.push_back(static_cast<uint8_t>((entity.id >> 24) & 0xFF));
-        payload.push_back(static_cast<uint8_t>((entity.id >> 16) & 0xFF));
-        payload.push_back(static_cast<uint8_t>((entity.id >> 8) & 0xFF));
-        payload.push_back(static_cast<uint8_t>(entity.id & 0xFF));
-
-        // type (2 bytes, big endian)
-        payload.push_back(static_cast<uint8_t>((entity.type >> 8) & 0xFF));
-        payload.push_back(static_cast<uint8_t>(entity.type & 0xFF));
-
-        // x, y, vx, vy (floats en big endian)
-        const uint8_t *xBytes = reinterpret_cast<const uint8_t *>(&entity.x);
-        const uint8_t *yBytes = reinterpret_cast<const uint8_t *>(&entity.y);
-        const uint8_t *vxBytes = reinterpret_cast<const uint8_t *>(&entity.vx);
-        const uint8_t *vyBytes = reinterpret_cast<const uint8_t *>(&entity.vy);
-
-        // Note: Assuming little endian system, reverse for big endian network order
-        for (int i = 3; i >= 0; --i)
-            payload.push_back(xBytes[i]);
-        for (int i = 3; i >= 0; --i)
-            payload.push_back(yBytes[i]);
-        for (int i = 3; i >= 0; --i)
-            payload.push_back(vxBytes[i]);
-        for (int i = 3; i >= 0; --i)
-            payload.push_back(vyBytes[i]);
-
-        // state_flags (1 byte)
-        payload.push_back(entity.stateFlags);
-    }
-
-    header.length = payload.size();
-    header.flags = 0;
-    header.reserved = 0;
-    header.sequence = ++m_sequenceNumber;
-    header.sessionId = getSessionId(client);
-
-    std::vector<uint8_t> buffer = rnp::serialize(header, payload.data());
-
-    m_socket.async_send_to(asio::buffer(buffer), client,
-                           [this](const asio::error_code &error, std::size_t bytesTransferred)
-                           { handleSend(error, bytesTransferred); });
+    // Compress the whole message, it may then fit a single datagram, otherwise fragment what is left
+    std::uint16_t messageFlags = flags;
+    const std::uint32_t caps = sessionCaps(session);
+    if (type != rnp::PacketType::CONNECT_ACCEPT && rnp::hasCapability(caps, rnp::Capability::LZ_COMPRESSION))
+    {
+        const std::optional<std::size_t> size =
+            m_codec.compress(message, std::span(m_compressBuffer).first(message.size() - 1),
+                             rnp::hasCapability(caps, rnp::Capability::COMPRESSION_DICTIONARY));
+        if (size)
+        {
+            message = std::span<const uint8_t>(m_compressBuffer).first(*size);
+            messageFlags |= static_cast<std::uint16_t>(rnp::PacketFlags::COMPRESSED);
+        }
+    }
+    if (message.size() <= maxDatagramPayload())
+    {
+        sendOnChannel(client, session, type, messageFlags, channel,
+                      [message](rnp::BufferWriter &writer) { writer.writeBytes(message); });
+        return;
+    }
+
+    const std::size_t fragmentSize = maxDatagramPayload() - rnp::WIRE_SIZE<rnp::FragmentHeader>;
+    const auto fragFlags =
+        static_cast<std::uint16_t>(messageFlags | static_cast<std::uint16_t>(rnp::PacketFlags::FRAG));
+
+    const bool sent = rnp::forEachFragment(
+        message, fragmentSize, ++m_nextFragId,
+        [&](const rnp::FragmentHeader &fragment, const std::span<const uint8_t> bytes)
+        {
+            sendOnChannel(client, session, type, fragFlags, channel,
+                          [&fragment, bytes](rnp::BufferWriter &writer)
+                          {
+                              rnp::write(writer, fragment);
+                              writer.writeBytes(bytes);
+                          });
+        });
+    if (!sent)
+    {
+        std::cerr << "[AsioServer] Message of " << message.size() << " bytes needs too many fragments, dropped\n";
+    }
 }
 
-void srv::AsioServer::sendEvents(const asio::ip::udp::endpoint &client, const std::vector<rnp::EventRecord> &events)
+void srv::AsioServer::sendPayload(const asio::ip::udp::endpoint &client, ClientInfo *session,
+                                  const rnp::PacketType type, std::uint16_t flags, const std::uint16_t channel,
+                                  SendPool::Lease packet)
 {
-    const std::vector<uint8_t> eventsPayload = rnp::serializeEvents(events);
+    // Fragments and CONNECT_ACCEPT (sent before the client knows the server caps) are never compressed here
+    constexpr auto PACKED = static_cast<std::uint16_t>(static_cast<std::uint16_t>(rnp::PacketFlags::FRAG) |
+                                                       static_cast<std::uint16_t>(rnp::PacketFlags::COMPRESSED));
+    if ((flags & PACKED) == 0 && type != rnp::PacketType::CONNECT_ACCEPT &&
+        compressPayload(sessionCaps(session), packet))
+    {
+        flags |= static_cast<std::uint16_t>(rnp::PacketFlags::COMPRESSED);
+    }
 
-    rnp::PacketHeader header;
-    header.type = static_cast<std::uint8_t>(rnp::PacketType::ENTITY_EVENT);
-    header.length = static_cast<std::uint16_t>(eventsPayload.size());
-    header.flags = 0;
-    header.reserved = 0;
-    header.sequence = ++m_sequenceNumber;
-    header.sessionId = getSessionId(client);
+    // Owed ACKs ride along when there is room, flushAcks() then has nothing left to send for them
+    const std::size_t payloadSize = packet.size() - rnp::HEADER_SIZE;
+    if (session != nullptr && type != rnp::PacketType::ACK &&
+        payloadSize + rnp::WIRE_SIZE<rnp::PacketAck> <= maxDatagramPayload())
+    {
+        if (const std::optional<rnp::PacketAck> ack = session->reliability->received.piggyback())
+        {
+            rnp::BufferWriter ackWriter(packet.buffer().subspan(packet.size(), rnp::WIRE_SIZE<rnp::PacketAck>));
+            rnp::write(ackWriter, *ack);
+            packet.resize(packet.size() + rnp::WIRE_SIZE<rnp::PacketAck>);
+            flags |= static_cast<std::uint16_t>(rnp::PacketFlags::PIGGYBACK_ACK);
+        }
+    }
 
-    std::vector<uint8_t> buffer = rnp::serialize(header, eventsPayload.data());
+    // Every session has its own sequence space, reliable datagrams are kept until acknowledged
+    const rnp::PacketHeader header{.type = static_cast<std::uint8_t>(type),
+                                   .length = static_cast<std::uint16_t>(payloadSize),
+                                   .flags = flags,
+                                   .channel = channel,
+                                   .sequence = session != nullptr ? ++session->sendSequence : ++m_sequenceNumber,
+                                   .sessionId = session != nullptr ? session->sessionId : 0};
+    rnp::BufferWriter headerWriter(packet.buffer().first(rnp::HEADER_SIZE));
+    rnp::write(headerWriter, header);
+    // Backlogged datagrams are sent by retransmitReliable(), which also closes the session once the sender stalled
+    if ((flags & static_cast<std::uint16_t>(rnp::PacketFlags::RELIABLE)) != 0 && session != nullptr &&
+        session->reliability->sent.track(header.sequence, packet.data()) != ReliableSender::Track::SEND)
+    {
+        return;
+    }
 
-    m_socket.async_send_to(asio::buffer(buffer), client,
-                           [this](const asio::error_code &error, std::size_t bytesTransferred)
-                           { handleSend(error, bytesTransferred); });
+    transmit(client, std::move(packet));
 }
 
-void srv::AsioServer::sendEntityEvent(const asio::ip::udp::endpoint &client, std::uint32_t serverTick,
-                                      const std::vector<rnp::EventRecord> &events)
+void srv::AsioServer::transmit(const asio::ip::udp::endpoint &client, SendPool::Lease packet)
 {
-    const std::vector<uint8_t> eventsPayload = rnp::serializeEvents(events);
+    if (!m_link)
+    {
+        sendDatagram(client, std::move(packet));
+        return;
+    }
+    const rnp::LinkConditioner::Delivery delivery = m_link->send(std::chrono::steady_clock::now(), packet.size());
+    for (std::uint8_t copy = 0; copy < delivery.copies; ++copy)
+    {
+        SendPool::Lease sent = copy + 1 < delivery.copies ? m_sendPool.acquire() : std::move(packet);
+        if (!sent)
+        {
+            continue;
+        }
+        if (copy + 1 < delivery.copies)
+        {
+            std::ranges::copy(packet.data(), sent.buffer().begin());
+            sent.resize(packet.size());
+        }
+        m_linkQueue.push(delivery.at[copy], {client, std::move(sent)});
+    }
+    scheduleLink();
+}
 
-    // Payload: server_tick(4, BE) | event_count(2, BE) | events...
-    std::vector<uint8_t> payload;
-
-    // server_tick (4 bytes, big endian)
-    payload.push_back(static_cast<uint8_t>((serverTick >> 24) & 0xFF));
-    payload.push_back(static_cast<uint8_t>((serverTick >> 16) & 0xFF));
-    payload.push_back(static_cast<uint8_t>((serverTick >> 8) & 0xFF));
-    payload.push_back(static_cast<uint8_t>(serverTick & 0xFF));
-
-    // event_count (2 bytes, big endian)
-    std::uint16_t eventCount = static_cast<std::uint16_t>(events.size());
-    payload.push_back(static_cast<uint8_t>((eventCount >> 8) & 0xFF));
-    payload.push_back(static_cast<uint8_t>(eventCount & 0xFF));
-
-    // Events serialized
-    payload.insert(payload.end(), eventsPayload.begin(), eventsPayload.end());
-
-    rnp::PacketHeader header;
-    header.type = static_cast<std::uint8_t>(rnp::PacketType::ENTITY_EVENT);
-    header.length = static_cast<std::uint16_t>(payload.size());
-    header.flags = 0;
-    header.reserved = 0;
-    header.sequence = ++m_sequenceNumber;
-    header.sessionId = getSessionId(client);
-
-    std::vector<uint8_t> buffer = rnp::serialize(header, payload.data());
-
-    m_socket.async_send_to(asio::buffer(buffer), client,
-                           [this](const asio::error_code &error, std::size_t bytesTransferred)
+void srv::AsioServer::setLinkConditions(const rnp::LinkConditions &conditions)
+{
+    asio::post(m_ioContext, [this, conditions]() { m_link.emplace(conditions); });
+}
+
+void srv::AsioServer::scheduleLink()
+{
+    // The timer is only moved when a datagram is due before the one it waits for
+    const std::optional<std::chrono::steady_clock::time_point> due = m_linkQueue.nextDue();
+    if (!due || (m_linkTimerDue && *m_linkTimerDue <= *due))
+    {
+        return;
+    }
+    m_linkTimerDue = due;
+    m_linkTimer.expires_at(*due);
+    m_linkTimer.async_wait(
+        [this](const asio::error_code &error)
+        {
+            if (error)
+            {
+                return;
+            }
+            m_linkTimerDue.reset();
+            m_linkQueue.popDue(std::chrono::steady_clock::now(),
+                               [this](std::pair<asio::ip::udp::endpoint, SendPool::Lease> &&datagram)
+                               { sendDatagram(datagram.first, std::move(datagram.second)); });
+            scheduleLink();
+        });
+}
+
+void srv::AsioServer::sendDatagram(const asio::ip::udp::endpoint &client, SendPool::Lease packet)
+{
+    // The lease rides along with the completion handler so the buffer outlives the asynchronous send
+    const asio::const_buffer buffer = asio::buffer(packet.data().data(), packet.size());
+    m_socket.async_send_to(buffer, client,
+                           [this, packet = std::move(packet)](const asio::error_code &error,
+                                                              std::size_t bytesTransferred)
                            { handleSend(error, bytesTransferred); });
 }
 
-void srv::AsioServer::sendPong(const asio::ip::udp::endpoint &client)
+void srv::AsioServer::sendConnectAccept(const asio::ip::udp::endpoint &client, std::uint32_t sessionId)
 {
-    rnp::PacketHeader header;
-    header.type = static_cast<std::uint8_t>(rnp::PacketType::PONG);
-    header.length = 0;
-    header.flags = 0;
-    header.reserved = 0;
-    header.sequence = ++m_sequenceNumber;
-    header.sessionId = getSessionId(client);
+    const rnp::PacketConnectAccept accept{.sessionId = sessionId,
+                                          .tickRateHz = m_tickRateHz,
+                                          .mtuPayloadBytes = m_mtuPayloadBytes,
+                                          .serverCaps = m_serverCaps};
+
+    sendPacket(client, rnp::PacketType::CONNECT_ACCEPT,
+               static_cast<std::uint16_t>(rnp::PacketFlags::RELIABLE) |
+                   static_cast<std::uint16_t>(rnp::PacketFlags::ACK_REQ),
+               [&accept](rnp::BufferWriter &writer) { rnp::write(writer, accept); });
+}
 
-    std::vector<uint8_t> buffer = rnp::serialize(header);
+void srv::AsioServer::sendAck(const asio::ip::udp::endpoint &client, std::uint32_t cumulative, std::uint32_t ackBits)
+{
+    const rnp::PacketAck ack{.cumulativeAck = cumulative, .ackBits = ackBits};
 
-    m_socket.async_send_to(asio::buffer(buffer), client,
-                           [this](const asio::error_code &error, std::size_t bytesTransferred)
-                           { handleSend(error, bytesTransferred); });
+    sendPacket(client, rnp::PacketType::ACK, 0,
+               [&ack](rnp::BufferWriter &writer) { rnp::write(writer, ack); });
 }
 
-void srv::AsioServer::sendPong(const asio::ip::udp::endpoint &client, std::uint32_t nonce, std::uint32_t sendTimeMs)
+void srv::AsioServer::sendWorldState(const asio::ip::udp::endpoint &client, const std::vector<uint8_t> &worldData)
 {
-    rnp::PacketHeader header;
-    header.type = static_cast<std::uint8_t>(rnp::PacketType::PONG);
+    sendPacket(client, rnp::PacketType::WORLD_STATE, 0,
+               [&worldData](rnp::BufferWriter &writer) { writer.writeBytes(worldData); });
+}
+
+void srv::AsioServer::sendWorldState(const asio::ip::udp::endpoint &client, std::uint32_t serverTick,
+                                     const std::vector<rnp::EntityState> &entities)
+{
+    if (ClientInfo *session = m_clients.find(client))
+    {
+        sendWorldDelta(*session, serverTick, entities, 0, {});
+    }
+}
+
+void srv::AsioServer::sendEvents(const asio::ip::udp::endpoint &client, const std::vector<rnp::EventRecord> &events)
+{
+    sendPacket(client, rnp::PacketType::ENTITY_EVENT, rnp::reliableEventFlags(events),
+               [&events](rnp::BufferWriter &writer)
+               {
+                   for (const auto &ev : events)
+                   {
+                       rnp::writeEvent(writer, ev.type, ev.entityId, ev.data);
+                   }
+               });
+}
 
-    // Payload: nonce(4, BE) | send_time_ms(4, BE)
-    std::vector<uint8_t> payload;
+void srv::AsioServer::sendEntityEvent(const asio::ip::udp::endpoint &client, std::uint32_t serverTick,
+                                      const std::vector<rnp::EventRecord> &events)
+{
+    // Payload: server_tick(4, BE) | event_count(2, BE) | events...
+    const rnp::EntityEventHeader eventHeader{.serverTick = serverTick,
+                                             .eventCount = static_cast<std::uint16_t>(events.size())};
+
+    sendPacket(client, rnp::PacketType::ENTITY_EVENT, rnp::reliableEventFlags(events),
+               [&eventHeader, &events](rnp::BufferWriter &writer)
+               {
+                   rnp::write(writer, eventHeader);
+                   for (const auto &ev : events)
+                   {
+                       rnp::writeEvent(writer, ev.type, ev.entityId, ev.data);
+                   }
+               });
+}
 
-    // nonce (4 bytes, big endian)
-    payload.push_back(static_cast<uint8_t>((nonce >> 24) & 0xFF));
-    payload.push_back(static_cast<uint8_t>((nonce >> 16) & 0xFF));
-    payload.push_back(static_cast<uint8_t>((nonce >> 8) & 0xFF));
-    payload.push_back(static_cast<uint8_t>(nonce & 0xFF));
+void srv::AsioServer::sendEntityEvent(const asio::ip::udp::endpoint &client, std::uint32_t serverTick,
+                                      const rnp::EventRange &events)
+{
+    // Payload: server_tick(4, BE) | event_count(2, BE) | events, copied verbatim from the received TLV block
+    const rnp::EntityEventHeader eventHeader{.serverTick = serverTick,
+                                             .eventCount = static_cast<std::uint16_t>(events.size())};
+
+    sendPacket(client, rnp::PacketType::ENTITY_EVENT, rnp::reliableEventFlags(events),
+               [&eventHeader, &events](rnp::BufferWriter &writer)
+               {
+                   rnp::write(writer, eventHeader);
+                   writer.writeBytes(events.bytes());
+               });
+}
 
-    // send_time_ms (4 bytes, big endian)
-    payload.push_back(static_cast<uint8_t>((sendTimeMs >> 24) & 0xFF));
-    payload.push_back(static_cast<uint8_t>((sendTimeMs >> 16) & 0xFF));
-    payload.push_back(static_cast<uint8_t>((sendTimeMs >> 8) & 0xFF));
-    payload.push_back(static_cast<uint8_t>(sendTimeMs & 0xFF));
+void srv::AsioServer::sendPong(const asio::ip::udp::endpoint &client)
+{
+    sendPacket(client, rnp::PacketType::PONG, 0, [](rnp::BufferWriter &) {});
+}
 
-    header.length = payload.size();
-    header.flags = 0;
-    header.reserved = 0;
-    header.sequence = ++m_sequenceNumber;
-    header.sessionId = getSessionId(client);
+void srv::AsioServer::sendPong(const asio::ip::udp::endpoint &client, std::uint32_t nonce, std::uint32_t sendTimeMs)
+{
+    const rnp::PacketPingPong pong{.nonce = nonce, .sendTimeMs = sendTimeMs};
+    // The server clock, for the client to estimate the current tick
+    const auto tickPhase =
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_lastTickSentAt);
+    const rnp::PacketPongClock clock{.serverTick = m_lastTick,
+                                     .tickPhaseUs = static_cast<std::uint32_t>(tickPhase.count())};
+
+    sendPacket(client, rnp::PacketType::PONG, 0,
+               [&pong, &clock](rnp::BufferWriter &writer)
+               {
+                   rnp::write(writer, pong);
+                   rnp::write(writer, clock);
+               });
+}
 
-    std::vector<uint8_t> buffer = rnp::serialize(header, payload.data());
+void srv::AsioServer::sendPing(const asio::ip::udp::endpoint &client)
+{
+    // Keepalive of a silent session, the PONG answering it is all the server waits for
+    const rnp::PacketPingPong ping{.nonce = 0, .sendTimeMs = 0};
 
-    m_socket.async_send_to(asio::buffer(buffer), client,
-                           [this](const asio::error_code &error, std::size_t bytesTransferred)
-                           { handleSend(error, bytesTransferred); });
+    sendPacket(client, rnp::PacketType::PING, 0, [&ping](rnp::BufferWriter &writer) { rnp::write(writer, ping); });
 }
 
 void srv::AsioServer::sendError(const asio::ip::udp::endpoint &client, const std::string &errorMessage)
@@ -561,177 +1025,482 @@ void srv::AsioServer::sendError(const asio::ip::udp::endpoint &client, const std
 void srv::AsioServer::sendError(const asio::ip::udp::endpoint &client, rnp::ErrorCode errorCode,
                                 const std::string &errorMessage)
 {
-    rnp::PacketHeader header;
-    header.type = static_cast<std::uint8_t>(rnp::PacketType::PACKET_ERROR);
-
     // Payload: error_code(2, BE) | msg_len(2, BE) | message
-    std::vector<uint8_t> payload;
-    std::uint16_t code = static_cast<std::uint16_t>(errorCode);
-    payload.push_back(static_cast<uint8_t>((code >> 8) & 0xFF));
-    payload.push_back(static_cast<uint8_t>(code & 0xFF));
-
-    std::uint16_t msgLen = static_cast<std::uint16_t>(errorMessage.size());
-    payload.push_back(static_cast<uint8_t>((msgLen >> 8) & 0xFF));
-    payload.push_back(static_cast<uint8_t>(msgLen & 0xFF));
-
-    payload.insert(payload.end(), errorMessage.begin(), errorMessage.end());
-
-    header.length = payload.size();
-    header.flags = 0;
-    header.reserved = 0;
-    header.sequence = ++m_sequenceNumber;
-    header.sessionId = getSessionId(client);
+    sendPacket(client, rnp::PacketType::PACKET_ERROR, 0,
+               [errorCode, &errorMessage](rnp::BufferWriter &writer)
+               {
+                   writer.write(errorCode);
+                   writer.write(static_cast<std::uint16_t>(errorMessage.size()));
+                   writer.writeBytes(
+                       {reinterpret_cast<const std::uint8_t *>(errorMessage.data()), errorMessage.size()});
+               });
+}
 
-    std::vector<uint8_t> buffer = rnp::serialize(header, payload.data());
+void srv::AsioServer::sendDisconnect(const asio::ip::udp::endpoint &client, const rnp::DisconnectReason reason)
+{
+    const rnp::PacketDisconnect disconnect{.reasonCode = static_cast<std::uint16_t>(reason)};
 
-    m_socket.async_send_to(asio::buffer(buffer), client,
-                           [this](const asio::error_code &error, std::size_t bytesTransferred)
-                           { handleSend(error, bytesTransferred); });
+    sendPacket(client, rnp::PacketType::DISCONNECT, 0,
+               [&disconnect](rnp::BufferWriter &writer) { rnp::write(writer, disconnect); });
 }
 
 void srv::AsioServer::broadcastToAll(const std::vector<uint8_t> &data)
 {
-    for (const auto &[endpoint, clientInfo] : m_clients)
+    for (const ClientInfo &clientInfo : m_clients)
     {
         if (clientInfo.connected)
         {
-            m_socket.async_send_to(asio::buffer(data), endpoint,
-                                   [this](const asio::error_code &error, std::size_t bytesTransferred)
-                                   { handleSend(error, bytesTransferred); });
+            SendPool::Lease packet = m_sendPool.acquire();
+            if (!packet || data.size() > SendPool::BUFFER_SIZE)
+            {
+                continue;
+            }
+            std::memcpy(packet.buffer().data(), data.data(), data.size());
+            packet.resize(data.size());
+            transmit(clientInfo.endpoint, std::move(packet));
         }
     }
 }
 
 void srv::AsioServer::broadcastEvents(const std::vector<rnp::EventRecord> &events)
 {
-    const std::vector<uint8_t> payload = rnp::serializeEvents(events);
-
-    rnp::PacketHeader header;
-    header.type = static_cast<std::uint8_t>(rnp::PacketType::ENTITY_EVENT);
-    header.length = static_cast<std::uint16_t>(payload.size());
-    header.flags = 0;
-    header.reserved = 0;
-    header.sequence = ++m_sequenceNumber;
+    broadcastEvents(rnp::serializeEvents(events));
+}
 
-    for (const auto &[endpoint, clientInfo] : m_clients)
+void srv::AsioServer::broadcastEvents(std::span<const uint8_t> payload)
+{
+    const std::uint16_t flags = rnp::reliableEventFlags(rnp::EventRange(payload));
+    for (ClientInfo &clientInfo : m_clients)
     {
         if (clientInfo.connected)
         {
-            header.sessionId = clientInfo.sessionId;
-            const std::vector<uint8_t> frame = rnp::serialize(header, payload.data());
-
-            m_socket.async_send_to(asio::buffer(frame), endpoint,
-                                   [this](const asio::error_code &error, std::size_t bytesTransferred)
-                                   { handleSend(error, bytesTransferred); });
+            sendPacket(clientInfo.endpoint, &clientInfo, rnp::PacketType::ENTITY_EVENT, flags,
+                       [payload](rnp::BufferWriter &writer) { writer.writeBytes(payload); });
         }
     }
 }
 
 void srv::AsioServer::broadcastEntityEvents(std::uint32_t serverTick, const std::vector<rnp::EventRecord> &events)
 {
-    const std::vector<uint8_t> eventsPayload = rnp::serializeEvents(events);
-
-    // Payload: server_tick(4, BE) | event_count(2, BE) | events...
-    std::vector<uint8_t> payload;
-
-    // server_tick (4 bytes, big endian)
-    payload.push_back(static_cast<uint8_t>((serverTick >> 24) & 0xFF));
-    payload.push_back(static_cast<uint8_t>((serverTick >> 16) & 0xFF));
-    payload.push_back(static_cast<uint8_t>((serverTick >> 8) & 0xFF));
-    payload.push_back(static_cast<uint8_t>(serverTick & 0xFF));
-
-    // event_count (2 bytes, big endian)
-    std::uint16_t eventCount = static_cast<std::uint16_t>(events.size());
-    payload.push_back(static_cast<uint8_t>((eventCount >> 8) & 0xFF));
-    payload.push_back(static_cast<uint8_t>(eventCount & 0xFF));
+    for (const ClientInfo &clientInfo : m_clients)
+    {
+        if (clientInfo.connected)
+        {
+            sendEntityEvent(clientInfo.endpoint, serverTick, events);
+        }
+    }
+}
 
-    // Events serialized
-    payload.insert(payload.end(), eventsPayload.begin(), eventsPayload.end());
+void srv::AsioServer::broadcastWorldState(const std::uint32_t serverTick,
+                                          const std::span<const rnp::EntityState> entities)
+{
+    OutboundSnapshot *snapshot = m_egress.claim();
+    if (snapshot == nullptr)
+    {
+        return; // The IO thread is that many ticks behind, clients will interpolate over the gap
+    }
+    snapshot->serverTick = serverTick;
+    snapshot->entities.assign(entities.begin(), entities.end());
+    // The events of a dropped snapshot wait for the next one, the previous events of the slot are recycled
+    snapshot->events.swap(m_pendingEvents);
+    m_pendingEvents.clear();
+    m_egress.commit();
+
+    // Client table, acked baselines and sequence numbers belong to the IO thread, only a wakeup is posted
+    asio::post(m_ioContext, [this]() { drainEgress(); });
+}
 
-    rnp::PacketHeader header;
-    header.type = static_cast<std::uint8_t>(rnp::PacketType::ENTITY_EVENT);
-    header.length = static_cast<std::uint16_t>(payload.size());
-    header.flags = 0;
-    header.reserved = 0;
-    header.sequence = ++m_sequenceNumber;
+void srv::AsioServer::sendEvent(const std::uint16_t playerId, const rnp::EventType type, const std::uint32_t entityId,
+                                const std::span<const std::uint8_t> data)
+{
+    OutboundEvent event{.playerId = playerId, .type = type, .entityId = entityId};
+    if (data.size() > event.data.size())
+    {
+        std::cerr << "[AsioServer] Event of " << data.size() << " bytes dropped, too large\n";
+        return;
+    }
+    event.size = static_cast<std::uint8_t>(data.size());
+    std::ranges::copy(data, event.data.begin());
+    m_pendingEvents.push_back(event);
+}
 
-    for (const auto &[endpoint, clientInfo] : m_clients)
+void srv::AsioServer::drainEgress()
+{
+    while (OutboundSnapshot *snapshot = m_egress.front())
     {
-        if (clientInfo.connected)
+        m_history.store(snapshot->serverTick, snapshot->entities);
+        m_lastTick = snapshot->serverTick;
+        m_lastTickSentAt = std::chrono::steady_clock::now();
+        for (const OutboundEvent &event : snapshot->events)
         {
-            header.sessionId = clientInfo.sessionId;
-            const std::vector<uint8_t> frame = rnp::serialize(header, payload.data());
-
-            m_socket.async_send_to(asio::buffer(frame), endpoint,
-                                   [this](const asio::error_code &error, std::size_t bytesTransferred)
-                                   { handleSend(error, bytesTransferred); });
+            m_relay.pushTo(event.playerId, rnp::EventView{.type = event.type,
+                                                          .entityId = event.entityId,
+                                                          .data = std::span(event.data).first(event.size)});
         }
+        m_egress.pop();
+        relayEvents(m_lastTick);
+        sendWorldStates(m_lastTick);
     }
 }
 
-void srv::AsioServer::setPacketHandler(rnp::PacketType type, PacketHandler handler)
+void srv::AsioServer::setViewport(const Viewport &viewport)
 {
-    m_packetHandlers[type] = handler;
+    asio::post(m_ioContext, [this, viewport]() { m_viewport = viewport; });
 }
 
-void srv::AsioServer::handleReliablePacket(const asio::ip::udp::endpoint &sender, const rnp::PacketHeader &header)
+void srv::AsioServer::setSnapshotBudget(const std::size_t bytes)
 {
-    // Store for potential retransmission (simplified implementation)
-    // In production, you'd want more sophisticated tracking
-    auto it = m_clients.find(sender);
-    if (it != m_clients.end())
+    asio::post(m_ioContext, [this, bytes]() { m_snapshotBudgetBytes = bytes; });
+}
+
+void srv::AsioServer::setClientViewport(const asio::ip::udp::endpoint &client, const Viewport &viewport)
+{
+    asio::post(m_ioContext,
+               [this, client, viewport]()
+               {
+                   if (ClientInfo *session = m_clients.find(client))
+                   {
+                       session->interest->viewport = viewport;
+                   }
+               });
+}
+
+void srv::AsioServer::relayEvents(const std::uint32_t serverTick)
+{
+    if (m_relay.empty())
     {
-        it->second.lastSequence = header.sequence;
+        return;
     }
+    for (ClientInfo &clientInfo : m_clients)
+    {
+        if (!clientInfo.connected)
+        {
+            continue;
+        }
+        // One ENTITY_EVENT per client and tick, reliable as soon as one of its events must arrive
+        std::uint16_t eventCount = 0;
+        std::uint16_t flags = 0;
+        m_relay.forEachFor(clientInfo.playerId,
+                           [&eventCount, &flags](const rnp::EventView &event)
+                           {
+                               ++eventCount;
+                               flags |= rnp::reliableEventFlags(std::span(&event, 1));
+                           });
+        if (eventCount == 0)
+        {
+            continue;
+        }
+        const rnp::EntityEventHeader eventHeader{.serverTick = serverTick, .eventCount = eventCount};
+        sendPacket(clientInfo.endpoint, &clientInfo, rnp::PacketType::ENTITY_EVENT, flags,
+                   [this, &eventHeader, &clientInfo](rnp::BufferWriter &writer)
+                   {
+                       rnp::write(writer, eventHeader);
+                       m_relay.forEachFor(clientInfo.playerId, [&writer](const rnp::EventView &event)
+                                          { rnp::writeEvent(writer, event.type, event.entityId, event.data); });
+                   });
+    }
+    m_relay.clear();
 }
 
-void srv::AsioServer::processAck(const asio::ip::udp::endpoint &sender, const std::vector<uint8_t> &payload)
+void srv::AsioServer::sendWorldStates(const std::uint32_t serverTick)
 {
-    if (payload.size() < 8)
+    const std::optional<std::span<const rnp::EntityState>> current = m_history.find(serverTick);
+    if (!current)
     {
         return;
     }
 
-    // cumulative_ack (4 bytes, big endian)
-    std::uint32_t cumulative = (static_cast<std::uint32_t>(payload[0]) << 24) |
-                               (static_cast<std::uint32_t>(payload[1]) << 16) |
-                               (static_cast<std::uint32_t>(payload[2]) << 8) | static_cast<std::uint32_t>(payload[3]);
-
-    // ack_bits (4 bytes, big endian)
-    std::uint32_t ackBits = (static_cast<std::uint32_t>(payload[4]) << 24) |
-                            (static_cast<std::uint32_t>(payload[5]) << 16) |
-                            (static_cast<std::uint32_t>(payload[6]) << 8) | static_cast<std::uint32_t>(payload[7]);
+    bool gridBuilt = false;
+    for (ClientInfo &clientInfo : m_clients)
+    {
+        // Clients on a congested link get fewer snapshots rather than queues
+        if (!clientInfo.connected || !clientInfo.congestion->shouldSend(serverTick, m_tickRateHz))
+        {
+            continue;
+        }
+        // Deltas are against the snapshot the client rebuilt, fall back to a full state when it is missing or about
+        // to leave the history
+        std::optional<std::span<const rnp::EntityState>> baseline;
+        if (serverTick - clientInfo.lastSnapshotAck < rnp::WORLD_STATE_HISTORY)
+        {
+            baseline = clientInfo.replication->find(clientInfo.lastSnapshotAck);
+        }
 
-    // Remove acknowledged packets from pending reliable
-    m_pendingReliable.erase(cumulative);
+        // Only the entities around the client viewport are sent, the others are removed from its snapshot
+        std::span<const rnp::EntityState> relevant = *current;
+        ClientInterest &interest = *clientInfo.interest;
+        const std::optional<Viewport> viewport = interest.viewport ? interest.viewport : m_viewport;
+        if (viewport)
+        {
+            if (!gridBuilt)
+            {
+                m_interestGrid.build(*current);
+                gridBuilt = true;
+            }
+            selectEntities(*current, interest.update(m_interestGrid, *current, *viewport), m_relevantCurrent);
+            relevant = m_relevantCurrent;
+        }
+        sendWorldDelta(clientInfo, serverTick, relevant, baseline ? clientInfo.lastSnapshotAck : 0,
+                       baseline.value_or(std::span<const rnp::EntityState>{}));
+    }
+}
 
-    // Process ack bits for selective acknowledgment
-    for (int i = 0; i < 32; ++i)
+void srv::AsioServer::sendWorldDelta(ClientInfo &clientInfo, const std::uint32_t serverTick,
+                                     const std::span<const rnp::EntityState> current, const std::uint32_t baselineTick,
+                                     const std::span<const rnp::EntityState> baseline)
+{
+    constexpr std::size_t BODY_OFFSET = rnp::HEADER_SIZE + rnp::WIRE_SIZE<rnp::WorldStateHeader>;
+    constexpr std::size_t MAX_ID_BITS = 40;
+    const std::size_t bodySize = maxDatagramPayload() - rnp::WIRE_SIZE<rnp::WorldStateHeader>;
+    const rnp::EntityStateCodec codec(
+        rnp::hasCapability(clientInfo.clientCaps & m_serverCaps, rnp::Capability::QUANTIZED_STATE));
+
+    // Choose the entities within the budget, which never exceeds what the link sustains nor what the chunks hold
+    // even when an item is left at the end of each of them
+    std::size_t budgetBits =
+        rnp::MAX_WORLD_STATE_CHUNKS * (bodySize * 8 - MAX_ID_BITS - codec.recordBits(rnp::EntityStateFields::ALL));
+    budgetBits = std::min(budgetBits, clientInfo.congestion->snapshotBudget(m_tickRateHz) * 8);
+    if (m_snapshotBudgetBytes != 0)
+    {
+        budgetBits = std::min(budgetBits, m_snapshotBudgetBytes * 8);
+    }
+    std::optional<std::array<float, 2>> focus;
+    if (const std::optional<Viewport> viewport = clientInfo.interest->viewport ? clientInfo.interest->viewport
+                                                                              : m_viewport)
+    {
+        focus = {viewport->x + viewport->width / 2, viewport->y + viewport->height / 2};
+    }
+    ClientReplication &replication = *clientInfo.replication;
+    replication.plan(baseline, current, codec, budgetBits, focus);
+
+    // Every chunk of the snapshot is one message of the sequenced channel
+    const std::uint16_t channel = stampChannel(&clientInfo, rnp::PacketType::WORLD_STATE, 0);
+    WorldStateChunks chunks;
+    std::array<rnp::WorldStateHeader, rnp::MAX_WORLD_STATE_CHUNKS> headers{};
+    std::size_t chunkCount = 0;
+    std::optional<rnp::BitWriter> writer;
+    std::uint32_t previousId = 0;
+
+    // Make room for one item, opening a new chunk (which resets the id delta) when the current one is full
+    const auto reserve = [&](const auto &itemBits) -> bool
+    {
+        if (writer && writer->remainingBits() >= itemBits(previousId))
+        {
+            return true;
+        }
+        if (chunkCount == rnp::MAX_WORLD_STATE_CHUNKS || !(chunks[chunkCount] = m_sendPool.acquire()))
+        {
+            return false;
+        }
+        writer.emplace(chunks[chunkCount].buffer().subspan(BODY_OFFSET, bodySize));
+        headers[chunkCount] = {.serverTick = serverTick,
+                               .baselineTick = baselineTick,
+                               .entityCount = 0,
+                               .removedCount = 0,
+                               .chunkIndex = static_cast<std::uint8_t>(chunkCount),
+                               .chunkCount = 0};
+        previousId = 0;
+        ++chunkCount;
+        return true;
+    };
+    const auto commit = [&]() { chunks[chunkCount - 1].resize(BODY_OFFSET + writer->size()); };
+
+    // Removed ids lead each chunk, so every removal is encoded before the first entity record. What is encoded
+    // stays a prefix of the plan when the send pool runs dry, and is what the client will rebuild.
+    std::size_t removedCount = 0;
+    for (const std::uint32_t id : replication.removed())
     {
-        if (ackBits & (1 << i))
+        if (!reserve([&](const std::uint32_t previous) { return codec.idBits(id, previous); }))
         {
-            m_pendingReliable.erase(cumulative - i - 1);
+            break;
         }
+        codec.writeId(*writer, id, previousId);
+        previousId = id;
+        ++headers[chunkCount - 1].removedCount;
+        ++removedCount;
+        commit();
     }
+    std::size_t recordCount = 0;
+    previousId = 0;
+    for (const ClientReplication::Record &record : replication.records())
+    {
+        if (removedCount != replication.removed().size())
+        {
+            break;
+        }
+        const rnp::EntityState &entity = current[record.index];
+        if (!reserve([&](const std::uint32_t previous)
+                     { return codec.idBits(entity.id, previous) + codec.recordBits(record.fieldMask); }))
+        {
+            break;
+        }
+        codec.writeId(*writer, entity.id, previousId);
+        codec.writeRecord(*writer, entity, record.fieldMask);
+        previousId = entity.id;
+        ++headers[chunkCount - 1].entityCount;
+        ++recordCount;
+        commit();
+    }
+    if (chunkCount == 0 && reserve([](std::uint32_t) { return std::size_t{0}; }))
+    {
+        commit();
+    }
+    if (chunkCount == 0)
+    {
+        std::cerr << "[AsioServer] World state " << serverTick << " dropped, no send buffer\n";
+        return;
+    }
+    if (removedCount + recordCount != replication.removed().size() + replication.records().size())
+    {
+        std::cerr << "[AsioServer] World state " << serverTick << " truncated to " << chunkCount << " chunks\n";
+    }
+    replication.commit(serverTick, baseline, current, removedCount, recordCount);
 
-    m_clientLastAck[sender] = cumulative;
+    std::size_t bytes = 0;
+    for (std::size_t i = 0; i < chunkCount; ++i)
+    {
+        bytes += chunks[i].size();
+        headers[i].chunkCount = static_cast<std::uint8_t>(chunkCount);
+        rnp::BufferWriter headerWriter(
+            chunks[i].buffer().subspan(rnp::HEADER_SIZE, rnp::WIRE_SIZE<rnp::WorldStateHeader>));
+        rnp::write(headerWriter, headers[i]);
+        sendPayload(clientInfo.endpoint, &clientInfo, rnp::PacketType::WORLD_STATE, 0, channel, std::move(chunks[i]));
+    }
+    clientInfo.congestion->onSent(serverTick, bytes);
 }
 
-void srv::AsioServer::retransmitReliable()
+void srv::AsioServer::setPacketHandler(rnp::PacketType type, PacketHandler handler)
 {
-    // Simplified retransmission logic
-    // In production, track timestamps and implement exponential backoff
-    for (const auto &[seq, data] : m_pendingReliable)
+    const auto index = static_cast<std::size_t>(type);
+    if (index < m_packetHandlers.size())
     {
-        // Retransmit to all clients (would need per-client tracking in production)
-        for (const auto &[endpoint, clientInfo] : m_clients)
+        m_packetHandlers[index] = std::move(handler);
+    }
+}
+
+void srv::AsioServer::processAck(ClientInfo *client, std::span<const uint8_t> payload)
+{
+    rnp::BufferReader reader(payload);
+    rnp::PacketAck ack{};
+    if (client != nullptr && rnp::read(reader, ack))
+    {
+        client->reliability->sent.acknowledge(ack);
+    }
+}
+
+void srv::AsioServer::scheduleReliability()
+{
+    m_reliabilityTimer.expires_after(rnp::ACK_DELAY);
+    m_reliabilityTimer.async_wait(
+        [this](const asio::error_code &error)
         {
-            if (clientInfo.connected)
+            if (error)
             {
-                m_socket.async_send_to(asio::buffer(data), endpoint,
-                                       [this](const asio::error_code &error, std::size_t bytesTransferred)
-                                       { handleSend(error, bytesTransferred); });
+                return;
             }
+            retransmitReliable();
+            flushBatches();
+            // Owed ACKs the batches did not carry go out on their own
+            flushAcks();
+            checkSessions();
+            const auto now = std::chrono::steady_clock::now();
+            if ((m_droppedPackets != 0 || m_droppedMessages != 0) && now - m_lastDropReport >= std::chrono::seconds(1))
+            {
+                if (m_droppedPackets != 0)
+                {
+                    std::cerr << "[AsioServer] " << m_droppedPackets << " packet(s) over budget dropped\n";
+                }
+                if (m_droppedMessages != 0)
+                {
+                    std::cerr << "[AsioServer] " << m_droppedMessages << " message(s) dropped, not polled in time\n";
+                }
+                m_droppedPackets = 0;
+                m_droppedMessages = 0;
+                m_lastDropReport = now;
+            }
+            scheduleReliability();
+        });
+}
+
+void srv::AsioServer::flushAcks()
+{
+    for (ClientInfo &clientInfo : m_clients)
+    {
+        clientInfo.reliability->received.flushAcks(
+            [this, &clientInfo](const rnp::PacketAck &ack)
+            {
+                sendPacket(clientInfo.endpoint, &clientInfo, rnp::PacketType::ACK, 0,
+                           [&ack](rnp::BufferWriter &writer) { rnp::write(writer, ack); });
+            });
+    }
+}
+
+void srv::AsioServer::retransmitReliable()
+{
+    const auto now = std::chrono::steady_clock::now();
+    for (ClientInfo &clientInfo : m_clients)
+    {
+        const std::size_t lost = clientInfo.reliability->sent.retransmit(
+            now,
+            [this, &clientInfo](const std::span<const uint8_t> datagram)
+            {
+                SendPool::Lease packet = m_sendPool.acquire();
+                if (!packet)
+                {
+                    return;
+                }
+                std::memcpy(packet.buffer().data(), datagram.data(), datagram.size());
+                packet.resize(datagram.size());
+                transmit(clientInfo.endpoint, std::move(packet));
+            });
+        if (lost != 0)
+        {
+            std::cerr << "[AsioServer] " << lost << " reliable packet(s) to " << clientInfo.playerName << " lost after "
+                      << static_cast<int>(rnp::MAX_RETRANSMITS) << " retransmissions\n";
+        }
+        if (clientInfo.reliability->sent.stalled())
+        {
+            std::cout << "[AsioServer] Client bloqué, paquets fiables non acquittés: " << clientInfo.playerName
+                      << " - Session: " << clientInfo.sessionId << "\n";
+            m_stalledClients.push_back(clientInfo.endpoint);
         }
     }
+
+    // Nothing ordered can be delivered to them past an unacknowledged message: their session is over
+    for (const asio::ip::udp::endpoint &endpoint : m_stalledClients)
+    {
+        sendDisconnect(endpoint, rnp::DisconnectReason::TIMEOUT);
+        removeClient(endpoint);
+    }
+    m_stalledClients.clear();
+}
+
+void srv::AsioServer::flushBatches()
+{
+    for (ClientInfo &clientInfo : m_clients)
+    {
+        flushBatch(clientInfo);
+    }
+}
+
+void srv::AsioServer::flushBatch(ClientInfo &clientInfo)
+{
+    rnp::MessageBatch &batch = *clientInfo.batch;
+    if (batch.empty())
+    {
+        return;
+    }
+    SendPool::Lease packet = m_sendPool.acquire();
+    if (packet)
+    {
+        const std::span<const uint8_t> payload = batch.payload();
+        std::memcpy(packet.buffer().data() + rnp::HEADER_SIZE, payload.data(), payload.size());
+        packet.resize(rnp::HEADER_SIZE + payload.size());
+        sendPayload(clientInfo.endpoint, &clientInfo, batch.type(), 0, 0, std::move(packet));
+    }
+    else
+    {
+        std::cerr << "[AsioServer] Send pool exhausted, " << batch.count() << " batched message(s) dropped\n";
+    }
+    batch.clear();
 }
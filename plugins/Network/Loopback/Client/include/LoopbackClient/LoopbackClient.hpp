@@ -0,0 +1,115 @@
+///
+/// @file LoopbackClient.hpp
+/// @brief This file contains the client network implementation over an in-process loopback link
+/// @namespace eng
+///
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+
+#include "Interfaces/INetworkClient.hpp"
+#include "Interfaces/Protocol/PacketView.hpp"
+#include "Interfaces/Protocol/Protocol.hpp"
+#include "LoopbackLink/LoopbackLink.hpp"
+#include "Utils/SpscRing.hpp"
+
+namespace eng
+{
+
+    ///
+    /// @class LoopbackClient
+    /// @brief Network implementation for a client whose server runs in the same process, for solo play and tests
+    /// There is no IO thread: datagrams are decoded when pollWorldState() or pollEvent() is called, and handlers run
+    /// there. Every call is to come from the same thread.
+    /// @namespace eng
+    ///
+    class LoopbackClient final : public INetworkClient
+    {
+        public:
+            LoopbackClient() = default;
+            ~LoopbackClient() override { disconnect(); }
+
+            LoopbackClient(const LoopbackClient &) = delete;
+            LoopbackClient(LoopbackClient &&) = delete;
+            LoopbackClient &operator=(const LoopbackClient &) = delete;
+            LoopbackClient &operator=(LoopbackClient &&) = delete;
+
+            [[nodiscard]] const std::string getName() const override { return "Network_Loopback_Client"; }
+            [[nodiscard]] utl::PluginType getType() const override { return utl::PluginType::NETWORK_CLIENT; }
+
+            ///
+            /// @brief Attach to the link of port, host is ignored
+            ///
+            void connect(const std::string &host, uint16_t port) override;
+            void disconnect() override;
+            void setLinkConditions(const rnp::LinkConditions &conditions) override;
+
+            void sendConnect(const std::string &playerName) override;
+            void sendConnectWithCaps(const std::string &playerName, std::uint32_t clientCaps) override;
+            void sendDisconnect() override;
+            void sendDisconnect(rnp::DisconnectReason reason) override;
+            void sendPlayerInput(uint8_t direction, uint8_t shooting) override;
+            void sendPlayerInputAsEvent(std::uint16_t playerId, uint8_t direction, uint8_t shooting,
+                                        uint32_t clientTimeMs) override;
+            void sendPing() override;
+            void sendPing(std::uint32_t nonce, std::uint32_t sendTimeMs) override;
+            // Nothing is lost on the link, there is nothing to acknowledge
+            void sendAck(std::uint32_t /*cumulative*/, std::uint32_t /*ackBits*/) override {}
+
+            void setPacketHandler(rnp::PacketType type, PacketHandler handler) override;
+            ///
+            /// @brief Receive every ENTITY_EVENT when it is decoded, before its events are queued for pollEvent()
+            ///
+            void setEventsHandler(EventsHandler handler) override { m_eventsHandler = std::move(handler); }
+            bool pollEvent(NetworkEvent &event) override;
+
+            bool pollWorldState(rnp::PacketWorldState &snapshot) override;
+
+            std::uint32_t getSessionId() const override { return m_sessionId; }
+            std::uint16_t getServerTickRate() const override { return m_serverTickRate; }
+            ///
+            /// @brief Both ends share the clock, the estimate is exact as soon as the server published a tick
+            ///
+            std::optional<double> getServerTickEstimate() const override;
+            ClockStats getClockStats() const override;
+
+        private:
+            static constexpr std::size_t EVENT_DATAGRAMS = 64;
+
+            template <typename Encoder> void sendPacket(rnp::PacketType type, Encoder &&encodePayload);
+            void receive();
+            void handleDatagram(const rnp::PacketView &packet, rnp::LoopbackLink::Datagram &datagram);
+            void processWorldState(std::span<const uint8_t> payload);
+            void queueEvents(const rnp::PacketView &packet, rnp::LoopbackLink::Datagram &datagram);
+
+            std::shared_ptr<rnp::LoopbackLink> m_link;
+            std::uint32_t m_linkSessionId = 0; // Slot taken on the link, the session once accepted
+            std::uint32_t m_sendSequence = 0;
+            bool m_sendOverflow = false; // Told so since the last datagram the server ring took
+
+            std::array<PacketHandler, rnp::PACKET_TYPE_COUNT> m_packetHandlers;
+            EventsHandler m_eventsHandler;
+            // ENTITY_EVENT datagrams, pollEvent() hands out their events one at a time
+            utl::SpscRing<rnp::LoopbackLink::Datagram, EVENT_DATAGRAMS> m_eventDatagrams;
+            std::size_t m_eventOffset = 0; // Events of the oldest datagram already handed out, in bytes
+            bool m_eventsOverflow = false;
+
+            rnp::PacketWorldState m_pendingWorldState{}; // Chunks of the tick being received
+            std::size_t m_nextChunk = 0;
+            rnp::PacketWorldState m_readyWorldState{};
+            bool m_worldStateReady = false;
+
+            bool m_connected = false;
+            std::uint32_t m_sessionId = 0;
+            std::uint16_t m_serverTickRate = 0;
+            std::size_t m_pongs = 0;
+    }; // class LoopbackClient
+
+} // namespace eng
@@ -0,0 +1,8 @@
+#include <memory>
+
+#include "LoopbackClient/LoopbackClient.hpp"
+
+extern "C"
+{
+    eng::INetworkClient *entryPoint() { return std::make_unique<eng::LoopbackClient>().release(); }
+}
\ No newline at end of file
@@ -0,0 +1,338 @@
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+#include "LoopbackClient/LoopbackClient.hpp"
+
+void eng::LoopbackClient::connect(const std::string & /*host*/, uint16_t port)
+{
+    disconnect();
+    m_link = rnp::LoopbackLink::open(port);
+    m_linkSessionId = m_link->attach();
+    if (m_linkSessionId == 0)
+    {
+        std::cerr << "[LoopbackClient] Erreur de connexion: every slot of the link " << port << " is taken\n";
+        m_link.reset();
+        return;
+    }
+    std::cout << "[LoopbackClient] Connecté au lien local " << port << "\n";
+}
+
+void eng::LoopbackClient::disconnect()
+{
+    if (!m_link)
+    {
+        return;
+    }
+    if (m_connected)
+    {
+        sendDisconnect();
+    }
+
+    // Buffers go back to the pool of the link before the slot is handed to another client
+    rnp::LoopbackLink::Datagram datagram;
+    while (m_link->receiveOnClient(m_linkSessionId, datagram))
+    {
+    }
+    while (rnp::LoopbackLink::Datagram *queued = m_eventDatagrams.front())
+    {
+        *queued = {};
+        m_eventDatagrams.pop();
+    }
+    m_eventOffset = 0;
+    m_link->detach(m_linkSessionId);
+    m_link.reset();
+    m_linkSessionId = 0;
+    m_sessionId = 0;
+    m_connected = false;
+    std::cout << "[LoopbackClient] Déconnecté du serveur\n";
+}
+
+void eng::LoopbackClient::setLinkConditions(const rnp::LinkConditions & /*conditions*/)
+{
+    std::cerr << "[LoopbackClient] Link conditions ignored, the loopback link neither delays nor loses datagrams\n";
+}
+
+template <typename Encoder> void eng::LoopbackClient::sendPacket(const rnp::PacketType type, Encoder &&encodePayload)
+{
+    if (!m_link)
+    {
+        std::cerr << "[LoopbackClient] Not connected, packet dropped\n";
+        return;
+    }
+    rnp::LoopbackLink::Datagram datagram =
+        m_link->encode(type, m_linkSessionId, ++m_sendSequence, std::forward<Encoder>(encodePayload));
+    if (datagram && m_link->sendToServer(std::move(datagram)))
+    {
+        m_sendOverflow = false;
+        return;
+    }
+    if (!m_sendOverflow)
+    {
+        std::cerr << "[LoopbackClient] Server not polling, datagrams dropped\n";
+        m_sendOverflow = true;
+    }
+}
+
+void eng::LoopbackClient::sendConnect(const std::string &playerName) { sendConnectWithCaps(playerName, 0); }
+
+void eng::LoopbackClient::sendConnectWithCaps(const std::string &playerName, std::uint32_t clientCaps)
+{
+    // Payload: name_len(1) | player_name[name_len] | client_caps(4, BE)
+    const std::size_t nameLen = std::min<std::size_t>(playerName.size(), 31);
+
+    sendPacket(rnp::PacketType::CONNECT,
+               [&playerName, nameLen, clientCaps](rnp::BufferWriter &writer)
+               {
+                   writer.write(static_cast<std::uint8_t>(nameLen));
+                   writer.writeBytes({reinterpret_cast<const std::uint8_t *>(playerName.data()), nameLen});
+                   writer.write(clientCaps);
+               });
+}
+
+void eng::LoopbackClient::sendDisconnect() { sendDisconnect(rnp::DisconnectReason::CLIENT_REQUEST); }
+
+void eng::LoopbackClient::sendDisconnect(rnp::DisconnectReason reason)
+{
+    const rnp::PacketDisconnect disconnect{.reasonCode = static_cast<std::uint16_t>(reason)};
+
+    sendPacket(rnp::PacketType::DISCONNECT,
+               [&disconnect](rnp::BufferWriter &writer) { rnp::write(writer, disconnect); });
+}
+
+void eng::LoopbackClient::sendPlayerInput(uint8_t direction, uint8_t shooting)
+{
+    sendPacket(rnp::PacketType::PLAYER_INPUT,
+               [direction, shooting](rnp::BufferWriter &writer)
+               {
+                   writer.write(direction);
+                   writer.write(shooting);
+               });
+}
+
+void eng::LoopbackClient::sendPlayerInputAsEvent(std::uint16_t playerId, uint8_t direction, uint8_t shooting,
+                                                 uint32_t clientTimeMs)
+{
+    // Every input arrives, there is no need to repeat the last frames
+    const rnp::InputEventData input{
+        .buttons = 0, .direction = direction, .shooting = shooting, .clientTimeMs = clientTimeMs};
+
+    sendPacket(rnp::PacketType::ENTITY_EVENT, [playerId, &input](rnp::BufferWriter &writer)
+               { rnp::writeEvent(writer, rnp::EventType::INPUT, playerId, input); });
+}
+
+void eng::LoopbackClient::sendPing()
+{
+    sendPacket(rnp::PacketType::PING, [](rnp::BufferWriter &) {});
+}
+
+void eng::LoopbackClient::sendPing(std::uint32_t nonce, std::uint32_t sendTimeMs)
+{
+    const rnp::PacketPingPong ping{.nonce = nonce, .sendTimeMs = sendTimeMs};
+
+    sendPacket(rnp::PacketType::PING, [&ping](rnp::BufferWriter &writer) { rnp::write(writer, ping); });
+}
+
+void eng::LoopbackClient::setPacketHandler(rnp::PacketType type, PacketHandler handler)
+{
+    const auto index = static_cast<std::size_t>(type);
+    if (index < m_packetHandlers.size())
+    {
+        m_packetHandlers[index] = std::move(handler);
+    }
+}
+
+void eng::LoopbackClient::receive()
+{
+    rnp::LoopbackLink::Datagram datagram;
+    while (m_link && m_link->receiveOnClient(m_linkSessionId, datagram))
+    {
+        const std::optional<rnp::PacketView> packet = rnp::PacketView::parse(datagram.data());
+        // Datagrams sent to a previous client of the slot are dropped
+        if (packet && packet->header().sessionId == m_linkSessionId)
+        {
+            handleDatagram(*packet, datagram);
+        }
+    }
+}
+
+void eng::LoopbackClient::handleDatagram(const rnp::PacketView &packet, rnp::LoopbackLink::Datagram &datagram)
+{
+    const rnp::PacketHeader &header = packet.header();
+    switch (static_cast<rnp::PacketType>(header.type))
+    {
+        case rnp::PacketType::CONNECT_ACCEPT:
+        {
+            rnp::BufferReader reader(packet.payload());
+            rnp::PacketConnectAccept accept{};
+            if (!rnp::read(reader, accept))
+            {
+                std::cerr << "[LoopbackClient] Invalid CONNECT_ACCEPT payload\n";
+                break;
+            }
+            m_sessionId = accept.sessionId;
+            m_serverTickRate = accept.tickRateHz;
+            m_connected = true;
+            std::cout << "[LoopbackClient] Connection accepted - Session ID: " << m_sessionId
+                      << ", Tick Rate: " << m_serverTickRate << " Hz\n";
+            break;
+        }
+        case rnp::PacketType::DISCONNECT:
+            m_connected = false;
+            std::cout << "[LoopbackClient] Déconnecté par le serveur\n";
+            break;
+        case rnp::PacketType::WORLD_STATE:
+            processWorldState(packet.payload());
+            break;
+        case rnp::PacketType::PONG:
+            ++m_pongs;
+            break;
+        default:
+            break;
+    }
+
+    // Appeler les handlers personnalisés
+    if (header.type < m_packetHandlers.size() && m_packetHandlers[header.type])
+    {
+        m_packetHandlers[header.type](header, packet.payload());
+    }
+    // Last, the datagram is moved to the event queue
+    if (static_cast<rnp::PacketType>(header.type) == rnp::PacketType::ENTITY_EVENT)
+    {
+        queueEvents(packet, datagram);
+    }
+}
+
+void eng::LoopbackClient::processWorldState(std::span<const uint8_t> payload)
+{
+    // Payload: header | entity_count full records | input_ack(4), chunks in order since none is lost
+    rnp::BufferReader reader(payload);
+    rnp::WorldStateHeader worldState{};
+    if (!rnp::read(reader, worldState) || worldState.chunkCount == 0 ||
+        worldState.chunkCount > rnp::MAX_WORLD_STATE_CHUNKS || worldState.chunkIndex >= worldState.chunkCount)
+    {
+        std::cerr << "[LoopbackClient] Erreur de parsing WORLD_STATE: invalid chunk\n";
+        return;
+    }
+    if (worldState.chunkIndex == 0)
+    {
+        m_pendingWorldState.serverTick = worldState.serverTick;
+        m_pendingWorldState.entities.clear();
+        m_nextChunk = 0;
+    }
+    // A chunk the server could not hand over leaves the rest of its tick out
+    if (worldState.serverTick != m_pendingWorldState.serverTick || worldState.chunkIndex != m_nextChunk)
+    {
+        return;
+    }
+
+    for (std::uint16_t i = 0; i < worldState.entityCount; ++i)
+    {
+        (void)rnp::read(reader, m_pendingWorldState.entities.emplace_back());
+    }
+    const auto inputAck = reader.read<std::uint32_t>();
+    if (!reader.ok())
+    {
+        std::cerr << "[LoopbackClient] Erreur de parsing WORLD_STATE: truncated chunk\n";
+        m_nextChunk = rnp::MAX_WORLD_STATE_CHUNKS;
+        return;
+    }
+    if (++m_nextChunk != worldState.chunkCount)
+    {
+        return;
+    }
+
+    // Every chunk arrived: publish the snapshot, the previous ready one becomes the next pending buffer
+    std::ranges::sort(m_pendingWorldState.entities, {}, &rnp::EntityState::id);
+    m_pendingWorldState.entityCount = static_cast<std::uint16_t>(m_pendingWorldState.entities.size());
+    m_pendingWorldState.inputAck = inputAck;
+    std::swap(m_pendingWorldState, m_readyWorldState);
+    m_worldStateReady = true;
+}
+
+bool eng::LoopbackClient::pollWorldState(rnp::PacketWorldState &snapshot)
+{
+    receive();
+    if (!m_worldStateReady)
+    {
+        return false;
+    }
+    std::swap(snapshot, m_readyWorldState);
+    m_worldStateReady = false;
+    return true;
+}
+
+void eng::LoopbackClient::queueEvents(const rnp::PacketView &packet, rnp::LoopbackLink::Datagram &datagram)
+{
+    // server_tick (4 bytes, big endian) | event_count (2 bytes, big endian) | events
+    rnp::BufferReader reader(packet.payload());
+    rnp::EntityEventHeader eventHeader{};
+    (void)rnp::read(reader, eventHeader);
+    const rnp::EventRange events(reader.rest());
+    if (!reader.ok() || !events.isValid() || events.size() != eventHeader.eventCount)
+    {
+        std::cerr << "[LoopbackClient] Erreur de parsing ENTITY_EVENT: truncated event\n";
+        return;
+    }
+    if (m_eventsHandler)
+    {
+        m_eventsHandler(events);
+    }
+
+    // The datagram itself waits for pollEvent(), its events are not copied until then
+    rnp::LoopbackLink::Datagram *queued = m_eventDatagrams.claim();
+    if (queued == nullptr)
+    {
+        if (!m_eventsOverflow)
+        {
+            std::cerr << "[LoopbackClient] Event queue full, events dropped until it is polled\n";
+            m_eventsOverflow = true;
+        }
+        return;
+    }
+    m_eventsOverflow = false;
+    *queued = std::move(datagram);
+    m_eventDatagrams.commit();
+}
+
+bool eng::LoopbackClient::pollEvent(NetworkEvent &event)
+{
+    receive();
+    while (rnp::LoopbackLink::Datagram *queued = m_eventDatagrams.front())
+    {
+        // Validated when queued
+        const std::optional<rnp::PacketView> packet = rnp::PacketView::parse(queued->data());
+        rnp::BufferReader reader(packet->payload());
+        rnp::EntityEventHeader eventHeader{};
+        (void)rnp::read(reader, eventHeader);
+        const rnp::EventRange events(reader.rest().subspan(m_eventOffset));
+        if (!events.empty())
+        {
+            const rnp::EventView view = *events.begin();
+            m_eventOffset += rnp::EventRange::EVENT_HEADER_SIZE + view.data.size();
+            event.serverTick = eventHeader.serverTick;
+            event.type = view.type;
+            event.entityId = view.entityId;
+            event.size = static_cast<std::uint8_t>(view.data.size());
+            std::ranges::copy(view.data, event.data.begin());
+            return true;
+        }
+        *queued = {};
+        m_eventDatagrams.pop();
+        m_eventOffset = 0;
+    }
+    return false;
+}
+
+std::optional<double> eng::LoopbackClient::getServerTickEstimate() const
+{
+    return m_link ? m_link->tickEstimate() : std::nullopt;
+}
+
+eng::ClockStats eng::LoopbackClient::getClockStats() const
+{
+    return {.roundTrip = std::chrono::microseconds(0),
+            .minRoundTrip = std::chrono::microseconds(0),
+            .jitter = std::chrono::microseconds(0),
+            .samples = m_pongs};
+}
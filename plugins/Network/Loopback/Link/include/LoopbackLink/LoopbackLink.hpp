@@ -0,0 +1,190 @@
+///
+/// @file LoopbackLink.hpp
+/// @brief This file contains the in-process link the loopback client and server exchange datagrams through
+/// @namespace rnp
+///
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+
+#include "Interfaces/Protocol/Buffer.hpp"
+#include "Interfaces/Protocol/Protocol.hpp"
+#include "Utils/BufferPool.hpp"
+#include "Utils/MpscRing.hpp"
+#include "Utils/SpscRing.hpp"
+
+namespace rnp
+{
+
+    ///
+    /// @class LoopbackLink
+    /// @brief Datagrams between the clients and the server of one process, handed over through lock-free rings
+    /// A datagram is an RNP header and payload encoded once into a pooled buffer, whose lease then moves through
+    /// the rings: nothing is copied, nor sent through a socket. Every client pushes to the ring the server drains,
+    /// the server pushes to the ring of each client. The link neither loses nor reorders datagrams, there is no
+    /// reliability, fragmentation nor delta compression on top of it.
+    /// @namespace rnp
+    ///
+    class LoopbackLink
+    {
+        public:
+            using Clock = std::chrono::steady_clock;
+
+            static constexpr std::size_t MAX_CLIENTS = 4; // Solo play and tests
+            static constexpr std::size_t DATAGRAM_SIZE = 4096;
+            static constexpr std::size_t SERVER_INBOX = 512;
+            static constexpr std::size_t CLIENT_INBOX = 128;
+            // Enough for every ring to be full, a client that stops polling only fills its own
+            using Pool = utl::BufferPool<DATAGRAM_SIZE, SERVER_INBOX + MAX_CLIENTS * CLIENT_INBOX>;
+            using Datagram = Pool::Lease;
+
+            ///
+            /// @brief Link of a port, shared by the client and server opening it until the last one lets it go
+            /// The only call taking a lock. A port carries one server.
+            ///
+            [[nodiscard]] static std::shared_ptr<LoopbackLink> open(std::uint16_t port);
+
+            LoopbackLink() = default;
+            ~LoopbackLink() = default;
+
+            LoopbackLink(const LoopbackLink &) = delete;
+            LoopbackLink(LoopbackLink &&) = delete;
+            LoopbackLink &operator=(const LoopbackLink &) = delete;
+            LoopbackLink &operator=(LoopbackLink &&) = delete;
+
+            ///
+            /// @brief Take a free client slot, the session id tells it apart from the previous owners of the slot
+            /// @return the session id, 0 if every slot is taken
+            ///
+            [[nodiscard]] std::uint32_t attach();
+            ///
+            /// @brief Give the slot back, the server can no longer send to the session
+            ///
+            void detach(std::uint32_t sessionId);
+
+            ///
+            /// @brief Slot of a session id, MAX_CLIENTS if it has none
+            ///
+            [[nodiscard]] static std::size_t slotOf(const std::uint32_t sessionId)
+            {
+                const std::size_t slot = (sessionId & SLOT_MASK) - 1U;
+                return slot < MAX_CLIENTS ? slot : MAX_CLIENTS;
+            }
+
+            ///
+            /// @brief Encode a datagram into a pooled buffer
+            /// @return an empty lease if the pool is exhausted or the payload does not fit
+            ///
+            template <typename Encoder>
+            [[nodiscard]] Datagram encode(const PacketType type, const std::uint32_t sessionId,
+                                          const std::uint32_t sequence, Encoder &&encodePayload)
+            {
+                Datagram datagram = m_pool.acquire();
+                if (!datagram)
+                {
+                    return datagram;
+                }
+                BufferWriter payload(datagram.buffer().subspan(HEADER_SIZE));
+                std::forward<Encoder>(encodePayload)(payload);
+                if (!payload.ok())
+                {
+                    return {};
+                }
+                BufferWriter header(datagram.buffer());
+                write(header, PacketHeader{.type = static_cast<std::uint8_t>(type),
+                                           .length = static_cast<std::uint16_t>(payload.size()),
+                                           .flags = 0,
+                                           .channel = 0,
+                                           .sequence = sequence,
+                                           .sessionId = sessionId});
+                datagram.resize(HEADER_SIZE + payload.size());
+                return datagram;
+            }
+
+            ///
+            /// @brief Hand a datagram to the server, from any client thread
+            /// @return false if the server ring is full, the datagram is dropped
+            ///
+            [[nodiscard]] bool sendToServer(Datagram &&datagram) { return m_toServer.tryPush(std::move(datagram)); }
+            ///
+            /// @brief Take the oldest datagram sent to the server, from the server thread only
+            ///
+            [[nodiscard]] bool receiveOnServer(Datagram &datagram) { return m_toServer.tryPop(datagram); }
+
+            ///
+            /// @brief Hand a datagram to a client, from the server thread only
+            /// @return false if the session is gone or its ring is full, the datagram is dropped
+            ///
+            [[nodiscard]] bool sendToClient(const std::uint32_t sessionId, Datagram &&datagram)
+            {
+                const std::size_t slot = slotOf(sessionId);
+                if (slot == MAX_CLIENTS || m_clients[slot].sessionId.load(std::memory_order_acquire) != sessionId)
+                {
+                    return false;
+                }
+                Datagram *cell = m_clients[slot].inbox.claim();
+                if (cell == nullptr)
+                {
+                    return false;
+                }
+                *cell = std::move(datagram);
+                m_clients[slot].inbox.commit();
+                return true;
+            }
+            ///
+            /// @brief Take the oldest datagram sent to the slot of a session, from the thread of its client only
+            /// Datagrams left for a previous owner of the slot are handed out too, their header tells them apart.
+            ///
+            [[nodiscard]] bool receiveOnClient(const std::uint32_t sessionId, Datagram &datagram)
+            {
+                const std::size_t slot = slotOf(sessionId);
+                if (slot == MAX_CLIENTS)
+                {
+                    return false;
+                }
+                Datagram *cell = m_clients[slot].inbox.front();
+                if (cell == nullptr)
+                {
+                    return false;
+                }
+                datagram = std::move(*cell);
+                m_clients[slot].inbox.pop();
+                return true;
+            }
+
+            ///
+            /// @brief Record the tick the server just simulated, clients estimate its clock from it
+            ///
+            void publishTick(std::uint32_t serverTick, std::uint16_t tickRate);
+            ///
+            /// @brief Tick, fractional, the server is at right now, std::nullopt until it published one
+            /// Both ends share the clock, so there is no round trip to correct for.
+            ///
+            [[nodiscard]] std::optional<double> tickEstimate() const;
+
+        private:
+            static constexpr std::uint32_t SLOT_MASK = 0xFF; // Low byte of a session id, the generation above
+
+            struct Client
+            {
+                    std::atomic<std::uint32_t> sessionId{0}; // 0 while the slot is free
+                    utl::SpscRing<Datagram, CLIENT_INBOX> inbox;
+            };
+
+            Pool m_pool; // Before the rings, outlives the leases they hold
+            utl::MpscRing<Datagram, SERVER_INBOX> m_toServer;
+            std::array<Client, MAX_CLIENTS> m_clients;
+            std::atomic<std::uint32_t> m_generation{0};
+            std::atomic<std::uint64_t> m_tick{0}; // Tick in the high half, milliseconds since m_epoch in the low half
+            std::atomic<std::uint16_t> m_tickRate{0};
+            Clock::time_point m_epoch = Clock::now();
+    }; // class LoopbackLink
+
+} // namespace rnp
@@ -0,0 +1,68 @@
+#include <mutex>
+#include <unordered_map>
+
+#include "LoopbackLink/LoopbackLink.hpp"
+
+std::shared_ptr<rnp::LoopbackLink> rnp::LoopbackLink::open(const std::uint16_t port)
+{
+    // Links live as long as an end holds them, the map only lets the other end find them
+    static std::mutex mutex;
+    static std::unordered_map<std::uint16_t, std::weak_ptr<LoopbackLink>> links;
+
+    std::scoped_lock lock(mutex);
+    std::weak_ptr<LoopbackLink> &entry = links[port];
+    std::shared_ptr<LoopbackLink> link = entry.lock();
+    if (!link)
+    {
+        link = std::make_shared<LoopbackLink>();
+        entry = link;
+    }
+    return link;
+}
+
+std::uint32_t rnp::LoopbackLink::attach()
+{
+    const std::uint32_t generation = m_generation.fetch_add(1, std::memory_order_relaxed);
+    for (std::size_t slot = 0; slot < MAX_CLIENTS; ++slot)
+    {
+        const auto sessionId = generation << 8U | static_cast<std::uint32_t>(slot + 1);
+        std::uint32_t expected = 0;
+        if (m_clients[slot].sessionId.compare_exchange_strong(expected, sessionId, std::memory_order_acq_rel))
+        {
+            return sessionId;
+        }
+    }
+    return 0;
+}
+
+void rnp::LoopbackLink::detach(const std::uint32_t sessionId)
+{
+    const std::size_t slot = slotOf(sessionId);
+    if (slot != MAX_CLIENTS)
+    {
+        std::uint32_t expected = sessionId;
+        (void)m_clients[slot].sessionId.compare_exchange_strong(expected, 0, std::memory_order_acq_rel);
+    }
+}
+
+void rnp::LoopbackLink::publishTick(const std::uint32_t serverTick, const std::uint16_t tickRate)
+{
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - m_epoch);
+    m_tickRate.store(tickRate, std::memory_order_relaxed);
+    m_tick.store(static_cast<std::uint64_t>(serverTick) << 32U | static_cast<std::uint32_t>(elapsed.count()),
+                 std::memory_order_release);
+}
+
+std::optional<double> rnp::LoopbackLink::tickEstimate() const
+{
+    const std::uint64_t tick = m_tick.load(std::memory_order_acquire);
+    const std::uint16_t tickRate = m_tickRate.load(std::memory_order_relaxed);
+    if (tick == 0 || tickRate == 0)
+    {
+        return std::nullopt;
+    }
+    const auto now = static_cast<std::uint32_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - m_epoch).count());
+    const std::uint32_t sinceTick = now - static_cast<std::uint32_t>(tick);
+    return static_cast<double>(tick >> 32U) + static_cast<double>(sinceTick) * tickRate / 1000.0;
+}
@@ -0,0 +1,108 @@
+///
+/// @file LoopbackServer.hpp
+/// @brief This file contains the server network implementation over an in-process loopback link
+/// @namespace srv
+///
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+
+#include "Interfaces/INetworkServer.hpp"
+#include "Interfaces/Protocol/PacketView.hpp"
+#include "Interfaces/Protocol/Protocol.hpp"
+#include "LoopbackLink/LoopbackLink.hpp"
+
+namespace srv
+{
+
+    ///
+    /// @class LoopbackServer
+    /// @brief Network implementation for a server running in the same process as its clients, for solo play and
+    /// tests
+    /// There is no IO thread: datagrams are decoded by pollMessage() on the simulation thread and snapshots are
+    /// encoded by broadcastWorldState(). Snapshots are full states, the link does not lose them.
+    /// @namespace srv
+    ///
+    class LoopbackServer final : public INetworkServer
+    {
+        public:
+            LoopbackServer() = default;
+            ~LoopbackServer() override { stop(); }
+
+            LoopbackServer(const LoopbackServer &) = delete;
+            LoopbackServer(LoopbackServer &&) = delete;
+            LoopbackServer &operator=(const LoopbackServer &) = delete;
+            LoopbackServer &operator=(LoopbackServer &&) = delete;
+
+            ///
+            /// @brief Open the link of port, host is ignored
+            ///
+            void init(const std::string &host, uint16_t port) override;
+            [[nodiscard]] const std::string getName() const override { return "Network_Loopback_Server"; }
+            [[nodiscard]] utl::PluginType getType() const override { return utl::PluginType::NETWORK_SERVER; }
+
+            void start() override {}
+            void stop() override;
+
+            void setTickRate(std::uint16_t tickRate) override { m_tickRateHz = tickRate; }
+            void setServerCapabilities(std::uint32_t caps) override { m_serverCaps = caps; }
+            void setLinkConditions(const rnp::LinkConditions &conditions) override;
+
+            ///
+            /// @brief Encode the snapshot of a tick for every connected client, from the simulation thread only
+            ///
+            void broadcastWorldState(std::uint32_t serverTick, std::span<const rnp::EntityState> entities) override;
+            // Every entity fits the link, there is no interest management nor budget to apply
+            void setViewport(const Viewport & /*viewport*/) override {}
+            void setSnapshotBudget(std::size_t /*bytes*/) override {}
+            ///
+            /// @brief Send an event at once, the link keeps it ahead of the snapshot that follows
+            ///
+            void sendEvent(std::uint16_t playerId, rnp::EventType type, std::uint32_t entityId,
+                           std::span<const std::uint8_t> data) override;
+
+            [[nodiscard]] bool pollMessage(NetworkMessage &message) override;
+
+        private:
+            struct Session
+            {
+                    std::uint32_t sessionId = 0;
+                    std::uint16_t playerId = 0;
+                    bool connected = false;
+                    std::uint32_t sendSequence = 0;
+                    std::uint32_t inputAck = 0; // client_time_ms of the last INPUT handed to the simulation
+                    bool dropping = false;      // Told so since the last datagram its ring took
+            };
+
+            // Datagram encoding: header | entities | input_ack(4), per chunk
+            static constexpr std::size_t ENTITIES_PER_DATAGRAM =
+                (rnp::LoopbackLink::DATAGRAM_SIZE - rnp::HEADER_SIZE - rnp::WIRE_SIZE<rnp::WorldStateHeader> -
+                 sizeof(std::uint32_t)) /
+                rnp::WIRE_SIZE<rnp::EntityState>;
+
+            [[nodiscard]] bool handleDatagram(NetworkMessage &message);
+            [[nodiscard]] bool handleConnect(Session &session, const rnp::PacketView &packet, NetworkMessage &message);
+            [[nodiscard]] bool handleEvent(Session &session, std::span<const uint8_t> payload, NetworkMessage &message);
+            void handleInput(Session &session, std::uint32_t entityId, const rnp::InputEventData &input,
+                             NetworkMessage &message);
+            void relayEvent(const Session &source, const rnp::EventView &event);
+            template <typename Encoder> void send(Session &session, rnp::PacketType type, Encoder &&encodePayload);
+
+            std::shared_ptr<rnp::LoopbackLink> m_link;
+            rnp::LoopbackLink::Datagram m_datagram; // Being decoded, ENTITY_EVENTs over several calls
+            std::size_t m_eventOffset = 0;          // In the payload of m_datagram
+            MessagePool m_messagePool;
+            std::array<Session, rnp::LoopbackLink::MAX_CLIENTS> m_sessions{};
+            std::uint16_t m_tickRateHz = 60;
+            std::uint32_t m_serverCaps = 0;
+            std::uint32_t m_serverTick = 0; // Last tick broadcast
+            std::uint16_t m_nextPlayerId = 1;
+            bool m_snapshotTooLarge = false; // Told so since the last snapshot that fit
+    }; // class LoopbackServer
+
+} // namespace srv
@@ -0,0 +1,8 @@
+#include <memory>
+
+#include "LoopbackServer/LoopbackServer.hpp"
+
+extern "C"
+{
+    srv::INetworkServer *entryPoint() { return std::make_unique<srv::LoopbackServer>().release(); }
+}
\ No newline at end of file
@@ -0,0 +1,334 @@
+#include <algorithm>
+#include <iostream>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+#include "LoopbackServer/LoopbackServer.hpp"
+
+void srv::LoopbackServer::init(const std::string & /*host*/, uint16_t port)
+{
+    m_link = rnp::LoopbackLink::open(port);
+    std::cout << "[LoopbackServer] Serveur en écoute sur le lien local " << port << "\n";
+}
+
+void srv::LoopbackServer::stop()
+{
+    if (!m_link)
+    {
+        return;
+    }
+    const rnp::PacketDisconnect disconnect{.reasonCode =
+                                               static_cast<std::uint16_t>(rnp::DisconnectReason::SERVER_SHUTDOWN)};
+    for (Session &session : m_sessions)
+    {
+        if (session.connected)
+        {
+            send(session, rnp::PacketType::DISCONNECT,
+                 [&disconnect](rnp::BufferWriter &writer) { rnp::write(writer, disconnect); });
+        }
+    }
+    m_datagram = {};
+    m_eventOffset = 0;
+    m_sessions = {};
+    m_link.reset();
+}
+
+void srv::LoopbackServer::setLinkConditions(const rnp::LinkConditions & /*conditions*/)
+{
+    std::cerr << "[LoopbackServer] Link conditions ignored, the loopback link neither delays nor loses datagrams\n";
+}
+
+template <typename Encoder>
+void srv::LoopbackServer::send(Session &session, const rnp::PacketType type, Encoder &&encodePayload)
+{
+    rnp::LoopbackLink::Datagram datagram =
+        m_link->encode(type, session.sessionId, ++session.sendSequence, std::forward<Encoder>(encodePayload));
+    if (datagram && m_link->sendToClient(session.sessionId, std::move(datagram)))
+    {
+        session.dropping = false;
+        return;
+    }
+    // A client that stops polling loses what it is sent, as over a network
+    if (!session.dropping)
+    {
+        std::cerr << "[LoopbackServer] Client " << session.playerId << " not polling, datagrams dropped\n";
+        session.dropping = true;
+    }
+}
+
+bool srv::LoopbackServer::pollMessage(NetworkMessage &message)
+{
+    while (m_link)
+    {
+        if (!m_datagram && !m_link->receiveOnServer(m_datagram))
+        {
+            return false;
+        }
+        if (handleDatagram(message))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool srv::LoopbackServer::handleDatagram(NetworkMessage &message)
+{
+    const std::optional<rnp::PacketView> packet = rnp::PacketView::parse(m_datagram.data());
+    const std::size_t slot =
+        packet ? rnp::LoopbackLink::slotOf(packet->header().sessionId) : rnp::LoopbackLink::MAX_CLIENTS;
+    if (slot == rnp::LoopbackLink::MAX_CLIENTS)
+    {
+        m_datagram = {};
+        return false;
+    }
+    Session &session = m_sessions[slot];
+    const auto type = static_cast<rnp::PacketType>(packet->header().type);
+    if (type == rnp::PacketType::CONNECT)
+    {
+        return handleConnect(session, *packet, message);
+    }
+    // Anything else comes from the current session of the slot
+    if (!session.connected || session.sessionId != packet->header().sessionId)
+    {
+        m_datagram = {};
+        return false;
+    }
+
+    bool handled = false;
+    switch (type)
+    {
+        case rnp::PacketType::ENTITY_EVENT:
+            // Releases the datagram once its last event is handed out
+            return handleEvent(session, packet->payload(), message);
+        case rnp::PacketType::DISCONNECT:
+            std::cout << "[LoopbackServer] Client déconnecté - Session: " << session.sessionId << "\n";
+            session.connected = false;
+            message = {.kind = NetworkMessage::Kind::DISCONNECT, .playerId = session.playerId};
+            handled = true;
+            break;
+        case rnp::PacketType::PLAYER_INPUT:
+        {
+            // Support legacy PLAYER_INPUT: direction(1) | shooting(1)
+            const std::span<const uint8_t> payload = packet->payload();
+            if (payload.size() >= 2)
+            {
+                handleInput(session, session.playerId,
+                            {.buttons = 0, .direction = payload[0], .shooting = payload[1], .clientTimeMs = 0},
+                            message);
+                handled = true;
+            }
+            break;
+        }
+        case rnp::PacketType::PING:
+        {
+            rnp::BufferReader reader(packet->payload());
+            rnp::PacketPingPong ping{};
+            if (rnp::read(reader, ping))
+            {
+                send(session, rnp::PacketType::PONG, [&ping](rnp::BufferWriter &writer) { rnp::write(writer, ping); });
+            }
+            else
+            {
+                send(session, rnp::PacketType::PONG, [](rnp::BufferWriter &) {});
+            }
+            break;
+        }
+        default:
+            break; // Nothing to acknowledge on a lossless link
+    }
+    m_datagram = {};
+    return handled;
+}
+
+bool srv::LoopbackServer::handleConnect(Session &session, const rnp::PacketView &packet, NetworkMessage &message)
+{
+    const std::uint32_t sessionId = packet.header().sessionId;
+    if (session.connected && session.sessionId != sessionId)
+    {
+        // The previous client of the slot left without a DISCONNECT: it leaves first, the CONNECT is handled next
+        session.connected = false;
+        message = {.kind = NetworkMessage::Kind::DISCONNECT, .playerId = session.playerId};
+        return true;
+    }
+
+    // Payload: name_len(1) | player_name[name_len] | client_caps(4, BE), no capability changes the encoding here
+    rnp::BufferReader reader(packet.payload());
+    const std::span<const uint8_t> name = reader.readBytes(reader.read<std::uint8_t>());
+    (void)reader.read<std::uint32_t>();
+    if (!reader.ok() || session.connected)
+    {
+        m_datagram = {};
+        return false;
+    }
+
+    session = {.sessionId = sessionId, .playerId = m_nextPlayerId++, .connected = true};
+    const rnp::PacketConnectAccept accept{
+        .sessionId = sessionId,
+        .tickRateHz = m_tickRateHz,
+        .mtuPayloadBytes = static_cast<std::uint16_t>(rnp::LoopbackLink::DATAGRAM_SIZE - rnp::HEADER_SIZE),
+        .serverCaps = m_serverCaps};
+    send(session, rnp::PacketType::CONNECT_ACCEPT,
+         [&accept](rnp::BufferWriter &writer) { rnp::write(writer, accept); });
+    std::cout << "[LoopbackServer] Client connecté: " << std::string_view(reinterpret_cast<const char *>(name.data()),
+                                                                         name.size())
+              << " - Session: " << sessionId << "\n";
+
+    message = {.kind = NetworkMessage::Kind::CONNECT, .playerId = session.playerId};
+    message.data = m_messagePool.acquire();
+    if (message.data)
+    {
+        message.data.resize(name.size());
+        std::ranges::copy(name, message.data.data().begin());
+    }
+    m_datagram = {};
+    return true;
+}
+
+bool srv::LoopbackServer::handleEvent(Session &session, const std::span<const uint8_t> payload,
+                                      NetworkMessage &message)
+{
+    rnp::EventRange events(payload.subspan(m_eventOffset));
+    if (m_eventOffset == 0 && !events.isValid())
+    {
+        std::cerr << "[LoopbackServer] Erreur parsing ENTITY_EVENT: truncated event\n";
+        events = {};
+    }
+
+    // One event per call, the datagram is held until the next one is asked for
+    for (const rnp::EventView event : events)
+    {
+        m_eventOffset += rnp::EventRange::EVENT_HEADER_SIZE + event.data.size();
+        if (event.type == rnp::EventType::INPUT)
+        {
+            rnp::BufferReader reader(event.data);
+            rnp::InputEventData input{};
+            if (rnp::read(reader, input))
+            {
+                handleInput(session, event.entityId, input, message);
+                return true;
+            }
+        }
+        else if (event.type != rnp::EventType::INPUT_FRAMES)
+        {
+            relayEvent(session, event);
+            message = {.kind = NetworkMessage::Kind::EVENT,
+                       .playerId = session.playerId,
+                       .entityId = event.entityId,
+                       .eventType = event.type};
+            message.data = m_messagePool.acquire();
+            if (message.data)
+            {
+                message.data.resize(event.data.size());
+                std::ranges::copy(event.data, message.data.data().begin());
+            }
+            return true;
+        }
+    }
+    m_datagram = {};
+    m_eventOffset = 0;
+    return false;
+}
+
+void srv::LoopbackServer::handleInput(Session &session, const std::uint32_t entityId,
+                                      const rnp::InputEventData &input, NetworkMessage &message)
+{
+    // Handed to the simulation before the next snapshot, which therefore reflects it
+    session.inputAck = input.clientTimeMs;
+    message = {.kind = NetworkMessage::Kind::INPUT,
+               .playerId = session.playerId,
+               .entityId = entityId,
+               .eventType = rnp::EventType::INPUT,
+               .input = input};
+}
+
+void srv::LoopbackServer::relayEvent(const Session &source, const rnp::EventView &event)
+{
+    const rnp::EntityEventHeader eventHeader{.serverTick = m_serverTick, .eventCount = 1};
+    for (Session &session : m_sessions)
+    {
+        if (session.connected && &session != &source)
+        {
+            send(session, rnp::PacketType::ENTITY_EVENT,
+                 [&eventHeader, &event](rnp::BufferWriter &writer)
+                 {
+                     rnp::write(writer, eventHeader);
+                     rnp::writeEvent(writer, event.type, event.entityId, event.data);
+                 });
+        }
+    }
+}
+
+void srv::LoopbackServer::sendEvent(const std::uint16_t playerId, const rnp::EventType type,
+                                    const std::uint32_t entityId, const std::span<const std::uint8_t> data)
+{
+    const rnp::EntityEventHeader eventHeader{.serverTick = m_serverTick, .eventCount = 1};
+    for (Session &session : m_sessions)
+    {
+        if (session.connected && (playerId == EVERY_PLAYER || session.playerId == playerId))
+        {
+            send(session, rnp::PacketType::ENTITY_EVENT,
+                 [&eventHeader, type, entityId, data](rnp::BufferWriter &writer)
+                 {
+                     rnp::write(writer, eventHeader);
+                     rnp::writeEvent(writer, type, entityId, data);
+                 });
+        }
+    }
+}
+
+void srv::LoopbackServer::broadcastWorldState(const std::uint32_t serverTick,
+                                              const std::span<const rnp::EntityState> entities)
+{
+    if (!m_link)
+    {
+        return;
+    }
+    m_serverTick = serverTick;
+    m_link->publishTick(serverTick, m_tickRateHz);
+
+    const std::size_t chunkCount =
+        std::max<std::size_t>(1, (entities.size() + ENTITIES_PER_DATAGRAM - 1) / ENTITIES_PER_DATAGRAM);
+    if (chunkCount > rnp::MAX_WORLD_STATE_CHUNKS)
+    {
+        if (!m_snapshotTooLarge)
+        {
+            std::cerr << "[LoopbackServer] World state of " << entities.size() << " entities dropped, too large\n";
+            m_snapshotTooLarge = true;
+        }
+        return;
+    }
+    m_snapshotTooLarge = false;
+
+    // Full states, chunked like the network ones, each client gets its own input_ack
+    for (Session &session : m_sessions)
+    {
+        if (!session.connected)
+        {
+            continue;
+        }
+        for (std::size_t chunk = 0; chunk < chunkCount; ++chunk)
+        {
+            const std::size_t first = chunk * ENTITIES_PER_DATAGRAM;
+            const std::span<const rnp::EntityState> records =
+                entities.subspan(first, std::min(ENTITIES_PER_DATAGRAM, entities.size() - first));
+            const rnp::WorldStateHeader worldState{.serverTick = serverTick,
+                                                   .baselineTick = 0,
+                                                   .entityCount = static_cast<std::uint16_t>(records.size()),
+                                                   .removedCount = 0,
+                                                   .chunkIndex = static_cast<std::uint8_t>(chunk),
+                                                   .chunkCount = static_cast<std::uint8_t>(chunkCount)};
+            send(session, rnp::PacketType::WORLD_STATE,
+                 [&worldState, records, &session](rnp::BufferWriter &writer)
+                 {
+                     rnp::write(writer, worldState);
+                     for (const rnp::EntityState &entity : records)
+                     {
+                         rnp::write(writer, entity);
+                     }
+                     writer.write(session.inputAck);
+                 });
+        }
+    }
+}
@@ -7,9 +7,11 @@
 #pragma once
 
 #include <fstream>
+#include <optional>
 
 #include <nlohmann/json.hpp>
 
+#include "Interfaces/Protocol/LinkConditioner.hpp"
 #include "Server/Common.hpp"
 
 namespace srv
@@ -23,6 +25,7 @@ namespace srv
             std::string host = Config::Network::DEFAULT_NETWORK_HOST;
             uint16_t port = Config::Network::DEFAULT_NETWORK_PORT;
             std::string network_lib_path = Path::Plugin::PLUGINS_NETWORK_ASIO_SERVER.string();
+            std::optional<rnp::LinkConditions> link; // Simulated degraded link, for testing
 
             static ArgsConfig fromFile(const std::string &path);
     }; // struct Config
@@ -0,0 +1,163 @@
+///
+/// @file LagCompensation.hpp
+/// @brief This file contains the history of hitboxes shots are judged against, as each client saw them
+/// @namespace srv
+///
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "ECS/Component.hpp"
+#include "ECS/Registry.hpp"
+
+namespace srv
+{
+
+    ///
+    /// @brief Farthest a shot is rewound by default, players lagging more have to lead their targets
+    ///
+    inline constexpr std::chrono::milliseconds DEFAULT_MAX_REWIND{200};
+
+    ///
+    /// @class HitboxHistory
+    /// @brief Positions and radii of the damageable entities over the last HISTORY ticks
+    /// Each tick is stored as arrays of ids, positions and radii sorted by id, reused from one lap of the ring to
+    /// the next, so recording does not allocate once they have grown. A client-fired shot is tested against the
+    /// hitboxes at the tick the client was looking at, lerped between the two recorded ticks around it, and never
+    /// further back than the maximum rewind.
+    /// @namespace srv
+    ///
+    class HitboxHistory
+    {
+        public:
+            static constexpr std::size_t HISTORY = 64; // About a second at 60 Hz
+
+            void setMaxRewind(const std::chrono::milliseconds maxRewind) { m_maxRewind = maxRewind; }
+
+            ///
+            /// @brief Store the hitboxes of serverTick: entities with a Hitbox and a Transform, but projectiles
+            ///
+            void record(const std::uint32_t serverTick, ecs::Registry &registry)
+            {
+                Frame &frame = m_frames[serverTick % HISTORY];
+                frame.serverTick = serverTick;
+                frame.ids.clear();
+                for (const auto &[entity, hitbox] : registry.getAll<ecs::Hitbox>())
+                {
+                    if (!registry.hasComponent<ecs::Projectile>(entity) &&
+                        registry.hasComponent<ecs::Transform>(entity))
+                    {
+                        frame.ids.push_back(entity);
+                    }
+                }
+                std::ranges::sort(frame.ids);
+                frame.x.resize(frame.ids.size());
+                frame.y.resize(frame.ids.size());
+                frame.radius.resize(frame.ids.size());
+                for (std::size_t i = 0; i < frame.ids.size(); ++i)
+                {
+                    const ecs::Transform *transform = registry.getComponent<ecs::Transform>(frame.ids[i]);
+                    frame.x[i] = transform->x;
+                    frame.y[i] = transform->y;
+                    frame.radius[i] = registry.getComponent<ecs::Hitbox>(frame.ids[i])->radius;
+                }
+                m_newestTick = serverTick;
+                if (!m_oldestTick)
+                {
+                    m_oldestTick = serverTick;
+                }
+            }
+
+            ///
+            /// @brief Tick, fractional, a client was rendering when it sent an input that arrived at arrivalTick
+            /// viewDelay is how long before its arrival the client saw what it shot at, as estimated by the network.
+            /// The rewind is bounded by the maximum rewind and the recorded history.
+            ///
+            [[nodiscard]] double viewTick(const std::uint32_t arrivalTick, const std::uint16_t tickRate,
+                                          const std::chrono::microseconds viewDelay) const
+            {
+                const std::chrono::duration<double> behind = viewDelay;
+                const std::chrono::duration<double> maxRewind = m_maxRewind;
+                const double rewound = std::clamp(behind.count(), 0.0, maxRewind.count()) * tickRate;
+                const double oldest =
+                    m_newestTick ? std::max<double>(*m_oldestTick, static_cast<double>(*m_newestTick) - (HISTORY - 1))
+                                 : arrivalTick;
+                return std::max(arrivalTick - rewound, oldest);
+            }
+
+            ///
+            /// @brief Entity whose hitbox, as of viewTick, a shot of the given radius at (x, y) overlaps
+            /// @return the one whose center is the closest, std::nullopt if none or if viewTick was not recorded
+            ///
+            [[nodiscard]] std::optional<ecs::Entity> hit(const double viewTick, const float x, const float y,
+                                                         const float radius) const
+            {
+                const auto tick = static_cast<std::uint32_t>(viewTick);
+                const Frame *from = find(tick);
+                if (from == nullptr)
+                {
+                    return std::nullopt;
+                }
+                const Frame *to = find(tick + 1);
+                const auto alpha = static_cast<float>(viewTick - tick);
+
+                std::optional<ecs::Entity> closest;
+                float closestDistance = 0.F;
+                std::size_t next = 0;
+                for (std::size_t i = 0; i < from->ids.size(); ++i)
+                {
+                    float entityX = from->x[i];
+                    float entityY = from->y[i];
+                    if (to != nullptr)
+                    {
+                        while (next < to->ids.size() && to->ids[next] < from->ids[i])
+                        {
+                            ++next;
+                        }
+                        if (next < to->ids.size() && to->ids[next] == from->ids[i])
+                        {
+                            entityX = std::lerp(entityX, to->x[next], alpha);
+                            entityY = std::lerp(entityY, to->y[next], alpha);
+                        }
+                    }
+                    const float distance = std::hypot(entityX - x, entityY - y);
+                    if (distance <= radius + from->radius[i] && (!closest || distance < closestDistance))
+                    {
+                        closest = from->ids[i];
+                        closestDistance = distance;
+                    }
+                }
+                return closest;
+            }
+
+        private:
+            struct Frame
+            {
+                    std::uint32_t serverTick = 0;
+                    std::vector<ecs::Entity> ids;
+                    std::vector<float> x;
+                    std::vector<float> y;
+                    std::vector<float> radius;
+            };
+
+            [[nodiscard]] const Frame *find(const std::uint32_t serverTick) const
+            {
+                const Frame &frame = m_frames[serverTick % HISTORY];
+                return m_newestTick && serverTick <= *m_newestTick && frame.serverTick == serverTick ? &frame
+                                                                                                      : nullptr;
+            }
+
+            std::array<Frame, HISTORY> m_frames{};
+            std::optional<std::uint32_t> m_oldestTick; // First recorded
+            std::optional<std::uint32_t> m_newestTick;
+            std::chrono::milliseconds m_maxRewind = DEFAULT_MAX_REWIND;
+    }; // class HitboxHistory
+
+} // namespace srv
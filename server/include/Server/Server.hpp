@@ -7,9 +7,13 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
+#include "ECS/Registry.hpp"
 #include "Interfaces/INetworkServer.hpp"
 #include "Server/ArgsHandler.hpp"
+#include "Server/LagCompensation.hpp"
+#include "Server/Systems/Systems.hpp"
 #include "Utils/PluginLoader.hpp"
 
 namespace srv
@@ -38,13 +42,28 @@ namespace srv
             Server(Server &&) = delete;
             Server &operator=(Server &&) = delete;
 
-            void run() const;
+            void run();
 
         private:
             AppConfig setupConfig(const ArgsConfig &cfg) const;
+            void handleMessages();
+            ///
+            /// @brief Damage what the projectiles hit this tick, and tell every player
+            ///
+            void resolveHits();
+            void broadcastSnapshot();
 
             AppConfig m_config;
 
+            ecs::Registry m_registry;
+            PlayerSystem m_players;
+            ObstacleSystem m_obstacles;
+            ShotSystem m_shots;
+            HitboxHistory m_hitboxes;
+            std::vector<rnp::EntityState> m_snapshot;
+            NetworkMessage m_message; // Drained from the network each tick, its data returns to the pool
+            std::uint32_t m_serverTick = 0;
+
             std::unique_ptr<utl::PluginLoader> m_pluginLoader;
             std::shared_ptr<INetworkServer> m_network;
     }; // class Server
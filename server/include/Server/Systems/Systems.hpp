@@ -6,11 +6,344 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
 #include "ECS/Component.hpp"
 #include "ECS/Interfaces/ISystems.hpp"
 #include "ECS/Registry.hpp"
+#include "Interfaces/Protocol/Movement.hpp"
+#include "Interfaces/Protocol/Protocol.hpp"
+#include "Server/LagCompensation.hpp"
 
 namespace srv
 {
 
-} // namespace srv
\ No newline at end of file
+    ///
+    /// @class PlayerSystem
+    /// @brief Entity of each connected player, moved by its inputs as they are received
+    /// Each input moves the player for the client time since the previous one, as the client predicts it. That
+    /// time is drawn from a credit filled by update() at the pace of the server clock, so a client claiming more
+    /// time than went by moves no faster.
+    /// @namespace srv
+    ///
+    class PlayerSystem final : public eng::ASystem
+    {
+        public:
+            ///
+            /// @brief Most input time a player may save up, in seconds, to cover inputs arriving in bursts
+            ///
+            static constexpr float MAX_CREDIT = 0.25F;
+
+            ///
+            /// @brief Create the entity of a player who just connected, replacing any it already had
+            ///
+            ecs::Entity spawn(ecs::Registry &registry, const std::uint16_t playerId)
+            {
+                despawn(registry, playerId);
+                // Spread over the left of the field, one lane per player
+                const float y = static_cast<float>(playerId % LANES + 1) *
+                                (rnp::FIELD_HEIGHT - rnp::PLAYER_HEIGHT) / static_cast<float>(LANES + 1);
+                const ecs::Entity entity = registry.createEntity()
+                                               .with<ecs::Transform>("player_transform", SPAWN_X, y, 0.F)
+                                               .with<ecs::Velocity>("player_velocity", 0.F, 0.F)
+                                               .with<ecs::Player>("player", false)
+                                               .build();
+                m_players[playerId] = {.entity = entity};
+                return entity;
+            }
+
+            ///
+            /// @brief Remove the entity of a player who left
+            /// @return the entity removed, if the player had one
+            ///
+            std::optional<ecs::Entity> despawn(ecs::Registry &registry, const std::uint16_t playerId)
+            {
+                const auto player = m_players.find(playerId);
+                if (player == m_players.end())
+                {
+                    return std::nullopt;
+                }
+                const ecs::Entity entity = player->second.entity;
+                registry.removeComponent<ecs::Transform>(entity);
+                registry.removeComponent<ecs::Velocity>(entity);
+                registry.removeComponent<ecs::Player>(entity);
+                m_players.erase(player);
+                return entity;
+            }
+
+            [[nodiscard]] std::optional<ecs::Entity> entityOf(const std::uint16_t playerId) const
+            {
+                const auto player = m_players.find(playerId);
+                return player != m_players.end() ? std::optional(player->second.entity) : std::nullopt;
+            }
+
+            ///
+            /// @brief Move the entity of the player as the input says, inputs of players without one are ignored
+            ///
+            void applyInput(ecs::Registry &registry, const std::uint16_t playerId, const rnp::InputEventData &input)
+            {
+                const auto player = m_players.find(playerId);
+                if (player == m_players.end())
+                {
+                    return;
+                }
+                State &state = player->second;
+                auto *transform = registry.getComponent<ecs::Transform>(state.entity);
+                auto *velocity = registry.getComponent<ecs::Velocity>(state.entity);
+                if (transform == nullptr || velocity == nullptr)
+                {
+                    return;
+                }
+                const float step = std::min(rnp::inputStep(state.lastInputMs, input.clientTimeMs), state.credit);
+                if (input.clientTimeMs != 0)
+                {
+                    state.lastInputMs = input.clientTimeMs;
+                }
+                state.credit -= step;
+                const rnp::PlayerVelocity moving = rnp::playerVelocity(input.direction);
+                velocity->x = moving.x;
+                velocity->y = moving.y;
+                rnp::movePlayer(transform->x, transform->y, moving, step);
+            }
+
+            ///
+            /// @brief Give every player the input time of a tick
+            ///
+            void update(ecs::Registry & /* registry */, const float dt) override
+            {
+                for (auto &[playerId, state] : m_players)
+                {
+                    state.credit = std::min(state.credit + dt, MAX_CREDIT);
+                }
+            }
+
+        private:
+            static constexpr float SPAWN_X = 200.F;
+            static constexpr std::uint16_t LANES = 4;
+
+            struct State
+            {
+                    ecs::Entity entity;
+                    std::uint32_t lastInputMs = 0; // Client time of the last input applied, 0 before the first
+                    float credit = 0.F;            // Input time left to apply, in seconds
+            };
+
+            std::unordered_map<std::uint16_t, State> m_players;
+    }; // class PlayerSystem
+
+    ///
+    /// @class ObstacleSystem
+    /// @brief Asteroids drifting from the right edge of the field to the left one, the targets of the players
+    /// One enters every SPAWN_INTERVAL on the next of LANES lanes, and leaves once past the left edge or destroyed.
+    /// @namespace srv
+    ///
+    class ObstacleSystem final : public eng::ASystem
+    {
+        public:
+            static constexpr float SPEED = 80.F;
+            static constexpr float RADIUS = 25.F;
+            static constexpr float HEALTH = 20.F;
+            static constexpr float SPAWN_INTERVAL = 2.F;
+
+            void update(ecs::Registry &registry, const float dt) override
+            {
+                m_untilSpawn -= dt;
+                if (m_untilSpawn <= 0.F)
+                {
+                    m_untilSpawn += SPAWN_INTERVAL;
+                    spawn(registry);
+                }
+                m_gone.clear();
+                for (const auto &[entity, asteroid] : registry.getAll<ecs::Asteroid>())
+                {
+                    auto *transform = registry.getComponent<ecs::Transform>(entity);
+                    const auto *velocity = registry.getComponent<ecs::Velocity>(entity);
+                    transform->x += velocity->x * dt;
+                    if (transform->x < -RADIUS)
+                    {
+                        m_gone.push_back(entity);
+                    }
+                }
+                for (const ecs::Entity entity : m_gone)
+                {
+                    remove(registry, entity);
+                }
+            }
+
+            ///
+            /// @brief Take amount from the health of an obstacle
+            /// @return true if it was destroyed, false if it survived or was not an obstacle
+            ///
+            bool damage(ecs::Registry &registry, const ecs::Entity entity, const float amount)
+            {
+                auto *asteroid = registry.getComponent<ecs::Asteroid>(entity);
+                if (asteroid == nullptr)
+                {
+                    return false;
+                }
+                asteroid->health -= amount;
+                if (asteroid->health > 0.F)
+                {
+                    return false;
+                }
+                remove(registry, entity);
+                return true;
+            }
+
+        private:
+            static constexpr std::uint32_t LANES = 7;
+
+            void spawn(ecs::Registry &registry)
+            {
+                // Every third lane, so that two in a row are never close
+                const std::uint32_t lane = m_spawned++ * 3 % LANES;
+                const float y = (static_cast<float>(lane) + 0.5F) * rnp::FIELD_HEIGHT / static_cast<float>(LANES);
+                registry.createEntity()
+                    .with<ecs::Transform>("asteroid_transform", rnp::FIELD_WIDTH + RADIUS, y, 0.F)
+                    .with<ecs::Velocity>("asteroid_velocity", -SPEED, 0.F)
+                    .with<ecs::Asteroid>("asteroid", ecs::Asteroid::SMALL, 0.F, HEALTH)
+                    .with<ecs::Hitbox>("asteroid_hitbox", RADIUS);
+            }
+
+            static void remove(ecs::Registry &registry, const ecs::Entity entity)
+            {
+                registry.removeComponent<ecs::Transform>(entity);
+                registry.removeComponent<ecs::Velocity>(entity);
+                registry.removeComponent<ecs::Asteroid>(entity);
+                registry.removeComponent<ecs::Hitbox>(entity);
+            }
+
+            float m_untilSpawn = SPAWN_INTERVAL;
+            std::uint32_t m_spawned = 0;
+            std::vector<ecs::Entity> m_gone; // Past the left edge this tick
+    }; // class ObstacleSystem
+
+    ///
+    /// @class ShotSystem
+    /// @brief Projectiles fired by the players, judged against the hitboxes as their shooter saw them
+    /// A projectile leaves its shooter where the server has it when the input arrives, and every tick it is tested
+    /// against the hitbox history rewound by as many ticks as that input was late, so a player aiming at what their
+    /// screen shows hits it despite their latency. The rewind is set at firing for the whole flight.
+    /// @namespace srv
+    ///
+    class ShotSystem final : public eng::ASystem
+    {
+        public:
+            static constexpr float SPEED = 800.F;
+            static constexpr float RADIUS = 5.F;
+            static constexpr std::uint16_t DAMAGE = 10;
+            static constexpr std::uint32_t COOLDOWN_TICKS = 18; // 0.3 s at 60 Hz
+
+            struct Hit
+            {
+                    ecs::Entity target;
+                    ecs::Entity shooter;
+            };
+
+            ///
+            /// @brief Fire a projectile from the shooter, unless it fired in the last COOLDOWN_TICKS
+            /// @param rewind ticks the hitboxes it is judged against are behind the server
+            /// @return the projectile, if one was fired
+            ///
+            std::optional<ecs::Entity> fire(ecs::Registry &registry, const ecs::Entity shooter,
+                                            const std::uint32_t serverTick, const double rewind)
+            {
+                const auto *transform = registry.getComponent<ecs::Transform>(shooter);
+                if (transform == nullptr)
+                {
+                    return std::nullopt;
+                }
+                const auto lastFired = m_lastFired.find(shooter);
+                if (lastFired != m_lastFired.end() && serverTick - lastFired->second < COOLDOWN_TICKS)
+                {
+                    return std::nullopt;
+                }
+                m_lastFired[shooter] = serverTick;
+                const ecs::Entity projectile =
+                    registry.createEntity()
+                        .with<ecs::Transform>("projectile_transform", transform->x + rnp::PLAYER_WIDTH,
+                                              transform->y + rnp::PLAYER_HEIGHT / 2, 0.F)
+                        .with<ecs::Velocity>("projectile_velocity", SPEED, 0.F)
+                        .with<ecs::Projectile>("projectile", ecs::Projectile::BASIC, static_cast<float>(DAMAGE), 0.F,
+                                               0.F)
+                        .with<ecs::Hitbox>("projectile_hitbox", RADIUS)
+                        .build();
+                m_shots.push_back({.projectile = projectile, .shooter = shooter, .rewind = rewind});
+                return projectile;
+            }
+
+            ///
+            /// @brief Forget the cooldown of a shooter that left, its projectiles fly on
+            ///
+            void forget(const ecs::Entity shooter) { m_lastFired.erase(shooter); }
+
+            ///
+            /// @brief Move the projectiles, those past the right edge of the field are removed
+            ///
+            void update(ecs::Registry &registry, const float dt) override
+            {
+                std::erase_if(m_shots,
+                              [&registry, dt](const Shot &shot)
+                              {
+                                  auto *transform = registry.getComponent<ecs::Transform>(shot.projectile);
+                                  transform->x += SPEED * dt;
+                                  if (transform->x <= rnp::FIELD_WIDTH)
+                                  {
+                                      return false;
+                                  }
+                                  remove(registry, shot.projectile);
+                                  return true;
+                              });
+            }
+
+            ///
+            /// @brief Remove the projectiles overlapping a hitbox as their shooter saw it, at serverTick
+            /// @return the hits, valid until the next call
+            ///
+            const std::vector<Hit> &judge(ecs::Registry &registry, const HitboxHistory &history,
+                                          const std::uint32_t serverTick)
+            {
+                m_hits.clear();
+                std::erase_if(m_shots,
+                              [this, &registry, &history, serverTick](const Shot &shot)
+                              {
+                                  const auto *transform = registry.getComponent<ecs::Transform>(shot.projectile);
+                                  const std::optional<ecs::Entity> target =
+                                      history.hit(serverTick - shot.rewind, transform->x, transform->y, RADIUS);
+                                  if (!target)
+                                  {
+                                      return false;
+                                  }
+                                  m_hits.push_back({.target = *target, .shooter = shot.shooter});
+                                  remove(registry, shot.projectile);
+                                  return true;
+                              });
+                return m_hits;
+            }
+
+        private:
+            struct Shot
+            {
+                    ecs::Entity projectile;
+                    ecs::Entity shooter;
+                    double rewind; // Ticks
+            };
+
+            static void remove(ecs::Registry &registry, const ecs::Entity projectile)
+            {
+                registry.removeComponent<ecs::Transform>(projectile);
+                registry.removeComponent<ecs::Velocity>(projectile);
+                registry.removeComponent<ecs::Projectile>(projectile);
+                registry.removeComponent<ecs::Hitbox>(projectile);
+            }
+
+            std::vector<Shot> m_shots;
+            std::vector<Hit> m_hits;
+            std::unordered_map<ecs::Entity, std::uint32_t> m_lastFired; // Server tick each shooter last fired at
+    }; // class ShotSystem
+
+} // namespace srv
@@ -47,6 +47,10 @@ srv::ArgsConfig srv::ArgsConfig::fromFile(const std::string &path)
     {
         cfg.network_lib_path = p["network"];
     }
+    if (j.contains("link"))
+    {
+        cfg.link = rnp::linkConditionsFromJson(j["link"]);
+    }
     return cfg;
 }
 
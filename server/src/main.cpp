@@ -15,7 +15,7 @@ int main(const int argc, const char *const argv[], const char *const env[])
         {
             return EXIT_SUCCESS;
         }
-        const srv::Server server(argsConf);
+        srv::Server server(argsConf);
         server.run();
     }
     catch (const std::exception &e)
@@ -1,11 +1,36 @@
+#include <array>
+#include <chrono>
+#include <optional>
+#include <string>
 #include <thread>
 
 #include "Server/ArgsHandler.hpp"
 #include "Server/Common.hpp"
 #include "Server/Generated/Version.hpp"
+#include "ECS/Component.hpp"
 #include "Server/Server.hpp"
 #include "Utils/Logger.hpp"
 
+namespace
+{
+    rnp::EntityType entityTypeOf(ecs::Registry &registry, const ecs::Entity entity)
+    {
+        if (registry.hasComponent<ecs::Player>(entity))
+        {
+            return rnp::EntityType::PLAYER;
+        }
+        if (registry.hasComponent<ecs::Projectile>(entity))
+        {
+            return rnp::EntityType::PROJECTILE;
+        }
+        if (registry.hasComponent<ecs::Asteroid>(entity))
+        {
+            return rnp::EntityType::OBSTACLE;
+        }
+        return rnp::EntityType::ENEMY;
+    }
+} // namespace
+
 srv::Server::Server(const ArgsConfig &config)
     : m_pluginLoader(std::make_unique<utl::PluginLoader>()),
       m_network(m_pluginLoader->loadPlugin<INetworkServer>(!config.network_lib_path.empty()
@@ -21,15 +46,124 @@ srv::Server::Server(const ArgsConfig &config)
 
     m_config = setupConfig(config);
     m_network->init(config.host, config.port);
+    if (config.link)
+    {
+        m_network->setLinkConditions(*config.link);
+    }
 }
 
-void srv::Server::run() const
+void srv::Server::run()
 {
+    using clock = std::chrono::steady_clock;
+    const auto tickInterval = std::chrono::duration_cast<clock::duration>(
+        std::chrono::duration<double>(1.0 / Game::DEFAULT_TICK_RATE));
+    constexpr float tickSeconds = 1.F / static_cast<float>(Game::DEFAULT_TICK_RATE);
+
+    m_network->setTickRate(Game::DEFAULT_TICK_RATE);
     m_network->start();
+    auto nextTick = clock::now();
     for (;;)
     {
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+        ++m_serverTick;
+        m_players.update(m_registry, tickSeconds);
+        m_obstacles.update(m_registry, tickSeconds);
+        m_shots.update(m_registry, tickSeconds);
+        handleMessages();
+        m_hitboxes.record(m_serverTick, m_registry);
+        resolveHits();
+        broadcastSnapshot();
+        nextTick += tickInterval;
+        std::this_thread::sleep_until(nextTick);
+    }
+}
+
+void srv::Server::handleMessages()
+{
+    // Everything the IO thread received since the last tick, the simulation never waits on it
+    while (m_network->pollMessage(m_message))
+    {
+        switch (m_message.kind)
+        {
+            case NetworkMessage::Kind::CONNECT:
+            {
+                const ecs::Entity entity = m_players.spawn(m_registry, m_message.playerId);
+                m_network->sendEvent(m_message.playerId, rnp::EventType::CONTROL, entity, {});
+                utl::Logger::log("Player " + std::to_string(m_message.playerId) + " joined: " +
+                                     std::string(m_message.data.data().begin(), m_message.data.data().end()) +
+                                     ", entity " + std::to_string(entity),
+                                 utl::LogLevel::INFO);
+                break;
+            }
+            case NetworkMessage::Kind::DISCONNECT:
+                if (const std::optional<ecs::Entity> entity = m_players.despawn(m_registry, m_message.playerId))
+                {
+                    m_shots.forget(*entity);
+                    std::array<std::uint8_t, rnp::WIRE_SIZE<rnp::DespawnEventData>> data{};
+                    rnp::BufferWriter writer(data);
+                    rnp::write(writer, rnp::DespawnEventData{.reason = 0});
+                    m_network->sendEvent(EVERY_PLAYER, rnp::EventType::DESPAWN, *entity, data);
+                }
+                utl::Logger::log("Player " + std::to_string(m_message.playerId) + " left", utl::LogLevel::INFO);
+                break;
+            case NetworkMessage::Kind::INPUT:
+                // Applied to the entity of its sender, whatever entity it names
+                m_players.applyInput(m_registry, m_message.playerId, m_message.input);
+                if (const std::optional<ecs::Entity> entity = m_players.entityOf(m_message.playerId);
+                    entity && m_message.input.shooting != 0)
+                {
+                    const double viewTick =
+                        m_hitboxes.viewTick(m_serverTick, Game::DEFAULT_TICK_RATE, m_message.viewDelay);
+                    m_shots.fire(m_registry, *entity, m_serverTick, m_serverTick - viewTick);
+                }
+                break;
+            case NetworkMessage::Kind::EVENT:
+                break; // No system consumes the other client events
+            default:
+                break;
+        }
+        m_message.data = {};
+    }
+}
+
+void srv::Server::resolveHits()
+{
+    for (const ShotSystem::Hit &hit : m_shots.judge(m_registry, m_hitboxes, m_serverTick))
+    {
+        // Rewound, a shot may hit what an earlier one of the tick destroyed
+        if (!m_registry.hasComponent<ecs::Asteroid>(hit.target))
+        {
+            continue;
+        }
+        std::array<std::uint8_t, rnp::WIRE_SIZE<rnp::DamageEventData>> damage{};
+        rnp::BufferWriter damageWriter(damage);
+        rnp::write(damageWriter, rnp::DamageEventData{.amount = ShotSystem::DAMAGE, .sourceId = hit.shooter});
+        m_network->sendEvent(EVERY_PLAYER, rnp::EventType::DAMAGE, hit.target, damage);
+        if (m_obstacles.damage(m_registry, hit.target, ShotSystem::DAMAGE))
+        {
+            std::array<std::uint8_t, rnp::WIRE_SIZE<rnp::DespawnEventData>> despawn{};
+            rnp::BufferWriter despawnWriter(despawn);
+            rnp::write(despawnWriter, rnp::DespawnEventData{.reason = 0});
+            m_network->sendEvent(EVERY_PLAYER, rnp::EventType::DESPAWN, hit.target, despawn);
+        }
+    }
+}
+
+void srv::Server::broadcastSnapshot()
+{
+    // m_snapshot keeps its capacity between ticks, steady state does not allocate
+    m_snapshot.clear();
+    for (const auto &[entity, transform] : m_registry.getAll<ecs::Transform>())
+    {
+        const ecs::Velocity *velocity = m_registry.getComponent<ecs::Velocity>(entity);
+        m_snapshot.push_back({.id = entity,
+                              .type = static_cast<std::uint16_t>(entityTypeOf(m_registry, entity)),
+                              .x = transform.x,
+                              .y = transform.y,
+                              .vx = velocity != nullptr ? velocity->x : 0.F,
+                              .vy = velocity != nullptr ? velocity->y : 0.F,
+                              .stateFlags = 0});
     }
+    m_network->broadcastWorldState(m_serverTick, m_snapshot);
 }
 
 srv::AppConfig srv::Server::setupConfig(const ArgsConfig &cfg) const
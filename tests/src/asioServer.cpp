@@ -0,0 +1,511 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "AsioServer/AsioServer.hpp"
+#include "Interfaces/Protocol/Batch.hpp"
+#include "Interfaces/Protocol/Buffer.hpp"
+#include "Interfaces/Protocol/Input.hpp"
+#include "Interfaces/Protocol/LinkConditioner.hpp"
+#include "Interfaces/Protocol/PacketView.hpp"
+#include "Interfaces/Protocol/Protocol.hpp"
+
+namespace
+{
+
+    using namespace std::chrono_literals;
+    using Clock = std::chrono::steady_clock;
+
+    struct Message
+    {
+            rnp::PacketHeader header;
+            std::vector<std::uint8_t> payload;
+    };
+
+    ///
+    /// @brief Bare UDP peer writing RNP packets by hand, it answers nothing on its own
+    ///
+    class Peer
+    {
+        public:
+            ///
+            /// @param address local address to send from, any of 127.0.0.0/8 so that peers do not share a budget
+            ///
+            explicit Peer(const std::uint16_t port, const std::string &address = "127.0.0.1")
+                : m_socket(m_io, asio::ip::udp::endpoint(asio::ip::make_address(address), 0)),
+                  m_server(asio::ip::make_address("127.0.0.1"), port)
+            {
+                m_socket.non_blocking(true);
+            }
+
+            template <typename Encoder>
+            void send(const rnp::PacketType type, const std::uint16_t flags, Encoder &&encode)
+            {
+                std::array<std::uint8_t, rnp::HEADER_SIZE + rnp::MAX_PAYLOAD> datagram{};
+                rnp::BufferWriter payload(std::span<std::uint8_t>(datagram).subspan(rnp::HEADER_SIZE));
+                encode(payload);
+                rnp::BufferWriter header(std::span<std::uint8_t>(datagram).first(rnp::HEADER_SIZE));
+                rnp::write(header, rnp::PacketHeader{.type = static_cast<std::uint8_t>(type),
+                                                     .length = static_cast<std::uint16_t>(payload.size()),
+                                                     .flags = flags,
+                                                     .channel = 0,
+                                                     .sequence = ++m_sequence,
+                                                     .sessionId = m_sessionId});
+                m_socket.send_to(asio::buffer(datagram.data(), rnp::HEADER_SIZE + payload.size()), m_server);
+            }
+
+            ///
+            /// @brief CONNECT, then wait for CONNECT_ACCEPT and acknowledge it, which completes the handshake
+            ///
+            bool connect(const std::string &name, const std::uint32_t caps)
+            {
+                const std::optional<Message> accept = requestSession(name, caps);
+                if (!accept)
+                {
+                    return false;
+                }
+                acknowledge(*accept);
+                return true;
+            }
+
+            ///
+            /// @brief CONNECT and wait for CONNECT_ACCEPT, leaving the session pending
+            ///
+            std::optional<Message> requestSession(const std::string &name, const std::uint32_t caps)
+            {
+                send(rnp::PacketType::CONNECT, static_cast<std::uint16_t>(rnp::PacketFlags::RELIABLE),
+                     [&name, caps](rnp::BufferWriter &writer)
+                     {
+                         writer.write(static_cast<std::uint8_t>(name.size()));
+                         writer.writeBytes({reinterpret_cast<const std::uint8_t *>(name.data()), name.size()});
+                         writer.write(caps);
+                     });
+                std::optional<Message> accept = receive(rnp::PacketType::CONNECT_ACCEPT, Clock::now() + 1s);
+                if (accept)
+                {
+                    m_sessionId = accept->header.sessionId;
+                }
+                return accept;
+            }
+
+            ///
+            /// @brief ACK a reliable message of the session, the first one completes the handshake
+            ///
+            void acknowledge(const Message &message)
+            {
+                const rnp::PacketAck ack{.cumulativeAck = message.header.sequence, .ackBits = 0};
+                send(rnp::PacketType::ACK, 0, [&ack](rnp::BufferWriter &writer) { rnp::write(writer, ack); });
+            }
+
+            ///
+            /// @brief First message of a type received before the deadline, looked for inside BATCH packets too
+            ///
+            std::optional<Message> receive(const rnp::PacketType type, const Clock::time_point deadline)
+            {
+                std::array<std::uint8_t, rnp::HEADER_SIZE + rnp::MAX_PAYLOAD> datagram{};
+                while (Clock::now() < deadline)
+                {
+                    asio::error_code error;
+                    const std::size_t size = m_socket.receive(asio::buffer(datagram), 0, error);
+                    if (error)
+                    {
+                        std::this_thread::sleep_for(1ms);
+                        continue;
+                    }
+                    const std::optional<rnp::PacketView> packet =
+                        rnp::PacketView::parse(std::span<const std::uint8_t>(datagram).first(size));
+                    if (!packet)
+                    {
+                        continue;
+                    }
+                    std::optional<Message> found;
+                    const auto match = [&](const rnp::PacketType received, const std::span<const std::uint8_t> bytes)
+                    {
+                        if (received == type && !found)
+                        {
+                            found = Message{.header = packet->header(), .payload = {bytes.begin(), bytes.end()}};
+                        }
+                    };
+                    if (packet->type() == rnp::PacketType::BATCH && type != rnp::PacketType::BATCH)
+                    {
+                        EXPECT_TRUE(rnp::forEachBatched(packet->payload(), match));
+                    }
+                    else
+                    {
+                        match(packet->type(), packet->payload());
+                    }
+                    if (found)
+                    {
+                        return found;
+                    }
+                }
+                return std::nullopt;
+            }
+
+            [[nodiscard]] std::uint32_t sessionId() const { return m_sessionId; }
+
+        private:
+            asio::io_context m_io;
+            asio::ip::udp::socket m_socket;
+            asio::ip::udp::endpoint m_server;
+            std::uint32_t m_sequence = 0;
+            std::uint32_t m_sessionId = 0;
+    }; // class Peer
+
+    constexpr auto BATCHING = static_cast<std::uint32_t>(rnp::Capability::MESSAGE_BATCHING);
+
+} // namespace
+
+TEST(asioServer, timedOutSessionToldSo)
+{
+    constexpr std::uint16_t port = 41101;
+    srv::AsioServer server;
+    server.setSessionTimeouts(
+        {.handshake = 500ms, .keepaliveAfter = 200ms, .keepaliveInterval = 100ms, .session = 1s});
+    server.init("127.0.0.1", port);
+    server.start();
+
+    // With batching negotiated, as the Asio client always asks, then silent: keepalives are left unanswered
+    Peer peer(port);
+    ASSERT_TRUE(peer.connect("Bobi", BATCHING));
+    const Clock::time_point silentSince = Clock::now();
+    const std::optional<Message> disconnect = peer.receive(rnp::PacketType::DISCONNECT, silentSince + 3s);
+    ASSERT_TRUE(disconnect.has_value());
+    EXPECT_GE(Clock::now() - silentSince, 1s);
+    EXPECT_EQ(disconnect->header.sessionId, peer.sessionId());
+    rnp::BufferReader reader(disconnect->payload);
+    rnp::PacketDisconnect reason{};
+    ASSERT_TRUE(rnp::read(reader, reason));
+    EXPECT_EQ(reason.reasonCode, static_cast<std::uint16_t>(rnp::DisconnectReason::TIMEOUT));
+
+    srv::NetworkMessage message;
+    ASSERT_TRUE(server.pollMessage(message));
+    EXPECT_EQ(message.kind, srv::NetworkMessage::Kind::CONNECT);
+    ASSERT_TRUE(server.pollMessage(message));
+    EXPECT_EQ(message.kind, srv::NetworkMessage::Kind::DISCONNECT);
+    server.stop();
+}
+
+TEST(asioServer, simulationEventSentWithSnapshot)
+{
+    constexpr std::uint16_t port = 41102;
+    srv::AsioServer server;
+    server.init("127.0.0.1", port);
+    server.start();
+    Peer peer(port);
+    ASSERT_TRUE(peer.connect("Bobi", 0));
+    // Handed to the simulation once the handshake is complete
+    srv::NetworkMessage message;
+    const Clock::time_point deadline = Clock::now() + 1s;
+    bool polled = server.pollMessage(message);
+    while (!polled && Clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(1ms);
+        polled = server.pollMessage(message);
+    }
+    ASSERT_TRUE(polled);
+    ASSERT_EQ(message.kind, srv::NetworkMessage::Kind::CONNECT);
+    ASSERT_NE(message.playerId, srv::EVERY_PLAYER);
+
+    const std::array<rnp::EntityState, 1> entities{
+        {{.id = 9, .type = 0, .x = 0.F, .y = 0.F, .vx = 0.F, .vy = 0.F, .stateFlags = 0}}};
+    std::uint32_t tick = 1;
+    server.sendEvent(message.playerId, rnp::EventType::CONTROL, 9, {});
+    server.broadcastWorldState(++tick, entities);
+    const std::optional<Message> control = peer.receive(rnp::PacketType::ENTITY_EVENT, Clock::now() + 1s);
+    ASSERT_TRUE(control.has_value());
+    EXPECT_NE(control->header.flags & static_cast<std::uint16_t>(rnp::PacketFlags::RELIABLE), 0);
+    rnp::BufferReader reader(control->payload);
+    rnp::EntityEventHeader eventHeader{};
+    ASSERT_TRUE(rnp::read(reader, eventHeader));
+    EXPECT_EQ(eventHeader.serverTick, tick);
+    EXPECT_EQ(eventHeader.eventCount, 1U);
+    const rnp::EventRange events(reader.rest());
+    ASSERT_TRUE(events.isValid());
+    ASSERT_NE(events.begin(), events.end());
+    EXPECT_EQ((*events.begin()).type, rnp::EventType::CONTROL);
+    EXPECT_EQ((*events.begin()).entityId, 9U);
+
+    // Addressed to another player, it is not sent to this one
+    server.sendEvent(message.playerId + 1, rnp::EventType::CONTROL, 10, {});
+    server.broadcastWorldState(++tick, entities);
+    EXPECT_FALSE(peer.receive(rnp::PacketType::ENTITY_EVENT, Clock::now() + 100ms).has_value());
+    server.stop();
+}
+
+TEST(asioServer, pongNeverBatched)
+{
+    constexpr std::uint16_t port = 41103;
+    srv::AsioServer server;
+    server.init("127.0.0.1", port);
+    server.start();
+    Peer peer(port);
+    ASSERT_TRUE(peer.connect("Bobi", BATCHING));
+
+    // Answered within the same network tick, two batchable messages would leave in one BATCH
+    for (std::uint32_t nonce = 1; nonce <= 2; ++nonce)
+    {
+        const rnp::PacketPingPong ping{.nonce = nonce, .sendTimeMs = 0};
+        peer.send(rnp::PacketType::PING, 0, [&ping](rnp::BufferWriter &writer) { rnp::write(writer, ping); });
+    }
+    for (std::uint32_t nonce = 1; nonce <= 2; ++nonce)
+    {
+        const std::optional<Message> pong = peer.receive(rnp::PacketType::PONG, Clock::now() + 1s);
+        ASSERT_TRUE(pong.has_value());
+        EXPECT_EQ(static_cast<rnp::PacketType>(pong->header.type), rnp::PacketType::PONG);
+        rnp::BufferReader reader(pong->payload);
+        rnp::PacketPingPong answered{};
+        ASSERT_TRUE(rnp::read(reader, answered));
+        EXPECT_EQ(answered.nonce, nonce);
+    }
+    server.stop();
+}
+
+TEST(asioServer, clientEventsRelayedOncePerTick)
+{
+    constexpr std::uint16_t port = 41104;
+    srv::AsioServer server;
+    server.init("127.0.0.1", port);
+    server.start();
+    Peer sender(port);
+    Peer receiver(port);
+    ASSERT_TRUE(sender.connect("Bobi", 0));
+    ASSERT_TRUE(receiver.connect("Bobo", 0));
+
+    // Three packets of one event each, all handed to the simulation before the tick ends. Unreliable, so that
+    // nothing is retransmitted.
+    constexpr std::uint32_t events = 3;
+    for (std::uint32_t entityId = 1; entityId <= events; ++entityId)
+    {
+        const rnp::DamageEventData damage{.amount = 1, .sourceId = 0};
+        sender.send(rnp::PacketType::ENTITY_EVENT, 0, [entityId, &damage](rnp::BufferWriter &writer)
+                    { rnp::writeEvent(writer, rnp::EventType::DAMAGE, entityId, damage); });
+    }
+    srv::NetworkMessage message;
+    std::uint32_t received = 0;
+    const Clock::time_point deadline = Clock::now() + 1s;
+    while (received < events && Clock::now() < deadline)
+    {
+        if (!server.pollMessage(message))
+        {
+            std::this_thread::sleep_for(1ms);
+            continue;
+        }
+        received += message.kind == srv::NetworkMessage::Kind::EVENT ? 1 : 0;
+    }
+    ASSERT_EQ(received, events);
+
+    server.broadcastWorldState(1, {});
+    const std::optional<Message> relayed = receiver.receive(rnp::PacketType::ENTITY_EVENT, Clock::now() + 1s);
+    ASSERT_TRUE(relayed.has_value());
+    rnp::BufferReader reader(relayed->payload);
+    rnp::EntityEventHeader eventHeader{};
+    ASSERT_TRUE(rnp::read(reader, eventHeader));
+    EXPECT_EQ(relayed->header.flags & static_cast<std::uint16_t>(rnp::PacketFlags::RELIABLE), 0);
+    EXPECT_EQ(eventHeader.serverTick, 1U);
+    ASSERT_EQ(eventHeader.eventCount, events);
+    std::uint32_t entityId = 0;
+    for (const rnp::EventView event : rnp::EventRange(reader.rest()))
+    {
+        EXPECT_EQ(event.type, rnp::EventType::DAMAGE);
+        EXPECT_EQ(event.entityId, ++entityId);
+    }
+    EXPECT_EQ(entityId, events);
+    // Nothing to send back to the sender, nor twice to the receiver
+    EXPECT_FALSE(sender.receive(rnp::PacketType::ENTITY_EVENT, Clock::now() + 100ms).has_value());
+    server.broadcastWorldState(2, {});
+    EXPECT_FALSE(receiver.receive(rnp::PacketType::ENTITY_EVENT, Clock::now() + 100ms).has_value());
+    server.stop();
+}
+
+TEST(asioServer, redundantInputFramesHandedOnce)
+{
+    constexpr std::uint16_t port = 41105;
+    srv::AsioServer server;
+    server.init("127.0.0.1", port);
+    server.start();
+    Peer peer(port);
+    ASSERT_TRUE(peer.connect("Bobi", 0));
+
+    // Each event repeats the frames of the previous ones, the last is a stale copy arriving late
+    rnp::InputHistory history;
+    std::vector<std::vector<std::uint8_t>> sent;
+    for (std::uint32_t clientTimeMs = 10; clientTimeMs <= 40; clientTimeMs += 10)
+    {
+        history.push({.buttons = 0, .direction = 1, .shooting = 0, .clientTimeMs = clientTimeMs});
+        if (clientTimeMs == 10)
+        {
+            continue;
+        }
+        std::array<std::uint8_t, rnp::MAX_INPUT_FRAMES_SIZE> data{};
+        rnp::BufferWriter writer(data);
+        history.write(writer);
+        sent.emplace_back(data.begin(), data.begin() + static_cast<std::ptrdiff_t>(writer.size()));
+    }
+    sent.push_back(sent.front());
+    for (const std::vector<std::uint8_t> &frames : sent)
+    {
+        peer.send(rnp::PacketType::ENTITY_EVENT, 0, [&frames](rnp::BufferWriter &writer)
+                  { rnp::writeEvent(writer, rnp::EventType::INPUT_FRAMES, 1, frames); });
+    }
+
+    std::vector<std::uint32_t> inputs;
+    srv::NetworkMessage message;
+    for (const Clock::time_point deadline = Clock::now() + 500ms; Clock::now() < deadline;)
+    {
+        if (!server.pollMessage(message))
+        {
+            std::this_thread::sleep_for(1ms);
+            continue;
+        }
+        if (message.kind == srv::NetworkMessage::Kind::INPUT)
+        {
+            inputs.push_back(message.input.clientTimeMs);
+        }
+        ASSERT_NE(message.kind, srv::NetworkMessage::Kind::EVENT);
+    }
+    EXPECT_EQ(inputs, (std::vector<std::uint32_t>{10, 20, 30, 40}));
+    server.stop();
+}
+
+TEST(asioServer, oldestPendingHandshakeEvicted)
+{
+    constexpr std::uint16_t port = 41106;
+    srv::AsioServer server;
+    server.init("127.0.0.1", port);
+    server.start();
+
+    // One pending session more than allowed, each from its own address and within the server's CONNECT budget
+    std::vector<std::unique_ptr<Peer>> peers;
+    std::vector<Message> accepts;
+    for (std::size_t i = 0; i <= srv::MAX_PENDING_HANDSHAKES; ++i)
+    {
+        peers.push_back(std::make_unique<Peer>(port, "127.0.1." + std::to_string(i + 1)));
+        const std::optional<Message> accept = peers.back()->requestSession("Bobi" + std::to_string(i), 0);
+        ASSERT_TRUE(accept.has_value()) << i;
+        accepts.push_back(*accept);
+        std::this_thread::sleep_for(10ms); // HANDSHAKE_RATE refills a token as fast
+    }
+
+    // The first made room for the last: its acknowledgement completes nothing, the last one's does
+    peers.front()->acknowledge(accepts.front());
+    peers.back()->acknowledge(accepts.back());
+    std::vector<std::string> connected;
+    srv::NetworkMessage message;
+    for (const Clock::time_point deadline = Clock::now() + 300ms; Clock::now() < deadline;)
+    {
+        if (!server.pollMessage(message))
+        {
+            std::this_thread::sleep_for(1ms);
+            continue;
+        }
+        ASSERT_EQ(message.kind, srv::NetworkMessage::Kind::CONNECT);
+        connected.emplace_back(message.data.data().begin(), message.data.data().end());
+    }
+    EXPECT_EQ(connected, std::vector<std::string>{"Bobi" + std::to_string(srv::MAX_PENDING_HANDSHAKES)});
+    server.stop();
+}
+
+TEST(asioServer, pendingHandshakeExpires)
+{
+    constexpr std::uint16_t port = 41107;
+    srv::AsioServer server;
+    server.setSessionTimeouts({.handshake = 200ms,
+                               .keepaliveAfter = srv::KEEPALIVE_AFTER,
+                               .keepaliveInterval = srv::KEEPALIVE_INTERVAL,
+                               .session = srv::SESSION_TIMEOUT});
+    server.init("127.0.0.1", port);
+    server.start();
+
+    Peer late(port);
+    const std::optional<Message> accept = late.requestSession("Bobi", 0);
+    ASSERT_TRUE(accept.has_value());
+    std::this_thread::sleep_for(400ms);
+    late.acknowledge(*accept);
+    Peer onTime(port, "127.0.0.2");
+    ASSERT_TRUE(onTime.connect("Alice", 0));
+
+    std::vector<std::string> connected;
+    srv::NetworkMessage message;
+    for (const Clock::time_point deadline = Clock::now() + 300ms; Clock::now() < deadline;)
+    {
+        if (!server.pollMessage(message))
+        {
+            std::this_thread::sleep_for(1ms);
+            continue;
+        }
+        ASSERT_EQ(message.kind, srv::NetworkMessage::Kind::CONNECT);
+        connected.emplace_back(message.data.data().begin(), message.data.data().end());
+    }
+    EXPECT_EQ(connected, std::vector<std::string>{"Alice"});
+    server.stop();
+}
+
+TEST(asioServer, conditionedDownlinkFollowsItsSeed)
+{
+    constexpr std::uint16_t port = 41108;
+    constexpr std::uint32_t pings = 200;
+    const rnp::LinkConditions conditions{.latency = 40ms, .jitter = 20ms, .loss = 0.2, .seed = 3};
+    srv::AsioServer server;
+    server.init("127.0.0.1", port);
+    server.start();
+    Peer peer(port);
+    ASSERT_TRUE(peer.connect("Bobi", 0));
+    server.setLinkConditions(conditions);
+    std::this_thread::sleep_for(50ms);
+
+    // A PONG is the only datagram the server sends meanwhile, so the same seed loses the same ones
+    rnp::LinkConditioner model(conditions);
+    std::vector<std::uint32_t> expected;
+    for (std::uint32_t nonce = 1; nonce <= pings; ++nonce)
+    {
+        if (model.send(Clock::now(), 0).copies != 0)
+        {
+            expected.push_back(nonce);
+        }
+    }
+
+    // One PING every 5 ms, within the session budget, the PONGs collected in between
+    std::vector<Clock::time_point> sentAt(pings + 1);
+    std::vector<std::uint32_t> received;
+    std::vector<Clock::duration> delays;
+    const auto collect = [&](const Clock::time_point until)
+    {
+        for (std::optional<Message> pong = peer.receive(rnp::PacketType::PONG, until); pong;
+             pong = peer.receive(rnp::PacketType::PONG, until))
+        {
+            rnp::BufferReader reader(pong->payload);
+            rnp::PacketPingPong echoed{};
+            ASSERT_TRUE(rnp::read(reader, echoed));
+            ASSERT_GE(echoed.nonce, 1U);
+            ASSERT_LE(echoed.nonce, pings);
+            received.push_back(echoed.nonce);
+            delays.push_back(Clock::now() - sentAt[echoed.nonce]);
+        }
+    };
+    for (std::uint32_t nonce = 1; nonce <= pings; ++nonce)
+    {
+        sentAt[nonce] = Clock::now();
+        const rnp::PacketPingPong ping{.nonce = nonce, .sendTimeMs = 0};
+        peer.send(rnp::PacketType::PING, 0, [&ping](rnp::BufferWriter &writer) { rnp::write(writer, ping); });
+        collect(sentAt[nonce] + 5ms);
+    }
+    collect(Clock::now() + conditions.latency + conditions.jitter + 200ms);
+
+    std::ranges::sort(received);
+    EXPECT_EQ(received, expected);
+    // Loopback adds next to nothing to the conditioned delay, the timers and this thread's polling a little
+    ASSERT_FALSE(delays.empty());
+    EXPECT_GE(std::ranges::min(delays), conditions.latency);
+    EXPECT_LT(std::ranges::max(delays), conditions.latency + conditions.jitter + 30ms);
+    server.stop();
+}
@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "Interfaces/Protocol/Batch.hpp"
+#include "Interfaces/Protocol/Buffer.hpp"
+#include "Interfaces/Protocol/Protocol.hpp"
+
+namespace
+{
+
+    struct Entry
+    {
+            rnp::PacketType type;
+            std::vector<std::uint8_t> bytes;
+    };
+
+    ///
+    /// @brief Queue a message of length bytes, each of them value
+    ///
+    void add(rnp::MessageBatch &batch, const rnp::PacketType type, const std::size_t length, const std::uint8_t value)
+    {
+        const std::optional<std::span<std::uint8_t>> room = batch.reserve(rnp::MAX_PAYLOAD);
+        ASSERT_TRUE(room.has_value());
+        ASSERT_GE(room->size(), length);
+        std::fill_n(room->begin(), length, value);
+        batch.commit(type, length);
+    }
+
+    ///
+    /// @brief Entries of a BATCH payload, std::nullopt if it is rejected
+    ///
+    std::optional<std::vector<Entry>> unbatch(const std::span<const std::uint8_t> payload)
+    {
+        std::vector<Entry> entries;
+        const auto collect = [&entries](const rnp::PacketType type, const std::span<const std::uint8_t> bytes)
+        { entries.push_back({.type = type, .bytes = {bytes.begin(), bytes.end()}}); };
+        if (!rnp::forEachBatched(payload, collect))
+        {
+            EXPECT_TRUE(entries.empty()); // Nothing visited before the payload is known to be valid
+            return std::nullopt;
+        }
+        return entries;
+    }
+
+    ///
+    /// @brief BATCH payload of entries written by hand, their lengths as given whatever bytes follow
+    ///
+    std::vector<std::uint8_t> payloadOf(const std::vector<rnp::BatchEntryHeader> &entries, const std::size_t bytes)
+    {
+        std::vector<std::uint8_t> payload(entries.size() * rnp::WIRE_SIZE<rnp::BatchEntryHeader> + bytes);
+        rnp::BufferWriter writer(payload);
+        for (const rnp::BatchEntryHeader &entry : entries)
+        {
+            rnp::write(writer, entry);
+            writer.writeBytes(std::vector<std::uint8_t>(std::min<std::size_t>(entry.length, writer.remaining())));
+        }
+        payload.resize(writer.size());
+        return payload;
+    }
+
+} // namespace
+
+TEST(batch, roundTrip)
+{
+    rnp::MessageBatch batch;
+    EXPECT_TRUE(batch.empty());
+    add(batch, rnp::PacketType::ACK, 8, 0xA1);
+    add(batch, rnp::PacketType::WORLD_STATE, 300, 0xB2);
+    add(batch, rnp::PacketType::PING, 0, 0);
+    EXPECT_EQ(batch.count(), 3U);
+    EXPECT_EQ(batch.type(), rnp::PacketType::BATCH);
+    EXPECT_EQ(batch.payload().size(), 3 * rnp::WIRE_SIZE<rnp::BatchEntryHeader> + 308);
+
+    const std::optional<std::vector<Entry>> entries = unbatch(batch.payload());
+    ASSERT_TRUE(entries.has_value());
+    ASSERT_EQ(entries->size(), 3U);
+    EXPECT_EQ((*entries)[0].type, rnp::PacketType::ACK);
+    EXPECT_EQ((*entries)[0].bytes, std::vector<std::uint8_t>(8, 0xA1));
+    EXPECT_EQ((*entries)[1].type, rnp::PacketType::WORLD_STATE);
+    EXPECT_EQ((*entries)[1].bytes, std::vector<std::uint8_t>(300, 0xB2));
+    EXPECT_EQ((*entries)[2].type, rnp::PacketType::PING);
+    EXPECT_TRUE((*entries)[2].bytes.empty());
+
+    batch.clear();
+    EXPECT_TRUE(batch.empty());
+    EXPECT_TRUE(batch.payload().empty());
+}
+
+TEST(batch, loneMessageSentPlain)
+{
+    rnp::MessageBatch batch;
+    add(batch, rnp::PacketType::ENTITY_EVENT, 5, 0x42);
+    EXPECT_EQ(batch.type(), rnp::PacketType::ENTITY_EVENT);
+    EXPECT_EQ(std::vector<std::uint8_t>(batch.payload().begin(), batch.payload().end()),
+              std::vector<std::uint8_t>(5, 0x42));
+}
+
+TEST(batch, reserveBoundedByCapacity)
+{
+    rnp::MessageBatch batch;
+    EXPECT_FALSE(batch.reserve(rnp::WIRE_SIZE<rnp::BatchEntryHeader> - 1).has_value());
+    const std::optional<std::span<std::uint8_t>> room = batch.reserve(100);
+    ASSERT_TRUE(room.has_value());
+    EXPECT_EQ(room->size(), 100 - rnp::WIRE_SIZE<rnp::BatchEntryHeader>);
+    batch.commit(rnp::PacketType::ACK, room->size());
+    // Full: not even the header of another entry fits
+    EXPECT_FALSE(batch.reserve(100).has_value());
+    EXPECT_EQ(batch.reserve(rnp::MAX_PAYLOAD)->size(), rnp::MAX_PAYLOAD - 100 - rnp::WIRE_SIZE<rnp::BatchEntryHeader>);
+}
+
+TEST(batch, nestedOrTruncatedRejected)
+{
+    constexpr auto ACK = static_cast<std::uint8_t>(rnp::PacketType::ACK);
+    constexpr auto BATCH = static_cast<std::uint8_t>(rnp::PacketType::BATCH);
+    EXPECT_TRUE(unbatch(payloadOf({{.type = ACK, .length = 4}, {.type = ACK, .length = 2}}, 6)).has_value());
+    EXPECT_TRUE(unbatch({}).has_value());
+
+    // A valid entry first, then a BATCH inside the BATCH
+    EXPECT_FALSE(unbatch(payloadOf({{.type = ACK, .length = 4}, {.type = BATCH, .length = 0}}, 4)).has_value());
+    // Longer than the payload left
+    EXPECT_FALSE(unbatch(payloadOf({{.type = ACK, .length = 4}, {.type = ACK, .length = 8}}, 6)).has_value());
+    // Header cut short
+    std::vector<std::uint8_t> cut = payloadOf({{.type = ACK, .length = 4}}, 4);
+    cut.push_back(ACK);
+    EXPECT_FALSE(unbatch(cut).has_value());
+}
+
+TEST(batch, exemptions)
+{
+    // Timing, session setup and teardown leave at once, and a BATCH is never put in another
+    EXPECT_FALSE(rnp::batchable(rnp::PacketType::PONG));
+    EXPECT_FALSE(rnp::batchable(rnp::PacketType::CONNECT_ACCEPT));
+    EXPECT_FALSE(rnp::batchable(rnp::PacketType::DISCONNECT));
+    EXPECT_FALSE(rnp::batchable(rnp::PacketType::BATCH));
+    EXPECT_TRUE(rnp::batchable(rnp::PacketType::PING));
+    EXPECT_TRUE(rnp::batchable(rnp::PacketType::ACK));
+    EXPECT_TRUE(rnp::batchable(rnp::PacketType::WORLD_STATE));
+    EXPECT_TRUE(rnp::batchable(rnp::PacketType::ENTITY_EVENT));
+}
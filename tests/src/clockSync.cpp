@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+#include "AsioClient/ClockSync.hpp"
+
+namespace
+{
+
+    using namespace std::chrono_literals;
+    using Clock = eng::ClockSync::Clock;
+
+    constexpr std::uint16_t TICK_RATE = 50;
+    constexpr double SERVER_AHEAD = 100.0; // Server seconds at the epoch of the client clock
+    const Clock::time_point EPOCH = Clock::time_point{} + 1h;
+
+    ///
+    /// @brief Clock of a PONG stamped by the server at a local time, as a tick and the time into it
+    ///
+    rnp::PacketPongClock serverClockAt(const Clock::time_point stampedAt)
+    {
+        const auto serverUs =
+            std::chrono::duration_cast<std::chrono::microseconds>(stampedAt - EPOCH).count() +
+            static_cast<std::int64_t>(SERVER_AHEAD * 1e6);
+        constexpr std::int64_t tickUs = 1'000'000 / TICK_RATE;
+        return {.serverTick = static_cast<std::uint32_t>(serverUs / tickUs),
+                .tickPhaseUs = static_cast<std::uint32_t>(serverUs % tickUs)};
+    }
+
+    ///
+    /// @brief PING sent at sentAt, stamped by the server after outbound and answered after inbound more
+    ///
+    void exchange(eng::ClockSync &sync, const Clock::time_point sentAt, const std::chrono::microseconds outbound,
+                  const std::chrono::microseconds inbound)
+    {
+        const std::optional<rnp::PacketPingPong> ping = sync.ping(sentAt);
+        ASSERT_TRUE(ping.has_value());
+        sync.onPong(*ping, serverClockAt(sentAt + outbound), TICK_RATE, sentAt + outbound + inbound);
+    }
+
+    ///
+    /// @brief Estimated server seconds minus local seconds
+    ///
+    double offsetOf(const eng::ClockSync &sync) { return *sync.serverTick(EPOCH, TICK_RATE) / TICK_RATE; }
+
+} // namespace
+
+TEST(clockSync, pingBurstThenInterval)
+{
+    eng::ClockSync sync(EPOCH);
+    Clock::time_point now = EPOCH + 10ms;
+    std::optional<rnp::PacketPingPong> ping = sync.ping(now);
+    ASSERT_TRUE(ping.has_value());
+    EXPECT_EQ(ping->nonce, 1U);
+    EXPECT_EQ(ping->sendTimeMs, 10U);
+    EXPECT_FALSE(sync.ping(now + eng::CLOCK_SYNC_BURST_INTERVAL - 1ms).has_value());
+
+    for (std::size_t sent = 1; sent < eng::CLOCK_SYNC_BURST; ++sent)
+    {
+        now += eng::CLOCK_SYNC_BURST_INTERVAL;
+        ASSERT_TRUE(sync.ping(now).has_value()) << sent;
+    }
+    // Burst over
+    EXPECT_FALSE(sync.ping(now + eng::CLOCK_SYNC_BURST_INTERVAL).has_value());
+    EXPECT_FALSE(sync.ping(now + eng::CLOCK_SYNC_INTERVAL - 1ms).has_value());
+    ping = sync.ping(now + eng::CLOCK_SYNC_INTERVAL);
+    ASSERT_TRUE(ping.has_value());
+    EXPECT_EQ(ping->nonce, eng::CLOCK_SYNC_BURST + 1);
+}
+
+TEST(clockSync, roundTripSmoothed)
+{
+    eng::ClockSync sync(EPOCH);
+    EXPECT_FALSE(sync.serverTick(EPOCH, TICK_RATE).has_value());
+    EXPECT_EQ(sync.stats().samples, 0U);
+
+    exchange(sync, EPOCH + 1s, 10ms, 10ms);
+    EXPECT_EQ(sync.stats().roundTrip, 20ms);
+    EXPECT_EQ(sync.stats().jitter, 10ms);
+    exchange(sync, EPOCH + 2s, 20ms, 20ms);
+    // RFC 6298: variation (3 * 10 + 20) / 4, round trip (7 * 20 + 40) / 8
+    EXPECT_EQ(sync.stats().jitter, 12500us);
+    EXPECT_EQ(sync.stats().roundTrip, 22500us);
+    EXPECT_EQ(sync.stats().minRoundTrip, 20ms);
+    EXPECT_EQ(sync.stats().samples, 2U);
+}
+
+TEST(clockSync, offsetOfShortestRoundTrip)
+{
+    eng::ClockSync sync(EPOCH);
+    // Symmetric: exactly the server clock
+    exchange(sync, EPOCH + 1s, 5ms, 5ms);
+    EXPECT_NEAR(offsetOf(sync), SERVER_AHEAD, 1e-6);
+    EXPECT_NEAR(*sync.serverTick(EPOCH + 2s, TICK_RATE), (SERVER_AHEAD + 2.0) * TICK_RATE, 1e-4);
+
+    // Queued on the way back: its sample is 45 ms off, but a shorter round trip is in the window
+    exchange(sync, EPOCH + 2s, 5ms, 95ms);
+    EXPECT_NEAR(offsetOf(sync), SERVER_AHEAD, 1e-6);
+    EXPECT_EQ(sync.stats().minRoundTrip, 10ms);
+}
+
+TEST(clockSync, offsetEasedOnceBestSampleLeavesWindow)
+{
+    eng::ClockSync sync(EPOCH);
+    exchange(sync, EPOCH + 1s, 5ms, 5ms);
+    // Each 10 ms off, with longer round trips: the first sample stays the trusted one while in the window
+    for (std::size_t i = 1; i < eng::ClockSync::WINDOW; ++i)
+    {
+        exchange(sync, EPOCH + 1s + i * 1s, 10ms, 30ms);
+        ASSERT_NEAR(offsetOf(sync), SERVER_AHEAD, 1e-6) << i;
+    }
+    exchange(sync, EPOCH + 1s + eng::ClockSync::WINDOW * 1s, 10ms, 30ms);
+    EXPECT_EQ(sync.stats().minRoundTrip, 40ms);
+    EXPECT_NEAR(offsetOf(sync), SERVER_AHEAD - 0.010 / 8, 1e-6);
+}
+
+TEST(clockSync, strayPongIgnored)
+{
+    eng::ClockSync sync(EPOCH);
+    const std::optional<rnp::PacketPingPong> ping = sync.ping(EPOCH + 1s);
+    ASSERT_TRUE(ping.has_value());
+    const rnp::PacketPongClock clock = serverClockAt(EPOCH + 1s);
+
+    sync.onPong({.nonce = ping->nonce + 1, .sendTimeMs = 0}, clock, TICK_RATE, EPOCH + 1s + 10ms);
+    sync.onPong(*ping, clock, 0, EPOCH + 1s + 10ms); // Tick rate not known yet
+    EXPECT_EQ(sync.stats().samples, 0U);
+    sync.onPong(*ping, clock, TICK_RATE, EPOCH + 1s + 10ms);
+    sync.onPong(*ping, clock, TICK_RATE, EPOCH + 1s + 20ms); // Duplicated
+    EXPECT_EQ(sync.stats().samples, 1U);
+    EXPECT_EQ(sync.stats().roundTrip, 10ms);
+}
@@ -0,0 +1,304 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "Interfaces/Protocol/BitStream.hpp"
+#include "Interfaces/Protocol/Buffer.hpp"
+#include "Interfaces/Protocol/Protocol.hpp"
+#include "Interfaces/Protocol/Quantization.hpp"
+
+namespace
+{
+
+    constexpr std::uint8_t ALL_FIELDS = 0x3F;
+
+    ///
+    /// @brief Largest error of a value inside the range of a quantizer: half a step
+    ///
+    float halfStep(const rnp::Quantizer &quantizer)
+    {
+        return (quantizer.max - quantizer.min) / static_cast<float>((1U << quantizer.bits) - 1U) / 2.F;
+    }
+
+    rnp::EntityState entity(const std::uint32_t id)
+    {
+        return {.id = id,
+                .type = static_cast<std::uint16_t>(rnp::EntityType::ENEMY),
+                .x = 123.456F,
+                .y = -78.9F,
+                .vx = 512.25F,
+                .vy = -3.75F,
+                .stateFlags = 0x01};
+    }
+
+} // namespace
+
+TEST(codec, zigzagEdgeValues)
+{
+    EXPECT_EQ(rnp::zigzagEncode(0), 0U);
+    EXPECT_EQ(rnp::zigzagEncode(-1), 1U);
+    EXPECT_EQ(rnp::zigzagEncode(1), 2U);
+    EXPECT_EQ(rnp::zigzagEncode(-2), 3U);
+    EXPECT_EQ(rnp::zigzagEncode(std::numeric_limits<std::int32_t>::max()), 0xFFFFFFFEU);
+    EXPECT_EQ(rnp::zigzagEncode(std::numeric_limits<std::int32_t>::min()), 0xFFFFFFFFU);
+    for (const std::int32_t value : {0, 1, -1, 63, -64, 64, -65, std::numeric_limits<std::int32_t>::max(),
+                                     std::numeric_limits<std::int32_t>::min()})
+    {
+        EXPECT_EQ(rnp::zigzagDecode(rnp::zigzagEncode(value)), value);
+    }
+}
+
+TEST(codec, varintEdgeValues)
+{
+    struct Case
+    {
+            std::uint32_t value;
+            std::size_t bits;
+    };
+    const std::array<Case, 8> cases = {{{0, 8},
+                                        {0x7F, 8},
+                                        {0x80, 16},
+                                        {0x3FFF, 16},
+                                        {0x4000, 24},
+                                        {0x0FFFFFFF, 32},
+                                        {0x10000000, 40},
+                                        {std::numeric_limits<std::uint32_t>::max(), 40}}};
+    std::array<std::uint8_t, 64> buffer{};
+    rnp::BitWriter writer(buffer);
+    std::size_t bits = 0;
+    for (const Case &c : cases)
+    {
+        EXPECT_EQ(rnp::varintBits(c.value), c.bits);
+        writer.writeVarint(c.value);
+        bits += c.bits;
+        EXPECT_EQ(writer.bitSize(), bits);
+    }
+    ASSERT_TRUE(writer.ok());
+
+    rnp::BitReader reader(std::span<const std::uint8_t>(buffer).first(writer.size()));
+    for (const Case &c : cases)
+    {
+        EXPECT_EQ(reader.readVarint(), c.value);
+    }
+    EXPECT_TRUE(reader.ok());
+    EXPECT_EQ(reader.remainingBits(), 0U);
+}
+
+TEST(codec, varintMalformed)
+{
+    // Five bytes with the continuation bit: longer than any 32-bit value
+    const std::array<std::uint8_t, 6> endless = {0x80, 0x80, 0x80, 0x80, 0x80, 0x00};
+    rnp::BitReader reader(endless);
+    EXPECT_EQ(reader.readVarint(), 0U);
+    EXPECT_FALSE(reader.ok());
+
+    const std::array<std::uint8_t, 2> truncated = {0xFF, 0xFF};
+    rnp::BitReader truncatedReader(truncated);
+    (void)truncatedReader.readVarint(); // Whatever was read, the reader reports the missing bytes
+    EXPECT_FALSE(truncatedReader.ok());
+}
+
+TEST(codec, bitFieldsRoundTrip)
+{
+    std::array<std::uint8_t, 16> buffer{};
+    rnp::BitWriter writer(buffer);
+    writer.writeBool(true);
+    writer.writeBits(5, 3);
+    writer.writeBits(0x55, 7);
+    writer.writeBits(0x1ABC, 13);
+    writer.writeBits(0xDEADBEEF, 32);
+    writer.writeBits(0, 0);
+    ASSERT_TRUE(writer.ok());
+    EXPECT_EQ(writer.bitSize(), 56U);
+    EXPECT_EQ(writer.size(), 7U);
+
+    rnp::BitReader reader(std::span<const std::uint8_t>(buffer).first(writer.size()));
+    EXPECT_TRUE(reader.readBool());
+    EXPECT_EQ(reader.readBits(3), 5U);
+    EXPECT_EQ(reader.readBits(7), 0x55U);
+    EXPECT_EQ(reader.readBits(13), 0x1ABCU);
+    EXPECT_EQ(reader.readBits(32), 0xDEADBEEFU);
+    EXPECT_TRUE(reader.ok());
+}
+
+TEST(codec, alignedBitsMatchBufferWriter)
+{
+    std::array<std::uint8_t, 7> bits{};
+    rnp::BitWriter bitWriter(bits);
+    bitWriter.writeBits(0xAB, 8);
+    bitWriter.writeBits(0x1234, 16);
+    bitWriter.writeBits(0x89ABCDEF, 32);
+
+    std::array<std::uint8_t, 7> bytes{};
+    rnp::BufferWriter writer(bytes);
+    writer.write(std::uint8_t{0xAB});
+    writer.write(std::uint16_t{0x1234});
+    writer.write(std::uint32_t{0x89ABCDEF});
+    ASSERT_TRUE(bitWriter.ok());
+    ASSERT_TRUE(writer.ok());
+    EXPECT_EQ(bits, bytes);
+}
+
+TEST(codec, bitStreamOverflow)
+{
+    std::array<std::uint8_t, 2> buffer{};
+    rnp::BitWriter writer(buffer);
+    writer.writeBits(0x3FF, 10);
+    writer.writeBits(0x7F, 7); // One bit too many
+    EXPECT_FALSE(writer.ok());
+    writer.writeBits(1, 1); // Would fit, but the writer stays failed
+    EXPECT_FALSE(writer.ok());
+    EXPECT_EQ(writer.bitSize(), 10U);
+
+    rnp::BitWriter wide(buffer);
+    wide.writeBits(0, 33);
+    EXPECT_FALSE(wide.ok());
+
+    rnp::BitReader reader(buffer);
+    EXPECT_EQ(reader.readBits(10), 0x3FFU);
+    EXPECT_EQ(reader.readBits(7), 0U);
+    EXPECT_FALSE(reader.ok());
+    EXPECT_EQ(reader.readBits(1), 0U);
+}
+
+TEST(codec, quantizationErrorBounds)
+{
+    const rnp::EntityQuantization &q = rnp::DEFAULT_ENTITY_QUANTIZATION;
+    for (const rnp::Quantizer &quantizer : {q.x, q.y, q.vx, q.vy})
+    {
+        const float bound = halfStep(quantizer);
+        // Both bounds, then a sweep off the quantization grid
+        EXPECT_EQ(quantizer.dequantize(quantizer.quantize(quantizer.min)), quantizer.min);
+        EXPECT_FLOAT_EQ(quantizer.dequantize(quantizer.quantize(quantizer.max)), quantizer.max);
+        EXPECT_EQ(quantizer.quantize(quantizer.max), (1U << quantizer.bits) - 1U);
+        for (float value = quantizer.min; value <= quantizer.max; value += (quantizer.max - quantizer.min) / 997.F)
+        {
+            const float decoded = quantizer.dequantize(quantizer.quantize(value));
+            EXPECT_LE(std::abs(decoded - value), bound * 1.001F) << "value " << value;
+        }
+
+        // Out of range values clamp to the bounds
+        EXPECT_EQ(quantizer.quantize(quantizer.min - 1000.F), 0U);
+        EXPECT_EQ(quantizer.quantize(quantizer.max + 1000.F), (1U << quantizer.bits) - 1U);
+        EXPECT_EQ(quantizer.quantize(-std::numeric_limits<float>::infinity()), 0U);
+        EXPECT_EQ(quantizer.quantize(std::numeric_limits<float>::infinity()), (1U << quantizer.bits) - 1U);
+    }
+    // About 1/25th of a pixel on positions
+    EXPECT_LT(halfStep(q.x), 0.02F);
+    EXPECT_LT(halfStep(q.y), 0.02F);
+}
+
+TEST(codec, plainRecordRoundTrip)
+{
+    const rnp::EntityStateCodec codec(false);
+    const rnp::EntityState sent = entity(0xCAFEBABE);
+    std::array<std::uint8_t, 64> buffer{};
+    rnp::BitWriter writer(buffer);
+    codec.writeId(writer, sent.id, 0);
+    codec.writeRecord(writer, sent, ALL_FIELDS);
+    ASSERT_TRUE(writer.ok());
+    EXPECT_EQ(writer.bitSize(), codec.idBits(sent.id, 0) + codec.recordBits(ALL_FIELDS));
+
+    rnp::BitReader reader(std::span<const std::uint8_t>(buffer).first(writer.size()));
+    rnp::EntityState received{};
+    received.id = codec.readId(reader, 0);
+    codec.readRecord(reader, received);
+    ASSERT_TRUE(reader.ok());
+    EXPECT_EQ(received.id, sent.id);
+    EXPECT_EQ(received.type, sent.type);
+    EXPECT_EQ(received.x, sent.x);
+    EXPECT_EQ(received.y, sent.y);
+    EXPECT_EQ(received.vx, sent.vx);
+    EXPECT_EQ(received.vy, sent.vy);
+    EXPECT_EQ(received.stateFlags, sent.stateFlags);
+}
+
+TEST(codec, quantizedRecordsRoundTrip)
+{
+    const rnp::EntityStateCodec codec(true);
+    const rnp::EntityQuantization &q = rnp::DEFAULT_ENTITY_QUANTIZATION;
+    // Ids going up, down, and wrapping around
+    const std::vector<std::uint32_t> ids = {5, 6, 1000, 3, 0xFFFFFFFF, 0};
+    std::array<std::uint8_t, 256> buffer{};
+    rnp::BitWriter writer(buffer);
+    std::uint32_t previous = 0;
+    std::size_t bits = 0;
+    for (const std::uint32_t id : ids)
+    {
+        rnp::EntityState state = entity(id);
+        state.x += static_cast<float>(id % 100);
+        bits += codec.idBits(id, previous) + codec.recordBits(ALL_FIELDS);
+        codec.writeId(writer, id, previous);
+        codec.writeRecord(writer, state, ALL_FIELDS);
+        previous = id;
+    }
+    ASSERT_TRUE(writer.ok());
+    EXPECT_EQ(writer.bitSize(), bits);
+
+    rnp::BitReader reader(std::span<const std::uint8_t>(buffer).first(writer.size()));
+    previous = 0;
+    for (const std::uint32_t id : ids)
+    {
+        rnp::EntityState sent = entity(id);
+        sent.x += static_cast<float>(id % 100);
+        rnp::EntityState received{};
+        received.id = codec.readId(reader, previous);
+        codec.readRecord(reader, received);
+        previous = received.id;
+        EXPECT_EQ(received.id, id);
+        EXPECT_EQ(received.type, sent.type);
+        EXPECT_LE(std::abs(received.x - sent.x), halfStep(q.x) * 1.001F);
+        EXPECT_LE(std::abs(received.y - sent.y), halfStep(q.y) * 1.001F);
+        EXPECT_LE(std::abs(received.vx - sent.vx), halfStep(q.vx) * 1.001F);
+        EXPECT_LE(std::abs(received.vy - sent.vy), halfStep(q.vy) * 1.001F);
+        EXPECT_EQ(received.stateFlags, sent.stateFlags);
+    }
+    EXPECT_TRUE(reader.ok());
+}
+
+TEST(codec, partialRecordKeepsBaseline)
+{
+    for (const bool quantized : {false, true})
+    {
+        const rnp::EntityStateCodec codec(quantized);
+        const rnp::EntityState baseline = entity(1);
+        rnp::EntityState current = baseline;
+        current.y = 500.F;
+        current.stateFlags = 0;
+
+        const std::uint8_t mask = codec.diff(baseline, current);
+        EXPECT_EQ(mask, 0x04 | 0x20);
+        std::array<std::uint8_t, 32> buffer{};
+        rnp::BitWriter writer(buffer);
+        codec.writeRecord(writer, current, mask);
+        EXPECT_EQ(writer.bitSize(), codec.recordBits(mask));
+
+        rnp::BitReader reader(std::span<const std::uint8_t>(buffer).first(writer.size()));
+        rnp::EntityState received = baseline;
+        codec.readRecord(reader, received);
+        ASSERT_TRUE(reader.ok());
+        EXPECT_EQ(received.x, baseline.x);
+        EXPECT_EQ(received.vx, baseline.vx);
+        EXPECT_NEAR(received.y, 500.F, halfStep(rnp::DEFAULT_ENTITY_QUANTIZATION.y));
+        EXPECT_EQ(received.stateFlags, 0);
+    }
+}
+
+TEST(codec, quantizedDiffIgnoresSubStepChanges)
+{
+    const rnp::EntityStateCodec plain(false);
+    const rnp::EntityStateCodec quantized(true);
+    rnp::EntityState baseline = entity(1);
+    baseline.x = rnp::DEFAULT_ENTITY_QUANTIZATION.x.dequantize(1000);
+    rnp::EntityState current = baseline;
+    current.x += halfStep(rnp::DEFAULT_ENTITY_QUANTIZATION.x) / 4.F;
+
+    EXPECT_EQ(plain.diff(baseline, current), 0x02);
+    EXPECT_EQ(quantized.diff(baseline, current), 0);
+    current.x += halfStep(rnp::DEFAULT_ENTITY_QUANTIZATION.x) * 2.F;
+    EXPECT_EQ(quantized.diff(baseline, current), 0x02);
+}
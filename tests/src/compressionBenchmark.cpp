@@ -0,0 +1,211 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <span>
+#include <vector>
+
+#include "Interfaces/Protocol/BitStream.hpp"
+#include "Interfaces/Protocol/Compression.hpp"
+#include "Interfaces/Protocol/Delta.hpp"
+#include "Interfaces/Protocol/Quantization.hpp"
+
+namespace
+{
+
+    using Payloads = std::vector<std::vector<std::uint8_t>>;
+
+    ///
+    /// @brief WORLD_STATE and ENTITY_EVENT payloads of a simulated match, encoded by the protocol codecs
+    ///
+    Payloads recordTraffic(const bool quantized, const std::uint32_t ticks)
+    {
+        constexpr std::size_t BODY_SIZE = rnp::MAX_PAYLOAD - rnp::WIRE_SIZE<rnp::WorldStateHeader>;
+        constexpr std::size_t MAX_RECORD_BITS = 8 * (4 + rnp::WIRE_SIZE<rnp::EntityState> + 1);
+        const rnp::EntityStateCodec codec(quantized);
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<float> jitter(-2.F, 2.F);
+        std::vector<rnp::EntityState> previous;
+        std::vector<rnp::EntityState> current;
+        std::uint32_t nextId = 1;
+        Payloads payloads;
+
+        for (std::uint32_t i = 0; i < 4; ++i)
+        {
+            current.push_back({nextId++, 1, 100.F, 200.F + 150.F * static_cast<float>(i), 0.F, 0.F, 1});
+        }
+        for (std::uint32_t tick = 1; tick <= ticks; ++tick)
+        {
+            previous = current;
+            std::vector<rnp::EventRecord> events;
+            if (tick % 5 == 0)
+            {
+                current.push_back({nextId++, 2, 1980.F, static_cast<float>(rng() % 1000), -180.F, 0.F, 0});
+                events.push_back(
+                    {rnp::EventType::SPAWN, current.back().id, {0, 2, 0x44, 0xF7, 0, 0, 0x43, 0x48, 0, 0}});
+            }
+            for (rnp::EntityState &entity : current)
+            {
+                entity.x += entity.vx / 60.F + (entity.type == 1 ? jitter(rng) : 0.F);
+                entity.y += entity.type == 1 ? jitter(rng) : 0.F;
+            }
+            std::erase_if(current,
+                          [&](const rnp::EntityState &entity)
+                          {
+                              const bool gone = entity.x < -64.F;
+                              if (gone)
+                              {
+                                  events.push_back({rnp::EventType::DESPAWN, entity.id, {1}});
+                                  events.push_back({rnp::EventType::SCORE, 1, {0, 100}});
+                              }
+                              return gone;
+                          });
+
+            // WORLD_STATE chunk against the previous tick
+            std::array<std::uint8_t, rnp::MAX_PAYLOAD> buffer{};
+            constexpr std::size_t HEADER_SIZE = rnp::WIRE_SIZE<rnp::WorldStateHeader>;
+            rnp::BitWriter bits(std::span<std::uint8_t>(buffer).subspan(HEADER_SIZE, BODY_SIZE));
+            rnp::WorldStateHeader header{tick, tick - 1, 0, 0, 0, 1};
+            std::uint32_t previousId = 0;
+            rnp::forEachRemoved(previous, current,
+                                [&](const std::uint32_t id)
+                                {
+                                    codec.writeId(bits, id, previousId);
+                                    previousId = id;
+                                    ++header.removedCount;
+                                });
+            previousId = 0;
+            rnp::forEachChanged(
+                previous, current,
+                [&](const rnp::EntityState &baseline, const rnp::EntityState &entity)
+                { return codec.diff(baseline, entity); },
+                [&](const rnp::EntityState &entity, const std::uint8_t mask)
+                {
+                    if (bits.remainingBits() < MAX_RECORD_BITS)
+                    {
+                        return; // The rest would go in the next chunk
+                    }
+                    codec.writeId(bits, entity.id, previousId);
+                    codec.writeRecord(bits, entity, mask);
+                    previousId = entity.id;
+                    ++header.entityCount;
+                });
+            rnp::BufferWriter headerWriter(buffer);
+            rnp::write(headerWriter, header);
+            payloads.emplace_back(buffer.begin(),
+                                  buffer.begin() + static_cast<std::ptrdiff_t>(HEADER_SIZE + bits.size()));
+
+            // ENTITY_EVENT burst of the tick
+            if (!events.empty())
+            {
+                std::vector<std::uint8_t> payload(rnp::WIRE_SIZE<rnp::EntityEventHeader>);
+                rnp::BufferWriter eventHeader(payload);
+                rnp::write(eventHeader, rnp::EntityEventHeader{tick, static_cast<std::uint16_t>(events.size())});
+                const std::vector<std::uint8_t> body = rnp::serializeEvents(events);
+                payload.insert(payload.end(), body.begin(), body.end());
+                payloads.push_back(std::move(payload));
+            }
+        }
+        return payloads;
+    }
+
+    struct Result
+    {
+            double ratio;
+            double compressNsPerByte;
+            double decompressNsPerByte;
+    };
+
+    Result measure(const rnp::LzCodec &codec, const Payloads &payloads, const bool useDictionary)
+    {
+        constexpr int ROUNDS = 20;
+        std::array<std::uint8_t, rnp::MAX_PAYLOAD> compressed{};
+        std::array<std::uint8_t, rnp::MAX_PAYLOAD> restored{};
+        std::vector<std::size_t> sizes(payloads.size());
+        std::size_t rawBytes = 0;
+        std::size_t sentBytes = 0;
+
+        const auto start = std::chrono::steady_clock::now();
+        for (int round = 0; round < ROUNDS; ++round)
+        {
+            for (std::size_t i = 0; i < payloads.size(); ++i)
+            {
+                const std::optional<std::size_t> size =
+                    codec.compress(payloads[i], std::span(compressed).first(payloads[i].size() - 1), useDictionary);
+                sizes[i] = size.value_or(0);
+            }
+        }
+        const auto compressedAt = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < payloads.size(); ++i)
+        {
+            rawBytes += payloads[i].size();
+            // Payloads that do not shrink go out uncompressed
+            sentBytes += sizes[i] != 0 ? sizes[i] : payloads[i].size();
+        }
+
+        std::size_t decodedBytes = 0;
+        std::chrono::nanoseconds decodeTime{0};
+        for (std::size_t i = 0; i < payloads.size(); ++i)
+        {
+            if (sizes[i] == 0)
+            {
+                continue;
+            }
+            const std::size_t size = *codec.compress(payloads[i], compressed, useDictionary);
+            const auto before = std::chrono::steady_clock::now();
+            std::optional<std::size_t> restoredSize;
+            for (int round = 0; round < ROUNDS; ++round)
+            {
+                restoredSize = codec.decompress(std::span(compressed).first(size), restored, useDictionary);
+            }
+            decodeTime += std::chrono::steady_clock::now() - before;
+            decodedBytes += ROUNDS * payloads[i].size();
+            EXPECT_TRUE(restoredSize && std::ranges::equal(std::span(restored).first(*restoredSize), payloads[i]));
+        }
+
+        const double encodeTime = std::chrono::duration<double, std::nano>(compressedAt - start).count();
+        const double decodeNs = std::chrono::duration<double, std::nano>(decodeTime).count();
+        return {.ratio = static_cast<double>(sentBytes) / static_cast<double>(rawBytes),
+                .compressNsPerByte = encodeTime / static_cast<double>(ROUNDS * rawBytes),
+                .decompressNsPerByte = decodedBytes == 0 ? 0. : decodeNs / static_cast<double>(decodedBytes)};
+    }
+
+    void report(const char *name, const Payloads &traffic)
+    {
+        // Train on the first half of the match, measure on the second
+        const auto middle = traffic.begin() + static_cast<std::ptrdiff_t>(traffic.size() / 2);
+        const Payloads training(traffic.begin(), middle);
+        const Payloads evaluation(middle, traffic.end());
+        const rnp::LzCodec plain;
+        const rnp::LzCodec trained(rnp::trainDictionary(training));
+
+        const Result lz = measure(plain, evaluation, false);
+        const Result dictionary = measure(trained, evaluation, true);
+        std::cout << "[compression] " << name << ": " << evaluation.size() << " payloads, lz ratio " << lz.ratio
+                  << " (" << lz.compressNsPerByte << " ns/B in, " << lz.decompressNsPerByte << " ns/B out), dictionary("
+                  << trained.dictionary().size() << " B) ratio " << dictionary.ratio << " ("
+                  << dictionary.compressNsPerByte << " ns/B in, " << dictionary.decompressNsPerByte << " ns/B out)\n";
+        // The dictionary is only worth shipping if it saves at least a tenth of what plain LZ sends
+        EXPECT_LT(dictionary.ratio, lz.ratio * 0.9);
+    }
+
+} // namespace
+
+TEST(compressionBenchmark, plainRecords) { report("plain records", recordTraffic(false, 600)); }
+
+TEST(compressionBenchmark, quantizedRecords) { report("quantized records", recordTraffic(true, 600)); }
+
+TEST(compressionBenchmark, rejectsMalformedInput)
+{
+    const rnp::LzCodec codec;
+    std::array<std::uint8_t, 64> output{};
+    const std::array<std::uint8_t, 4> backReferenceBeforeStart = {0x10, 'a', 0x00, 0x05};
+    const std::array<std::uint8_t, 2> truncatedLiterals = {0x50, 'a'};
+
+    EXPECT_FALSE(codec.decompress(backReferenceBeforeStart, output, false));
+    EXPECT_FALSE(codec.decompress(truncatedLiterals, output, false));
+}
@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+
+#include "AsioServer/Congestion.hpp"
+
+namespace
+{
+
+    using namespace std::chrono_literals;
+    using Clock = srv::CongestionControl::Clock;
+
+    constexpr std::chrono::milliseconds STEP{10}; // One snapshot every 10 ms, 25 per congestion period
+    constexpr std::size_t BYTES = 2000;           // 200 KB/s when every snapshot arrives
+
+    ///
+    /// @brief Snapshots sent over a simulated link and acknowledged a round trip later, unless lost
+    ///
+    class Link
+    {
+        public:
+            ///
+            /// @brief Send a snapshot every STEP for a while
+            /// @param lossEvery every lossEvery-th snapshot is never acknowledged, 0 for none
+            ///
+            void run(const Clock::duration duration, const std::chrono::milliseconds roundTrip,
+                     const std::uint32_t lossEvery = 0)
+            {
+                for (const Clock::time_point end = now + duration; now < end; now += STEP)
+                {
+                    while (!m_acks.empty() && m_acks.front().at <= now)
+                    {
+                        congestion.onAcked(m_acks.front().serverTick, m_acks.front().at);
+                        m_acks.pop_front();
+                    }
+                    ++m_tick;
+                    congestion.onSent(m_tick, BYTES, now);
+                    if (lossEvery == 0 || m_tick % lossEvery != 0)
+                    {
+                        m_acks.push_back({.serverTick = m_tick, .at = now + roundTrip});
+                    }
+                }
+            }
+
+            srv::CongestionControl congestion;
+            Clock::time_point now = Clock::time_point{} + 1h;
+
+        private:
+            struct Ack
+            {
+                    std::uint32_t serverTick;
+                    Clock::time_point at;
+            };
+
+            std::uint32_t m_tick = 0;
+            std::deque<Ack> m_acks;
+    }; // class Link
+
+} // namespace
+
+TEST(congestion, slowStartUntilUnused)
+{
+    Link link;
+    EXPECT_EQ(link.congestion.rate(), srv::INITIAL_SEND_RATE);
+    // Doubled every period while the client uses at least half of it: 32, 64, 128, 256, then 512 KB/s
+    link.run(srv::CongestionControl::CONGESTION_PERIOD + STEP, 20ms);
+    EXPECT_EQ(link.congestion.rate(), 2 * srv::INITIAL_SEND_RATE);
+    link.run(2s, 20ms);
+    EXPECT_EQ(link.congestion.rate(), 16 * srv::INITIAL_SEND_RATE);
+    ASSERT_TRUE(link.congestion.roundTripTime().has_value());
+    EXPECT_EQ(*link.congestion.roundTripTime(), 20ms);
+}
+
+TEST(congestion, lossCutsThenAdditiveIncrease)
+{
+    Link link;
+    link.run(2s, 20ms);
+    const std::size_t before = link.congestion.rate();
+
+    // One snapshot in five lost: cut to 70% of what was delivered, about 160 KB/s, or less every lossy period
+    link.run(1s, 20ms, 5);
+    EXPECT_LE(link.congestion.rate(), BYTES * 100 * 7 / 10);
+    EXPECT_GE(link.congestion.rate(), srv::MIN_SEND_RATE);
+    EXPECT_LT(link.congestion.rate(), before);
+
+    // No more doubling after the first congestion, RATE_INCREASE per period
+    link.run(1s, 20ms);
+    const std::size_t settled = link.congestion.rate();
+    link.run(4 * srv::CongestionControl::CONGESTION_PERIOD, 20ms);
+    EXPECT_EQ(link.congestion.rate(), settled + 4 * srv::CongestionControl::RATE_INCREASE);
+}
+
+TEST(congestion, queueingDelayCuts)
+{
+    Link link;
+    link.run(2s, 20ms);
+    const std::size_t before = link.congestion.rate();
+    // Every snapshot still arrives, but the round trip grew more than QUEUE_DELAY_TARGET over its minimum
+    link.run(3 * srv::CongestionControl::CONGESTION_PERIOD, 20ms + srv::CongestionControl::QUEUE_DELAY_TARGET + 10ms);
+    EXPECT_LE(link.congestion.rate(), before * 7 / 10);
+    // A round trip within the target is no congestion
+    Link steady;
+    steady.run(2s, 20ms);
+    steady.run(1s, 20ms + srv::CongestionControl::QUEUE_DELAY_TARGET - 10ms);
+    EXPECT_EQ(steady.congestion.rate(), before);
+}
+
+TEST(congestion, snapshotIntervalFromRate)
+{
+    Link link;
+    // 32 KB/s: 546 bytes per snapshot at 60 Hz, enough for one every tick
+    EXPECT_EQ(link.congestion.interval(60), 1U);
+    EXPECT_EQ(link.congestion.snapshotBudget(60), srv::INITIAL_SEND_RATE / 60);
+    EXPECT_EQ(link.congestion.interval(0), 1U);
+    EXPECT_TRUE(link.congestion.shouldSend(1, 60));
+
+    // Nothing acknowledged: down to the minimum rate once the snapshots are declared lost, which takes two default
+    // round trips without a measured one
+    link.run(1s, 20ms, 1);
+    ASSERT_EQ(link.congestion.rate(), srv::MIN_SEND_RATE);
+    // 68 bytes per tick at 60 Hz, never MIN_SNAPSHOT_BYTES: the longest interval
+    EXPECT_EQ(link.congestion.interval(60), srv::MAX_SNAPSHOT_INTERVAL);
+    EXPECT_EQ(link.congestion.snapshotBudget(60), srv::MIN_SEND_RATE * srv::MAX_SNAPSHOT_INTERVAL / 60);
+    // 409 bytes per tick at 10 Hz, 819 every two
+    EXPECT_EQ(link.congestion.interval(10), 2U);
+
+    link.congestion.onSent(100, 0, link.now);
+    EXPECT_FALSE(link.congestion.shouldSend(100 + srv::MAX_SNAPSHOT_INTERVAL - 1, 60));
+    EXPECT_TRUE(link.congestion.shouldSend(100 + srv::MAX_SNAPSHOT_INTERVAL, 60));
+}
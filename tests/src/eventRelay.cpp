@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "AsioServer/EventRelay.hpp"
+#include "Interfaces/Protocol/Buffer.hpp"
+#include "Interfaces/Protocol/PacketView.hpp"
+#include "Interfaces/Protocol/Protocol.hpp"
+
+namespace
+{
+
+    constexpr std::uint16_t ALICE = 1;
+    constexpr std::uint16_t BOB = 2;
+    constexpr std::uint16_t CAROL = 3;
+
+    struct Relayed
+    {
+            rnp::EventType type;
+            std::uint32_t entityId;
+            std::vector<std::uint8_t> data;
+
+            bool operator==(const Relayed &) const = default;
+    };
+
+    std::vector<Relayed> relayedTo(const srv::EventRelay &relay, const std::uint16_t destination)
+    {
+        std::vector<Relayed> relayed;
+        relay.forEachFor(destination, [&relayed](const rnp::EventView &event)
+                         { relayed.push_back({event.type, event.entityId, {event.data.begin(), event.data.end()}}); });
+        return relayed;
+    }
+
+    rnp::EventView event(const rnp::EventType type, const std::uint32_t entityId, const std::vector<std::uint8_t> &data)
+    {
+        return {.type = type, .entityId = entityId, .data = data};
+    }
+
+    const std::vector<std::uint8_t> FIRST{1};
+    const std::vector<std::uint8_t> SECOND{2, 2};
+
+} // namespace
+
+TEST(eventRelay, lastInputOfEachEntityKept)
+{
+    srv::EventRelay relay;
+    EXPECT_TRUE(relay.empty());
+    relay.push(ALICE, event(rnp::EventType::INPUT, 5, FIRST));
+    relay.push(ALICE, event(rnp::EventType::INPUT, 6, FIRST));
+    relay.push(BOB, event(rnp::EventType::INPUT, 5, FIRST)); // Another sender: superseded by nothing of Alice
+    relay.push(ALICE, event(rnp::EventType::INPUT, 5, SECOND));
+    EXPECT_FALSE(relay.empty());
+
+    const std::vector<Relayed> toCarol = relayedTo(relay, CAROL);
+    ASSERT_EQ(toCarol.size(), 3U);
+    EXPECT_EQ(toCarol[0], (Relayed{rnp::EventType::INPUT, 6, FIRST}));
+    EXPECT_EQ(toCarol[1], (Relayed{rnp::EventType::INPUT, 5, FIRST}));
+    EXPECT_EQ(toCarol[2], (Relayed{rnp::EventType::INPUT, 5, SECOND}));
+
+    // Echoed to their sender as acknowledgements, so each sees its own and the other's
+    EXPECT_EQ(relayedTo(relay, ALICE), toCarol);
+    EXPECT_EQ(relayedTo(relay, BOB), toCarol);
+}
+
+TEST(eventRelay, otherEventsInOrderNotEchoed)
+{
+    srv::EventRelay relay;
+    relay.push(ALICE, event(rnp::EventType::SCORE, 1, FIRST));
+    relay.push(BOB, event(rnp::EventType::DAMAGE, 2, SECOND));
+    relay.push(ALICE, event(rnp::EventType::SCORE, 1, SECOND)); // Not deduplicated
+    relay.push(srv::EventRelay::EVERYONE, event(rnp::EventType::SPAWN, 3, {})); // Legacy input path
+
+    EXPECT_EQ(relayedTo(relay, ALICE), (std::vector<Relayed>{{rnp::EventType::DAMAGE, 2, SECOND},
+                                                             {rnp::EventType::SPAWN, 3, {}}}));
+    EXPECT_EQ(relayedTo(relay, BOB), (std::vector<Relayed>{{rnp::EventType::SCORE, 1, FIRST},
+                                                           {rnp::EventType::SCORE, 1, SECOND},
+                                                           {rnp::EventType::SPAWN, 3, {}}}));
+    EXPECT_EQ(relayedTo(relay, CAROL).size(), 4U);
+
+    relay.clear();
+    EXPECT_TRUE(relay.empty());
+    EXPECT_TRUE(relayedTo(relay, CAROL).empty());
+}
+
+TEST(eventRelay, simulationEventsToOneOrAll)
+{
+    srv::EventRelay relay;
+    relay.pushTo(BOB, event(rnp::EventType::CONTROL, 7, {}));
+    relay.pushTo(srv::EventRelay::EVERYONE, event(rnp::EventType::DESPAWN, 8, FIRST));
+
+    EXPECT_EQ(relayedTo(relay, BOB), (std::vector<Relayed>{{rnp::EventType::CONTROL, 7, {}},
+                                                           {rnp::EventType::DESPAWN, 8, FIRST}}));
+    EXPECT_EQ(relayedTo(relay, ALICE), (std::vector<Relayed>{{rnp::EventType::DESPAWN, 8, FIRST}}));
+}
+
+TEST(eventRelay, pushedFromPayload)
+{
+    std::array<std::uint8_t, 64> payload{};
+    rnp::BufferWriter writer(payload);
+    rnp::writeEvent(writer, rnp::EventType::SCORE, 1, rnp::ScoreEventData{.points = 10});
+    rnp::writeEvent(writer, rnp::EventType::INPUT, 4, std::span<const std::uint8_t>(FIRST));
+    rnp::writeEvent(writer, rnp::EventType::INPUT, 4, std::span<const std::uint8_t>(SECOND));
+    const rnp::EventRange events(std::span<const std::uint8_t>(payload).first(writer.size()));
+    ASSERT_TRUE(events.isValid());
+
+    srv::EventRelay relay;
+    relay.push(ALICE, events);
+    const std::vector<Relayed> toBob = relayedTo(relay, BOB);
+    ASSERT_EQ(toBob.size(), 2U);
+    EXPECT_EQ(toBob[0].type, rnp::EventType::SCORE);
+    EXPECT_EQ(toBob[0].data.size(), rnp::WIRE_SIZE<rnp::ScoreEventData>);
+    EXPECT_EQ(toBob[1], (Relayed{rnp::EventType::INPUT, 4, SECOND}));
+}
@@ -0,0 +1,205 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "Interfaces/Protocol/Fragment.hpp"
+
+namespace
+{
+
+    using Clock = std::chrono::steady_clock;
+    using Reassembler = rnp::FragmentReassembler<rnp::MAX_FRAGMENTS, 2>;
+    using Messages = std::vector<std::vector<std::uint8_t>>;
+
+    struct Fragment
+    {
+            rnp::FragmentHeader header;
+            std::vector<std::uint8_t> bytes;
+    };
+
+    std::vector<std::uint8_t> message(const std::size_t size)
+    {
+        std::vector<std::uint8_t> bytes(size);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            bytes[i] = static_cast<std::uint8_t>(i * 7 + i / 256);
+        }
+        return bytes;
+    }
+
+    std::vector<Fragment> split(const std::span<const std::uint8_t> bytes, const std::uint16_t fragId,
+                                const std::size_t fragmentSize = rnp::MAX_FRAGMENT_PAYLOAD)
+    {
+        std::vector<Fragment> fragments;
+        EXPECT_TRUE(rnp::forEachFragment(bytes, fragmentSize, fragId,
+                                         [&fragments](const rnp::FragmentHeader &header,
+                                                      const std::span<const std::uint8_t> fragment)
+                                         { fragments.push_back({header, {fragment.begin(), fragment.end()}}); }));
+        return fragments;
+    }
+
+    ///
+    /// @brief Push fragments in the given order
+    /// @return the messages completed, in the order they completed
+    ///
+    Messages pushAll(Reassembler &reassembler, const std::vector<Fragment> &fragments, const Clock::time_point now)
+    {
+        Messages completed;
+        for (const Fragment &fragment : fragments)
+        {
+            if (const auto whole = reassembler.push(fragment.header, fragment.bytes, now))
+            {
+                completed.emplace_back(whole->begin(), whole->end());
+            }
+        }
+        return completed;
+    }
+
+} // namespace
+
+TEST(fragment, splitLayout)
+{
+    const std::vector<std::uint8_t> bytes = message(2 * rnp::MAX_FRAGMENT_PAYLOAD + 10);
+    const std::vector<Fragment> fragments = split(bytes, 9);
+    ASSERT_EQ(fragments.size(), 3U);
+    for (std::size_t i = 0; i < fragments.size(); ++i)
+    {
+        EXPECT_EQ(fragments[i].header.fragId, 9);
+        EXPECT_EQ(fragments[i].header.fragIndex, i);
+        EXPECT_EQ(fragments[i].header.fragCount, 3);
+    }
+    EXPECT_EQ(fragments[0].bytes.size(), rnp::MAX_FRAGMENT_PAYLOAD);
+    EXPECT_EQ(fragments[2].bytes.size(), 10U);
+}
+
+TEST(fragment, splitRejectsOverflow)
+{
+    std::size_t emitted = 0;
+    const auto count = [&emitted](const rnp::FragmentHeader &, std::span<const std::uint8_t>) { ++emitted; };
+
+    // One byte too many for MAX_FRAGMENTS fragments: nothing is emitted
+    const std::vector<std::uint8_t> tooLarge = message(rnp::MAX_FRAGMENTS * 10 + 1);
+    EXPECT_FALSE(rnp::forEachFragment(tooLarge, 10, 1, count));
+    EXPECT_FALSE(rnp::forEachFragment({}, 10, 1, count));
+    EXPECT_FALSE(rnp::forEachFragment(tooLarge, 0, 1, count));
+    EXPECT_EQ(emitted, 0U);
+
+    const std::vector<std::uint8_t> largest = message(rnp::MAX_FRAGMENTS * 10);
+    EXPECT_TRUE(rnp::forEachFragment(largest, 10, 1, count));
+    EXPECT_EQ(emitted, rnp::MAX_FRAGMENTS);
+}
+
+TEST(fragment, reassembleInAnyOrder)
+{
+    const Clock::time_point now = Clock::now();
+    const std::vector<std::uint8_t> bytes = message(5 * rnp::MAX_FRAGMENT_PAYLOAD - 3);
+    std::vector<Fragment> fragments = split(bytes, 1);
+
+    Reassembler reassembler;
+    EXPECT_EQ(pushAll(reassembler, fragments, now), Messages{bytes});
+
+    std::ranges::reverse(fragments);
+    for (Fragment &fragment : fragments)
+    {
+        fragment.header.fragId = 2;
+    }
+    EXPECT_EQ(pushAll(reassembler, fragments, now), Messages{bytes});
+
+    // Middle first, the short last fragment in between
+    const std::vector<std::size_t> order = {2, 4, 0, 3, 1};
+    std::vector<Fragment> shuffled;
+    for (const std::size_t index : order)
+    {
+        shuffled.push_back(split(bytes, 3)[index]);
+    }
+    EXPECT_EQ(pushAll(reassembler, shuffled, now), Messages{bytes});
+}
+
+TEST(fragment, reassembleMostFragments)
+{
+    const std::vector<std::uint8_t> bytes = message(rnp::MAX_MESSAGE_SIZE);
+    const std::vector<Fragment> fragments = split(bytes, 4);
+    ASSERT_EQ(fragments.size(), rnp::MAX_FRAGMENTS);
+    Reassembler reassembler;
+    EXPECT_EQ(pushAll(reassembler, fragments, Clock::now()), Messages{bytes});
+}
+
+TEST(fragment, duplicatesIgnored)
+{
+    const Clock::time_point now = Clock::now();
+    const std::vector<std::uint8_t> bytes = message(3 * rnp::MAX_FRAGMENT_PAYLOAD);
+    const std::vector<Fragment> fragments = split(bytes, 5);
+
+    // The first fragment twice before the others, then the whole message again once complete
+    std::vector<Fragment> received = {fragments[0], fragments[0], fragments[1], fragments[1], fragments[2]};
+    received.insert(received.end(), fragments.begin(), fragments.end());
+    Reassembler reassembler;
+    EXPECT_EQ(pushAll(reassembler, received, now), Messages{bytes});
+}
+
+TEST(fragment, missingFragmentExpires)
+{
+    const Clock::time_point now = Clock::now();
+    const std::vector<std::uint8_t> bytes = message(3 * rnp::MAX_FRAGMENT_PAYLOAD);
+    const std::vector<Fragment> fragments = split(bytes, 6);
+    Reassembler reassembler(std::chrono::milliseconds(100));
+
+    EXPECT_TRUE(pushAll(reassembler, {fragments[0], fragments[2]}, now).empty());
+    // Past the timeout the first fragments are gone, the missing one alone completes nothing
+    EXPECT_TRUE(pushAll(reassembler, {fragments[1]}, now + std::chrono::milliseconds(101)).empty());
+    // Resent in full it does
+    EXPECT_EQ(pushAll(reassembler, fragments, now + std::chrono::milliseconds(150)), Messages{bytes});
+}
+
+TEST(fragment, invalidHeadersRejected)
+{
+    const Clock::time_point now = Clock::now();
+    Reassembler reassembler;
+    const std::vector<std::uint8_t> bytes(10, 1);
+    const std::vector<std::uint8_t> oversized(rnp::MAX_FRAGMENT_PAYLOAD + 1, 1);
+
+    EXPECT_FALSE(reassembler.push({.fragId = 1, .fragIndex = 0, .fragCount = 0}, bytes, now));
+    EXPECT_FALSE(reassembler.push({.fragId = 1, .fragIndex = 1, .fragCount = 1}, bytes, now));
+    EXPECT_FALSE(reassembler.push({.fragId = 1, .fragIndex = 0, .fragCount = rnp::MAX_FRAGMENTS + 1}, bytes, now));
+    EXPECT_FALSE(reassembler.push({.fragId = 1, .fragIndex = 0, .fragCount = 1}, oversized, now));
+    // None of them took a slot, a valid single fragment completes at once
+    const auto whole = reassembler.push({.fragId = 1, .fragIndex = 0, .fragCount = 1}, bytes, now);
+    ASSERT_TRUE(whole);
+    EXPECT_TRUE(std::ranges::equal(*whole, bytes));
+}
+
+TEST(fragment, conflictingLayoutDropped)
+{
+    const Clock::time_point now = Clock::now();
+    Reassembler reassembler;
+    const std::vector<std::uint8_t> bytes(10, 1);
+
+    EXPECT_FALSE(reassembler.push({.fragId = 7, .fragIndex = 0, .fragCount = 2}, bytes, now));
+    EXPECT_FALSE(reassembler.push({.fragId = 7, .fragIndex = 1, .fragCount = 3}, bytes, now));
+    // The first message was dropped with the conflicting fragment, its last fragment starts over
+    EXPECT_FALSE(reassembler.push({.fragId = 7, .fragIndex = 1, .fragCount = 2}, bytes, now));
+    EXPECT_TRUE(reassembler.push({.fragId = 7, .fragIndex = 0, .fragCount = 2}, bytes, now));
+}
+
+TEST(fragment, oldestSlotRecycled)
+{
+    const Clock::time_point now = Clock::now();
+    const std::vector<std::uint8_t> bytes = message(2 * rnp::MAX_FRAGMENT_PAYLOAD);
+    const std::vector<Fragment> first = split(bytes, 10);
+    const std::vector<Fragment> second = split(bytes, 11);
+    const std::vector<Fragment> third = split(bytes, 12);
+    Reassembler reassembler;
+
+    EXPECT_TRUE(pushAll(reassembler, {first[0]}, now).empty());
+    EXPECT_TRUE(pushAll(reassembler, {second[0]}, now + std::chrono::milliseconds(1)).empty());
+    // Both slots are busy, the third message takes the first one's
+    EXPECT_TRUE(pushAll(reassembler, {third[0]}, now + std::chrono::milliseconds(2)).empty());
+    EXPECT_TRUE(pushAll(reassembler, {first[1]}, now + std::chrono::milliseconds(3)).empty());
+    EXPECT_EQ(pushAll(reassembler, {third[1]}, now + std::chrono::milliseconds(3)), Messages{bytes});
+}
@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Interfaces/Protocol/Buffer.hpp"
+#include "Interfaces/Protocol/Input.hpp"
+#include "Interfaces/Protocol/Protocol.hpp"
+
+namespace
+{
+
+    rnp::InputEventData input(const std::uint8_t direction, const std::uint8_t shooting,
+                              const std::uint32_t clientTimeMs)
+    {
+        return {.buttons = 0, .direction = direction, .shooting = shooting, .clientTimeMs = clientTimeMs};
+    }
+
+    std::vector<std::uint8_t> written(const rnp::InputHistory &history)
+    {
+        std::array<std::uint8_t, rnp::MAX_INPUT_FRAMES_SIZE> data{};
+        rnp::BufferWriter writer(data);
+        history.write(writer);
+        EXPECT_TRUE(writer.ok());
+        return {data.begin(), data.begin() + static_cast<std::ptrdiff_t>(writer.size())};
+    }
+
+    std::vector<rnp::InputFrame> framesOf(const std::span<const std::uint8_t> data)
+    {
+        std::vector<rnp::InputFrame> frames;
+        EXPECT_TRUE(rnp::InputHistory::forEachFrame(data, [&frames](const rnp::InputFrame &frame)
+                                                    { frames.push_back(frame); }));
+        return frames;
+    }
+
+    void expectSameInput(const rnp::InputEventData &actual, const rnp::InputEventData &expected)
+    {
+        EXPECT_EQ(actual.buttons, expected.buttons);
+        EXPECT_EQ(actual.direction, expected.direction);
+        EXPECT_EQ(actual.shooting, expected.shooting);
+        EXPECT_EQ(actual.clientTimeMs, expected.clientTimeMs);
+    }
+
+} // namespace
+
+TEST(inputFrames, roundTripOldestFirst)
+{
+    rnp::InputHistory history;
+    EXPECT_TRUE(history.empty());
+    const std::array<rnp::InputEventData, 3> inputs{input(1, 0, 1000), input(1, 1, 1016), input(4, 0, 1040)};
+    for (const rnp::InputEventData &pushed : inputs)
+    {
+        history.push(pushed);
+    }
+    EXPECT_FALSE(history.empty());
+
+    const std::vector<rnp::InputFrame> frames = framesOf(written(history));
+    ASSERT_EQ(frames.size(), inputs.size());
+    for (std::size_t i = 0; i < inputs.size(); ++i)
+    {
+        EXPECT_EQ(frames[i].sequence, i + 1);
+        expectSameInput(frames[i].input, inputs[i]);
+    }
+}
+
+TEST(inputFrames, redundantFramesCheapWhenHeld)
+{
+    rnp::InputHistory history;
+    history.push(input(2, 0, 100));
+    const std::size_t single = written(history).size();
+    EXPECT_EQ(single, 3 + rnp::WIRE_SIZE<rnp::InputEventData>);
+    for (std::uint32_t i = 1; i < rnp::MAX_INPUT_FRAMES + 4; ++i)
+    {
+        history.push(input(2, 0, 100 + i * 16));
+    }
+    // The same keys held: changes and time delta only, and never more than MAX_INPUT_FRAMES frames
+    const std::vector<std::uint8_t> held = written(history);
+    EXPECT_EQ(held.size(), single + (rnp::MAX_INPUT_FRAMES - 1) * 3);
+    const std::vector<rnp::InputFrame> frames = framesOf(held);
+    ASSERT_EQ(frames.size(), rnp::MAX_INPUT_FRAMES);
+    EXPECT_EQ(frames.back().sequence, rnp::MAX_INPUT_FRAMES + 4);
+    EXPECT_EQ(frames.front().input.clientTimeMs, 100 + 4 * 16U);
+
+    // Every field of every frame changing stays within MAX_INPUT_FRAMES_SIZE
+    for (std::uint32_t i = 0; i < rnp::MAX_INPUT_FRAMES; ++i)
+    {
+        rnp::InputEventData changing = input(static_cast<std::uint8_t>(i), static_cast<std::uint8_t>(i % 2), i);
+        changing.buttons = static_cast<std::uint16_t>(i);
+        history.push(changing);
+    }
+    EXPECT_EQ(written(history).size(), rnp::MAX_INPUT_FRAMES_SIZE);
+    EXPECT_EQ(framesOf(written(history)).front().input.buttons, 0U);
+}
+
+TEST(inputFrames, sequenceWraps)
+{
+    rnp::InputHistory history;
+    for (std::uint32_t i = 0; i < 0xFFFF; ++i)
+    {
+        history.push(input(0, 0, i));
+    }
+    EXPECT_EQ(history.push(input(0, 0, 0xFFFF)), 0U);
+    EXPECT_EQ(history.push(input(0, 0, 0x10000)), 1U);
+    const std::vector<rnp::InputFrame> frames = framesOf(written(history));
+    ASSERT_EQ(frames.size(), rnp::MAX_INPUT_FRAMES);
+    EXPECT_EQ(frames[rnp::MAX_INPUT_FRAMES - 3].sequence, 0xFFFFU);
+    EXPECT_EQ(frames.back().sequence, 1U);
+    EXPECT_EQ(frames.back().input.clientTimeMs, 0x10000U);
+
+    EXPECT_TRUE(rnp::isNewerInput(0, 0xFFFF));
+    EXPECT_TRUE(rnp::isNewerInput(1, 0xFFFF));
+    EXPECT_FALSE(rnp::isNewerInput(0xFFFF, 0));
+    EXPECT_FALSE(rnp::isNewerInput(5, 5));
+}
+
+TEST(inputFrames, malformedRejected)
+{
+    rnp::InputHistory history;
+    history.push(input(1, 0, 10));
+    history.push(input(2, 1, 20));
+    std::vector<std::uint8_t> data = written(history);
+    const auto reject = [](const std::span<const std::uint8_t> bytes)
+    {
+        std::size_t visited = 0;
+        EXPECT_FALSE(rnp::InputHistory::forEachFrame(bytes, [&visited](const rnp::InputFrame &) { ++visited; }));
+        EXPECT_EQ(visited, 0U);
+    };
+
+    reject(std::span<const std::uint8_t>(data).first(data.size() - 1)); // Last older field cut
+    reject(std::span<const std::uint8_t>(data).first(2));
+    data[2] = 0; // No frame
+    reject(data);
+    data[2] = rnp::MAX_INPUT_FRAMES + 1;
+    reject(data);
+}
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <span>
+#include <vector>
+
+#include "AsioServer/Interest.hpp"
+#include "Interfaces/Protocol/Protocol.hpp"
+
+namespace
+{
+
+    constexpr srv::Viewport VIEW{.x = 0.F, .y = 0.F, .width = 1000.F, .height = 500.F};
+
+    rnp::EntityState enemy(const std::uint32_t id, const float x, const float y)
+    {
+        return {.id = id,
+                .type = static_cast<std::uint16_t>(rnp::EntityType::ENEMY),
+                .x = x,
+                .y = y,
+                .vx = 0.F,
+                .vy = 0.F,
+                .stateFlags = 0};
+    }
+
+    ///
+    /// @brief Relevant ids of a snapshot, the grid built for it
+    ///
+    std::vector<std::uint32_t> relevant(srv::ClientInterest &interest, const std::vector<rnp::EntityState> &entities,
+                                        const srv::Viewport &area = VIEW)
+    {
+        srv::InterestGrid grid;
+        grid.build(entities);
+        const std::span<const std::uint32_t> ids = interest.update(grid, entities, area);
+        return {ids.begin(), ids.end()};
+    }
+
+} // namespace
+
+TEST(interest, enterWithinMarginLeaveBeyondHysteresis)
+{
+    srv::ClientInterest interest;
+    const float edge = VIEW.x + VIEW.width;
+    const std::vector<std::uint32_t> none;
+    const std::vector<std::uint32_t> one{1};
+    // A second entity near the origin keeps the grid larger than the moving one
+    const auto at = [](const float x) { return std::vector{enemy(1, x, 250.F), enemy(2, 0.F, 0.F)}; };
+    const auto moving = [&](const float x)
+    {
+        std::vector<std::uint32_t> ids = relevant(interest, at(x));
+        std::erase(ids, 2U);
+        return ids;
+    };
+
+    EXPECT_EQ(moving(edge + srv::INTEREST_MARGIN + 1.F), none);
+    EXPECT_EQ(moving(edge + srv::INTEREST_MARGIN), one);
+    EXPECT_EQ(moving(edge + srv::INTEREST_MARGIN + srv::INTEREST_HYSTERESIS - 1.F), one); // Stays while in the band
+    EXPECT_EQ(moving(edge + srv::INTEREST_MARGIN + srv::INTEREST_HYSTERESIS + 1.F), none);
+    EXPECT_EQ(moving(edge + srv::INTEREST_MARGIN + srv::INTEREST_HYSTERESIS - 1.F), none); // Not back in the band
+    EXPECT_EQ(moving(VIEW.x - srv::INTEREST_MARGIN), one);                                 // Same on the other side
+    EXPECT_EQ(moving(VIEW.x - srv::INTEREST_MARGIN - srv::INTEREST_HYSTERESIS), one);
+}
+
+TEST(interest, alwaysRelevantAnywhere)
+{
+    srv::ClientInterest interest;
+    std::vector<rnp::EntityState> entities{enemy(1, 1e6F, 1e6F), enemy(2, 1e6F, 1e6F), enemy(3, 10.F, 10.F),
+                                           enemy(4, std::numeric_limits<float>::quiet_NaN(), 10.F)};
+    entities[0].type = static_cast<std::uint16_t>(rnp::EntityType::PLAYER);
+    entities[1].stateFlags = static_cast<std::uint8_t>(rnp::EntityStateFlags::ALWAYS_RELEVANT);
+    EXPECT_TRUE(srv::isAlwaysRelevant(entities[0]));
+    EXPECT_TRUE(srv::isAlwaysRelevant(entities[1]));
+    EXPECT_FALSE(srv::isAlwaysRelevant(entities[2]));
+    EXPECT_EQ(relevant(interest, entities), (std::vector<std::uint32_t>{1, 2, 3}));
+}
+
+TEST(interest, gridMatchesExhaustiveTest)
+{
+    // Spread over a field far larger than MAX_CELLS_PER_AXIS cells of CELL_SIZE, so cells grow
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> coordinate(-50'000.F, 50'000.F);
+    std::vector<rnp::EntityState> entities;
+    for (std::uint32_t id = 1; id <= 2000; ++id)
+    {
+        entities.push_back(enemy(id, coordinate(random), coordinate(random)));
+    }
+    // And some around the viewport
+    std::uniform_real_distribution<float> near(-300.F, 1300.F);
+    for (std::uint32_t id = 2001; id <= 2500; ++id)
+    {
+        entities.push_back(enemy(id, near(random), near(random)));
+    }
+
+    const srv::Viewport inner = srv::expand(VIEW, srv::INTEREST_MARGIN);
+    std::vector<std::uint32_t> expected;
+    for (const rnp::EntityState &entity : entities)
+    {
+        if (srv::contains(inner, entity))
+        {
+            expected.push_back(entity.id);
+        }
+    }
+    ASSERT_FALSE(expected.empty());
+    srv::ClientInterest interest;
+    EXPECT_EQ(relevant(interest, entities), expected);
+}
+
+TEST(interest, selectedBySortedIds)
+{
+    const std::vector<rnp::EntityState> entities{enemy(2, 0.F, 0.F), enemy(4, 1.F, 0.F), enemy(7, 2.F, 0.F),
+                                                 enemy(9, 3.F, 0.F)};
+    const std::vector<std::uint32_t> ids{1, 4, 5, 9, 12};
+    std::vector<rnp::EntityState> selected{enemy(100, 0.F, 0.F)};
+    srv::selectEntities(entities, ids, selected);
+    ASSERT_EQ(selected.size(), 2U);
+    EXPECT_EQ(selected[0].id, 4U);
+    EXPECT_FLOAT_EQ(selected[0].x, 1.F);
+    EXPECT_EQ(selected[1].id, 9U);
+}
@@ -0,0 +1,207 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "Engine/Interpolation.hpp"
+
+namespace
+{
+
+    using namespace std::chrono_literals;
+    using Clock = eng::SnapshotInterpolator::Clock;
+
+    constexpr std::uint16_t TICK_RATE = 10; // A snapshot every 100 ms
+
+    ///
+    /// @brief Snapshot of one entity 1 at x = 100 per tick, moving at that speed, with entity 2 on even ticks
+    ///
+    rnp::PacketWorldState snapshotOf(const std::uint32_t serverTick)
+    {
+        rnp::PacketWorldState snapshot{};
+        snapshot.serverTick = serverTick;
+        snapshot.entities.push_back({.id = 1,
+                                     .type = 0,
+                                     .x = 100.F * static_cast<float>(serverTick),
+                                     .y = 5.F,
+                                     .vx = 1000.F,
+                                     .vy = 0.F,
+                                     .stateFlags = 0});
+        if (serverTick % 2 == 0)
+        {
+            snapshot.entities.push_back(
+                {.id = 2, .type = 0, .x = 0.F, .y = 0.F, .vx = 0.F, .vy = 0.F, .stateFlags = 0});
+        }
+        snapshot.entityCount = static_cast<std::uint16_t>(snapshot.entities.size());
+        return snapshot;
+    }
+
+    void push(eng::SnapshotInterpolator &interpolator, const std::uint32_t serverTick, const Clock::time_point arrival)
+    {
+        rnp::PacketWorldState snapshot = snapshotOf(serverTick);
+        interpolator.push(snapshot, arrival);
+    }
+
+    ///
+    /// @brief Interpolator fed ticks 1 to last, each arriving exactly 100 ms after the previous one
+    ///
+    eng::SnapshotInterpolator regular(const Clock::time_point start, const std::uint32_t last)
+    {
+        eng::SnapshotInterpolator interpolator;
+        interpolator.setTickRate(TICK_RATE);
+        for (std::uint32_t tick = 1; tick <= last; ++tick)
+        {
+            push(interpolator, tick, start + (tick - 1) * 100ms);
+        }
+        return interpolator;
+    }
+
+} // namespace
+
+TEST(interpolation, nothingBeforeFirstSnapshot)
+{
+    eng::SnapshotInterpolator interpolator;
+    std::vector<rnp::EntityState> entities = {
+        {.id = 7, .type = 0, .x = 1.F, .y = 1.F, .vx = 0.F, .vy = 0.F, .stateFlags = 0}};
+    EXPECT_FALSE(interpolator.sample(entities, Clock::now()));
+    ASSERT_EQ(entities.size(), 1U);
+    EXPECT_EQ(entities[0].id, 7U);
+}
+
+TEST(interpolation, renderedOneSpacingBehindArrival)
+{
+    const Clock::time_point start{};
+    eng::SnapshotInterpolator interpolator = regular(start, 5);
+    // Regular arrivals: no jitter, the delay is the spacing alone
+    EXPECT_NEAR(interpolator.delay().count(), 0.1, 1e-9);
+
+    // Tick 5 arrived at 400 ms: at 450 ms the render time is halfway between ticks 4 and 5
+    std::vector<rnp::EntityState> entities;
+    ASSERT_TRUE(interpolator.sample(entities, start + 450ms));
+    ASSERT_FALSE(entities.empty());
+    EXPECT_EQ(entities[0].id, 1U);
+    EXPECT_NEAR(entities[0].x, 450.F, 0.01F);
+    EXPECT_FLOAT_EQ(entities[0].y, 5.F);
+}
+
+TEST(interpolation, alphaFollowsRenderTime)
+{
+    const Clock::time_point start{};
+    eng::SnapshotInterpolator interpolator = regular(start, 5);
+    std::vector<rnp::EntityState> entities;
+    for (const auto elapsed : {410ms, 425ms, 460ms, 499ms})
+    {
+        ASSERT_TRUE(interpolator.sample(entities, start + elapsed));
+        const auto alpha = static_cast<float>((elapsed - 400ms).count()) / 100.F;
+        EXPECT_NEAR(entities[0].x, 400.F + 100.F * alpha, 0.01F) << elapsed.count() << " ms";
+    }
+
+    // At a snapshot's time, exactly its state
+    ASSERT_TRUE(interpolator.sample(entities, start + 500ms));
+    EXPECT_NEAR(entities[0].x, 500.F, 0.01F);
+}
+
+TEST(interpolation, entitiesOfOneSnapshotOnly)
+{
+    const Clock::time_point start{};
+    eng::SnapshotInterpolator interpolator = regular(start, 5);
+    std::vector<rnp::EntityState> entities;
+
+    // Between 4, which has entity 2, and 5, which does not: it stays until 5
+    ASSERT_TRUE(interpolator.sample(entities, start + 450ms));
+    ASSERT_EQ(entities.size(), 2U);
+    EXPECT_EQ(entities[1].id, 2U);
+    // Between 3 and 4: it waits for 4
+    interpolator = regular(start, 5);
+    ASSERT_TRUE(interpolator.sample(entities, start + 350ms));
+    ASSERT_EQ(entities.size(), 1U);
+}
+
+TEST(interpolation, lateSnapshotExtrapolatedThenHeld)
+{
+    const Clock::time_point start{};
+    eng::SnapshotInterpolator interpolator = regular(start, 5);
+    std::vector<rnp::EntityState> entities;
+
+    // Tick 6 is late: 50 ms past tick 5, entity 1 moved on at its 1000 units/s
+    ASSERT_TRUE(interpolator.sample(entities, start + 550ms));
+    EXPECT_NEAR(entities[0].x, 550.F, 0.01F);
+    // Then it stops MAX_EXTRAPOLATION past it
+    interpolator = regular(start, 5);
+    ASSERT_TRUE(interpolator.sample(entities, start + 900ms));
+    EXPECT_NEAR(entities[0].x, 500.F + 1000.F * 0.1F, 0.01F);
+}
+
+TEST(interpolation, delayCoversJitter)
+{
+    const Clock::time_point start{};
+    eng::SnapshotInterpolator interpolator;
+    interpolator.setTickRate(TICK_RATE);
+    // Every other snapshot 40 ms late
+    for (std::uint32_t tick = 1; tick <= 64; ++tick)
+    {
+        push(interpolator, tick, start + (tick - 1) * 100ms + (tick % 2 == 0 ? 40ms : 0ms));
+    }
+    EXPECT_GT(interpolator.delay().count(), 0.1 + 2 * 0.015);
+    EXPECT_LT(interpolator.delay().count(), 0.1 + 2 * 0.04);
+
+    // However bad the link, the delay is bounded
+    for (std::uint32_t tick = 65; tick <= 200; ++tick)
+    {
+        push(interpolator, tick, start + (tick - 1) * 100ms + (tick % 2 == 0 ? 2s : 0s));
+    }
+    EXPECT_DOUBLE_EQ(interpolator.delay().count(),
+                     std::chrono::duration<double>(eng::MAX_INTERPOLATION_DELAY).count());
+}
+
+TEST(interpolation, outOfOrderSnapshotFillsGap)
+{
+    const Clock::time_point start{};
+    eng::SnapshotInterpolator interpolator;
+    interpolator.setTickRate(TICK_RATE);
+    push(interpolator, 1, start);
+    push(interpolator, 2, start + 100ms);
+    push(interpolator, 4, start + 300ms);
+    // Tick 3 overtaken by 4, with entity 1 back at 0: kept for sampling, without changing the delay
+    const auto delay = interpolator.delay();
+    rnp::PacketWorldState late = snapshotOf(3);
+    late.entities[0].x = 0.F;
+    interpolator.push(late, start + 310ms);
+    EXPECT_EQ(interpolator.delay(), delay);
+
+    // Spacing 112.5 ms: at 375 ms, 5/8 of the way from 3 to 4, where it would be 13/16 of the way from 2
+    std::vector<rnp::EntityState> entities;
+    ASSERT_TRUE(interpolator.sample(entities, start + 375ms));
+    EXPECT_NEAR(entities[0].x, 400.F * 0.625F, 0.01F);
+    EXPECT_EQ(entities.size(), 1U); // Entity 2 is in 4, not in 3
+
+    // A duplicate, or a snapshot older than the history, changes nothing
+    interpolator = eng::SnapshotInterpolator{};
+    interpolator.setTickRate(TICK_RATE);
+    push(interpolator, 40, start);
+    push(interpolator, 41, start + 100ms);
+    push(interpolator, 41 - eng::SnapshotInterpolator::HISTORY, start + 150ms);
+    rnp::PacketWorldState duplicate = snapshotOf(41);
+    duplicate.entities[0].x = -1.F;
+    interpolator.push(duplicate, start + 160ms);
+    ASSERT_TRUE(interpolator.sample(entities, start + 200ms));
+    EXPECT_NEAR(entities[0].x, 4100.F, 0.01F);
+}
+
+TEST(interpolation, renderClockEasesIntoNewDelay)
+{
+    const Clock::time_point start{};
+    eng::SnapshotInterpolator interpolator = regular(start, 5);
+    std::vector<rnp::EntityState> entities;
+    ASSERT_TRUE(interpolator.sample(entities, start + 450ms));
+    const float before = entities[0].x;
+
+    // Jittered arrivals raise the delay: the render time runs 10% slower instead of jumping back
+    for (std::uint32_t tick = 6; tick <= 12; ++tick)
+    {
+        push(interpolator, tick, start + (tick - 1) * 100ms + (tick % 2 == 0 ? 40ms : 0ms));
+    }
+    ASSERT_TRUE(interpolator.sample(entities, start + 460ms));
+    EXPECT_NEAR(entities[0].x - before, 1000.F * 0.009F, 0.01F);
+}
@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+#include "ECS/Component.hpp"
+#include "ECS/Registry.hpp"
+#include "Interfaces/Protocol/Movement.hpp"
+#include "Server/LagCompensation.hpp"
+#include "Server/Systems/Systems.hpp"
+
+namespace
+{
+
+    using namespace std::chrono_literals;
+
+    constexpr std::uint16_t TICK_RATE = 60;
+
+    ecs::Entity target(ecs::Registry &registry, const float x, const float y, const float radius)
+    {
+        return registry.createEntity()
+            .with<ecs::Transform>("target_transform", x, y, 0.F)
+            .with<ecs::Hitbox>("target_hitbox", radius)
+            .build();
+    }
+
+    ///
+    /// @brief Shooter whose projectiles leave from (x, y)
+    ///
+    ecs::Entity shooter(ecs::Registry &registry, const float x, const float y)
+    {
+        return registry.createEntity()
+            .with<ecs::Transform>("shooter_transform", x - rnp::PLAYER_WIDTH, y - rnp::PLAYER_HEIGHT / 2, 0.F)
+            .build();
+    }
+
+} // namespace
+
+TEST(lagCompensation, viewTickRewoundAndBounded)
+{
+    ecs::Registry registry;
+    srv::HitboxHistory history;
+    EXPECT_DOUBLE_EQ(history.viewTick(100, TICK_RATE, 50ms), 100.0); // Nothing recorded to rewind to
+
+    for (std::uint32_t tick = 1; tick <= 100; ++tick)
+    {
+        history.record(tick, registry);
+    }
+    EXPECT_DOUBLE_EQ(history.viewTick(100, TICK_RATE, 50ms), 97.0);
+    EXPECT_DOUBLE_EQ(history.viewTick(100, TICK_RATE, -50ms), 100.0);
+    EXPECT_DOUBLE_EQ(history.viewTick(100, TICK_RATE, 1s), 100.0 - 0.2 * TICK_RATE); // DEFAULT_MAX_REWIND
+    history.setMaxRewind(2s);
+    EXPECT_DOUBLE_EQ(history.viewTick(100, TICK_RATE, 2s), 100.0 - (srv::HitboxHistory::HISTORY - 1));
+}
+
+TEST(lagCompensation, hitLerpedBetweenTicks)
+{
+    ecs::Registry registry;
+    srv::HitboxHistory history;
+    const ecs::Entity moving = target(registry, 0.F, 0.F, 10.F);
+    const ecs::Entity projectile = target(registry, 0.F, 0.F, 10.F);
+    registry.addComponent<ecs::Projectile>(projectile, "projectile", ecs::Projectile::BASIC, 1.F, 0.F, 0.F);
+    history.record(1, registry);
+    registry.getComponent<ecs::Transform>(moving)->x = 100.F;
+    history.record(2, registry);
+
+    EXPECT_EQ(history.hit(1.0, 0.F, 0.F, 1.F), moving); // Projectiles are not hitboxes
+    EXPECT_EQ(history.hit(1.5, 50.F, 0.F, 1.F), moving);
+    EXPECT_EQ(history.hit(1.5, 0.F, 0.F, 1.F), std::nullopt);
+    EXPECT_EQ(history.hit(1.5, 39.F, 0.F, 1.F), moving); // Touching
+    EXPECT_EQ(history.hit(2.0, 100.F, 0.F, 1.F), moving);
+    EXPECT_EQ(history.hit(3.0, 100.F, 0.F, 1.F), std::nullopt); // Not recorded yet
+    EXPECT_EQ(history.hit(0.5, 0.F, 0.F, 1.F), std::nullopt);
+
+    // The closest of two overlapping
+    const ecs::Entity closer = target(registry, 104.F, 0.F, 10.F);
+    history.record(3, registry);
+    EXPECT_EQ(history.hit(3.0, 103.F, 0.F, 1.F), closer);
+    EXPECT_EQ(history.hit(3.0, 101.F, 0.F, 1.F), moving);
+}
+
+TEST(lagCompensation, shotJudgedAsShooterSaw)
+{
+    ecs::Registry registry;
+    srv::HitboxHistory history;
+    srv::ShotSystem shots;
+    // On the line of fire for 5 ticks, then gone from it
+    const ecs::Entity dodging = target(registry, 300.F, 500.F, 20.F);
+    for (std::uint32_t tick = 1; tick <= 5; ++tick)
+    {
+        history.record(tick, registry);
+    }
+    registry.getComponent<ecs::Transform>(dodging)->y = 700.F;
+
+    const ecs::Entity lagging = shooter(registry, 290.F, 500.F);
+    const ecs::Entity current = shooter(registry, 290.F, 500.F);
+    const std::optional<ecs::Entity> projectile = shots.fire(registry, lagging, 6, 3.0);
+    ASSERT_TRUE(projectile.has_value());
+    EXPECT_FALSE(shots.fire(registry, lagging, 6 + srv::ShotSystem::COOLDOWN_TICKS - 1, 3.0).has_value());
+    ASSERT_TRUE(shots.fire(registry, current, 6, 0.0).has_value());
+    EXPECT_FLOAT_EQ(registry.getComponent<ecs::Velocity>(*projectile)->x, srv::ShotSystem::SPEED);
+
+    history.record(6, registry);
+    const std::vector<srv::ShotSystem::Hit> &hits = shots.judge(registry, history, 6);
+    ASSERT_EQ(hits.size(), 1U);
+    EXPECT_EQ(hits.front().target, dodging);
+    EXPECT_EQ(hits.front().shooter, lagging);
+    EXPECT_FALSE(registry.hasComponent<ecs::Projectile>(*projectile));
+    EXPECT_EQ(registry.getAll<ecs::Projectile>().size(), 1U); // The one judged against the present flies on
+
+    // Past the right edge
+    shots.update(registry, rnp::FIELD_WIDTH / srv::ShotSystem::SPEED);
+    EXPECT_TRUE(registry.getAll<ecs::Projectile>().empty());
+    EXPECT_TRUE(shots.judge(registry, history, 6).empty());
+    EXPECT_TRUE(shots.fire(registry, lagging, 6 + srv::ShotSystem::COOLDOWN_TICKS, 0.0).has_value());
+}
+
+TEST(lagCompensation, obstaclesDriftAndBreak)
+{
+    ecs::Registry registry;
+    srv::ObstacleSystem obstacles;
+    obstacles.update(registry, srv::ObstacleSystem::SPAWN_INTERVAL / 2);
+    EXPECT_TRUE(registry.getAll<ecs::Asteroid>().empty());
+    obstacles.update(registry, srv::ObstacleSystem::SPAWN_INTERVAL / 2);
+    ASSERT_EQ(registry.getAll<ecs::Asteroid>().size(), 1U);
+    const ecs::Entity asteroid = registry.getAll<ecs::Asteroid>().begin()->first;
+    EXPECT_FLOAT_EQ(registry.getComponent<ecs::Transform>(asteroid)->x,
+                    rnp::FIELD_WIDTH + srv::ObstacleSystem::RADIUS -
+                        srv::ObstacleSystem::SPEED * srv::ObstacleSystem::SPAWN_INTERVAL / 2);
+    EXPECT_FLOAT_EQ(registry.getComponent<ecs::Hitbox>(asteroid)->radius, srv::ObstacleSystem::RADIUS);
+
+    EXPECT_FALSE(obstacles.damage(registry, asteroid, srv::ObstacleSystem::HEALTH / 2));
+    EXPECT_TRUE(obstacles.damage(registry, asteroid, srv::ObstacleSystem::HEALTH / 2));
+    EXPECT_FALSE(registry.hasComponent<ecs::Transform>(asteroid));
+    EXPECT_FALSE(obstacles.damage(registry, asteroid, 1.F)); // Gone already
+
+    // Long enough to cross the whole field
+    obstacles.update(registry, srv::ObstacleSystem::SPAWN_INTERVAL);
+    ASSERT_EQ(registry.getAll<ecs::Asteroid>().size(), 1U);
+    obstacles.update(registry, (rnp::FIELD_WIDTH + 3 * srv::ObstacleSystem::RADIUS) / srv::ObstacleSystem::SPEED);
+    EXPECT_TRUE(registry.getAll<ecs::Asteroid>().empty());
+}
@@ -0,0 +1,209 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "Interfaces/Protocol/LinkConditioner.hpp"
+
+namespace
+{
+
+    using namespace std::chrono_literals;
+    using Clock = rnp::LinkConditioner::Clock;
+
+    const Clock::time_point START = Clock::time_point{} + 1h;
+    constexpr std::size_t DATAGRAMS = 20'000;
+
+    rnp::LinkConditions degraded(const std::uint64_t seed)
+    {
+        return {.latency = 40ms,
+                .jitter = 20ms,
+                .loss = 0.1,
+                .burstEnter = 0.0,
+                .burstExit = 1.0,
+                .burstLoss = 1.0,
+                .duplicate = 0.05,
+                .reorder = 0.05,
+                .reorderDelay = 30ms,
+                .bandwidthBytesPerSecond = 0,
+                .queueBytes = 64 * 1024,
+                .seed = seed};
+    }
+
+    ///
+    /// @brief Delay of each copy delivered, one datagram every millisecond, Clock::duration::min() for a loss
+    ///
+    std::vector<Clock::duration> run(rnp::LinkConditioner &link, const std::size_t count = DATAGRAMS)
+    {
+        std::vector<Clock::duration> delays;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const Clock::time_point now = START + std::chrono::milliseconds(i);
+            const rnp::LinkConditioner::Delivery delivery = link.send(now, 100);
+            if (delivery.copies == 0)
+            {
+                delays.push_back(Clock::duration::min());
+            }
+            for (std::uint8_t copy = 0; copy < delivery.copies; ++copy)
+            {
+                delays.push_back(delivery.at[copy] - now);
+            }
+        }
+        return delays;
+    }
+
+} // namespace
+
+TEST(linkConditioner, sameSeedSameDecisions)
+{
+    rnp::LinkConditioner first(degraded(7));
+    rnp::LinkConditioner second(degraded(7));
+    rnp::LinkConditioner other(degraded(8));
+    const std::vector<Clock::duration> delays = run(first);
+    EXPECT_EQ(delays, run(second));
+    EXPECT_NE(delays, run(other));
+}
+
+TEST(linkConditioner, lossLatencyAndJitter)
+{
+    rnp::LinkConditions conditions = degraded(3);
+    conditions.duplicate = 0.0;
+    conditions.reorder = 0.0;
+    rnp::LinkConditioner link(conditions);
+    std::size_t lost = 0;
+    Clock::duration total{};
+    Clock::duration shortest = Clock::duration::max();
+    Clock::duration longest{};
+    for (const Clock::duration delay : run(link))
+    {
+        if (delay == Clock::duration::min())
+        {
+            ++lost;
+            continue;
+        }
+        total += delay;
+        shortest = std::min(shortest, delay);
+        longest = std::max(longest, delay);
+    }
+    EXPECT_NEAR(static_cast<double>(lost) / DATAGRAMS, conditions.loss, 0.01);
+    EXPECT_GE(shortest, conditions.latency);
+    EXPECT_LT(longest, conditions.latency + conditions.jitter);
+    // Uniform jitter: half of it on average, the extremes both reached
+    const auto mean = std::chrono::duration_cast<std::chrono::microseconds>(total / (DATAGRAMS - lost));
+    const std::chrono::microseconds expected = conditions.latency + conditions.jitter / 2;
+    EXPECT_NEAR(static_cast<double>(mean.count()), static_cast<double>(expected.count()), 500.0);
+    EXPECT_LT(shortest, conditions.latency + 1ms);
+    EXPECT_GT(longest, conditions.latency + conditions.jitter - 1ms);
+}
+
+TEST(linkConditioner, burstLossClusters)
+{
+    // Same average loss, 10%: uniform, then in bursts of five on average
+    rnp::LinkConditions uniform = degraded(5);
+    uniform.jitter = 0ms;
+    uniform.duplicate = 0.0;
+    uniform.reorder = 0.0;
+    rnp::LinkConditions bursty = uniform;
+    bursty.loss = 0.0;
+    bursty.burstExit = 0.2;
+    bursty.burstEnter = bursty.burstExit / 9;
+    const auto lossRuns = [](const rnp::LinkConditions &conditions)
+    {
+        rnp::LinkConditioner link(conditions);
+        std::size_t lost = 0;
+        std::size_t runs = 0;
+        bool previousLost = false;
+        for (const Clock::duration delay : run(link))
+        {
+            const bool isLost = delay == Clock::duration::min();
+            lost += isLost ? 1U : 0U;
+            runs += isLost && !previousLost ? 1U : 0U;
+            previousLost = isLost;
+        }
+        return std::pair{static_cast<double>(lost) / DATAGRAMS, static_cast<double>(lost) / static_cast<double>(runs)};
+    };
+
+    const auto [uniformLoss, uniformRun] = lossRuns(uniform);
+    const auto [burstyLoss, burstyRun] = lossRuns(bursty);
+    EXPECT_NEAR(uniformLoss, 0.1, 0.01);
+    EXPECT_NEAR(burstyLoss, 0.1, 0.02);
+    EXPECT_LT(uniformRun, 1.2);
+    EXPECT_NEAR(burstyRun, 1.0 / bursty.burstExit, 0.5);
+}
+
+TEST(linkConditioner, duplicateAndReorder)
+{
+    rnp::LinkConditions conditions = degraded(11);
+    conditions.loss = 0.0;
+    conditions.jitter = 0ms;
+    rnp::LinkConditioner link(conditions);
+    const std::vector<Clock::duration> delays = run(link);
+    EXPECT_NEAR(static_cast<double>(delays.size() - DATAGRAMS) / DATAGRAMS, conditions.duplicate, 0.01);
+    std::size_t held = 0;
+    for (const Clock::duration delay : delays)
+    {
+        if (delay == conditions.latency + conditions.reorderDelay)
+        {
+            ++held;
+        }
+        else
+        {
+            EXPECT_EQ(delay, conditions.latency);
+        }
+    }
+    EXPECT_NEAR(static_cast<double>(held) / static_cast<double>(delays.size()), conditions.reorder, 0.01);
+}
+
+TEST(linkConditioner, bandwidthCapQueuesThenDrops)
+{
+    // 125 bytes take 125 ms at 1000 B/s, and the queue holds a second of them
+    const rnp::LinkConditions conditions{.latency = 10ms, .bandwidthBytesPerSecond = 1000, .queueBytes = 1000};
+    rnp::LinkConditioner link(conditions);
+    std::vector<Clock::time_point> arrivals;
+    for (std::size_t i = 0; i < 20; ++i)
+    {
+        const rnp::LinkConditioner::Delivery delivery = link.send(START, 125);
+        if (delivery.copies == 1)
+        {
+            arrivals.push_back(delivery.at[0]);
+        }
+    }
+    ASSERT_EQ(arrivals.size(), 9U);
+    for (std::size_t i = 0; i < arrivals.size(); ++i)
+    {
+        EXPECT_EQ(arrivals[i], START + conditions.latency + 125ms * static_cast<int>(i + 1)) << i;
+    }
+    // Room again once the link drained
+    EXPECT_EQ(link.send(START + 2s, 125).at[0], START + 2s + 125ms + conditions.latency);
+}
+
+TEST(linkConditioner, delayLineInArrivalThenSendingOrder)
+{
+    rnp::DelayLine<int> line;
+    EXPECT_FALSE(line.nextDue().has_value());
+    line.push(START + 30ms, 1);
+    line.push(START + 10ms, 2);
+    line.push(START + 30ms, 3);
+    line.push(START + 20ms, 4);
+    line.push(START + 10ms, 5);
+    EXPECT_EQ(line.size(), 5U);
+    ASSERT_TRUE(line.nextDue().has_value());
+    EXPECT_EQ(*line.nextDue(), START + 10ms);
+
+    std::vector<int> delivered;
+    const auto collect = [&delivered](int packet) { delivered.push_back(packet); };
+    line.popDue(START + 9ms, collect);
+    EXPECT_TRUE(delivered.empty());
+    line.popDue(START + 20ms, collect);
+    EXPECT_EQ(delivered, (std::vector<int>{2, 5, 4}));
+    EXPECT_EQ(*line.nextDue(), START + 30ms);
+    line.push(START + 30ms, 6);
+    line.popDue(START + 1s, collect);
+    EXPECT_EQ(delivered, (std::vector<int>{2, 5, 4, 1, 3, 6}));
+    EXPECT_EQ(line.size(), 0U);
+    EXPECT_FALSE(line.nextDue().has_value());
+}
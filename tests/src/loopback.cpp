@@ -0,0 +1,241 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "Interfaces/INetworkServer.hpp"
+#include "Interfaces/Protocol/Buffer.hpp"
+#include "Interfaces/Protocol/Protocol.hpp"
+#include "LoopbackClient/LoopbackClient.hpp"
+#include "LoopbackLink/LoopbackLink.hpp"
+#include "LoopbackServer/LoopbackServer.hpp"
+
+namespace
+{
+
+    constexpr std::uint16_t TICK_RATE = 30;
+
+    ///
+    /// @brief Server and clients of one link, each test on its own port so links do not outlive it
+    ///
+    struct Loopback
+    {
+            explicit Loopback(const std::uint16_t linkPort) : port(linkPort)
+            {
+                server.setTickRate(TICK_RATE);
+                server.init("", port);
+            }
+
+            ///
+            /// @brief Connect a client and hand its CONNECT to the server
+            ///
+            void join(eng::LoopbackClient &client, const std::string &name)
+            {
+                client.connect("", port);
+                client.sendConnect(name);
+                srv::NetworkMessage message;
+                ASSERT_TRUE(server.pollMessage(message));
+                EXPECT_EQ(message.kind, srv::NetworkMessage::Kind::CONNECT);
+                EXPECT_EQ(std::string(message.data.data().begin(), message.data.data().end()), name);
+                EXPECT_FALSE(server.pollMessage(message));
+            }
+
+            std::uint16_t port;
+            srv::LoopbackServer server;
+    };
+
+    std::vector<rnp::EntityState> entities(const std::size_t count)
+    {
+        std::vector<rnp::EntityState> states(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            // Sent in reverse, the client sorts them by id
+            states[i] = {.id = static_cast<std::uint32_t>(count - i),
+                         .type = static_cast<std::uint16_t>(rnp::EntityType::ENEMY),
+                         .x = static_cast<float>(i),
+                         .y = -static_cast<float>(i),
+                         .vx = 1.5F,
+                         .vy = -2.5F,
+                         .stateFlags = 0};
+        }
+        return states;
+    }
+
+} // namespace
+
+TEST(loopback, connectAccepted)
+{
+    Loopback loopback(41001);
+    eng::LoopbackClient client;
+    std::optional<std::uint32_t> acceptedSession;
+    client.setPacketHandler(rnp::PacketType::CONNECT_ACCEPT,
+                            [&acceptedSession](const rnp::PacketHeader &header, std::span<const std::uint8_t>)
+                            { acceptedSession = header.sessionId; });
+    loopback.join(client, "Bobi");
+
+    rnp::PacketWorldState snapshot{};
+    EXPECT_FALSE(client.pollWorldState(snapshot)); // Decodes the CONNECT_ACCEPT
+    ASSERT_TRUE(acceptedSession.has_value());
+    EXPECT_NE(client.getSessionId(), 0U);
+    EXPECT_EQ(client.getSessionId(), *acceptedSession);
+    EXPECT_EQ(client.getServerTickRate(), TICK_RATE);
+
+    client.disconnect();
+    srv::NetworkMessage message;
+    ASSERT_TRUE(loopback.server.pollMessage(message));
+    EXPECT_EQ(message.kind, srv::NetworkMessage::Kind::DISCONNECT);
+}
+
+TEST(loopback, chunkedSnapshotRoundTrip)
+{
+    Loopback loopback(41002);
+    eng::LoopbackClient client;
+    loopback.join(client, "Bobi");
+
+    // More entities than a datagram holds, the snapshot is split in chunks
+    const std::vector<rnp::EntityState> sent = entities(500);
+    loopback.server.broadcastWorldState(7, sent);
+    rnp::PacketWorldState snapshot{};
+    ASSERT_TRUE(client.pollWorldState(snapshot));
+    EXPECT_EQ(snapshot.serverTick, 7U);
+    EXPECT_EQ(snapshot.inputAck, 0U);
+    ASSERT_EQ(snapshot.entityCount, sent.size());
+    ASSERT_EQ(snapshot.entities.size(), sent.size());
+    for (std::size_t i = 0; i < sent.size(); ++i)
+    {
+        const rnp::EntityState &expected = sent[sent.size() - 1 - i];
+        const rnp::EntityState &received = snapshot.entities[i];
+        EXPECT_EQ(received.id, expected.id);
+        EXPECT_EQ(received.type, expected.type);
+        EXPECT_EQ(received.x, expected.x);
+        EXPECT_EQ(received.y, expected.y);
+        EXPECT_EQ(received.vx, expected.vx);
+        EXPECT_EQ(received.vy, expected.vy);
+    }
+    EXPECT_FALSE(client.pollWorldState(snapshot));
+
+    // An empty world still sends one chunk
+    loopback.server.broadcastWorldState(8, {});
+    ASSERT_TRUE(client.pollWorldState(snapshot));
+    EXPECT_EQ(snapshot.serverTick, 8U);
+    EXPECT_TRUE(snapshot.entities.empty());
+}
+
+TEST(loopback, inputAcknowledgedBySnapshot)
+{
+    Loopback loopback(41003);
+    eng::LoopbackClient client;
+    loopback.join(client, "Bobi");
+
+    client.sendPlayerInputAsEvent(3, static_cast<std::uint8_t>(rnp::InputDirection::UP), 1, 1234);
+    srv::NetworkMessage message;
+    ASSERT_TRUE(loopback.server.pollMessage(message));
+    EXPECT_EQ(message.kind, srv::NetworkMessage::Kind::INPUT);
+    EXPECT_EQ(message.entityId, 3U);
+    EXPECT_EQ(message.input.direction, static_cast<std::uint8_t>(rnp::InputDirection::UP));
+    EXPECT_EQ(message.input.shooting, 1);
+    EXPECT_EQ(message.input.clientTimeMs, 1234U);
+    EXPECT_FALSE(loopback.server.pollMessage(message));
+
+    // The next snapshot reflects the input
+    loopback.server.broadcastWorldState(1, entities(1));
+    rnp::PacketWorldState snapshot{};
+    ASSERT_TRUE(client.pollWorldState(snapshot));
+    EXPECT_EQ(snapshot.inputAck, 1234U);
+}
+
+TEST(loopback, eventRelayedToOtherClients)
+{
+    Loopback loopback(41004);
+    eng::LoopbackClient sender;
+    eng::LoopbackClient receiver;
+    loopback.join(sender, "Alice");
+    loopback.join(receiver, "Bob");
+    rnp::PacketWorldState snapshot{};
+    (void)sender.pollWorldState(snapshot);
+    (void)receiver.pollWorldState(snapshot);
+
+    // The client interface only sends inputs, the event goes on the link as the sender's
+    const std::shared_ptr<rnp::LoopbackLink> link = rnp::LoopbackLink::open(loopback.port);
+    rnp::LoopbackLink::Datagram datagram =
+        link->encode(rnp::PacketType::ENTITY_EVENT, sender.getSessionId(), 100, [](rnp::BufferWriter &writer)
+                     { rnp::writeEvent(writer, rnp::EventType::SCORE, 42, rnp::ScoreEventData{.points = 500}); });
+    ASSERT_TRUE(datagram);
+    ASSERT_TRUE(link->sendToServer(std::move(datagram)));
+
+    srv::NetworkMessage message;
+    ASSERT_TRUE(loopback.server.pollMessage(message));
+    EXPECT_EQ(message.kind, srv::NetworkMessage::Kind::EVENT);
+    EXPECT_EQ(message.eventType, rnp::EventType::SCORE);
+    EXPECT_EQ(message.entityId, 42U);
+    EXPECT_FALSE(loopback.server.pollMessage(message));
+
+    eng::NetworkEvent event;
+    EXPECT_FALSE(sender.pollEvent(event)); // Not echoed to its sender
+    ASSERT_TRUE(receiver.pollEvent(event));
+    EXPECT_EQ(event.type, rnp::EventType::SCORE);
+    EXPECT_EQ(event.entityId, 42U);
+    rnp::BufferReader reader(event.bytes());
+    rnp::ScoreEventData score{};
+    ASSERT_TRUE(rnp::read(reader, score));
+    EXPECT_EQ(score.points, 500);
+    EXPECT_FALSE(receiver.pollEvent(event));
+}
+
+TEST(loopback, slotReusedByNewSession)
+{
+    Loopback loopback(41005);
+    eng::LoopbackClient client;
+    loopback.join(client, "Bobi");
+    rnp::PacketWorldState snapshot{};
+    (void)client.pollWorldState(snapshot);
+    const std::uint32_t first = client.getSessionId();
+
+    client.disconnect();
+    srv::NetworkMessage message;
+    ASSERT_TRUE(loopback.server.pollMessage(message));
+    EXPECT_EQ(message.kind, srv::NetworkMessage::Kind::DISCONNECT);
+
+    loopback.join(client, "Bobi");
+    (void)client.pollWorldState(snapshot);
+    EXPECT_NE(client.getSessionId(), 0U);
+    EXPECT_NE(client.getSessionId(), first);
+    loopback.server.broadcastWorldState(2, entities(3));
+    ASSERT_TRUE(client.pollWorldState(snapshot));
+    EXPECT_EQ(snapshot.entities.size(), 3U);
+}
+
+TEST(loopback, serverEventToOnePlayerOrAll)
+{
+    Loopback loopback(41007);
+    eng::LoopbackClient first;
+    eng::LoopbackClient second;
+    loopback.join(first, "Alice");
+    loopback.join(second, "Bob");
+    rnp::PacketWorldState snapshot{};
+    (void)first.pollWorldState(snapshot);
+    (void)second.pollWorldState(snapshot);
+
+    // Players are numbered in connection order
+    loopback.server.sendEvent(2, rnp::EventType::CONTROL, 7, {});
+    eng::NetworkEvent event;
+    EXPECT_FALSE(first.pollEvent(event));
+    ASSERT_TRUE(second.pollEvent(event));
+    EXPECT_EQ(event.type, rnp::EventType::CONTROL);
+    EXPECT_EQ(event.entityId, 7U);
+    EXPECT_EQ(event.size, 0U);
+
+    const std::array<std::uint8_t, 1> reason{0};
+    loopback.server.sendEvent(srv::EVERY_PLAYER, rnp::EventType::DESPAWN, 7, reason);
+    for (eng::LoopbackClient *client : {&first, &second})
+    {
+        ASSERT_TRUE(client->pollEvent(event));
+        EXPECT_EQ(event.type, rnp::EventType::DESPAWN);
+        EXPECT_EQ(event.entityId, 7U);
+        EXPECT_EQ(event.size, 1U);
+        EXPECT_FALSE(client->pollEvent(event));
+    }
+}
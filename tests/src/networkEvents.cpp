@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "Engine/Engine.hpp"
+#include "Interfaces/INetworkServer.hpp"
+#include "Interfaces/Protocol/Buffer.hpp"
+#include "LoopbackClient/LoopbackClient.hpp"
+#include "LoopbackLink/LoopbackLink.hpp"
+#include "LoopbackServer/LoopbackServer.hpp"
+
+namespace
+{
+
+    constexpr std::uint16_t PORT = 41006;
+    constexpr std::uint32_t EVENTS = 10;
+
+    ///
+    /// @brief Engine whose network is a loopback client, sent SCORE events of entities 1 to EVENTS by another one
+    ///
+    struct Relayed
+    {
+            Relayed()
+            {
+                server.setTickRate(30);
+                server.init("", PORT);
+                join(*receiver);
+                join(sender);
+                const std::shared_ptr<rnp::LoopbackLink> link = rnp::LoopbackLink::open(PORT);
+                for (std::uint32_t entityId = 1; entityId <= EVENTS; ++entityId)
+                {
+                    const auto score = [entityId](rnp::BufferWriter &writer)
+                    { rnp::writeEvent(writer, rnp::EventType::SCORE, entityId, rnp::ScoreEventData{.points = 1}); };
+                    rnp::LoopbackLink::Datagram datagram =
+                        link->encode(rnp::PacketType::ENTITY_EVENT, sender.getSessionId(), entityId, score);
+                    EXPECT_TRUE(link->sendToServer(std::move(datagram)));
+                }
+                srv::NetworkMessage message;
+                while (server.pollMessage(message))
+                {
+                }
+            }
+
+            void join(eng::LoopbackClient &client)
+            {
+                client.connect("", PORT);
+                client.sendConnect("Bobi");
+                srv::NetworkMessage message;
+                EXPECT_TRUE(server.pollMessage(message));
+                rnp::PacketWorldState snapshot{};
+                (void)client.pollWorldState(snapshot); // Decodes the CONNECT_ACCEPT
+            }
+
+            srv::LoopbackServer server;
+            std::shared_ptr<eng::LoopbackClient> receiver = std::make_shared<eng::LoopbackClient>();
+            eng::LoopbackClient sender;
+            // No window nor sound: only the network is used
+            eng::Engine engine{[] { return nullptr; }, [this] { return receiver; }, [] { return nullptr; }};
+    };
+
+} // namespace
+
+TEST(networkEvents, keptUntilHandlerSet)
+{
+    Relayed relayed;
+    relayed.engine.dispatchNetworkEvents();
+    relayed.engine.dispatchNetworkEvents();
+
+    std::vector<std::uint32_t> handled;
+    relayed.engine.setNetworkEventHandler([&handled](const eng::NetworkEvent &event)
+                                          { handled.push_back(event.entityId); });
+    relayed.engine.dispatchNetworkEvents();
+    ASSERT_EQ(handled.size(), EVENTS);
+    for (std::uint32_t i = 0; i < EVENTS; ++i)
+    {
+        EXPECT_EQ(handled[i], i + 1);
+    }
+}
+
+TEST(networkEvents, spreadOverFramesByCount)
+{
+    Relayed relayed;
+    std::vector<std::uint32_t> handled;
+    relayed.engine.setNetworkEventHandler([&handled](const eng::NetworkEvent &event)
+                                          { handled.push_back(event.entityId); });
+    relayed.engine.setNetworkEventBudget({.maxEvents = 4, .maxTime = std::chrono::seconds(1)});
+
+    relayed.engine.dispatchNetworkEvents();
+    EXPECT_EQ(handled.size(), 4U);
+    relayed.engine.dispatchNetworkEvents();
+    EXPECT_EQ(handled.size(), 8U);
+    relayed.engine.dispatchNetworkEvents();
+    ASSERT_EQ(handled.size(), EVENTS);
+    EXPECT_EQ(handled.back(), EVENTS);
+    relayed.engine.dispatchNetworkEvents();
+    EXPECT_EQ(handled.size(), EVENTS);
+}
+
+TEST(networkEvents, spreadOverFramesByTime)
+{
+    Relayed relayed;
+    std::vector<std::uint32_t> handled;
+    // Each event takes longer than the budget of a frame: one per frame, never none
+    relayed.engine.setNetworkEventHandler(
+        [&handled](const eng::NetworkEvent &event)
+        {
+            handled.push_back(event.entityId);
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        });
+    relayed.engine.setNetworkEventBudget({.maxEvents = 64, .maxTime = std::chrono::milliseconds(1)});
+
+    for (std::uint32_t frame = 1; frame <= EVENTS; ++frame)
+    {
+        relayed.engine.dispatchNetworkEvents();
+        ASSERT_EQ(handled.size(), frame);
+        EXPECT_EQ(handled.back(), frame);
+    }
+}
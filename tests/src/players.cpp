@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <optional>
+
+#include "ECS/Component.hpp"
+#include "ECS/Registry.hpp"
+#include "Interfaces/Protocol/Movement.hpp"
+#include "Server/Systems/Systems.hpp"
+
+namespace
+{
+
+    constexpr auto RIGHT = static_cast<std::uint8_t>(rnp::InputDirection::RIGHT);
+    constexpr auto LEFT = static_cast<std::uint8_t>(rnp::InputDirection::LEFT);
+    constexpr auto UP = static_cast<std::uint8_t>(rnp::InputDirection::UP);
+    constexpr auto DOWN = static_cast<std::uint8_t>(rnp::InputDirection::DOWN);
+
+    rnp::InputEventData input(const std::uint8_t direction, const std::uint32_t clientTimeMs)
+    {
+        return {.buttons = 0, .direction = direction, .shooting = 0, .clientTimeMs = clientTimeMs};
+    }
+
+} // namespace
+
+TEST(players, velocityOfDirection)
+{
+    EXPECT_FLOAT_EQ(rnp::playerVelocity(RIGHT).x, rnp::PLAYER_SPEED);
+    EXPECT_FLOAT_EQ(rnp::playerVelocity(RIGHT).y, 0.F);
+    EXPECT_FLOAT_EQ(rnp::playerVelocity(UP).y, -rnp::PLAYER_SPEED);
+    EXPECT_FLOAT_EQ(rnp::playerVelocity(DOWN | LEFT).x, -rnp::PLAYER_SPEED * rnp::DIAGONAL_SPEED_MULTIPLIER);
+    EXPECT_FLOAT_EQ(rnp::playerVelocity(DOWN | LEFT).y, rnp::PLAYER_SPEED * rnp::DIAGONAL_SPEED_MULTIPLIER);
+    // Opposite directions cancel out, the other axis moves at full speed
+    EXPECT_FLOAT_EQ(rnp::playerVelocity(LEFT | RIGHT | UP).x, 0.F);
+    EXPECT_FLOAT_EQ(rnp::playerVelocity(LEFT | RIGHT | UP).y, -rnp::PLAYER_SPEED);
+
+    EXPECT_FLOAT_EQ(rnp::inputStep(0, 5000), 0.F);
+    EXPECT_FLOAT_EQ(rnp::inputStep(1000, 1016), 0.016F);
+    EXPECT_FLOAT_EQ(rnp::inputStep(1000, 9000), rnp::MAX_INPUT_STEP);
+    EXPECT_FLOAT_EQ(rnp::inputStep(1016, 1000), 0.F);
+}
+
+TEST(players, spawnAndDespawn)
+{
+    ecs::Registry registry;
+    srv::PlayerSystem players;
+    const ecs::Entity first = players.spawn(registry, 1);
+    const ecs::Entity second = players.spawn(registry, 2);
+    EXPECT_NE(first, second);
+    EXPECT_EQ(players.entityOf(1), first);
+    EXPECT_TRUE(registry.hasComponent<ecs::Player>(first));
+    ASSERT_NE(registry.getComponent<ecs::Transform>(second), nullptr);
+    EXPECT_NE(registry.getComponent<ecs::Transform>(first)->y, registry.getComponent<ecs::Transform>(second)->y);
+    EXPECT_EQ(registry.getAll<ecs::Transform>().size(), 2U);
+
+    // A player spawned again leaves its previous entity
+    const ecs::Entity again = players.spawn(registry, 1);
+    EXPECT_EQ(players.entityOf(1), again);
+    EXPECT_FALSE(registry.hasComponent<ecs::Transform>(first));
+    EXPECT_EQ(registry.getAll<ecs::Transform>().size(), 2U);
+
+    EXPECT_EQ(players.despawn(registry, 2), second);
+    EXPECT_EQ(players.despawn(registry, 2), std::nullopt);
+    EXPECT_EQ(players.entityOf(2), std::nullopt);
+    EXPECT_FALSE(registry.hasComponent<ecs::Velocity>(second));
+    EXPECT_EQ(registry.getAll<ecs::Transform>().size(), 1U);
+
+    // Inputs of a player without an entity change nothing
+    players.update(registry, 1.F);
+    players.applyInput(registry, 2, input(RIGHT, 1000));
+    players.applyInput(registry, 2, input(RIGHT, 1100));
+    EXPECT_EQ(registry.getAll<ecs::Transform>().size(), 1U);
+}
+
+TEST(players, inputHeldForClientTime)
+{
+    ecs::Registry registry;
+    srv::PlayerSystem players;
+    const ecs::Entity entity = players.spawn(registry, 1);
+    const ecs::Transform start = *registry.getComponent<ecs::Transform>(entity);
+    players.update(registry, srv::PlayerSystem::MAX_CREDIT);
+
+    // The first input sets the velocity only, the next ones move for the time since the previous one
+    players.applyInput(registry, 1, input(RIGHT, 1000));
+    EXPECT_FLOAT_EQ(registry.getComponent<ecs::Transform>(entity)->x, start.x);
+    EXPECT_FLOAT_EQ(registry.getComponent<ecs::Velocity>(entity)->x, rnp::PLAYER_SPEED);
+    players.applyInput(registry, 1, input(RIGHT, 1100));
+    players.applyInput(registry, 1, input(DOWN, 1150));
+    const ecs::Transform *moved = registry.getComponent<ecs::Transform>(entity);
+    EXPECT_FLOAT_EQ(moved->x, start.x + rnp::PLAYER_SPEED * 0.1F);
+    EXPECT_FLOAT_EQ(moved->y, start.y + rnp::PLAYER_SPEED * 0.05F);
+    EXPECT_FLOAT_EQ(registry.getComponent<ecs::Velocity>(entity)->x, 0.F);
+
+    // An input older than the previous one does not move back in time
+    players.applyInput(registry, 1, input(DOWN, 1120));
+    EXPECT_FLOAT_EQ(registry.getComponent<ecs::Transform>(entity)->y, start.y + rnp::PLAYER_SPEED * 0.05F);
+}
+
+TEST(players, serverClockBoundsSpeed)
+{
+    ecs::Registry registry;
+    srv::PlayerSystem players;
+    const ecs::Entity entity = players.spawn(registry, 1);
+    const float startX = registry.getComponent<ecs::Transform>(entity)->x;
+
+    // Claiming 100 ms per input, a tick of 10 ms moves the player for 10 ms only
+    players.applyInput(registry, 1, input(RIGHT, 1000));
+    players.update(registry, 0.01F);
+    for (std::uint32_t time = 1100; time <= 2000; time += 100)
+    {
+        players.applyInput(registry, 1, input(RIGHT, time));
+    }
+    EXPECT_FLOAT_EQ(registry.getComponent<ecs::Transform>(entity)->x, startX + rnp::PLAYER_SPEED * 0.01F);
+
+    // Idle ticks save up to MAX_CREDIT
+    for (int tick = 0; tick < 100; ++tick)
+    {
+        players.update(registry, 0.01F);
+    }
+    for (std::uint32_t time = 2100; time <= 3000; time += 100)
+    {
+        players.applyInput(registry, 1, input(RIGHT, time));
+    }
+    EXPECT_FLOAT_EQ(registry.getComponent<ecs::Transform>(entity)->x,
+                    startX + rnp::PLAYER_SPEED * (0.01F + srv::PlayerSystem::MAX_CREDIT));
+}
+
+TEST(players, keptWithinField)
+{
+    ecs::Registry registry;
+    srv::PlayerSystem players;
+    const ecs::Entity entity = players.spawn(registry, 1);
+    std::uint32_t time = 1000;
+    for (int tick = 0; tick < 100; ++tick)
+    {
+        players.update(registry, 0.1F);
+        players.applyInput(registry, 1, input(UP | LEFT, time += 100));
+    }
+    EXPECT_FLOAT_EQ(registry.getComponent<ecs::Transform>(entity)->x, 0.F);
+    EXPECT_FLOAT_EQ(registry.getComponent<ecs::Transform>(entity)->y, 0.F);
+    for (int tick = 0; tick < 100; ++tick)
+    {
+        players.update(registry, 0.1F);
+        players.applyInput(registry, 1, input(DOWN | RIGHT, time += 100));
+    }
+    EXPECT_FLOAT_EQ(registry.getComponent<ecs::Transform>(entity)->x, rnp::FIELD_WIDTH - rnp::PLAYER_WIDTH);
+    EXPECT_FLOAT_EQ(registry.getComponent<ecs::Transform>(entity)->y, rnp::FIELD_HEIGHT - rnp::PLAYER_HEIGHT);
+}
@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "Engine/Prediction.hpp"
+#include "Interfaces/Protocol/Movement.hpp"
+
+namespace
+{
+
+    constexpr std::uint32_t ENTITY = 5;
+    constexpr auto RIGHT = static_cast<std::uint8_t>(rnp::InputDirection::RIGHT);
+    constexpr float STEP = 0.1F; // Seconds each input covers, PLAYER_SPEED * STEP = 50 units
+
+    void simulate(rnp::EntityState &entity, const eng::PredictedInput &input)
+    {
+        const rnp::PlayerVelocity velocity = rnp::playerVelocity(input.direction);
+        entity.vx = velocity.x;
+        entity.vy = velocity.y;
+        rnp::movePlayer(entity.x, entity.y, velocity, input.dt);
+    }
+
+    eng::PredictedInput right(const std::uint32_t clientTimeMs)
+    {
+        return {.clientTimeMs = clientTimeMs, .direction = RIGHT, .shooting = 0, .dt = STEP};
+    }
+
+    ///
+    /// @brief Snapshot with the predicted entity at x between two others, sorted by id
+    ///
+    std::vector<rnp::EntityState> snapshotAt(const float x)
+    {
+        return {{.id = ENTITY - 1, .type = 0, .x = 0.F, .y = 0.F, .vx = 0.F, .vy = 0.F, .stateFlags = 0},
+                {.id = ENTITY, .type = 0, .x = x, .y = 100.F, .vx = 0.F, .vy = 0.F, .stateFlags = 0},
+                {.id = ENTITY + 1, .type = 0, .x = 0.F, .y = 0.F, .vx = 0.F, .vy = 0.F, .stateFlags = 0}};
+    }
+
+} // namespace
+
+TEST(prediction, nothingBeforeEntityInSnapshot)
+{
+    eng::InputPredictor predictor(simulate);
+    predictor.apply(right(100));
+    EXPECT_EQ(predictor.pending(), 0U); // No entity to predict
+
+    predictor.setEntity(ENTITY);
+    predictor.apply(right(200));
+    EXPECT_EQ(predictor.pending(), 1U);
+    EXPECT_EQ(predictor.state(), std::nullopt);
+
+    // A snapshot without the entity changes nothing
+    predictor.reconcile(std::vector<rnp::EntityState>{snapshotAt(0.F).front()}, 0);
+    EXPECT_EQ(predictor.state(), std::nullopt);
+    EXPECT_EQ(predictor.pending(), 1U);
+}
+
+TEST(prediction, unacknowledgedInputsReplayed)
+{
+    eng::InputPredictor predictor(simulate);
+    predictor.setEntity(ENTITY);
+    for (std::uint32_t time = 100; time <= 300; time += 100)
+    {
+        predictor.apply(right(time));
+    }
+
+    // The server applied the first input only: the two others are replayed on its state
+    predictor.reconcile(snapshotAt(100.F), 100);
+    EXPECT_EQ(predictor.pending(), 2U);
+    ASSERT_TRUE(predictor.state().has_value());
+    EXPECT_EQ(predictor.state()->id, ENTITY);
+    EXPECT_FLOAT_EQ(predictor.state()->x, 100.F + 2 * rnp::PLAYER_SPEED * STEP);
+    EXPECT_FLOAT_EQ(predictor.state()->vx, rnp::PLAYER_SPEED);
+
+    // Then each input moves it at once
+    predictor.apply(right(400));
+    EXPECT_FLOAT_EQ(predictor.state()->x, 100.F + 3 * rnp::PLAYER_SPEED * STEP);
+
+    // Every input acknowledged: exactly the server state
+    predictor.reconcile(snapshotAt(250.F), 400);
+    EXPECT_EQ(predictor.pending(), 0U);
+    EXPECT_FLOAT_EQ(predictor.state()->x, 250.F);
+}
+
+TEST(prediction, acknowledgementAcrossClockWrap)
+{
+    eng::InputPredictor predictor(simulate);
+    predictor.setEntity(ENTITY);
+    const std::uint32_t before = 0xFFFFFFFFU - 50;
+    predictor.apply(right(before));
+    predictor.apply(right(before + 100)); // Past the wrap
+    predictor.reconcile(snapshotAt(100.F), before);
+    EXPECT_EQ(predictor.pending(), 1U);
+    EXPECT_FLOAT_EQ(predictor.state()->x, 100.F + rnp::PLAYER_SPEED * STEP);
+}
+
+TEST(prediction, smallErrorSmoothedOut)
+{
+    eng::InputPredictor predictor(simulate);
+    predictor.setEntity(ENTITY);
+    predictor.apply(right(100));
+    predictor.reconcile(snapshotAt(100.F), 100);
+    ASSERT_FLOAT_EQ(predictor.state()->x, 100.F);
+
+    // The server has it 10 units behind: still displayed where it was, then eased towards the server
+    predictor.reconcile(snapshotAt(90.F), 100);
+    EXPECT_FLOAT_EQ(predictor.state()->x, 100.F);
+    predictor.apply(right(200));
+    const float decay = std::exp(-STEP / std::chrono::duration<float>(eng::CORRECTION_TIME).count());
+    EXPECT_NEAR(predictor.state()->x, 90.F + rnp::PLAYER_SPEED * STEP + 10.F * decay, 1e-3F);
+}
+
+TEST(prediction, largeErrorSnapped)
+{
+    eng::InputPredictor predictor(simulate);
+    predictor.setEntity(ENTITY);
+    predictor.apply(right(100));
+    predictor.reconcile(snapshotAt(100.F), 100);
+
+    predictor.reconcile(snapshotAt(100.F + eng::MAX_SMOOTHED_CORRECTION + 1.F), 100);
+    EXPECT_FLOAT_EQ(predictor.state()->x, 100.F + eng::MAX_SMOOTHED_CORRECTION + 1.F);
+}
+
+TEST(prediction, oldestInputDroppedWhenFull)
+{
+    eng::InputPredictor predictor(simulate);
+    predictor.setEntity(ENTITY);
+    for (std::uint32_t i = 1; i <= eng::InputPredictor::HISTORY + 2; ++i)
+    {
+        predictor.apply({.clientTimeMs = i, .direction = RIGHT, .shooting = 0, .dt = 0.001F});
+    }
+    EXPECT_EQ(predictor.pending(), eng::InputPredictor::HISTORY);
+    // The snapshot acknowledges none of the kept inputs: all of them are replayed
+    predictor.reconcile(snapshotAt(100.F), 2);
+    EXPECT_EQ(predictor.pending(), eng::InputPredictor::HISTORY);
+    EXPECT_NEAR(predictor.state()->x, 100.F + rnp::PLAYER_SPEED * 0.001F * eng::InputPredictor::HISTORY, 1e-2F);
+
+    // Another entity starts from scratch
+    predictor.setEntity(ENTITY + 1);
+    EXPECT_EQ(predictor.pending(), 0U);
+    EXPECT_EQ(predictor.state(), std::nullopt);
+}
@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstddef>
+
+#include "AsioServer/RateLimit.hpp"
+
+namespace
+{
+
+    using namespace std::chrono_literals;
+    using Clock = srv::TokenBucket::Clock;
+
+    const Clock::time_point START = Clock::time_point{} + 1h;
+    constexpr auto UNKNOWN_BURST = static_cast<std::size_t>(srv::UNKNOWN_PACKET_BURST);
+
+    ///
+    /// @brief Packets admitted out of count sent at the same instant
+    ///
+    std::size_t admitted(srv::TokenBucket &bucket, const std::size_t count, const Clock::time_point now)
+    {
+        std::size_t passed = 0;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            passed += bucket.consume(now) ? 1U : 0U;
+        }
+        return passed;
+    }
+
+} // namespace
+
+TEST(rateLimit, burstThenRefill)
+{
+    srv::TokenBucket bucket(srv::UNKNOWN_PACKET_RATE, srv::UNKNOWN_PACKET_BURST);
+    EXPECT_EQ(admitted(bucket, 100, START), UNKNOWN_BURST);
+
+    // 10 per second: a token every 100 ms, none before
+    EXPECT_FALSE(bucket.consume(START + 99ms));
+    EXPECT_TRUE(bucket.consume(START + 100ms + 1ms));
+    EXPECT_FALSE(bucket.consume(START + 101ms));
+    EXPECT_EQ(admitted(bucket, 100, START + 601ms), 5U);
+}
+
+TEST(rateLimit, idleCappedAtBurst)
+{
+    srv::TokenBucket bucket(srv::UNKNOWN_PACKET_RATE, srv::UNKNOWN_PACKET_BURST);
+    EXPECT_EQ(admitted(bucket, 5, START), 5U);
+    // An hour of silence saves no more than a burst
+    EXPECT_EQ(admitted(bucket, 100, START + 1h), UNKNOWN_BURST);
+
+    // The session defaults allow the recommended rate twice over, and a burst on top
+    srv::TokenBucket session;
+    EXPECT_EQ(admitted(session, 1000, START), static_cast<std::size_t>(srv::SESSION_PACKET_BURST));
+    std::size_t passed = 0;
+    for (std::chrono::milliseconds at = 1ms; at <= 1s; at += 1ms)
+    {
+        passed += admitted(session, 1, START + at);
+    }
+    EXPECT_NEAR(static_cast<double>(passed), srv::SESSION_PACKET_RATE, 1.0);
+}
+
+TEST(rateLimit, addressesShareTheirSlot)
+{
+    srv::AddressBuckets buckets;
+    constexpr std::size_t address = 12345;
+    for (std::size_t i = 0; i < UNKNOWN_BURST / 2; ++i)
+    {
+        EXPECT_TRUE(buckets.consume(address, START));
+        EXPECT_TRUE(buckets.consume(address + srv::AddressBuckets::SLOTS, START)); // Same slot, same budget
+    }
+    EXPECT_FALSE(buckets.consume(address, START));
+    EXPECT_FALSE(buckets.consume(address + 3 * srv::AddressBuckets::SLOTS, START));
+
+    // Any other slot still has its own burst
+    for (std::size_t i = 0; i < UNKNOWN_BURST; ++i)
+    {
+        EXPECT_TRUE(buckets.consume(address + 1, START));
+    }
+    EXPECT_FALSE(buckets.consume(address + 1, START));
+    EXPECT_TRUE(buckets.consume(address, START + 101ms));
+}
@@ -0,0 +1,319 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "Interfaces/Protocol/Buffer.hpp"
+#include "Interfaces/Protocol/Channel.hpp"
+#include "Interfaces/Protocol/PacketView.hpp"
+#include "Interfaces/Protocol/Reliability.hpp"
+
+namespace
+{
+
+    using Clock = std::chrono::steady_clock;
+    using Datagram = std::vector<std::uint8_t>;
+
+    ///
+    /// @brief RELIABLE datagram of one payload byte, on the channel of its type
+    ///
+    Datagram reliableDatagram(rnp::ChannelSender &channels, const rnp::PacketType type, const std::uint32_t sequence)
+    {
+        constexpr auto FLAGS = static_cast<std::uint16_t>(static_cast<std::uint16_t>(rnp::PacketFlags::RELIABLE) |
+                                                          static_cast<std::uint16_t>(rnp::PacketFlags::ACK_REQ));
+        Datagram datagram(rnp::HEADER_SIZE + 1, static_cast<std::uint8_t>(sequence));
+        const rnp::PacketHeader header{.type = static_cast<std::uint8_t>(type),
+                                       .length = 1,
+                                       .flags = FLAGS,
+                                       .channel = channels.stamp(rnp::channelFor(type, FLAGS)),
+                                       .sequence = sequence,
+                                       .sessionId = 1};
+        rnp::BufferWriter writer(std::span<std::uint8_t>(datagram).first(rnp::HEADER_SIZE));
+        rnp::write(writer, header);
+        return datagram;
+    }
+
+    rnp::PacketHeader headerOf(const std::span<const std::uint8_t> datagram)
+    {
+        rnp::BufferReader reader(datagram);
+        rnp::PacketHeader header{};
+        EXPECT_TRUE(rnp::read(reader, header));
+        return header;
+    }
+
+    ///
+    /// @brief Receiving end of a session: acknowledges what it admits, delivers ordered messages in order
+    ///
+    struct Receiver
+    {
+            rnp::ReceiveWindow window;
+            rnp::ChannelReceiver channels;
+            std::vector<std::uint8_t> delivered; // Payload bytes, in delivery order
+            std::vector<std::uint8_t> held;
+
+            template <std::size_t Capacity>
+            void receive(const std::span<const std::uint8_t> datagram, rnp::ReliableSender<Capacity> &sender,
+                         const Clock::time_point now)
+            {
+                rnp::PacketHeader header = headerOf(datagram);
+                if (!channels.admits(header) || !window.receive(header))
+                {
+                    return;
+                }
+                window.flushAcks([&sender, now](const rnp::PacketAck &ack) { sender.acknowledge(ack, now); });
+                const std::span<const std::uint8_t> payload = datagram.subspan(rnp::HEADER_SIZE);
+                if (channels.receive(header, payload) != rnp::ChannelReceiver::Delivery::DELIVER)
+                {
+                    return;
+                }
+                delivered.push_back(payload.front());
+                while (channels.popReady(header, held))
+                {
+                    delivered.push_back(held.front());
+                }
+            }
+    };
+
+} // namespace
+
+TEST(reliability, orderedMessageOutlivesRetransmitLimit)
+{
+    rnp::ChannelSender channels;
+    rnp::ReliableSender<8> sender;
+    Receiver receiver;
+    Clock::time_point now{};
+
+    // The first SPAWN batch is lost on every attempt, the next two arrive and wait behind it
+    for (std::uint32_t sequence = 1; sequence <= 3; ++sequence)
+    {
+        const Datagram datagram = reliableDatagram(channels, rnp::PacketType::ENTITY_EVENT, sequence);
+        ASSERT_EQ(sender.track(sequence, datagram, now), rnp::ReliableSender<8>::Track::SEND);
+        if (sequence != 1)
+        {
+            receiver.receive(datagram, sender, now);
+        }
+    }
+    EXPECT_TRUE(receiver.delivered.empty());
+
+    std::size_t resent = 0;
+    for (std::size_t pass = 0; pass <= rnp::MAX_RETRANSMITS; ++pass)
+    {
+        now += rnp::MAX_RETRANSMIT_TIMEOUT;
+        EXPECT_EQ(sender.retransmit(now, [&resent](std::span<const std::uint8_t>) { ++resent; }), 0U);
+    }
+    EXPECT_EQ(resent, rnp::MAX_RETRANSMITS + 1U);
+    EXPECT_TRUE(sender.stalled());
+
+    // Still kept: the next retransmission gets through and releases the held messages in order
+    now += rnp::MAX_RETRANSMIT_TIMEOUT;
+    Datagram retransmitted;
+    (void)sender.retransmit(now, [&retransmitted](const std::span<const std::uint8_t> datagram)
+                            { retransmitted.assign(datagram.begin(), datagram.end()); });
+    receiver.receive(retransmitted, sender, now);
+    EXPECT_EQ(receiver.delivered, (std::vector<std::uint8_t>{1, 2, 3}));
+
+    now += rnp::MAX_RETRANSMIT_TIMEOUT;
+    resent = 0;
+    (void)sender.retransmit(now, [&resent](std::span<const std::uint8_t>) { ++resent; });
+    EXPECT_EQ(resent, 0U);
+}
+
+TEST(reliability, unorderedMessageGivenUp)
+{
+    rnp::ChannelSender channels;
+    rnp::ReliableSender<8> sender;
+    Clock::time_point now{};
+    ASSERT_EQ(sender.track(1, reliableDatagram(channels, rnp::PacketType::CONNECT, 1), now),
+              rnp::ReliableSender<8>::Track::SEND);
+
+    std::size_t lost = 0;
+    for (std::size_t pass = 0; pass <= rnp::MAX_RETRANSMITS; ++pass)
+    {
+        now += rnp::MAX_RETRANSMIT_TIMEOUT;
+        lost += sender.retransmit(now, [](std::span<const std::uint8_t>) {});
+    }
+    EXPECT_EQ(lost, 1U);
+    EXPECT_FALSE(sender.stalled());
+}
+
+TEST(reliability, backlogAppliesBackPressure)
+{
+    using Sender = rnp::ReliableSender<2>;
+    rnp::ChannelSender channels;
+    Sender sender;
+    const Clock::time_point now{};
+    std::array<Datagram, 5> datagrams;
+    for (std::uint32_t sequence = 1; sequence <= datagrams.size(); ++sequence)
+    {
+        datagrams[sequence - 1] = reliableDatagram(channels, rnp::PacketType::ENTITY_EVENT, sequence);
+    }
+
+    EXPECT_EQ(sender.track(1, datagrams[0], now), Sender::Track::SEND);
+    EXPECT_EQ(sender.track(2, datagrams[1], now), Sender::Track::SEND);
+    EXPECT_EQ(sender.track(3, datagrams[2], now), Sender::Track::QUEUED);
+    EXPECT_EQ(sender.track(4, datagrams[3], now), Sender::Track::QUEUED);
+    EXPECT_EQ(sender.backlog(), 2U);
+
+    // An ACK frees a slot, the oldest backlogged datagram leaves first
+    sender.acknowledge({.cumulativeAck = 1, .ackBits = 0}, now);
+    std::vector<std::uint32_t> sent;
+    (void)sender.retransmit(now, [&sent](const std::span<const std::uint8_t> datagram)
+                            { sent.push_back(headerOf(datagram).sequence); });
+    EXPECT_EQ(sent, (std::vector<std::uint32_t>{3}));
+    EXPECT_EQ(sender.backlog(), 1U);
+    EXPECT_FALSE(sender.stalled());
+
+    EXPECT_EQ(sender.track(5, datagrams[4], now), Sender::Track::QUEUED);
+    EXPECT_EQ(sender.track(6, datagrams[4], now), Sender::Track::FULL);
+    EXPECT_TRUE(sender.stalled());
+
+    sender.clear();
+    EXPECT_FALSE(sender.stalled());
+    EXPECT_EQ(sender.track(7, datagrams[0], now), Sender::Track::SEND);
+}
+
+namespace rnp
+{
+
+    // Field by field, for the assertions
+    bool operator==(const PacketAck &a, const PacketAck &b)
+    {
+        return a.cumulativeAck == b.cumulativeAck && a.ackBits == b.ackBits;
+    }
+
+} // namespace rnp
+
+namespace
+{
+
+    rnp::PacketHeader receivedHeader(const std::uint32_t sequence, const rnp::PacketFlags flags)
+    {
+        return {.type = static_cast<std::uint8_t>(rnp::PacketType::ENTITY_EVENT),
+                .length = 0,
+                .flags = static_cast<std::uint16_t>(flags),
+                .channel = 0,
+                .sequence = sequence,
+                .sessionId = 1};
+    }
+
+    std::vector<rnp::PacketAck> flush(rnp::ReceiveWindow &window)
+    {
+        std::vector<rnp::PacketAck> acks;
+        window.flushAcks([&acks](const rnp::PacketAck &ack) { acks.push_back(ack); });
+        return acks;
+    }
+
+} // namespace
+
+TEST(reliability, sackDecoding)
+{
+    const rnp::PacketAck ack{.cumulativeAck = 100, .ackBits = 0b101};
+    EXPECT_TRUE(rnp::isAcknowledged(ack, 100));
+    EXPECT_TRUE(rnp::isAcknowledged(ack, 99));
+    EXPECT_FALSE(rnp::isAcknowledged(ack, 98));
+    EXPECT_TRUE(rnp::isAcknowledged(ack, 97));
+    EXPECT_FALSE(rnp::isAcknowledged(ack, 101));
+
+    const rnp::PacketAck full{.cumulativeAck = 5, .ackBits = 1U << (rnp::ACK_WINDOW - 1)};
+    EXPECT_TRUE(rnp::isAcknowledged(full, 5 - rnp::ACK_WINDOW)); // Across the wraparound
+    EXPECT_FALSE(rnp::isAcknowledged(full, 5 - rnp::ACK_WINDOW - 1));
+}
+
+TEST(reliability, windowShifting)
+{
+    rnp::ReceiveWindow window;
+    EXPECT_TRUE(window.receive(receivedHeader(10, rnp::PacketFlags::ACK_REQ)));
+    EXPECT_TRUE(window.receive(receivedHeader(12, rnp::PacketFlags::ACK_REQ)));
+    EXPECT_EQ(flush(window), (std::vector<rnp::PacketAck>{{.cumulativeAck = 12, .ackBits = 0b10}}));
+
+    // A gap of exactly the window keeps the previous latest in the last bit, a larger one forgets it
+    EXPECT_TRUE(window.receive(receivedHeader(12 + rnp::ACK_WINDOW, rnp::PacketFlags::ACK_REQ)));
+    EXPECT_EQ(flush(window).front().ackBits, 1U << (rnp::ACK_WINDOW - 1));
+    EXPECT_TRUE(window.receive(receivedHeader(13 + 2 * rnp::ACK_WINDOW, rnp::PacketFlags::ACK_REQ)));
+    EXPECT_EQ(flush(window).front().ackBits, 0U);
+    EXPECT_TRUE(flush(window).empty());
+}
+
+TEST(reliability, duplicateAndOldSequences)
+{
+    rnp::ReceiveWindow window;
+    EXPECT_TRUE(window.receive(receivedHeader(100, rnp::PacketFlags::ACK_REQ)));
+    EXPECT_FALSE(window.receive(receivedHeader(100, rnp::PacketFlags::ACK_REQ)));
+    EXPECT_TRUE(window.receive(receivedHeader(98, rnp::PacketFlags::ACK_REQ)));
+    EXPECT_FALSE(window.receive(receivedHeader(98, rnp::PacketFlags::ACK_REQ)));
+
+    // Behind the window: acknowledged on its own, and a reliable one is still handled only once
+    EXPECT_TRUE(window.receive(receivedHeader(150, rnp::PacketFlags::NONE)));
+    (void)flush(window);
+    EXPECT_TRUE(window.receive(receivedHeader(90, rnp::PacketFlags::RELIABLE)));
+    EXPECT_FALSE(window.receive(receivedHeader(90, rnp::PacketFlags::RELIABLE)));
+    EXPECT_TRUE(window.receive(receivedHeader(91, rnp::PacketFlags::ACK_REQ)));
+    const std::vector<rnp::PacketAck> acks = flush(window);
+    ASSERT_EQ(acks.size(), 2U);
+    EXPECT_EQ(acks[0].cumulativeAck, 150U);
+    EXPECT_EQ(acks[1], (rnp::PacketAck{.cumulativeAck = 91, .ackBits = 0}));
+}
+
+TEST(reliability, piggybackSettlesOwedAcks)
+{
+    rnp::ReceiveWindow window;
+    EXPECT_FALSE(window.piggyback());
+    EXPECT_TRUE(window.receive(receivedHeader(200, rnp::PacketFlags::ACK_REQ)));
+    EXPECT_TRUE(window.receive(receivedHeader(201, rnp::PacketFlags::ACK_REQ)));
+
+    const std::optional<rnp::PacketAck> ack = window.piggyback();
+    ASSERT_TRUE(ack);
+    EXPECT_EQ(*ack, (rnp::PacketAck{.cumulativeAck = 201, .ackBits = 1}));
+    EXPECT_FALSE(window.ackOwed());
+    EXPECT_TRUE(flush(window).empty());
+
+    // A sequence behind the window still needs its standalone ACK
+    EXPECT_TRUE(window.receive(receivedHeader(100, rnp::PacketFlags::ACK_REQ)));
+    EXPECT_TRUE(window.piggyback());
+    EXPECT_EQ(flush(window), (std::vector<rnp::PacketAck>{{.cumulativeAck = 201, .ackBits = 1},
+                                                          {.cumulativeAck = 100, .ackBits = 0}}));
+}
+
+TEST(reliability, piggybackedAckParsed)
+{
+    rnp::ChannelSender channels;
+    Datagram datagram = reliableDatagram(channels, rnp::PacketType::ENTITY_EVENT, 7);
+    datagram[4] |= static_cast<std::uint8_t>(rnp::PacketFlags::PIGGYBACK_ACK); // Low byte of the flags
+    EXPECT_FALSE(rnp::PacketView::parse(datagram));
+
+    datagram.resize(datagram.size() + rnp::WIRE_SIZE<rnp::PacketAck>);
+    rnp::BufferWriter writer(std::span<std::uint8_t>(datagram).last(rnp::WIRE_SIZE<rnp::PacketAck>));
+    rnp::write(writer, rnp::PacketAck{.cumulativeAck = 42, .ackBits = 0b11});
+    const std::optional<rnp::PacketView> packet = rnp::PacketView::parse(datagram);
+    ASSERT_TRUE(packet);
+    EXPECT_EQ(packet->payload().size(), 1U);
+    ASSERT_TRUE(packet->ack());
+    EXPECT_EQ(*packet->ack(), (rnp::PacketAck{.cumulativeAck = 42, .ackBits = 0b11}));
+}
+
+TEST(reliability, backoffBounds)
+{
+    rnp::RttEstimator rtt;
+    EXPECT_EQ(rtt.timeout(), rnp::MIN_RETRANSMIT_TIMEOUT);
+    EXPECT_EQ(rtt.timeout(1), 2 * rnp::MIN_RETRANSMIT_TIMEOUT);
+    EXPECT_EQ(rtt.timeout(rnp::MAX_RETRANSMITS), rnp::MAX_RETRANSMIT_TIMEOUT);
+    EXPECT_EQ(rtt.timeout(255), rnp::MAX_RETRANSMIT_TIMEOUT);
+
+    // A fast link is still held to the minimum, a slow one to the maximum
+    rtt.sample(std::chrono::milliseconds(1));
+    EXPECT_EQ(rtt.timeout(), rnp::MIN_RETRANSMIT_TIMEOUT);
+    rnp::RttEstimator slow;
+    slow.sample(std::chrono::seconds(5));
+    EXPECT_EQ(slow.timeout(), rnp::MAX_RETRANSMIT_TIMEOUT);
+
+    // RFC 6298: SRTT + 4 * RTTVAR, the first sample setting RTTVAR to half of it
+    rnp::RttEstimator typical;
+    typical.sample(std::chrono::milliseconds(100));
+    EXPECT_EQ(typical.smoothed(), std::chrono::milliseconds(100));
+    EXPECT_EQ(typical.timeout(), std::chrono::milliseconds(300));
+    EXPECT_EQ(typical.timeout(2), std::chrono::milliseconds(1200));
+}
@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <set>
+#include <span>
+#include <vector>
+
+#include "AsioServer/Replication.hpp"
+#include "Interfaces/Protocol/Protocol.hpp"
+#include "Interfaces/Protocol/Quantization.hpp"
+
+namespace
+{
+
+    constexpr std::uint32_t ENTITIES = 10;
+    const rnp::EntityStateCodec PLAIN(false);
+
+    rnp::EntityState entity(const std::uint32_t id, const rnp::EntityType type, const float x, const float y = 0.F)
+    {
+        return {.id = id,
+                .type = static_cast<std::uint16_t>(type),
+                .x = x,
+                .y = y,
+                .vx = 0.F,
+                .vy = 0.F,
+                .stateFlags = 0};
+    }
+
+    ///
+    /// @brief ENTITIES obstacles, every one of them moved since the previous tick
+    ///
+    std::vector<rnp::EntityState> worldAt(const std::uint32_t tick)
+    {
+        std::vector<rnp::EntityState> world;
+        for (std::uint32_t id = 1; id <= ENTITIES; ++id)
+        {
+            world.push_back(entity(id, rnp::EntityType::OBSTACLE, static_cast<float>(tick)));
+        }
+        return world;
+    }
+
+    ///
+    /// @brief Plan and send a whole tick against what the client rebuilt at the previous one
+    /// @return the ids sent
+    ///
+    std::set<std::uint32_t> replicate(srv::ClientReplication &replication, const std::uint32_t tick,
+                                      const std::size_t budgetBits)
+    {
+        const std::vector<rnp::EntityState> current = worldAt(tick);
+        const std::span<const rnp::EntityState> baseline =
+            replication.find(tick - 1).value_or(std::span<const rnp::EntityState>{});
+        replication.plan(baseline, current, PLAIN, budgetBits, std::nullopt);
+        std::set<std::uint32_t> sent;
+        for (const srv::ClientReplication::Record &record : replication.records())
+        {
+            sent.insert(current[record.index].id);
+        }
+        replication.commit(tick, baseline, current, replication.removed().size(), replication.records().size());
+        return sent;
+    }
+
+} // namespace
+
+TEST(replication, gainByTypeNewnessAndDistance)
+{
+    EXPECT_FLOAT_EQ(srv::priorityGain(entity(1, rnp::EntityType::PLAYER, 0.F), false, std::nullopt), 4.F);
+    EXPECT_FLOAT_EQ(srv::priorityGain(entity(1, rnp::EntityType::PROJECTILE, 0.F), false, std::nullopt), 3.F);
+    EXPECT_FLOAT_EQ(srv::priorityGain(entity(1, rnp::EntityType::ENEMY, 0.F), false, std::nullopt), 2.F);
+    EXPECT_FLOAT_EQ(srv::priorityGain(entity(1, rnp::EntityType::OBSTACLE, 0.F), false, std::nullopt), 1.F);
+    EXPECT_FLOAT_EQ(srv::priorityGain(entity(1, rnp::EntityType::ENEMY, 0.F), true, std::nullopt), 4.F);
+
+    const std::optional<std::array<float, 2>> focus = std::array{100.F, 100.F};
+    EXPECT_FLOAT_EQ(srv::priorityGain(entity(1, rnp::EntityType::ENEMY, 100.F, 100.F), false, focus), 2.F);
+    EXPECT_FLOAT_EQ(
+        srv::priorityGain(entity(1, rnp::EntityType::ENEMY, 100.F + srv::PRIORITY_DISTANCE_SCALE, 100.F), false, focus),
+        1.F);
+}
+
+TEST(replication, leftOutAccumulateSentReset)
+{
+    // Room for two new entities per snapshot
+    const std::size_t newRecordBits = PLAIN.idBits(1, 0) + PLAIN.recordBits(rnp::EntityStateFields::ALL);
+    const std::size_t budgetBits = 2 * newRecordBits;
+    srv::ClientReplication replication;
+
+    // Every tick the two sent drop back to zero while the others keep growing: each goes once, none starves
+    std::set<std::uint32_t> everSent;
+    std::array<std::set<std::uint32_t>, ENTITIES / 2> sentAt;
+    for (std::uint32_t tick = 1; tick <= ENTITIES / 2; ++tick)
+    {
+        sentAt[tick - 1] = replicate(replication, tick, budgetBits);
+        ASSERT_EQ(sentAt[tick - 1].size(), 2U) << tick;
+        for (const std::uint32_t id : sentAt[tick - 1])
+        {
+            EXPECT_TRUE(everSent.insert(id).second) << "entity " << id << " sent twice by tick " << tick;
+        }
+    }
+    EXPECT_EQ(everSent.size(), ENTITIES);
+    ASSERT_TRUE(replication.find(ENTITIES / 2).has_value());
+    EXPECT_EQ(replication.find(ENTITIES / 2)->size(), ENTITIES);
+
+    // Only their x changes now: smaller records, the longest waiting first
+    const std::set<std::uint32_t> next = replicate(replication, ENTITIES / 2 + 1, budgetBits);
+    const std::uint8_t moved = PLAIN.diff(worldAt(1).front(), worldAt(2).front());
+    const std::size_t movedRecordBits = PLAIN.idBits(1, 0) + PLAIN.recordBits(moved);
+    EXPECT_EQ(next.size(), budgetBits / movedRecordBits);
+    for (const std::uint32_t id : sentAt[0])
+    {
+        EXPECT_TRUE(next.contains(id)) << id;
+    }
+    for (const std::uint32_t id : sentAt[1])
+    {
+        EXPECT_TRUE(next.contains(id)) << id;
+    }
+    for (const std::uint32_t id : sentAt.back())
+    {
+        EXPECT_FALSE(next.contains(id)) << id;
+    }
+}
+
+TEST(replication, removalsAlwaysKept)
+{
+    srv::ClientReplication replication;
+    replicate(replication, 1, 1'000'000);
+    // Entity 1 removed, the others unchanged: nothing but the removal, even without any budget
+    std::vector<rnp::EntityState> current = worldAt(1);
+    current.erase(current.begin());
+    const std::span<const rnp::EntityState> baseline = *replication.find(1);
+    replication.plan(baseline, current, PLAIN, 0, std::nullopt);
+    EXPECT_TRUE(std::ranges::equal(replication.removed(), std::vector<std::uint32_t>{1}));
+    EXPECT_TRUE(replication.records().empty());
+    replication.commit(2, baseline, current, 1, 0);
+    ASSERT_TRUE(replication.find(2).has_value());
+    EXPECT_EQ(replication.find(2)->size(), ENTITIES - 1);
+    EXPECT_EQ(replication.find(2)->front().id, 2U);
+    EXPECT_FALSE(replication.find(3).has_value());
+    EXPECT_FALSE(replication.find(0).has_value());
+}
@@ -0,0 +1,176 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "Utils/MpscRing.hpp"
+#include "Utils/SpscRing.hpp"
+
+namespace
+{
+
+    constexpr std::size_t CAPACITY = 4;
+    constexpr std::uint32_t STRESS_VALUES = 200'000;
+    constexpr std::size_t PRODUCERS = 4;
+
+} // namespace
+
+TEST(rings, spscFullEmptyAndWraparound)
+{
+    utl::SpscRing<std::vector<int>, CAPACITY> ring;
+    EXPECT_EQ(ring.front(), nullptr);
+
+    // Several laps, every other one leaving a value behind so that the ring's start moves round
+    int next = 0;
+    int expected = 0;
+    for (std::size_t lap = 0; lap < 3 * CAPACITY; ++lap)
+    {
+        for (std::vector<int> *cell = ring.claim(); cell != nullptr; cell = ring.claim())
+        {
+            cell->assign(100, next++); // A cell coming back round still holds its buffer
+            ring.commit();
+        }
+        EXPECT_EQ(ring.claim(), nullptr);
+        const std::size_t taken = lap % 2 == 0 ? CAPACITY - 1 : CAPACITY;
+        for (std::size_t i = 0; i < taken; ++i)
+        {
+            std::vector<int> *cell = ring.front();
+            ASSERT_NE(cell, nullptr);
+            ASSERT_EQ(cell->size(), 100U);
+            EXPECT_EQ(cell->front(), expected++);
+            ring.pop();
+        }
+    }
+    EXPECT_EQ(next, expected);
+    EXPECT_EQ(ring.front(), nullptr);
+    ASSERT_NE(ring.claim(), nullptr);
+    EXPECT_GE(ring.claim()->capacity(), 100U);
+}
+
+TEST(rings, spscAcrossThreads)
+{
+    utl::SpscRing<std::uint32_t, CAPACITY> ring;
+    std::thread producer(
+        [&ring]
+        {
+            for (std::uint32_t value = 0; value < STRESS_VALUES; ++value)
+            {
+                std::uint32_t *cell = ring.claim();
+                while (cell == nullptr)
+                {
+                    std::this_thread::yield();
+                    cell = ring.claim();
+                }
+                *cell = value;
+                ring.commit();
+            }
+        });
+
+    std::vector<std::uint32_t> received;
+    while (received.size() < STRESS_VALUES)
+    {
+        const std::uint32_t *cell = ring.front();
+        if (cell == nullptr)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        received.push_back(*cell);
+        ring.pop();
+    }
+    producer.join();
+    EXPECT_EQ(ring.front(), nullptr);
+    for (std::uint32_t value = 0; value < STRESS_VALUES; ++value)
+    {
+        ASSERT_EQ(received[value], value);
+    }
+}
+
+TEST(rings, mpscFullEmptyAndWraparound)
+{
+    utl::MpscRing<std::unique_ptr<int>, CAPACITY> ring;
+    std::unique_ptr<int> value;
+    EXPECT_FALSE(ring.tryPop(value));
+
+    int next = 0;
+    int expected = 0;
+    for (std::size_t lap = 0; lap < 3 * CAPACITY; ++lap)
+    {
+        for (std::size_t i = 0; i < CAPACITY; ++i)
+        {
+            std::unique_ptr<int> pushed = std::make_unique<int>(next);
+            if (!ring.tryPush(std::move(pushed)))
+            {
+                ASSERT_NE(pushed, nullptr); // Refused, not taken
+                break;
+            }
+            ++next;
+        }
+        std::unique_ptr<int> extra = std::make_unique<int>(-1);
+        EXPECT_FALSE(ring.tryPush(std::move(extra)));
+        EXPECT_NE(extra, nullptr);
+
+        const std::size_t taken = lap % 2 == 0 ? CAPACITY - 1 : CAPACITY;
+        for (std::size_t i = 0; i < taken; ++i)
+        {
+            ASSERT_TRUE(ring.tryPop(value));
+            ASSERT_NE(value, nullptr);
+            EXPECT_EQ(*value, expected++);
+        }
+    }
+    EXPECT_EQ(next, expected);
+    EXPECT_FALSE(ring.tryPop(value));
+}
+
+TEST(rings, mpscManyProducers)
+{
+    // Every value pushed once and popped once, each producer's in the order it pushed them
+    utl::MpscRing<std::uint64_t, CAPACITY * 4> ring;
+    std::vector<std::thread> producers;
+    for (std::uint64_t producer = 0; producer < PRODUCERS; ++producer)
+    {
+        producers.emplace_back(
+            [&ring, producer]
+            {
+                for (std::uint64_t value = 0; value < STRESS_VALUES; ++value)
+                {
+                    std::uint64_t tagged = producer << 32U | value;
+                    while (!ring.tryPush(std::move(tagged)))
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+    }
+
+    std::vector<std::uint64_t> received;
+    std::uint64_t value = 0;
+    while (received.size() < PRODUCERS * STRESS_VALUES)
+    {
+        if (ring.tryPop(value))
+        {
+            received.push_back(value);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+    for (std::thread &producer : producers)
+    {
+        producer.join();
+    }
+    EXPECT_FALSE(ring.tryPop(value));
+
+    std::array<std::uint64_t, PRODUCERS> nextOf{};
+    for (const std::uint64_t tagged : received)
+    {
+        const std::uint64_t producer = tagged >> 32U;
+        ASSERT_LT(producer, PRODUCERS);
+        ASSERT_EQ(tagged & 0xFFFF'FFFFU, nextOf[producer]++) << "producer " << producer;
+    }
+}
@@ -0,0 +1,205 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "AsioServer/SessionTable.hpp"
+#include "AsioServer/TimingWheel.hpp"
+
+namespace
+{
+
+    using namespace std::chrono_literals;
+
+    struct Session
+    {
+            std::uint32_t sessionId;
+            std::string name;
+    };
+
+    using Table = srv::SessionTable<std::string, Session>;
+    using Clock = srv::TimingWheel::Clock;
+
+    Session *add(Table &table, const std::string &endpoint)
+    {
+        return table.emplace(endpoint, [&endpoint](const std::uint32_t sessionId)
+                             { return Session{.sessionId = sessionId, .name = endpoint}; });
+    }
+
+    std::string endpointOf(const std::size_t index) { return "10.0.0." + std::to_string(index) + ":4567"; }
+
+    ///
+    /// @brief Advance the wheel in steps of the resolution up to until, recording when each id is handed
+    ///
+    void run(srv::TimingWheel &wheel, const Clock::time_point start, const Clock::time_point until,
+             std::map<std::uint32_t, std::vector<Clock::duration>> &handed)
+    {
+        for (Clock::time_point now = start; now <= until; now += srv::TimingWheel::RESOLUTION)
+        {
+            wheel.advance(now, [&handed, now, start](const std::uint32_t id) { handed[id].push_back(now - start); });
+        }
+    }
+
+} // namespace
+
+TEST(sessions, idCarriesSlot)
+{
+    Table table;
+    const Session *first = add(table, endpointOf(1));
+    const Session *second = add(table, endpointOf(2));
+    ASSERT_NE(first, nullptr);
+    ASSERT_NE(second, nullptr);
+    EXPECT_NE(first->sessionId, 0U);
+    EXPECT_NE(first->sessionId & Table::SLOT_MASK, second->sessionId & Table::SLOT_MASK);
+
+    EXPECT_EQ(table.find(first->sessionId), first);
+    EXPECT_EQ(table.find(endpointOf(2)), second);
+    EXPECT_EQ(table.find(first->sessionId, endpointOf(1)), first);
+    // The right id from another endpoint, or a guessed id in the right slot
+    EXPECT_EQ(table.find(first->sessionId, endpointOf(2)), nullptr);
+    EXPECT_EQ(table.find(first->sessionId ^ ~Table::SLOT_MASK), nullptr);
+    EXPECT_EQ(table.find(endpointOf(3)), nullptr);
+    EXPECT_EQ(table.size(), 2U);
+}
+
+TEST(sessions, slotReusedWithNewId)
+{
+    Table table;
+    const std::uint32_t oldId = add(table, endpointOf(0))->sessionId;
+    ASSERT_TRUE(table.erase(endpointOf(0)));
+    EXPECT_FALSE(table.erase(endpointOf(0)));
+    EXPECT_EQ(table.find(oldId), nullptr);
+
+    // The search for a free slot goes around before coming back to the first one
+    for (std::size_t i = 1; i < srv::MAX_SESSIONS; ++i)
+    {
+        ASSERT_NE(add(table, endpointOf(i)), nullptr);
+    }
+    const Session *reused = add(table, "192.168.0.1:4567");
+    ASSERT_NE(reused, nullptr);
+    EXPECT_EQ(reused->sessionId & Table::SLOT_MASK, oldId & Table::SLOT_MASK);
+    EXPECT_NE(reused->sessionId, oldId);
+    EXPECT_EQ(table.find(oldId), nullptr);
+    EXPECT_EQ(table.find(reused->sessionId), reused);
+}
+
+TEST(sessions, emplaceReplacesSessionOfEndpoint)
+{
+    Table table;
+    const std::uint32_t oldId = add(table, endpointOf(1))->sessionId;
+    add(table, endpointOf(2));
+    const Session *replacement = add(table, endpointOf(1));
+    ASSERT_NE(replacement, nullptr);
+    EXPECT_NE(replacement->sessionId, oldId);
+
+    // The endpoint index follows the new session, the old id finds nothing
+    EXPECT_EQ(table.size(), 2U);
+    EXPECT_TRUE(table.contains(endpointOf(1)));
+    EXPECT_EQ(table.find(endpointOf(1)), replacement);
+    EXPECT_EQ(table.find(replacement->sessionId, endpointOf(1)), replacement);
+    EXPECT_EQ(table.find(oldId), nullptr);
+    EXPECT_EQ(table.find(oldId, endpointOf(1)), nullptr);
+
+    ASSERT_TRUE(table.erase(endpointOf(1)));
+    EXPECT_EQ(table.find(replacement->sessionId), nullptr);
+    EXPECT_EQ(table.size(), 1U);
+}
+
+TEST(sessions, fullTable)
+{
+    Table table;
+    for (std::size_t i = 0; i < srv::MAX_SESSIONS; ++i)
+    {
+        ASSERT_NE(add(table, endpointOf(i)), nullptr);
+    }
+    EXPECT_EQ(add(table, "192.168.0.1:4567"), nullptr);
+    // An endpoint already in the table gives its own slot up first
+    EXPECT_NE(add(table, endpointOf(7)), nullptr);
+    EXPECT_EQ(table.size(), srv::MAX_SESSIONS);
+
+    // Iteration visits each session once, erased ones no longer
+    table.erase(endpointOf(3));
+    std::set<std::string> visited;
+    for (const Session &session : table)
+    {
+        EXPECT_TRUE(visited.insert(session.name).second);
+    }
+    EXPECT_EQ(visited.size(), srv::MAX_SESSIONS - 1);
+    EXPECT_FALSE(visited.contains(endpointOf(3)));
+}
+
+TEST(sessions, wheelNeverExpiresEarly)
+{
+    const Clock::time_point start{};
+    srv::TimingWheel wheel(start);
+    wheel.schedule(1, start + 250ms);
+    wheel.schedule(2, start + 300ms);
+    wheel.schedule(3, start - 1s); // Already due, handed at the next bucket
+
+    std::map<std::uint32_t, std::vector<Clock::duration>> handed;
+    run(wheel, start, start + 1s, handed);
+    EXPECT_EQ(handed[1], std::vector<Clock::duration>{300ms});
+    EXPECT_EQ(handed[2], std::vector<Clock::duration>{300ms});
+    EXPECT_EQ(handed[3], std::vector<Clock::duration>{100ms});
+
+    // Advancing to a time within the current bucket hands nothing
+    wheel.schedule(4, start + 1150ms);
+    std::size_t count = 0;
+    wheel.advance(start + 1199ms, [&count](std::uint32_t) { ++count; });
+    EXPECT_EQ(count, 0U);
+    wheel.advance(start + 1200ms, [&count](std::uint32_t) { ++count; });
+    EXPECT_EQ(count, 1U);
+}
+
+TEST(sessions, wheelBeyondHorizon)
+{
+    const Clock::time_point start{};
+    const auto horizon = srv::TimingWheel::RESOLUTION * (srv::TimingWheel::SLOTS - 1);
+    const Clock::time_point deadline = start + 60s;
+    srv::TimingWheel wheel(start);
+    wheel.schedule(1, deadline);
+
+    // Handed at the horizon first, as the caller would, it schedules the id again until its deadline
+    std::vector<Clock::duration> handed;
+    for (Clock::time_point now = start; now <= start + 61s; now += srv::TimingWheel::RESOLUTION)
+    {
+        wheel.advance(now,
+                      [&](const std::uint32_t id)
+                      {
+                          handed.push_back(now - start);
+                          if (now < deadline)
+                          {
+                              wheel.schedule(id, deadline);
+                          }
+                      });
+    }
+    ASSERT_EQ(handed.size(), 3U);
+    EXPECT_EQ(handed[0], horizon);
+    EXPECT_EQ(handed.back(), 60s);
+}
+
+TEST(sessions, wheelStallHandsEveryIdOnce)
+{
+    const Clock::time_point start{};
+    srv::TimingWheel wheel(start);
+    for (std::uint32_t id = 0; id < 500; ++id)
+    {
+        wheel.schedule(id, start + std::chrono::milliseconds(id * 97));
+    }
+
+    // Longer than the horizon without advancing, every bucket is handed once
+    std::map<std::uint32_t, std::size_t> handed;
+    wheel.advance(start + 100s, [&handed](const std::uint32_t id) { ++handed[id]; });
+    EXPECT_EQ(handed.size(), 500U);
+    for (const auto &[id, times] : handed)
+    {
+        EXPECT_EQ(times, 1U) << "id " << id;
+    }
+    std::size_t late = 0;
+    wheel.advance(start + 200s, [&late](std::uint32_t) { ++late; });
+    EXPECT_EQ(late, 0U);
+}